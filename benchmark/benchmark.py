@@ -45,10 +45,22 @@ class RenderSampleResult:
     render_with_none_results: AccelerationStructureResults
     render_with_uniform_grid_results: AccelerationStructureResults
     render_with_hierarchical_grid_results: AccelerationStructureResults
+    render_with_hashed_grid_results: AccelerationStructureResults
+    render_with_two_level_grid_results: AccelerationStructureResults
     render_with_octree_results: AccelerationStructureResults
+    render_with_parametric_octree_results: AccelerationStructureResults
+    render_with_loose_octree_results: AccelerationStructureResults
+    render_with_linear_octree_results: AccelerationStructureResults
     render_with_bsp_tree_results: AccelerationStructureResults
+    render_with_adaptive_bsp_tree_results: AccelerationStructureResults
     render_with_k_d_tree_results: AccelerationStructureResults
+    render_with_rope_k_d_tree_results: AccelerationStructureResults
     render_with_bounding_volume_hierarchy_results: AccelerationStructureResults
+    render_with_flat_bounding_volume_hierarchy_results: AccelerationStructureResults
+    render_with_wide_bounding_volume_hierarchy_4_results: AccelerationStructureResults
+    render_with_wide_bounding_volume_hierarchy_8_results: AccelerationStructureResults
+    render_with_linear_bounding_volume_hierarchy_results: AccelerationStructureResults
+    render_with_linear_bounding_volume_hierarchy_optimised_results: AccelerationStructureResults
 
 
 @dataclass
@@ -78,10 +90,22 @@ class RenderTestResults:
     render_with_none_results: RenderTestOneStructureResult
     uniform_grid_results: RenderTestOneStructureResult
     hierarchical_grid_results: RenderTestOneStructureResult
+    hashed_grid_results: RenderTestOneStructureResult
+    two_level_grid_results: RenderTestOneStructureResult
     octree_results: RenderTestOneStructureResult
+    parametric_octree_results: RenderTestOneStructureResult
+    loose_octree_results: RenderTestOneStructureResult
+    linear_octree_results: RenderTestOneStructureResult
     bsp_tree_results: RenderTestOneStructureResult
+    adaptive_bsp_tree_results: RenderTestOneStructureResult
     k_d_tree_results: RenderTestOneStructureResult
+    rope_k_d_tree_results: RenderTestOneStructureResult
     bounding_volume_hierarchy_results: RenderTestOneStructureResult
+    flat_bounding_volume_hierarchy_results: RenderTestOneStructureResult
+    wide_bounding_volume_hierarchy_4_results: RenderTestOneStructureResult
+    wide_bounding_volume_hierarchy_8_results: RenderTestOneStructureResult
+    linear_bounding_volume_hierarchy_results: RenderTestOneStructureResult
+    linear_bounding_volume_hierarchy_optimised_results: RenderTestOneStructureResult
 
 
 def parse_sample_log(filepath: str) -> RenderSampleResult:
@@ -113,10 +137,22 @@ def parse_sample_log(filepath: str) -> RenderSampleResult:
     render_with_none_results = None
     render_with_uniform_grid_results = None
     render_with_hierarchical_grid_results = None
+    render_with_hashed_grid_results = None
+    render_with_two_level_grid_results = None
     render_with_octree_results = None
+    render_with_parametric_octree_results = None
+    render_with_loose_octree_results = None
+    render_with_linear_octree_results = None
     render_with_bsp_tree_results = None
+    render_with_adaptive_bsp_tree_results = None
     render_with_k_d_tree_results = None
+    render_with_rope_k_d_tree_results = None
     render_with_bounding_volume_hierarchy_results = None
+    render_with_flat_bounding_volume_hierarchy_results = None
+    render_with_wide_bounding_volume_hierarchy_4_results = None
+    render_with_wide_bounding_volume_hierarchy_8_results = None
+    render_with_linear_bounding_volume_hierarchy_results = None
+    render_with_linear_bounding_volume_hierarchy_optimised_results = None
 
     with open(filepath) as f:
         for line in f.readlines():
@@ -130,37 +166,109 @@ def parse_sample_log(filepath: str) -> RenderSampleResult:
                 render_with_hierarchical_grid_results = (
                     parse_acceleration_structure_run_line(line)
                 )
+            elif "[Acceleration structure: Hashed grid]" in line:
+                render_with_hashed_grid_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
+            elif "[Acceleration structure: Two-level grid]" in line:
+                render_with_two_level_grid_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
             elif "[Acceleration structure: Octree]" in line:
                 render_with_octree_results = parse_acceleration_structure_run_line(line)
+            elif "[Acceleration structure: Parametric octree]" in line:
+                render_with_parametric_octree_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
+            elif "[Acceleration structure: Loose octree]" in line:
+                render_with_loose_octree_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
+            elif "[Acceleration structure: Linear octree]" in line:
+                render_with_linear_octree_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
             elif "[Acceleration structure: BSP tree]" in line:
                 render_with_bsp_tree_results = parse_acceleration_structure_run_line(
                     line
                 )
+            elif "[Acceleration structure: Adaptive BSP tree]" in line:
+                render_with_adaptive_bsp_tree_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
             elif "[Acceleration structure: k-d tree]" in line:
                 render_with_k_d_tree_results = parse_acceleration_structure_run_line(
                     line
                 )
+            elif "[Acceleration structure: Rope k-d tree]" in line:
+                render_with_rope_k_d_tree_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
             elif "[Acceleration structure: Bounding volume hierarchy]" in line:
                 render_with_bounding_volume_hierarchy_results = (
                     parse_acceleration_structure_run_line(line)
                 )
+            elif "[Acceleration structure: Flattened bounding volume hierarchy]" in line:
+                render_with_flat_bounding_volume_hierarchy_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
+            elif "[Acceleration structure: 4-wide bounding volume hierarchy]" in line:
+                render_with_wide_bounding_volume_hierarchy_4_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
+            elif "[Acceleration structure: 8-wide bounding volume hierarchy]" in line:
+                render_with_wide_bounding_volume_hierarchy_8_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
+            elif "[Acceleration structure: Linear bounding volume hierarchy]" in line:
+                render_with_linear_bounding_volume_hierarchy_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
+            elif "[Acceleration structure: Treelet optimised linear bounding volume hierarchy]" in line:
+                render_with_linear_bounding_volume_hierarchy_optimised_results = (
+                    parse_acceleration_structure_run_line(line)
+                )
 
     assert render_with_none_results
     assert render_with_uniform_grid_results
     assert render_with_hierarchical_grid_results
+    assert render_with_hashed_grid_results
+    assert render_with_two_level_grid_results
     assert render_with_octree_results
+    assert render_with_parametric_octree_results
+    assert render_with_loose_octree_results
+    assert render_with_linear_octree_results
     assert render_with_bsp_tree_results
+    assert render_with_adaptive_bsp_tree_results
     assert render_with_k_d_tree_results
+    assert render_with_rope_k_d_tree_results
     assert render_with_bounding_volume_hierarchy_results
+    assert render_with_flat_bounding_volume_hierarchy_results
+    assert render_with_wide_bounding_volume_hierarchy_4_results
+    assert render_with_wide_bounding_volume_hierarchy_8_results
+    assert render_with_linear_bounding_volume_hierarchy_results
+    assert render_with_linear_bounding_volume_hierarchy_optimised_results
 
     return RenderSampleResult(
         render_with_none_results,
         render_with_uniform_grid_results,
         render_with_hierarchical_grid_results,
+        render_with_hashed_grid_results,
+        render_with_two_level_grid_results,
         render_with_octree_results,
+        render_with_parametric_octree_results,
+        render_with_loose_octree_results,
+        render_with_linear_octree_results,
         render_with_bsp_tree_results,
+        render_with_adaptive_bsp_tree_results,
         render_with_k_d_tree_results,
+        render_with_rope_k_d_tree_results,
         render_with_bounding_volume_hierarchy_results,
+        render_with_flat_bounding_volume_hierarchy_results,
+        render_with_wide_bounding_volume_hierarchy_4_results,
+        render_with_wide_bounding_volume_hierarchy_8_results,
+        render_with_linear_bounding_volume_hierarchy_results,
+        render_with_linear_bounding_volume_hierarchy_optimised_results,
     )
 
 
@@ -266,31 +374,87 @@ def calculate_render_test_result(
     none_results = []
     uniform_grid_results = []
     hierarchical_grid_results = []
+    hashed_grid_results = []
+    two_level_grid_results = []
     octree_results = []
+    parametric_octree_results = []
+    loose_octree_results = []
+    linear_octree_results = []
     bsp_tree_results = []
+    adaptive_bsp_tree_results = []
     k_d_tree_results = []
+    rope_k_d_tree_results = []
     bounding_volume_hierarchy_results = []
+    flat_bounding_volume_hierarchy_results = []
+    wide_bounding_volume_hierarchy_4_results = []
+    wide_bounding_volume_hierarchy_8_results = []
+    linear_bounding_volume_hierarchy_results = []
+    linear_bounding_volume_hierarchy_optimised_results = []
     for sample_index in range(0, num_samples):
         sample = render_sample_results[sample_index]
 
         none_results.append(sample.render_with_none_results)
         uniform_grid_results.append(sample.render_with_uniform_grid_results)
         hierarchical_grid_results.append(sample.render_with_hierarchical_grid_results)
+        hashed_grid_results.append(sample.render_with_hashed_grid_results)
+        two_level_grid_results.append(sample.render_with_two_level_grid_results)
         octree_results.append(sample.render_with_octree_results)
+        parametric_octree_results.append(sample.render_with_parametric_octree_results)
+        loose_octree_results.append(sample.render_with_loose_octree_results)
+        linear_octree_results.append(sample.render_with_linear_octree_results)
         bsp_tree_results.append(sample.render_with_bsp_tree_results)
+        adaptive_bsp_tree_results.append(sample.render_with_adaptive_bsp_tree_results)
         k_d_tree_results.append(sample.render_with_k_d_tree_results)
+        rope_k_d_tree_results.append(sample.render_with_rope_k_d_tree_results)
         bounding_volume_hierarchy_results.append(
             sample.render_with_bounding_volume_hierarchy_results
         )
+        flat_bounding_volume_hierarchy_results.append(
+            sample.render_with_flat_bounding_volume_hierarchy_results
+        )
+        wide_bounding_volume_hierarchy_4_results.append(
+            sample.render_with_wide_bounding_volume_hierarchy_4_results
+        )
+        wide_bounding_volume_hierarchy_8_results.append(
+            sample.render_with_wide_bounding_volume_hierarchy_8_results
+        )
+        linear_bounding_volume_hierarchy_results.append(
+            sample.render_with_linear_bounding_volume_hierarchy_results
+        )
+        linear_bounding_volume_hierarchy_optimised_results.append(
+            sample.render_with_linear_bounding_volume_hierarchy_optimised_results
+        )
 
     return RenderTestResults(
         calculate_render_test_one_structure_result(none_results),
         calculate_render_test_one_structure_result(uniform_grid_results),
         calculate_render_test_one_structure_result(hierarchical_grid_results),
+        calculate_render_test_one_structure_result(hashed_grid_results),
+        calculate_render_test_one_structure_result(two_level_grid_results),
         calculate_render_test_one_structure_result(octree_results),
+        calculate_render_test_one_structure_result(parametric_octree_results),
+        calculate_render_test_one_structure_result(loose_octree_results),
+        calculate_render_test_one_structure_result(linear_octree_results),
         calculate_render_test_one_structure_result(bsp_tree_results),
+        calculate_render_test_one_structure_result(adaptive_bsp_tree_results),
         calculate_render_test_one_structure_result(k_d_tree_results),
+        calculate_render_test_one_structure_result(rope_k_d_tree_results),
         calculate_render_test_one_structure_result(bounding_volume_hierarchy_results),
+        calculate_render_test_one_structure_result(
+            flat_bounding_volume_hierarchy_results
+        ),
+        calculate_render_test_one_structure_result(
+            wide_bounding_volume_hierarchy_4_results
+        ),
+        calculate_render_test_one_structure_result(
+            wide_bounding_volume_hierarchy_8_results
+        ),
+        calculate_render_test_one_structure_result(
+            linear_bounding_volume_hierarchy_results
+        ),
+        calculate_render_test_one_structure_result(
+            linear_bounding_volume_hierarchy_optimised_results
+        ),
     )
 
 
@@ -345,10 +509,22 @@ def write_results_as_csv(filepath: str = "results/results.csv"):
         ("None", "render_with_none_results"),
         ("Uniform Grid", "uniform_grid_results"),
         ("Hierarchical Uniform Grid", "hierarchical_grid_results"),
+        ("Hashed Grid", "hashed_grid_results"),
+        ("Two-Level Grid", "two_level_grid_results"),
         ("Octree", "octree_results"),
+        ("Parametric Octree", "parametric_octree_results"),
+        ("Loose Octree", "loose_octree_results"),
+        ("Linear Octree", "linear_octree_results"),
         ("BSP Tree", "bsp_tree_results"),
+        ("Adaptive BSP Tree", "adaptive_bsp_tree_results"),
         ("k-d Tree", "k_d_tree_results"),
+        ("Rope k-d Tree", "rope_k_d_tree_results"),
         ("BVH", "bounding_volume_hierarchy_results"),
+        ("Flat BVH", "flat_bounding_volume_hierarchy_results"),
+        ("BVH4", "wide_bounding_volume_hierarchy_4_results"),
+        ("BVH8", "wide_bounding_volume_hierarchy_8_results"),
+        ("LBVH", "linear_bounding_volume_hierarchy_results"),
+        ("LBVH + Treelets", "linear_bounding_volume_hierarchy_optimised_results"),
     ]
 
     # (scene_name, config, struct_name, result)
@@ -18,10 +18,22 @@ STRUCTURE_ORDER = [
     "None",
     "Uniform Grid",
     "Hierarchical Uniform Grid",
+    "Hashed Grid",
+    "Two-Level Grid",
     "Octree",
+    "Parametric Octree",
+    "Loose Octree",
+    "Linear Octree",
     "BSP Tree",
+    "Adaptive BSP Tree",
     "KD Tree",
+    "Rope KD Tree",
     "BVH",
+    "Flat BVH",
+    "BVH4",
+    "BVH8",
+    "LBVH",
+    "LBVH + Treelets",
 ]
 
 
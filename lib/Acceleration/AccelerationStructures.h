@@ -3,7 +3,17 @@
 
 #include <Acceleration/BoundingVolumeHierarchy.h>
 #include <Acceleration/BSPTree.h>
+#include <Acceleration/FlatBoundingVolumeHierarchy.h>
+#include <Acceleration/HashedGrid.h>
 #include <Acceleration/HierarchicalUniformGrid.h>
 #include <Acceleration/KDTree.h>
+#include <Acceleration/LinearBoundingVolumeHierarchy.h>
+#include <Acceleration/LinearOctree.h>
+#include <Acceleration/LooseOctree.h>
 #include <Acceleration/Octree.h>
+#include <Acceleration/ParametricOctree.h>
+#include <Acceleration/RayMailbox.h>
+#include <Acceleration/RopeKDTree.h>
+#include <Acceleration/TwoLevelGrid.h>
 #include <Acceleration/UniformGrid.h>
+#include <Acceleration/WideBoundingVolumeHierarchy.h>
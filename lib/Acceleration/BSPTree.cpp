@@ -1,33 +1,51 @@
 // Copyright Mia Rolfe. All rights reserved.
 #include <Acceleration/BSPTree.h>
 
+#include <algorithm>
+
 #include <Core/Common.h>
 #include <Core/TraversalStats.h>
 
 namespace ART
 {
 
-BSPTreeNode::BSPTreeNode(std::vector<IRayHittable*>& objects)
+BSPTreeNode::BSPTreeNode(std::vector<IRayHittable*>& objects, const BSPBuildSettings& settings)
     : m_allocator(nullptr), m_front(nullptr), m_back(nullptr)
 {
     // Worst-case highwater-mark guess, every object duplicated into both child nodes
-    const std::size_t arena_size = (4 * objects.size()) * sizeof(BSPTreeNode);
+    const std::size_t arena_size = (4 * objects.size()) * sizeof(BSPTreeNode) + (objects.size() * sizeof(uint32_t));
     m_allocator = new ArenaAllocator(arena_size);
 
-    Create(objects.data(), objects.size(), 0, *m_allocator);
+    PrimitiveStore* primitive_store = new PrimitiveStore(objects);
+
+    // Boxes are looked up for every object at every candidate plane, so they're gathered once for the whole build
+    std::vector<AABB> object_boxes(objects.size());
+    uint32_t* object_indices = static_cast<uint32_t*>
+    (
+        m_allocator->Alloc(objects.size() * sizeof(uint32_t), alignof(uint32_t))
+    );
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    {
+        object_boxes[object_index] = objects[object_index]->BoundingBox();
+        object_indices[object_index] = static_cast<uint32_t>(object_index);
+    }
+
+    Create(object_indices, objects.size(), 0, *m_allocator, *primitive_store, object_boxes.data(), settings);
 }
 
-BSPTreeNode::BSPTreeNode(IRayHittable** objects, std::size_t count, std::size_t depth, ArenaAllocator& allocator)
+BSPTreeNode::BSPTreeNode(uint32_t* object_indices, std::size_t count, std::size_t depth, ArenaAllocator& allocator, const PrimitiveStore& primitive_store, const AABB* object_boxes, const BSPBuildSettings& settings)
     : m_allocator(nullptr), m_front(nullptr), m_back(nullptr)
 {
-    Create(objects, count, depth, allocator);
+    Create(object_indices, count, depth, allocator, primitive_store, object_boxes, settings);
 }
 
 BSPTreeNode::~BSPTreeNode()
 {
-    // Only root node owns and deletes allocator
+    // Only root node owns and deletes allocator and primitive store
     if (m_allocator)
     {
+        delete m_primitive_store;
+        m_primitive_store = nullptr;
         delete m_allocator;
         m_allocator = nullptr;
     }
@@ -74,26 +92,305 @@ BSPObjectClassification BSPTreeNode::ClassifyObject(const AABB& box, const BSPSp
     return BSPObjectClassification::SPANNING;
 }
 
-bool BSPTreeNode::FindSplitPlane(IRayHittable** objects, std::size_t count, BSPSplitPlane& out_plane)
+// Eigenvalues and orthonormal eigenvectors of a symmetric 3x3 matrix by cyclic Jacobi rotations, sorted by decreasing eigenvalue
+static void SymmetricEigenDecomposition(double matrix[3][3], double out_eigenvalues[3], Vec3 out_eigenvectors[3])
+{
+    double eigenvectors[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+    static constexpr std::size_t MAX_SWEEPS = 32;
+    static constexpr std::size_t PAIRS[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+
+    for (std::size_t sweep = 0; sweep < MAX_SWEEPS; sweep++)
+    {
+        const double off_diagonal = std::abs(matrix[0][1]) + std::abs(matrix[0][2]) + std::abs(matrix[1][2]);
+        const double diagonal = std::abs(matrix[0][0]) + std::abs(matrix[1][1]) + std::abs(matrix[2][2]);
+        if (off_diagonal <= 1e-15 * diagonal || off_diagonal == 0.0)
+        {
+            break;
+        }
+
+        for (const std::size_t* pair : PAIRS)
+        {
+            const std::size_t p = pair[0];
+            const std::size_t q = pair[1];
+            if (matrix[p][q] == 0.0)
+            {
+                continue;
+            }
+
+            // Rotation in the pq plane that zeroes matrix[p][q]
+            const double theta = (matrix[q][q] - matrix[p][p]) / (2.0 * matrix[p][q]);
+            const double t = ((theta >= 0.0) ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt((theta * theta) + 1.0));
+            const double c = 1.0 / std::sqrt((t * t) + 1.0);
+            const double s = t * c;
+
+            for (std::size_t k = 0; k < 3; k++)
+            {
+                const double kp = matrix[k][p];
+                const double kq = matrix[k][q];
+                matrix[k][p] = (c * kp) - (s * kq);
+                matrix[k][q] = (s * kp) + (c * kq);
+            }
+            for (std::size_t k = 0; k < 3; k++)
+            {
+                const double pk = matrix[p][k];
+                const double qk = matrix[q][k];
+                matrix[p][k] = (c * pk) - (s * qk);
+                matrix[q][k] = (s * pk) + (c * qk);
+            }
+            for (std::size_t k = 0; k < 3; k++)
+            {
+                const double kp = eigenvectors[k][p];
+                const double kq = eigenvectors[k][q];
+                eigenvectors[k][p] = (c * kp) - (s * kq);
+                eigenvectors[k][q] = (s * kp) + (c * kq);
+            }
+        }
+    }
+
+    std::size_t order[3] = { 0, 1, 2 };
+    std::sort(order, order + 3, [&matrix](std::size_t a, std::size_t b) { return matrix[a][a] > matrix[b][b]; });
+    for (std::size_t i = 0; i < 3; i++)
+    {
+        out_eigenvalues[i] = matrix[order[i]][order[i]];
+        out_eigenvectors[i] = Vec3(eigenvectors[0][order[i]], eigenvectors[1][order[i]], eigenvectors[2][order[i]]);
+    }
+}
+
+// Principal axes of a set of points, sorted by decreasing variance
+static void PrincipalAxes(const Point3* points, std::size_t count, double out_variances[3], Vec3 out_axes[3])
+{
+    Point3 mean(0.0, 0.0, 0.0);
+    for (std::size_t point_index = 0; point_index < count; point_index++)
+    {
+        mean += points[point_index];
+    }
+    mean /= static_cast<double>(count);
+
+    double covariance[3][3] = {};
+    for (std::size_t point_index = 0; point_index < count; point_index++)
+    {
+        const Vec3 offset = points[point_index] - mean;
+        for (std::size_t row = 0; row < 3; row++)
+        {
+            for (std::size_t column = 0; column < 3; column++)
+            {
+                covariance[row][column] += offset[row] * offset[column];
+            }
+        }
+    }
+
+    SymmetricEigenDecomposition(covariance, out_variances, out_axes);
+}
+
+std::size_t BSPTreeNode::FindCandidateNormals(const AABB* object_boxes, const uint32_t* object_indices, std::size_t count, std::size_t candidate_budget, Vec3 out_normals[])
+{
+    const std::size_t max_normals = std::clamp<std::size_t>(candidate_budget, BSPBuildSettings::MIN_CANDIDATE_BUDGET, MAX_CANDIDATE_NORMALS);
+    std::size_t num_normals = 0;
+
+    const auto add_candidate = [&](const Vec3& normal)
+    {
+        if (num_normals >= max_normals || normal.LengthSquared() == 0.0)
+        {
+            return;
+        }
+        const Vec3 unit_normal = Normalised(normal);
+        for (std::size_t normal_index = 0; normal_index < num_normals; normal_index++)
+        {
+            if (std::abs(Dot(unit_normal, out_normals[normal_index])) > DUPLICATE_NORMAL_COSINE)
+            {
+                return;
+            }
+        }
+        out_normals[num_normals++] = unit_normal;
+    };
+
+    // Axes first, so the tree is never worse off than a k-d style split
+    add_candidate(Vec3(1.0, 0.0, 0.0));
+    add_candidate(Vec3(0.0, 1.0, 0.0));
+    add_candidate(Vec3(0.0, 0.0, 1.0));
+    if (count < 2)
+    {
+        return num_normals;
+    }
+
+    std::vector<Point3> centroids(count);
+    for (std::size_t object_index = 0; object_index < count; object_index++)
+    {
+        const AABB& box = object_boxes[object_indices[object_index]];
+        centroids[object_index] = Point3
+        (
+            0.5 * (box.m_x.m_min + box.m_x.m_max),
+            0.5 * (box.m_y.m_min + box.m_y.m_max),
+            0.5 * (box.m_z.m_min + box.m_z.m_max)
+        );
+    }
+
+    // Longest axis separates the spread of objects, thinnest axis is the normal of a single flat wall
+    double variances[3];
+    Vec3 principal_axes[3];
+    PrincipalAxes(centroids.data(), count, variances, principal_axes);
+
+    // Flat walls inside the node show up as patches of consecutive objects along the longest axis that are thin in one direction
+    // Their normals are clustered so walls sharing an orientation produce one strong candidate
+    Vec3 cluster_normal_sums[MAX_PATCHES];
+    std::size_t cluster_sizes[MAX_PATCHES] = {};
+    std::size_t num_clusters = 0;
+
+    const std::size_t num_patches = std::min(MAX_PATCHES, count / MIN_OBJECTS_PER_PATCH);
+    if (num_patches >= 2)
+    {
+        std::sort(centroids.begin(), centroids.end(), [&principal_axes](const Point3& a, const Point3& b)
+        {
+            return Dot(a, principal_axes[0]) < Dot(b, principal_axes[0]);
+        });
+
+        for (std::size_t patch_index = 0; patch_index < num_patches; patch_index++)
+        {
+            const std::size_t begin = (count * patch_index) / num_patches;
+            const std::size_t end = (count * (patch_index + 1)) / num_patches;
+
+            double patch_variances[3];
+            Vec3 patch_axes[3];
+            PrincipalAxes(centroids.data() + begin, end - begin, patch_variances, patch_axes);
+            if (patch_variances[2] > PATCH_FLATNESS_RATIO * patch_variances[1])
+            {
+                continue;
+            }
+
+            const Vec3& patch_normal = patch_axes[2];
+            std::size_t cluster_index = 0;
+            while (cluster_index < num_clusters && std::abs(Dot(Normalised(cluster_normal_sums[cluster_index]), patch_normal)) < PATCH_CLUSTER_COSINE)
+            {
+                cluster_index++;
+            }
+
+            if (cluster_index == num_clusters)
+            {
+                cluster_normal_sums[num_clusters++] = patch_normal;
+                cluster_sizes[cluster_index] = 1;
+            }
+            else
+            {
+                // Normals are only defined up to sign, flip to agree with the cluster before averaging
+                const double sign = (Dot(cluster_normal_sums[cluster_index], patch_normal) >= 0.0) ? 1.0 : -1.0;
+                cluster_normal_sums[cluster_index] += sign * patch_normal;
+                cluster_sizes[cluster_index]++;
+            }
+        }
+    }
+
+    std::size_t cluster_order[MAX_PATCHES];
+    for (std::size_t cluster_index = 0; cluster_index < num_clusters; cluster_index++)
+    {
+        cluster_order[cluster_index] = cluster_index;
+    }
+    std::sort(cluster_order, cluster_order + num_clusters, [&cluster_sizes](std::size_t a, std::size_t b) { return cluster_sizes[a] > cluster_sizes[b]; });
+
+    add_candidate(principal_axes[0]);
+    add_candidate(principal_axes[2]);
+    for (std::size_t cluster_index = 0; cluster_index < num_clusters; cluster_index++)
+    {
+        add_candidate(cluster_normal_sums[cluster_order[cluster_index]]);
+    }
+    add_candidate(principal_axes[1]);
+
+    return num_normals;
+}
+
+double BSPTreeNode::ClippedSurfaceArea(const AABB& box, const BSPSplitPlane& plane, bool keep_front)
+{
+    const double side_sign = keep_front ? 1.0 : -1.0;
+    const double box_min[3] = { box.m_x.m_min, box.m_y.m_min, box.m_z.m_min };
+    const double box_max[3] = { box.m_x.m_max, box.m_y.m_max, box.m_z.m_max };
+    const double normal[3] = { plane.m_normal.m_x, plane.m_normal.m_y, plane.m_normal.m_z };
+
+    double surface_area = 0.0;
+    // Sum of each clipped face's area times its outward normal, the cap closing the cell balances it
+    double face_area_sum[3] = { 0.0, 0.0, 0.0 };
+
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const std::size_t u_axis = (axis + 1) % 3;
+        const std::size_t v_axis = (axis + 2) % 3;
+
+        for (std::size_t side = 0; side < 2; side++)
+        {
+            const double w = (side == 0) ? box_min[axis] : box_max[axis];
+            const double corners_u[4] = { box_min[u_axis], box_max[u_axis], box_max[u_axis], box_min[u_axis] };
+            const double corners_v[4] = { box_min[v_axis], box_min[v_axis], box_max[v_axis], box_max[v_axis] };
+
+            // Clip the face's quad against the kept half-space, a convex polygon gains at most one vertex per clip
+            double clipped_u[5];
+            double clipped_v[5];
+            std::size_t num_clipped = 0;
+            for (std::size_t corner = 0; corner < 4; corner++)
+            {
+                const std::size_t next_corner = (corner + 1) % 4;
+                const double distance = side_sign * ((normal[axis] * w) + (normal[u_axis] * corners_u[corner]) + (normal[v_axis] * corners_v[corner]) - plane.m_distance);
+                const double next_distance = side_sign * ((normal[axis] * w) + (normal[u_axis] * corners_u[next_corner]) + (normal[v_axis] * corners_v[next_corner]) - plane.m_distance);
+
+                if (distance >= 0.0)
+                {
+                    clipped_u[num_clipped] = corners_u[corner];
+                    clipped_v[num_clipped] = corners_v[corner];
+                    num_clipped++;
+                }
+                if ((distance >= 0.0) != (next_distance >= 0.0))
+                {
+                    const double t = distance / (distance - next_distance);
+                    clipped_u[num_clipped] = corners_u[corner] + (t * (corners_u[next_corner] - corners_u[corner]));
+                    clipped_v[num_clipped] = corners_v[corner] + (t * (corners_v[next_corner] - corners_v[corner]));
+                    num_clipped++;
+                }
+            }
+
+            // Shoelace formula
+            double twice_area = 0.0;
+            for (std::size_t vertex = 0; vertex < num_clipped; vertex++)
+            {
+                const std::size_t next_vertex = (vertex + 1) % num_clipped;
+                twice_area += (clipped_u[vertex] * clipped_v[next_vertex]) - (clipped_u[next_vertex] * clipped_v[vertex]);
+            }
+            const double face_area = 0.5 * std::abs(twice_area);
+
+            surface_area += face_area;
+            face_area_sum[axis] += (side == 0) ? -face_area : face_area;
+        }
+    }
+
+    const double cap_area = std::sqrt
+    (
+        (face_area_sum[0] * face_area_sum[0]) + (face_area_sum[1] * face_area_sum[1]) + (face_area_sum[2] * face_area_sum[2])
+    );
+    return surface_area + cap_area;
+}
+
+bool BSPTreeNode::FindSplitPlane(const uint32_t* object_indices, std::size_t count, const AABB* object_boxes, const BSPBuildSettings& settings, BSPSplitPlane& out_plane)
 {
     const double parent_node_surface_area = m_bounding_box.SurfaceArea();
     const double leaf_cost = count * HITTABLE_INTERSECT_COST;
     double best_cost = std::numeric_limits<double>::max();
     BSPSplitPlane best_splitting_plane;
 
-    // 3 axis-aligned (like k-d tree) + 4 diagonals
-    const Vec3 normals[7] =
+    Vec3 normals[MAX_CANDIDATE_NORMALS];
+    std::size_t num_normals = 0;
+    if (settings.split_normals == BSPSplitNormals::DATA_DRIVEN)
     {
-        Vec3(1.0, 0.0, 0.0),
-        Vec3(0.0, 1.0, 0.0),
-        Vec3(0.0, 0.0, 1.0),
-        Normalised(Vec3(1.0, 1.0, 0.0)),
-        Normalised(Vec3(1.0, 0.0, 1.0)),
-        Normalised(Vec3(0.0, 1.0, 1.0)),
-        Normalised(Vec3(1.0, 1.0, 1.0))
-    };
+        num_normals = FindCandidateNormals(object_boxes, object_indices, count, settings.candidate_budget, normals);
+    }
+    else
+    {
+        // 3 axis-aligned (like k-d tree) + 4 diagonals
+        normals[num_normals++] = Vec3(1.0, 0.0, 0.0);
+        normals[num_normals++] = Vec3(0.0, 1.0, 0.0);
+        normals[num_normals++] = Vec3(0.0, 0.0, 1.0);
+        normals[num_normals++] = Normalised(Vec3(1.0, 1.0, 0.0));
+        normals[num_normals++] = Normalised(Vec3(1.0, 0.0, 1.0));
+        normals[num_normals++] = Normalised(Vec3(0.0, 1.0, 1.0));
+        normals[num_normals++] = Normalised(Vec3(1.0, 1.0, 1.0));
+    }
 
-    for (std::size_t normal_index = 0; normal_index < 7; normal_index++)
+    for (std::size_t normal_index = 0; normal_index < num_normals; normal_index++)
     {
         const Vec3& normal = normals[normal_index];
 
@@ -104,7 +401,7 @@ bool BSPTreeNode::FindSplitPlane(IRayHittable** objects, std::size_t count, BSPS
 
         for (std::size_t object_index = 0; object_index < count; object_index++)
         {
-            const AABB& box = objects[object_index]->BoundingBox();
+            const AABB& box = object_boxes[object_indices[object_index]];
 
             const double projection_x = normal.m_x * (box.m_x.m_min + box.m_x.m_max);
             const double projection_y = normal.m_y * (box.m_y.m_min + box.m_y.m_max);
@@ -134,7 +431,7 @@ bool BSPTreeNode::FindSplitPlane(IRayHittable** objects, std::size_t count, BSPS
 
             for (std::size_t object_index = 0; object_index < count; object_index++)
             {
-                const AABB& object_bounding_box = objects[object_index]->BoundingBox();
+                const AABB& object_bounding_box = object_boxes[object_indices[object_index]];
                 const BSPObjectClassification classification = ClassifyObject(object_bounding_box, test_plane);
 
                 if (classification >= BSPObjectClassification::SPANNING)
@@ -154,8 +451,13 @@ bool BSPTreeNode::FindSplitPlane(IRayHittable** objects, std::size_t count, BSPS
                 continue;
             }
 
-            const double cost_of_front_subtree = (front_bounding_box.SurfaceArea() / parent_node_surface_area) * front_num_objects * HITTABLE_INTERSECT_COST;
-            const double cost_of_back_subtree = (back_bounding_box.SurfaceArea() / parent_node_surface_area) * back_num_objects * HITTABLE_INTERSECT_COST;
+            // Children are only traversed on their side of the plane, so in DATA_DRIVEN mode each is scored by its box
+            // clipped to that side. An oblique plane's child boxes overlap well past it, their full areas overstate its cost
+            const bool clip_cells = (settings.split_normals == BSPSplitNormals::DATA_DRIVEN);
+            const double front_surface_area = clip_cells ? ClippedSurfaceArea(front_bounding_box, test_plane, true) : front_bounding_box.SurfaceArea();
+            const double back_surface_area = clip_cells ? ClippedSurfaceArea(back_bounding_box, test_plane, false) : back_bounding_box.SurfaceArea();
+            const double cost_of_front_subtree = (front_surface_area / parent_node_surface_area) * front_num_objects * HITTABLE_INTERSECT_COST;
+            const double cost_of_back_subtree = (back_surface_area / parent_node_surface_area) * back_num_objects * HITTABLE_INTERSECT_COST;
             const double total_cost = NODE_TRAVERSAL_COST + cost_of_front_subtree + cost_of_back_subtree;
 
             if (total_cost < best_cost)
@@ -176,19 +478,27 @@ bool BSPTreeNode::FindSplitPlane(IRayHittable** objects, std::size_t count, BSPS
     return true;
 }
 
-void BSPTreeNode::Create(IRayHittable** objects, std::size_t count, std::size_t depth, ArenaAllocator& allocator)
+void BSPTreeNode::Create(uint32_t* object_indices, std::size_t count, std::size_t depth, ArenaAllocator& allocator, const PrimitiveStore& primitive_store, const AABB* object_boxes, const BSPBuildSettings& settings)
 {
+    m_primitive_store = &primitive_store;
+
     // Compute bounding box
     for (std::size_t object_index = 0; object_index < count; object_index++)
     {
-        m_bounding_box = AABB(m_bounding_box, objects[object_index]->BoundingBox());
+        m_bounding_box = AABB(m_bounding_box, object_boxes[object_indices[object_index]]);
     }
 
     // Create leaf if small number of objects left, hit max depth, or no good split found
-    if (count <= MAX_OBJECTS_PER_LEAF || depth >= MAX_DEPTH || !FindSplitPlane(objects, count, m_split_plane))
+    // No other node uses the leaf's indices, so they're replaced in place by the ids its objects are tested through
+    if (count <= MAX_OBJECTS_PER_LEAF || depth >= MAX_DEPTH || !FindSplitPlane(object_indices, count, object_boxes, settings, m_split_plane))
     {
-        m_front = objects[0];
-        m_back = (count > 1) ? allocator.Create<BSPTreeNode>(objects + 1, count - 1, depth + 1, allocator) : nullptr;
+        m_split_plane = BSPSplitPlane(Vec3(0.0, 0.0, 0.0), 0.0);
+        for (std::size_t object_index = 0; object_index < count; object_index++)
+        {
+            object_indices[object_index] = primitive_store.GetId(object_indices[object_index]);
+        }
+        m_primitives = object_indices;
+        m_num_primitives = count;
         return;
     }
 
@@ -196,7 +506,7 @@ void BSPTreeNode::Create(IRayHittable** objects, std::size_t count, std::size_t
     std::size_t back_num_objects = 0;
     for (std::size_t object_index = 0; object_index < count; object_index++)
     {
-        const BSPObjectClassification classification = ClassifyObject(objects[object_index]->BoundingBox(), m_split_plane);
+        const BSPObjectClassification classification = ClassifyObject(object_boxes[object_indices[object_index]], m_split_plane);
         front_num_objects += static_cast<std::size_t>(classification >= BSPObjectClassification::SPANNING);
         back_num_objects += static_cast<std::size_t>(classification <= BSPObjectClassification::SPANNING);
     }
@@ -204,44 +514,45 @@ void BSPTreeNode::Create(IRayHittable** objects, std::size_t count, std::size_t
     // If all objects on one side of the split, just split in half
     if (front_num_objects == 0 || back_num_objects == 0 || (front_num_objects == count && back_num_objects == count))
     {
+        m_split_plane = BSPSplitPlane(Vec3(0.0, 0.0, 0.0), 0.0);
         const std::size_t mid_index = count / 2;
-        m_front = allocator.Create<BSPTreeNode>(objects, mid_index, depth + 1, allocator);
-        m_back = allocator.Create<BSPTreeNode>(objects + mid_index, count - mid_index, depth + 1, allocator);
+        m_front = allocator.Create<BSPTreeNode>(object_indices, mid_index, depth + 1, allocator, primitive_store, object_boxes, settings);
+        m_back = allocator.Create<BSPTreeNode>(object_indices + mid_index, count - mid_index, depth + 1, allocator, primitive_store, object_boxes, settings);
         return;
     }
 
     // Allocate and distribute objects
-    IRayHittable** front_objects = static_cast<IRayHittable**>
+    uint32_t* front_object_indices = static_cast<uint32_t*>
     (
-        allocator.Alloc(front_num_objects * sizeof(IRayHittable*), alignof(IRayHittable*))
+        allocator.Alloc(front_num_objects * sizeof(uint32_t), alignof(uint32_t))
     );
-    IRayHittable** back_objects = static_cast<IRayHittable**>
+    uint32_t* back_object_indices = static_cast<uint32_t*>
     (
-        allocator.Alloc(back_num_objects * sizeof(IRayHittable*), alignof(IRayHittable*))
+        allocator.Alloc(back_num_objects * sizeof(uint32_t), alignof(uint32_t))
     );
 
     std::size_t front_objects_index = 0;
     std::size_t back_objects_index = 0;
     for (std::size_t object_index = 0; object_index < count; object_index++)
     {
-        const BSPObjectClassification classification = ClassifyObject(objects[object_index]->BoundingBox(), m_split_plane);
+        const BSPObjectClassification classification = ClassifyObject(object_boxes[object_indices[object_index]], m_split_plane);
         if (classification >= BSPObjectClassification::SPANNING)
         {
-            front_objects[front_objects_index] = objects[object_index];
+            front_object_indices[front_objects_index] = object_indices[object_index];
             front_objects_index++;
         }
         if (classification <= BSPObjectClassification::SPANNING)
         {
-            back_objects[back_objects_index] = objects[object_index];
+            back_object_indices[back_objects_index] = object_indices[object_index];
             back_objects_index++;
         }
     }
 
-    m_front = allocator.Create<BSPTreeNode>(front_objects, front_num_objects, depth + 1, allocator);
-    m_back = allocator.Create<BSPTreeNode>(back_objects, back_num_objects, depth + 1, allocator);
+    m_front = allocator.Create<BSPTreeNode>(front_object_indices, front_num_objects, depth + 1, allocator, primitive_store, object_boxes, settings);
+    m_back = allocator.Create<BSPTreeNode>(back_object_indices, back_num_objects, depth + 1, allocator, primitive_store, object_boxes, settings);
 }
 
-bool BSPTreeNode::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+bool BSPTreeNode::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
     if (!m_bounding_box.Hit(ray, ray_t))
     {
@@ -250,23 +561,71 @@ bool BSPTreeNode::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result)
 
     RecordNodeTraversal();
 
-    // Single child leaf
-    if (m_back == nullptr)
+    if (m_front == nullptr)
     {
-        return m_front->Hit(ray, ray_t, out_result);
+        return m_primitive_store->Hit(m_primitives, m_num_primitives, ray, ray_t, out_result);
+    }
+
+    // Children split arbitrarily, either may hold the closest hit
+    if (!m_split_plane.SeparatesChildren())
+    {
+        const bool hit_first = m_front->HitDeferred(ray, ray_t, out_result);
+        const bool hit_second = m_back->HitDeferred(ray, Interval(ray_t.m_min, hit_first ? out_result.m_t : ray_t.m_max), out_result);
+        return hit_first || hit_second;
     }
 
     // Determine traversal order (find closest side to origin)
+    // A ray starting on the plane belongs to the side it heads into
     const double origin_distance = Dot(m_split_plane.m_normal, ray.m_origin) - m_split_plane.m_distance;
-    const bool origin_in_front = origin_distance >= 0.0;
+    const double direction_along_normal = Dot(m_split_plane.m_normal, ray.m_direction);
+    const bool origin_in_front = (origin_distance > 0.0) || (origin_distance == 0.0 && direction_along_normal >= 0.0);
+
+    const BSPTreeNode* first = origin_in_front ? m_front : m_back;
+    const BSPTreeNode* second = origin_in_front ? m_back : m_front;
+
+    // Ray parameter where it crosses the plane, negative or infinite if it never crosses going forward
+    // Spanning objects are in both children, so every hit on the near side is found by the near child and vice versa
+    const bool crosses_plane = (direction_along_normal != 0.0) && (origin_distance != 0.0);
+    const double t_split = crosses_plane ? (-origin_distance / direction_along_normal) : infinity;
+    const double t_tolerance = SPLIT_T_TOLERANCE * (1.0 + std::abs(t_split));
+
+    // Interval ends before the plane, only near side is reachable
+    if (t_split < 0.0 || t_split - t_tolerance > ray_t.m_max)
+    {
+        return first->HitDeferred(ray, ray_t, out_result);
+    }
+
+    // Interval starts after the plane, only far side is reachable
+    if (t_split + t_tolerance < ray_t.m_min)
+    {
+        return second->HitDeferred(ray, ray_t, out_result);
+    }
 
-    IRayHittable* first = origin_in_front ? m_front : m_back;
-    IRayHittable* second = origin_in_front ? m_back : m_front;
+    // Any near side hit is closer than everything on the far side
+    if (first->HitDeferred(ray, Interval(ray_t.m_min, std::min(ray_t.m_max, t_split + t_tolerance)), out_result))
+    {
+        return true;
+    }
 
-    const bool hit_first = first->Hit(ray, ray_t, out_result);
-    const bool hit_second = second->Hit(ray, Interval(ray_t.m_min, hit_first ? out_result.m_t : ray_t.m_max), out_result);
+    return second->HitDeferred(ray, Interval(std::max(ray_t.m_min, t_split - t_tolerance), ray_t.m_max), out_result);
+}
 
-    return hit_first || hit_second;
+bool BSPTreeNode::HitAny(const Ray& ray, Interval ray_t) const
+{
+    if (!m_bounding_box.Hit(ray, ray_t))
+    {
+        return false;
+    }
+
+    RecordNodeTraversal();
+
+    if (m_front == nullptr)
+    {
+        return m_primitive_store->HitAny(m_primitives, m_num_primitives, ray, ray_t);
+    }
+
+    // Any hit ends the query, so neither side needs to be visited first
+    return m_front->HitAny(ray, ray_t) || m_back->HitAny(ray, ray_t);
 }
 
 AABB BSPTreeNode::BoundingBox() const
@@ -276,7 +635,12 @@ AABB BSPTreeNode::BoundingBox() const
 
 std::size_t BSPTreeNode::MemoryUsedBytes() const
 {
-    return m_allocator ? m_allocator->MemoryUsedBytes() : 0;
+    return m_allocator ? m_allocator->MemoryUsedBytes() + m_primitive_store->MemoryUsedBytes() : 0;
+}
+
+const PrimitiveStore& BSPTreeNode::GetPrimitiveStore() const
+{
+    return *m_primitive_store;
 }
 
 } // namespace ART
@@ -3,6 +3,7 @@
 
 #include <Core/ArenaAllocator.h>
 #include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
 #include <Maths/Interval.h>
 #include <Maths/Vec3.h>
 #include <RayTracing/IRayHittable.h>
@@ -13,6 +14,7 @@ namespace ART
 
 // Represents an arbritrary splitting plane
 // with equation: normal . p = distance
+// A zero normal marks a node whose children aren't separated by its plane
 struct BSPSplitPlane
 {
 public:
@@ -21,6 +23,8 @@ public:
 
     BSPSplitPlane() : m_normal(1.0, 0.0, 0.0), m_distance(0.0) {}
     BSPSplitPlane(const Vec3& normal, double distance) : m_normal(normal), m_distance(distance) {}
+
+    bool SeparatesChildren() const { return m_normal.m_x != 0.0 || m_normal.m_y != 0.0 || m_normal.m_z != 0.0; }
 };
 
 enum class BSPObjectClassification
@@ -30,43 +34,100 @@ enum class BSPObjectClassification
     FRONT
 };
 
+// Where candidate split plane normals come from
+enum class BSPSplitNormals
+{
+    // The three axes and four fixed diagonals
+    FIXED,
+    // The three axes, the principal axes of each node's object centroids, and the clustered normals of flat patches of objects
+    DATA_DRIVEN
+};
+
+struct BSPBuildSettings
+{
+public:
+    BSPSplitNormals split_normals = BSPSplitNormals::FIXED;
+    // Max number of normals scored per node in DATA_DRIVEN mode, the axes always come first
+    std::size_t candidate_budget = DEFAULT_CANDIDATE_BUDGET;
+
+    static constexpr std::size_t MIN_CANDIDATE_BUDGET = 3;
+    static constexpr std::size_t MAX_CANDIDATE_BUDGET = 16;
+    static constexpr std::size_t DEFAULT_CANDIDATE_BUDGET = 8;
+};
+
 class BSPTreeNode : public IRayHittable
 {
 public:
-    BSPTreeNode(std::vector<IRayHittable*>& objects);
+    BSPTreeNode(std::vector<IRayHittable*>& objects, const BSPBuildSettings& settings = BSPBuildSettings());
 
     ~BSPTreeNode();
 
-    bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+    // Can't be copied, the root owns and frees the arena and primitive store every node points into
+    BSPTreeNode(const BSPTreeNode&) = delete;
+    BSPTreeNode& operator=(const BSPTreeNode&) = delete;
+
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
 
     AABB BoundingBox() const override;
 
     std::size_t MemoryUsedBytes() const;
 
-    BSPTreeNode(IRayHittable** objects, std::size_t count, std::size_t depth, ArenaAllocator& allocator);
+    // Primitive data in the order of the constructor's objects, shared by every node
+    const PrimitiveStore& GetPrimitiveStore() const;
+
+    // object_indices index the objects that built primitive_store, whose bounding boxes are object_boxes
+    // Leaves overwrite their indices with the objects' ids and keep pointing at them, so they must live as long as the tree
+    BSPTreeNode(uint32_t* object_indices, std::size_t count, std::size_t depth, ArenaAllocator& allocator, const PrimitiveStore& primitive_store, const AABB* object_boxes, const BSPBuildSettings& settings = BSPBuildSettings());
+
+    // Candidate normals for DATA_DRIVEN mode from the objects of object_indices, returns how many were written to out_normals
+    static std::size_t FindCandidateNormals(const AABB* object_boxes, const uint32_t* object_indices, std::size_t count, std::size_t candidate_budget, Vec3 out_normals[]);
+
+    static constexpr std::size_t MAX_CANDIDATE_NORMALS = BSPBuildSettings::MAX_CANDIDATE_BUDGET;
+
+    // Surface area of the part of box in front of plane, or behind it if keep_front is false
+    static double ClippedSurfaceArea(const AABB& box, const BSPSplitPlane& plane, bool keep_front);
 
 protected:
-    void Create(IRayHittable** objects, std::size_t count, std::size_t depth, ArenaAllocator& allocator);
+    void Create(uint32_t* object_indices, std::size_t count, std::size_t depth, ArenaAllocator& allocator, const PrimitiveStore& primitive_store, const AABB* object_boxes, const BSPBuildSettings& settings);
 
     // Find optimal split plane using surface area heuristic
-    bool FindSplitPlane(IRayHittable** objects, std::size_t count, BSPSplitPlane& out_plane);
+    bool FindSplitPlane(const uint32_t* object_indices, std::size_t count, const AABB* object_boxes, const BSPBuildSettings& settings, BSPSplitPlane& out_plane);
 
     // Classify object relative to split plane
     BSPObjectClassification ClassifyObject(const AABB& box, const BSPSplitPlane& plane) const;
 
     AABB m_bounding_box;
+    // Only root node owns allocator and primitive store
     ArenaAllocator* m_allocator = nullptr;
-    IRayHittable* m_front = nullptr;
-    IRayHittable* m_back = nullptr;
+    const PrimitiveStore* m_primitive_store = nullptr;
+    // Interior nodes only
+    BSPTreeNode* m_front = nullptr;
+    BSPTreeNode* m_back = nullptr;
     BSPSplitPlane m_split_plane;
+    // Leaf nodes only, tested together through the store
+    const PrimitiveId* m_primitives = nullptr;
+    std::size_t m_num_primitives = 0;
 
 
     static constexpr double NODE_TRAVERSAL_COST = 1.0;
     static constexpr double HITTABLE_INTERSECT_COST = 1.0;
     static constexpr double FP_TOLERANCE = 1e-10;
+    // Relative slack on the ray's split distance, so hits right on the plane are found by whichever child owns them
+    static constexpr double SPLIT_T_TOLERANCE = 1e-9;
     static constexpr std::size_t MAX_DEPTH = 20;
     static constexpr std::size_t MAX_OBJECTS_PER_LEAF = 4;
     static constexpr std::size_t NUM_SAH_BUCKETS = 12;
+    // Patches of objects whose centroids are fitted with a plane, to find wall orientations inside a node
+    static constexpr std::size_t MAX_PATCHES = 8;
+    static constexpr std::size_t MIN_OBJECTS_PER_PATCH = 8;
+    // A patch is flat if its thinnest direction has less than this fraction of the variance of the next
+    static constexpr double PATCH_FLATNESS_RATIO = 0.1;
+    // Patch normals within about 15 degrees of each other are merged into one orientation
+    static constexpr double PATCH_CLUSTER_COSINE = 0.966;
+    // Candidates closer than this to an existing one add nothing
+    static constexpr double DUPLICATE_NORMAL_COSINE = 0.999;
 };
 
 } // namespace ART
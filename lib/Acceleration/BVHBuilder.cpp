@@ -0,0 +1,417 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/BVHBuilder.h>
+
+#include <algorithm>
+#include <limits>
+
+#include <Acceleration/SplitBucket.h>
+
+namespace ART
+{
+
+// Runs function(chunk_index, begin, end) over num_chunks equal pieces of [start, start + count)
+// Pieces run as OpenMP tasks when there is more than one, so they only run in parallel inside a parallel region
+template <typename Function>
+static void ForEachChunk(std::size_t start, std::size_t count, std::size_t num_chunks, const Function& function)
+{
+    if (num_chunks == 1)
+    {
+        function(0, start, start + count);
+        return;
+    }
+
+    const Function* function_pointer = &function;
+    for (std::size_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+    {
+        const std::size_t begin = start + ((count * chunk_index) / num_chunks);
+        const std::size_t end = start + ((count * (chunk_index + 1)) / num_chunks);
+
+        #pragma omp task firstprivate(function_pointer, chunk_index, begin, end)
+        (*function_pointer)(chunk_index, begin, end);
+    }
+
+    #pragma omp taskwait
+}
+
+// Avoids the out of line Vec3::operator[] in build loops
+static inline double Component(const Vec3& vec, std::size_t axis)
+{
+    return (axis == 0) ? vec.m_x : ((axis == 1) ? vec.m_y : vec.m_z);
+}
+
+// Union of object bounds and of object centroids over a range of refs
+struct RangeBounds
+{
+public:
+    AABB bounding_box;
+    AABB centroid_bounds;
+
+    void Extend(const BVHPrimitiveRef& ref)
+    {
+        bounding_box = AABB(bounding_box, ref.bounding_box);
+        centroid_bounds.m_x = Interval(std::min(centroid_bounds.m_x.m_min, ref.centroid.m_x), std::max(centroid_bounds.m_x.m_max, ref.centroid.m_x));
+        centroid_bounds.m_y = Interval(std::min(centroid_bounds.m_y.m_min, ref.centroid.m_y), std::max(centroid_bounds.m_y.m_max, ref.centroid.m_y));
+        centroid_bounds.m_z = Interval(std::min(centroid_bounds.m_z.m_min, ref.centroid.m_z), std::max(centroid_bounds.m_z.m_max, ref.centroid.m_z));
+    }
+
+    void Extend(const RangeBounds& other)
+    {
+        bounding_box = AABB(bounding_box, other.bounding_box);
+        centroid_bounds = AABB(centroid_bounds, other.centroid_bounds);
+    }
+};
+
+BVHBuilder::BVHBuilder(const std::vector<IRayHittable*>& objects)
+{
+    const std::size_t num_objects = objects.size();
+    if (num_objects == 0)
+    {
+        return;
+    }
+
+    m_refs.resize(num_objects);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t object_index = 0; object_index < static_cast<std::int64_t>(num_objects); object_index++)
+    {
+        BVHPrimitiveRef& ref = m_refs[object_index];
+        ref.object = objects[object_index];
+        ref.bounding_box = ref.object->BoundingBox();
+        ref.centroid = Point3
+        (
+            0.5 * (ref.bounding_box.m_x.m_min + ref.bounding_box.m_x.m_max),
+            0.5 * (ref.bounding_box.m_y.m_min + ref.bounding_box.m_y.m_max),
+            0.5 * (ref.bounding_box.m_z.m_min + ref.bounding_box.m_z.m_max)
+        );
+    }
+
+    if (num_objects >= PARALLEL_SPLIT_THRESHOLD)
+    {
+        m_scratch_refs.resize(num_objects);
+    }
+
+    // Binary tree with at most N leaves has at most 2N-1 nodes
+    m_nodes.resize((2 * num_objects) - 1);
+    m_num_nodes = 1;
+
+    #pragma omp parallel
+    {
+        // One thread starts the build, the rest of the team picks up its tasks
+        #pragma omp single
+        Build(0, 0, num_objects, 1);
+    }
+
+    m_nodes.resize(m_num_nodes);
+
+    m_ordered_objects.resize(num_objects);
+    for (std::size_t object_index = 0; object_index < num_objects; object_index++)
+    {
+        m_ordered_objects[object_index] = m_refs[object_index].object;
+    }
+
+    // Refs are only needed during the build
+    m_refs = std::vector<BVHPrimitiveRef>();
+    m_scratch_refs = std::vector<BVHPrimitiveRef>();
+}
+
+const std::vector<BVHBuildNode>& BVHBuilder::GetNodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<IRayHittable*>& BVHBuilder::GetOrderedObjects() const
+{
+    return m_ordered_objects;
+}
+
+void BVHBuilder::Build(uint32_t node_index, std::size_t start, std::size_t count, std::size_t depth)
+{
+    const std::size_t num_chunks = NumChunks(count);
+
+    RangeBounds range_bounds;
+    if (num_chunks == 1)
+    {
+        for (std::size_t ref_index = start; ref_index < start + count; ref_index++)
+        {
+            range_bounds.Extend(m_refs[ref_index]);
+        }
+    }
+    else
+    {
+        std::vector<RangeBounds> chunk_bounds(num_chunks);
+        ForEachChunk(start, count, num_chunks, [this, &chunk_bounds](std::size_t chunk_index, std::size_t begin, std::size_t end)
+        {
+            for (std::size_t ref_index = begin; ref_index < end; ref_index++)
+            {
+                chunk_bounds[chunk_index].Extend(m_refs[ref_index]);
+            }
+        });
+        for (std::size_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+        {
+            range_bounds.Extend(chunk_bounds[chunk_index]);
+        }
+    }
+
+    BVHBuildNode& node = m_nodes[node_index];
+    node.bounding_box = range_bounds.bounding_box;
+
+    if (count <= MAX_PRIMITIVES_PER_LEAF)
+    {
+        node.offset = static_cast<uint32_t>(start);
+        node.num_primitives = static_cast<uint32_t>(count);
+        return;
+    }
+
+    std::size_t split = (depth < MAX_SAH_DEPTH) ? SplitSAH(start, count, range_bounds.bounding_box, range_bounds.centroid_bounds) : 0;
+
+    // If SAH split fails use fallback method
+    if (split == 0 || split >= count)
+    {
+        split = SplitMedian(start, count, range_bounds.centroid_bounds);
+    }
+
+    // Children are allocated as a pair so the second is always directly after the first
+    const uint32_t first_child_index = m_num_nodes.fetch_add(2);
+    node.offset = first_child_index;
+    node.num_primitives = 0;
+
+    if (count >= SUBTREE_TASK_THRESHOLD)
+    {
+        // Completed at the barrier ending the parallel region in the constructor
+        #pragma omp task firstprivate(first_child_index, start, split, depth)
+        Build(first_child_index, start, split, depth + 1);
+    }
+    else
+    {
+        Build(first_child_index, start, split, depth + 1);
+    }
+    Build(first_child_index + 1, start + split, count - split, depth + 1);
+}
+
+std::size_t BVHBuilder::SplitSAH(std::size_t start, std::size_t count, const AABB& bounding_box, const AABB& centroid_bounds)
+{
+    struct Bins
+    {
+        SplitBucket buckets[3][NUM_SAH_BUCKETS];
+    };
+
+    double min_centroid[3];
+    double extent[3];
+    bool axis_has_extent[3];
+    bool any_axis_has_extent = false;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        static constexpr double fp_tolerance = 1e-10;
+        min_centroid[axis] = centroid_bounds[axis].m_min;
+        extent[axis] = centroid_bounds[axis].Size();
+        axis_has_extent[axis] = extent[axis] >= fp_tolerance;
+        any_axis_has_extent = any_axis_has_extent || axis_has_extent[axis];
+    }
+
+    if (!any_axis_has_extent)
+    {
+        return 0;
+    }
+
+    auto bucket_index_of = [&min_centroid, &extent](const BVHPrimitiveRef& ref, std::size_t axis)
+    {
+        const std::size_t bucket_index = static_cast<std::size_t>(NUM_SAH_BUCKETS * ((Component(ref.centroid, axis) - min_centroid[axis]) / extent[axis]));
+        return std::min(bucket_index, NUM_SAH_BUCKETS - 1);
+    };
+
+    auto bin_range = [this, &axis_has_extent, &bucket_index_of](Bins& bins, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t ref_index = begin; ref_index < end; ref_index++)
+        {
+            const BVHPrimitiveRef& ref = m_refs[ref_index];
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                if (axis_has_extent[axis])
+                {
+                    SplitBucket& bucket = bins.buckets[axis][bucket_index_of(ref, axis)];
+                    bucket.num_hittables++;
+                    bucket.bounding_box = AABB(bucket.bounding_box, ref.bounding_box);
+                }
+            }
+        }
+    };
+
+    // Assign refs to buckets
+    const std::size_t num_chunks = NumChunks(count);
+    Bins bins;
+    if (num_chunks == 1)
+    {
+        bin_range(bins, start, start + count);
+    }
+    else
+    {
+        std::vector<Bins> chunk_bins(num_chunks);
+        ForEachChunk(start, count, num_chunks, [&chunk_bins, &bin_range](std::size_t chunk_index, std::size_t begin, std::size_t end)
+        {
+            bin_range(chunk_bins[chunk_index], begin, end);
+        });
+        for (std::size_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+        {
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                for (std::size_t bucket_index = 0; bucket_index < NUM_SAH_BUCKETS; bucket_index++)
+                {
+                    const SplitBucket& chunk_bucket = chunk_bins[chunk_index].buckets[axis][bucket_index];
+                    bins.buckets[axis][bucket_index].num_hittables += chunk_bucket.num_hittables;
+                    bins.buckets[axis][bucket_index].bounding_box = AABB(bins.buckets[axis][bucket_index].bounding_box, chunk_bucket.bounding_box);
+                }
+            }
+        }
+    }
+
+    const double parent_node_surface_area = bounding_box.SurfaceArea();
+    const double leaf_cost = count * HITTABLE_INTERSECT_COST;
+
+    double best_cost = std::numeric_limits<double>::max();
+    std::size_t best_axis = 0;
+    std::size_t best_bucket = 0;
+
+    // Evaluate split positions, sweeping left to right then right to left
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        if (!axis_has_extent[axis])
+        {
+            continue;
+        }
+
+        const SplitBucket* buckets = bins.buckets[axis];
+
+        // Bounds of buckets [0, split) for split in [1, NUM_SAH_BUCKETS)
+        AABB left_bounding_boxes[NUM_SAH_BUCKETS];
+        std::size_t left_num_hittables[NUM_SAH_BUCKETS] = {};
+        AABB left_bounding_box;
+        std::size_t left_count = 0;
+        for (std::size_t split = 1; split < NUM_SAH_BUCKETS; split++)
+        {
+            left_bounding_box = AABB(left_bounding_box, buckets[split - 1].bounding_box);
+            left_count += buckets[split - 1].num_hittables;
+            left_bounding_boxes[split] = left_bounding_box;
+            left_num_hittables[split] = left_count;
+        }
+
+        AABB right_bounding_box;
+        std::size_t right_count = 0;
+        for (std::size_t split = NUM_SAH_BUCKETS - 1; split >= 1; split--)
+        {
+            right_bounding_box = AABB(right_bounding_box, buckets[split].bounding_box);
+            right_count += buckets[split].num_hittables;
+
+            if (left_num_hittables[split] == 0 || right_count == 0)
+            {
+                continue;
+            }
+
+            const double cost_of_left_subtree = (left_bounding_boxes[split].SurfaceArea() / parent_node_surface_area) * left_num_hittables[split] * HITTABLE_INTERSECT_COST;
+            const double cost_of_right_subtree = (right_bounding_box.SurfaceArea() / parent_node_surface_area) * right_count * HITTABLE_INTERSECT_COST;
+            const double total_cost = NODE_TRAVERSAL_COST + cost_of_left_subtree + cost_of_right_subtree;
+
+            if (total_cost < best_cost)
+            {
+                best_cost = total_cost;
+                best_axis = axis;
+                best_bucket = split;
+            }
+        }
+    }
+
+    // No worthwhile split found
+    if (best_cost >= leaf_cost)
+    {
+        return 0;
+    }
+
+    // Partition by bucket rather than by position so the sides match the bucket counts exactly
+    auto goes_left = [best_axis, best_bucket, &bucket_index_of](const BVHPrimitiveRef& ref)
+    {
+        return bucket_index_of(ref, best_axis) < best_bucket;
+    };
+
+    if (num_chunks == 1)
+    {
+        const auto mid = std::partition(m_refs.begin() + start, m_refs.begin() + start + count, goes_left);
+        return static_cast<std::size_t>(mid - (m_refs.begin() + start));
+    }
+
+    // Parallel partition: count each chunk's sides, then scatter chunks to their offsets and copy back
+    std::vector<std::size_t> chunk_num_left(num_chunks, 0);
+    ForEachChunk(start, count, num_chunks, [this, &chunk_num_left, &goes_left](std::size_t chunk_index, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t ref_index = begin; ref_index < end; ref_index++)
+        {
+            chunk_num_left[chunk_index] += goes_left(m_refs[ref_index]) ? 1 : 0;
+        }
+    });
+
+    std::size_t num_left = 0;
+    for (std::size_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+    {
+        num_left += chunk_num_left[chunk_index];
+    }
+
+    std::vector<std::size_t> chunk_left_offset(num_chunks);
+    std::vector<std::size_t> chunk_right_offset(num_chunks);
+    std::size_t left_offset = start;
+    std::size_t right_offset = start + num_left;
+    for (std::size_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+    {
+        const std::size_t chunk_begin = start + ((count * chunk_index) / num_chunks);
+        const std::size_t chunk_end = start + ((count * (chunk_index + 1)) / num_chunks);
+        chunk_left_offset[chunk_index] = left_offset;
+        chunk_right_offset[chunk_index] = right_offset;
+        left_offset += chunk_num_left[chunk_index];
+        right_offset += (chunk_end - chunk_begin) - chunk_num_left[chunk_index];
+    }
+
+    ForEachChunk(start, count, num_chunks, [this, &chunk_left_offset, &chunk_right_offset, &goes_left](std::size_t chunk_index, std::size_t begin, std::size_t end)
+    {
+        std::size_t left_index = chunk_left_offset[chunk_index];
+        std::size_t right_index = chunk_right_offset[chunk_index];
+        for (std::size_t ref_index = begin; ref_index < end; ref_index++)
+        {
+            if (goes_left(m_refs[ref_index]))
+            {
+                m_scratch_refs[left_index++] = m_refs[ref_index];
+            }
+            else
+            {
+                m_scratch_refs[right_index++] = m_refs[ref_index];
+            }
+        }
+    });
+
+    ForEachChunk(start, count, num_chunks, [this](std::size_t chunk_index, std::size_t begin, std::size_t end)
+    {
+        std::copy(m_scratch_refs.begin() + begin, m_scratch_refs.begin() + end, m_refs.begin() + begin);
+    });
+
+    return num_left;
+}
+
+std::size_t BVHBuilder::SplitMedian(std::size_t start, std::size_t count, const AABB& centroid_bounds)
+{
+    const std::size_t axis = centroid_bounds.LongestAxis();
+    const std::size_t split = count / 2;
+
+    std::nth_element
+    (
+        m_refs.begin() + start, m_refs.begin() + start + split, m_refs.begin() + start + count,
+        [axis](const BVHPrimitiveRef& a, const BVHPrimitiveRef& b)
+        {
+            return Component(a.centroid, axis) < Component(b.centroid, axis);
+        }
+    );
+
+    return split;
+}
+
+std::size_t BVHBuilder::NumChunks(std::size_t count)
+{
+    return (count >= PARALLEL_SPLIT_THRESHOLD) ? (count / PARALLEL_CHUNK_SIZE) : 1;
+}
+
+} // namespace ART
@@ -0,0 +1,83 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <atomic>
+
+#include <Core/Common.h>
+#include <Geometry/AxisAlignedBoundingBox.h>
+#include <Maths/Vec3.h>
+#include <RayTracing/IRayHittable.h>
+
+namespace ART
+{
+
+// Object bounds and centroid, computed once so the build never calls IRayHittable::BoundingBox() again
+struct BVHPrimitiveRef
+{
+public:
+    AABB bounding_box;
+    Point3 centroid;
+    IRayHittable* object = nullptr;
+};
+
+// Node of the binary tree produced by BVHBuilder
+struct BVHBuildNode
+{
+public:
+    AABB bounding_box;
+    // Interior: index of first child, second child is always the next node
+    // Leaf: index of first object in the ordered object array
+    uint32_t offset = 0;
+    // Zero for interior nodes
+    uint32_t num_primitives = 0;
+};
+
+// Binned SAH build shared by BVHNode and FlatBVH
+// Large ranges are binned and partitioned in parallel chunks, large subtrees are built as OpenMP tasks
+class BVHBuilder
+{
+public:
+    BVHBuilder(const std::vector<IRayHittable*>& objects);
+
+    // Root is the first node, empty if there were no objects
+    const std::vector<BVHBuildNode>& GetNodes() const;
+
+    // Objects reordered so each leaf references a contiguous range
+    const std::vector<IRayHittable*>& GetOrderedObjects() const;
+
+    static constexpr std::size_t MAX_PRIMITIVES_PER_LEAF = 2;
+    // Past this depth splits fall back to median, which bounds the tree depth by MAX_SAH_DEPTH + log2(N)
+    static constexpr std::size_t MAX_SAH_DEPTH = 32;
+
+protected:
+    // Builds the subtree for m_refs[start, start + count) into m_nodes[node_index]
+    void Build(uint32_t node_index, std::size_t start, std::size_t count, std::size_t depth);
+
+    // Partitions m_refs[start, start + count) using surface-area heuristic
+    // Returns number of refs in the first child, 0 if no beneficial split found
+    std::size_t SplitSAH(std::size_t start, std::size_t count, const AABB& bounding_box, const AABB& centroid_bounds);
+
+    // Fallback if SplitSAH couldn't find good split, halves the range along the longest centroid axis
+    std::size_t SplitMedian(std::size_t start, std::size_t count, const AABB& centroid_bounds);
+
+    // Number of chunks to process a range of count refs in
+    static std::size_t NumChunks(std::size_t count);
+
+    std::vector<BVHPrimitiveRef> m_refs;
+    // Destination of parallel partitions
+    std::vector<BVHPrimitiveRef> m_scratch_refs;
+    std::vector<BVHBuildNode> m_nodes;
+    std::atomic<uint32_t> m_num_nodes{0};
+    std::vector<IRayHittable*> m_ordered_objects;
+
+    static constexpr double NODE_TRAVERSAL_COST = 1.0;
+    static constexpr double HITTABLE_INTERSECT_COST = 1.0;
+    static constexpr std::size_t NUM_SAH_BUCKETS = 12;
+    // Ranges at least this large are bounded, binned and partitioned in parallel
+    static constexpr std::size_t PARALLEL_SPLIT_THRESHOLD = 1 << 16;
+    static constexpr std::size_t PARALLEL_CHUNK_SIZE = 1 << 14;
+    // Subtrees at least this large are built as separate tasks
+    static constexpr std::size_t SUBTREE_TASK_THRESHOLD = 1 << 12;
+};
+
+} // namespace ART
@@ -1,8 +1,7 @@
 // Copyright Mia Rolfe. All rights reserved.
 #include <Acceleration/BoundingVolumeHierarchy.h>
 
-#include <algorithm>
-#include <limits>
+#include <bitset>
 
 #include <Core/TraversalStats.h>
 #include <RayTracing/IRayHittable.h>
@@ -18,208 +17,184 @@ BVHNode::BVHNode(std::vector<IRayHittable*>& objects)
     const std::size_t arena_size = (2 * objects.size()) * sizeof(BVHNode);
     m_allocator = new ArenaAllocator(arena_size);
 
-    Create(objects.data(), objects.size(), *m_allocator);
+    // Store is built in the builder's object order, so each leaf's objects are a range of its ids
+    const BVHBuilder builder(objects);
+    PrimitiveStore* primitive_store = new PrimitiveStore(builder.GetOrderedObjects());
+    m_primitive_store = primitive_store;
+    if (!builder.GetNodes().empty())
+    {
+        Create(builder, 0, *m_allocator, *primitive_store);
+    }
 }
 
-BVHNode::BVHNode(IRayHittable** objects, std::size_t count, ArenaAllocator& allocator)
+BVHNode::BVHNode(const BVHBuilder& builder, uint32_t build_node_index, ArenaAllocator& allocator, const PrimitiveStore& primitive_store)
     : m_allocator(nullptr), m_left(nullptr), m_right(nullptr)
 {
-    Create(objects, count, allocator);
+    Create(builder, build_node_index, allocator, primitive_store);
 }
 
 BVHNode::~BVHNode()
 {
-    // Only root node owns and deletes allocator
+    // Only root node owns and deletes allocator and primitive store
     if (m_allocator)
     {
+        delete m_primitive_store;
+        m_primitive_store = nullptr;
         delete m_allocator;
         m_allocator = nullptr;
     }
 }
 
-void BVHNode::Create(IRayHittable** objects, std::size_t count, ArenaAllocator& allocator)
+void BVHNode::Create(const BVHBuilder& builder, uint32_t build_node_index, ArenaAllocator& allocator, const PrimitiveStore& primitive_store)
 {
-    // Compute bounding box for all objects
-    for (std::size_t object_index = 0; object_index < count; object_index++)
-    {
-        m_bounding_box = AABB(m_bounding_box, objects[object_index]->BoundingBox());
-    }
+    const BVHBuildNode& build_node = builder.GetNodes()[build_node_index];
+    m_bounding_box = build_node.bounding_box;
+    m_primitive_store = &primitive_store;
 
-    // Only one object, store directly as leaf
-    if (count == 1)
+    // Leaves reference their range of the ordered objects
+    if (build_node.num_primitives > 0)
     {
-        m_left = objects[0];
-        m_right = nullptr;
+        m_primitive_offset = build_node.offset;
+        m_num_primitives = build_node.num_primitives;
         return;
     }
 
-    // Two objects, store directly as leaves
-    if (count == 2)
+    m_left = allocator.Create<BVHNode>(builder, build_node.offset, allocator, primitive_store);
+    m_right = allocator.Create<BVHNode>(builder, build_node.offset + 1, allocator, primitive_store);
+}
+
+bool BVHNode::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    if (!m_bounding_box.Hit(ray, ray_t))
     {
-        m_left = objects[0];
-        m_right = objects[1];
-        return;
+        return false;
     }
 
-    std::size_t split = SplitSAH(objects, count);
+    RecordNodeTraversal();
+
+    return HitChildren(ray, ray_t, out_result);
+}
 
-    // If SAH split fails use fallback method
-    if (split == 0 || split >= count)
+bool BVHNode::HitChildren(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    if (m_left == nullptr)
     {
-        split = SplitLongestAxis(objects, count);
+        return m_primitive_store->Hit(m_primitive_store->GetIds() + m_primitive_offset, m_num_primitives, ray, ray_t, out_result);
     }
 
-    m_left = allocator.Create<BVHNode>(objects, split, allocator);
-    m_right = allocator.Create<BVHNode>(objects + split, count - split, allocator);
+    // Find closest hit of child nodes
+    const bool hit_left = m_left->HitDeferred(ray, ray_t, out_result);
+    const bool hit_right = m_right->HitDeferred(ray, Interval(ray_t.m_min, hit_left ? out_result.m_t : ray_t.m_max), out_result);
+
+    return hit_left || hit_right;
 }
 
-std::size_t BVHNode::SplitSAH(IRayHittable** objects, std::size_t count)
+bool BVHNode::HitAny(const Ray& ray, Interval ray_t) const
 {
-    const double parent_node_surface_area = m_bounding_box.SurfaceArea();
-    const double leaf_cost = count * HITTABLE_INTERSECT_COST;
+    if (!m_bounding_box.Hit(ray, ray_t))
+    {
+        return false;
+    }
 
-    double best_cost = std::numeric_limits<double>::max();
-    double best_split_pos_along_best_axis = 0.0;
-    std::size_t best_axis = 0;
-    std::size_t best_bucket = 0;
+    RecordNodeTraversal();
 
-    // Evaluate SAH for each axis
-    for (std::size_t axis = 0; axis < 3; axis++)
+    if (m_left == nullptr)
     {
-        double min_centroid = std::numeric_limits<double>::max();
-        double max_centroid = std::numeric_limits<double>::lowest();
+        return m_primitive_store->HitAny(m_primitive_store->GetIds() + m_primitive_offset, m_num_primitives, ray, ray_t);
+    }
 
-        for (std::size_t object_index = 0; object_index < count; object_index++)
-        {
-            const Interval interval = objects[object_index]->BoundingBox()[axis];
-            const double centroid = 0.5 * (interval.m_min + interval.m_max);
-            min_centroid = std::min(min_centroid, centroid);
-            max_centroid = std::max(max_centroid, centroid);
-        }
+    return m_left->HitAny(ray, ray_t) || m_right->HitAny(ray, ray_t);
+}
 
-        const double extent = max_centroid - min_centroid;
-        static constexpr double fp_tolerance = 1e-10;
-        if (extent < fp_tolerance)
-        {
-            continue;
-        }
+RayMask BVHNode::HitPacketDeferred(const RayPacket& packet, RayMask active_rays, double ray_t_min, double* ray_t_max, RayHitResult* out_results) const
+{
+    if (!packet.m_is_coherent)
+    {
+        return IRayHittable::HitPacketDeferred(packet, active_rays, ray_t_min, ray_t_max, out_results);
+    }
 
-        // Assign objects to buckets
-        SplitBucket buckets[NUM_SAH_BUCKETS];
-        for (std::size_t object_index = 0; object_index < count; object_index++)
-        {
-            const Interval interval = objects[object_index]->BoundingBox()[axis];
-            const double centroid = 0.5 * (interval.m_min + interval.m_max);
-            std::size_t bucket_index = static_cast<std::size_t>(NUM_SAH_BUCKETS * ((centroid - min_centroid) / extent));
-            if (bucket_index >= NUM_SAH_BUCKETS)
-            {
-                bucket_index = NUM_SAH_BUCKETS - 1;
-            }
-            buckets[bucket_index].num_hittables++;
-            buckets[bucket_index].bounding_box = AABB(buckets[bucket_index].bounding_box, objects[object_index]->BoundingBox());
-        }
+    const double box_min[3] = { m_bounding_box.m_x.m_min, m_bounding_box.m_y.m_min, m_bounding_box.m_z.m_min };
+    const double box_max[3] = { m_bounding_box.m_x.m_max, m_bounding_box.m_y.m_max, m_bounding_box.m_z.m_max };
+    if (!packet.MayHitBox(box_min, box_max, ray_t_min, packet.MaxRayT(active_rays, ray_t_max)))
+    {
+        return 0;
+    }
 
-        // Evaluate split positions
-        for (std::size_t split = 1; split < NUM_SAH_BUCKETS; split++)
+    // Leaf, test each ray against the box before its primitives
+    if (m_left == nullptr)
+    {
+        std::size_t num_node_rays = 0;
+        RayMask hit_rays = 0;
+        for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
         {
-            AABB left_bounding_box;
-            AABB right_bounding_box;
-            std::size_t left_num_hittables = 0;
-            std::size_t right_num_hittables = 0;
-
-            for (std::size_t bucket_index = 0; bucket_index < split; bucket_index++)
-            {
-                if (buckets[bucket_index].num_hittables > 0)
-                {
-                    left_bounding_box = AABB(left_bounding_box, buckets[bucket_index].bounding_box);
-                    left_num_hittables += buckets[bucket_index].num_hittables;
-                }
-            }
-            for (std::size_t bucket_index = split; bucket_index < NUM_SAH_BUCKETS; bucket_index++)
-            {
-                if (buckets[bucket_index].num_hittables > 0)
-                {
-                    right_bounding_box = AABB(right_bounding_box, buckets[bucket_index].bounding_box);
-                    right_num_hittables += buckets[bucket_index].num_hittables;
-                }
-            }
-
-            if (left_num_hittables == 0 || right_num_hittables == 0)
+            const RayMask ray_bit = RayMask(1) << ray_index;
+            const Ray& ray = packet.m_rays[ray_index];
+            if (!(active_rays & ray_bit) || !m_bounding_box.Hit(ray, Interval(ray_t_min, ray_t_max[ray_index])))
             {
                 continue;
             }
 
-            const double cost_of_left_subtree = (left_bounding_box.SurfaceArea() / parent_node_surface_area) * left_num_hittables * HITTABLE_INTERSECT_COST;
-            const double cost_of_right_subtree = (right_bounding_box.SurfaceArea() / parent_node_surface_area) * right_num_hittables * HITTABLE_INTERSECT_COST;
-            const double total_cost = NODE_TRAVERSAL_COST + cost_of_left_subtree + cost_of_right_subtree;
-
-            if (total_cost < best_cost)
+            num_node_rays++;
+            if (m_primitive_store->Hit(m_primitive_store->GetIds() + m_primitive_offset, m_num_primitives, ray, Interval(ray_t_min, ray_t_max[ray_index]), out_results[ray_index]))
             {
-                best_cost = total_cost;
-                best_axis = axis;
-                best_bucket = split;
-                best_split_pos_along_best_axis = min_centroid + (split * extent / NUM_SAH_BUCKETS);
+                ray_t_max[ray_index] = out_results[ray_index].m_t;
+                hit_rays |= ray_bit;
             }
         }
-    }
 
-    // No worthwhile split found
-    if (best_cost >= leaf_cost)
-    {
-        return 0;
+        RecordPacketNodeTraversal(packet.m_size, num_node_rays);
+        return hit_rays;
     }
 
-    // Partition objects at the best split position
-    IRayHittable** mid = std::partition
-    (
-        objects, objects + count,
-        [best_axis, best_split_pos_along_best_axis](IRayHittable* obj)
+    // Interior node, accepted for the packet as soon as one ray hits its box
+    // Rays before that one missed and are dropped, the rest are carried into the children untested
+    RayMask node_rays = active_rays;
+    for (std::size_t ray_index = 0; ray_index < packet.m_size && node_rays != 0; ray_index++)
+    {
+        const RayMask ray_bit = RayMask(1) << ray_index;
+        if (!(node_rays & ray_bit))
         {
-            const Interval interval = obj->BoundingBox()[best_axis];
-            return 0.5 * (interval.m_min + interval.m_max) < best_split_pos_along_best_axis;
+            continue;
         }
-    );
-
-    const std::size_t split_index = static_cast<std::size_t>(mid - objects);
-    return split_index;
-}
-
-std::size_t BVHNode::SplitLongestAxis(IRayHittable** objects, std::size_t count)
-{
-    const std::size_t axis = m_bounding_box.LongestAxis();
-
-    std::sort(objects, objects + count, [axis](IRayHittable* a, IRayHittable* b)
-    {
-        const Interval a_interval = a->BoundingBox()[axis];
-        const Interval b_interval = b->BoundingBox()[axis];
-        // Cheaper but equivalent for sorting comparison to comparing (2 * a_centroid) to (2 * b_centroid)
-        return (a_interval.m_min + a_interval.m_max) < (b_interval.m_min + b_interval.m_max);
-    });
-
-    const std::size_t split_index = count / 2;
-    return split_index;
-}
+        if (m_bounding_box.Hit(packet.m_rays[ray_index], Interval(ray_t_min, ray_t_max[ray_index])))
+        {
+            break;
+        }
+        node_rays &= ~ray_bit;
+    }
 
-bool BVHNode::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
-{
-    if (!m_bounding_box.Hit(ray, ray_t))
+    if (node_rays == 0)
     {
-        return false;
+        return 0;
     }
 
-    RecordNodeTraversal();
+    const std::size_t num_node_rays = std::bitset<RayPacket::MAX_SIZE>(node_rays).count();
+    RecordPacketNodeTraversal(packet.m_size, num_node_rays);
 
-    // Leaf nodes with only child
-    if (m_right == nullptr)
+    if (num_node_rays >= RayPacket::MIN_ACTIVE_RAYS)
     {
-        return m_left->Hit(ray, ray_t, out_result);
+        const RayMask hit_rays = m_left->HitPacketDeferred(packet, node_rays, ray_t_min, ray_t_max, out_results);
+        return hit_rays | m_right->HitPacketDeferred(packet, node_rays, ray_t_min, ray_t_max, out_results);
     }
 
-    // Find closest hit of child nodes
-    const bool hit_left = m_left->Hit(ray, ray_t, out_result);
-    const bool hit_right = m_right->Hit(ray, Interval(ray_t.m_min, hit_left ? out_result.m_t : ray_t.m_max), out_result);
+    // Too few rays left to share the node tests, finish the subtree one ray at a time
+    RayMask hit_rays = 0;
+    for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
+    {
+        const RayMask ray_bit = RayMask(1) << ray_index;
+        if (!(node_rays & ray_bit))
+        {
+            continue;
+        }
 
-    return hit_left || hit_right;
+        RayHitResult& result = out_results[ray_index];
+        if (HitChildren(packet.m_rays[ray_index], Interval(ray_t_min, ray_t_max[ray_index]), result))
+        {
+            ray_t_max[ray_index] = result.m_t;
+            hit_rays |= ray_bit;
+        }
+    }
+    return hit_rays;
 }
 
 AABB BVHNode::BoundingBox() const
@@ -229,7 +204,12 @@ AABB BVHNode::BoundingBox() const
 
 std::size_t BVHNode::MemoryUsedBytes() const
 {
-    return m_allocator ? m_allocator->MemoryUsedBytes() : 0;
+    return m_allocator ? m_allocator->MemoryUsedBytes() + m_primitive_store->MemoryUsedBytes() : 0;
+}
+
+const PrimitiveStore& BVHNode::GetPrimitiveStore() const
+{
+    return *m_primitive_store;
 }
 
 } // namespace ART
@@ -1,9 +1,10 @@
 // Copyright Mia Rolfe. All rights reserved.
 #pragma once
 
-#include <Acceleration/SplitBucket.h>
+#include <Acceleration/BVHBuilder.h>
 #include <Core/ArenaAllocator.h>
 #include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
 #include <Maths/Interval.h>
 #include <Maths/Vec3.h>
 #include <RayTracing/IRayHittable.h>
@@ -19,33 +20,45 @@ public:
 
     ~BVHNode();
 
-    bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+    // Can't be copied, the root owns and frees the arena and primitive store every node points into
+    BVHNode(const BVHNode&) = delete;
+    BVHNode& operator=(const BVHNode&) = delete;
+
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    // Culls each node for the whole packet with one interval test and enters it once any ray hits its box
+    // Rays are only tested one at a time against the boxes of leaves
+    RayMask HitPacketDeferred(const RayPacket& packet, RayMask active_rays, double ray_t_min, double* ray_t_max, RayHitResult* out_results) const override;
 
     AABB BoundingBox() const override;
 
     std::size_t MemoryUsedBytes() const;
 
-    BVHNode(IRayHittable** objects, std::size_t count, ArenaAllocator& allocator);
+    // Primitive data in the builder's object order, shared by every node
+    const PrimitiveStore& GetPrimitiveStore() const;
 
-protected:
-    void Create(IRayHittable** objects, std::size_t count, ArenaAllocator& allocator);
+    // Creates the subtree rooted at the builder's node build_node_index
+    // primitive_store holds the builder's ordered objects
+    BVHNode(const BVHBuilder& builder, uint32_t build_node_index, ArenaAllocator& allocator, const PrimitiveStore& primitive_store);
 
-    // Split objects using surface-area heuristic
-    // Returns index of split, 0 if no beneficial split found
-    std::size_t SplitSAH(IRayHittable** objects, std::size_t count);
+protected:
+    void Create(const BVHBuilder& builder, uint32_t build_node_index, ArenaAllocator& allocator, const PrimitiveStore& primitive_store);
 
-    // Fallback if SplitSAH couldn't find good split
-    std::size_t SplitLongestAxis(IRayHittable** objects, std::size_t count);
+    // Hit of the node's leaf primitives or children, once the ray is known to reach its bounds
+    bool HitChildren(const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
 
     AABB m_bounding_box;
-    // Only root node owns allocator
+    // Only root node owns allocator and primitive store
     ArenaAllocator* m_allocator = nullptr;
-    IRayHittable* m_left = nullptr;
-    IRayHittable* m_right = nullptr;
-
-    static constexpr double NODE_TRAVERSAL_COST = 1.0;
-    static constexpr double HITTABLE_INTERSECT_COST = 1.0;
-    static constexpr std::size_t NUM_SAH_BUCKETS = 12;
+    const PrimitiveStore* m_primitive_store = nullptr;
+    // Interior nodes only
+    BVHNode* m_left = nullptr;
+    BVHNode* m_right = nullptr;
+    // Leaf nodes only, a range of the store's ids tested together through the store
+    uint32_t m_primitive_offset = 0;
+    uint32_t m_num_primitives = 0;
 };
 
 } // namespace ART
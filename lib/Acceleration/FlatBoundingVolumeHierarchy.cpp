@@ -0,0 +1,390 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/FlatBoundingVolumeHierarchy.h>
+
+#include <bitset>
+
+#include <Core/TraversalStats.h>
+#include <Core/Utility.h>
+
+namespace ART
+{
+
+// Slab test against a node's single precision bounds, evaluated in double precision
+static inline bool FlatBVHNodeHit(const FlatBVHNode& node, const Ray& ray, double ray_t_min, double ray_t_max)
+{
+    const double t0_x = (static_cast<double>(node.bounds_min[0]) - ray.m_origin.m_x) * ray.m_inverse_direction.m_x;
+    const double t1_x = (static_cast<double>(node.bounds_max[0]) - ray.m_origin.m_x) * ray.m_inverse_direction.m_x;
+    const double t0_y = (static_cast<double>(node.bounds_min[1]) - ray.m_origin.m_y) * ray.m_inverse_direction.m_y;
+    const double t1_y = (static_cast<double>(node.bounds_max[1]) - ray.m_origin.m_y) * ray.m_inverse_direction.m_y;
+    const double t0_z = (static_cast<double>(node.bounds_min[2]) - ray.m_origin.m_z) * ray.m_inverse_direction.m_z;
+    const double t1_z = (static_cast<double>(node.bounds_max[2]) - ray.m_origin.m_z) * ray.m_inverse_direction.m_z;
+
+    const double t_near_x = t0_x < t1_x ? t0_x : t1_x;
+    const double t_far_x  = t0_x > t1_x ? t0_x : t1_x;
+    const double t_near_y = t0_y < t1_y ? t0_y : t1_y;
+    const double t_far_y  = t0_y > t1_y ? t0_y : t1_y;
+    const double t_near_z = t0_z < t1_z ? t0_z : t1_z;
+    const double t_far_z  = t0_z > t1_z ? t0_z : t1_z;
+
+    ray_t_min = t_near_x > ray_t_min ? t_near_x : ray_t_min;
+    ray_t_min = t_near_y > ray_t_min ? t_near_y : ray_t_min;
+    ray_t_min = t_near_z > ray_t_min ? t_near_z : ray_t_min;
+
+    ray_t_max = t_far_x < ray_t_max ? t_far_x : ray_t_max;
+    ray_t_max = t_far_y < ray_t_max ? t_far_y : ray_t_max;
+    ray_t_max = t_far_z < ray_t_max ? t_far_z : ray_t_max;
+
+    return ray_t_min <= ray_t_max;
+}
+
+FlatBVH::FlatBVH(std::vector<IRayHittable*>& objects)
+{
+    if (objects.empty())
+    {
+        return;
+    }
+
+    const BVHBuilder builder(objects);
+    Initialise(builder.GetNodes(), builder.GetOrderedObjects());
+}
+
+void FlatBVH::Initialise(const std::vector<BVHBuildNode>& build_nodes, const std::vector<IRayHittable*>& ordered_objects)
+{
+    if (build_nodes.empty())
+    {
+        return;
+    }
+
+    m_bounding_box = build_nodes[0].bounding_box;
+    m_primitive_store = PrimitiveStore(ordered_objects);
+    m_primitives.resize(ordered_objects.size());
+    for (std::size_t primitive_index = 0; primitive_index < ordered_objects.size(); primitive_index++)
+    {
+        m_primitives[primitive_index] = m_primitive_store.GetId(primitive_index);
+    }
+
+    m_nodes.reserve(build_nodes.size());
+    Flatten(build_nodes, 0);
+}
+
+uint32_t FlatBVH::Flatten(const std::vector<BVHBuildNode>& build_nodes, uint32_t build_node_index)
+{
+    const BVHBuildNode& build_node = build_nodes[build_node_index];
+
+    const uint32_t node_index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    // Can't hold references into m_nodes across recursion, emplace_back may reallocate
+    FlatBVHNode node{};
+    node.bounds_min[0] = RoundDownToFloat(build_node.bounding_box.m_x.m_min);
+    node.bounds_min[1] = RoundDownToFloat(build_node.bounding_box.m_y.m_min);
+    node.bounds_min[2] = RoundDownToFloat(build_node.bounding_box.m_z.m_min);
+    node.bounds_max[0] = RoundUpToFloat(build_node.bounding_box.m_x.m_max);
+    node.bounds_max[1] = RoundUpToFloat(build_node.bounding_box.m_y.m_max);
+    node.bounds_max[2] = RoundUpToFloat(build_node.bounding_box.m_z.m_max);
+
+    if (build_node.num_primitives > 0)
+    {
+        node.offset = build_node.offset;
+        node.num_primitives = static_cast<uint16_t>(build_node.num_primitives);
+        m_nodes[node_index] = node;
+        return node_index;
+    }
+
+    // Order children along the axis that separates their centres most, the child lower on that axis first
+    // Traversal relies on this, visiting the second child first only for rays heading down the axis
+    const AABB& first_bounds = build_nodes[build_node.offset].bounding_box;
+    const AABB& second_bounds = build_nodes[build_node.offset + 1].bounding_box;
+    double largest_separation = -1.0;
+    bool swap_children = false;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const double first_centre = first_bounds[axis].m_min + first_bounds[axis].m_max;
+        const double second_centre = second_bounds[axis].m_min + second_bounds[axis].m_max;
+        const double separation = std::abs(second_centre - first_centre);
+        if (separation > largest_separation)
+        {
+            largest_separation = separation;
+            node.split_axis = static_cast<uint8_t>(axis);
+            swap_children = second_centre < first_centre;
+        }
+    }
+
+    // First child is stored directly after its parent
+    const uint32_t low_build_node_index = swap_children ? build_node.offset + 1 : build_node.offset;
+    const uint32_t high_build_node_index = swap_children ? build_node.offset : build_node.offset + 1;
+    Flatten(build_nodes, low_build_node_index);
+    const uint32_t second_child_index = Flatten(build_nodes, high_build_node_index);
+
+    node.offset = second_child_index;
+    node.num_primitives = 0;
+    m_nodes[node_index] = node;
+    return node_index;
+}
+
+bool FlatBVH::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    return HitSubtree(0, ray, ray_t, out_result);
+}
+
+bool FlatBVH::HitSubtree(uint32_t root_node_index, const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    const bool direction_is_negative[3] =
+    {
+        ray.m_direction.m_x < 0.0,
+        ray.m_direction.m_y < 0.0,
+        ray.m_direction.m_z < 0.0
+    };
+
+    uint32_t nodes_to_visit[MAX_TREE_DEPTH];
+    std::size_t num_nodes_to_visit = 0;
+    uint32_t current_node_index = root_node_index;
+
+    bool hit_anything = false;
+    double closest_so_far = ray_t.m_max;
+
+    while (true)
+    {
+        const FlatBVHNode& node = m_nodes[current_node_index];
+
+        if (FlatBVHNodeHit(node, ray, ray_t.m_min, closest_so_far))
+        {
+            RecordNodeTraversal();
+
+            if (node.num_primitives > 0)
+            {
+                if (m_primitive_store.Hit(&m_primitives[node.offset], node.num_primitives, ray, Interval(ray_t.m_min, closest_so_far), out_result))
+                {
+                    hit_anything = true;
+                    closest_so_far = out_result.m_t;
+                }
+            }
+            else
+            {
+                // Visit the child nearest the ray origin first, defer the other
+                if (direction_is_negative[node.split_axis])
+                {
+                    nodes_to_visit[num_nodes_to_visit++] = current_node_index + 1;
+                    current_node_index = node.offset;
+                }
+                else
+                {
+                    nodes_to_visit[num_nodes_to_visit++] = node.offset;
+                    current_node_index = current_node_index + 1;
+                }
+                continue;
+            }
+        }
+
+        if (num_nodes_to_visit == 0)
+        {
+            break;
+        }
+        current_node_index = nodes_to_visit[--num_nodes_to_visit];
+    }
+
+    return hit_anything;
+}
+
+bool FlatBVH::HitAny(const Ray& ray, Interval ray_t) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    uint32_t nodes_to_visit[MAX_TREE_DEPTH];
+    std::size_t num_nodes_to_visit = 0;
+    uint32_t current_node_index = 0;
+
+    while (true)
+    {
+        const FlatBVHNode& node = m_nodes[current_node_index];
+
+        if (FlatBVHNodeHit(node, ray, ray_t.m_min, ray_t.m_max))
+        {
+            RecordNodeTraversal();
+
+            if (node.num_primitives > 0)
+            {
+                if (m_primitive_store.HitAny(&m_primitives[node.offset], node.num_primitives, ray, ray_t))
+                {
+                    return true;
+                }
+            }
+            else
+            {
+                nodes_to_visit[num_nodes_to_visit++] = node.offset;
+                current_node_index = current_node_index + 1;
+                continue;
+            }
+        }
+
+        if (num_nodes_to_visit == 0)
+        {
+            return false;
+        }
+        current_node_index = nodes_to_visit[--num_nodes_to_visit];
+    }
+}
+
+RayMask FlatBVH::HitPacketDeferred(const RayPacket& packet, RayMask active_rays, double ray_t_min, double* ray_t_max, RayHitResult* out_results) const
+{
+    if (m_nodes.empty())
+    {
+        return 0;
+    }
+
+    if (!packet.m_is_coherent)
+    {
+        return IRayHittable::HitPacketDeferred(packet, active_rays, ray_t_min, ray_t_max, out_results);
+    }
+
+    // Each deferred node carries the rays its parent was visited with
+    uint32_t nodes_to_visit[MAX_TREE_DEPTH];
+    RayMask rays_to_visit[MAX_TREE_DEPTH];
+    std::size_t num_nodes_to_visit = 0;
+    uint32_t current_node_index = 0;
+    RayMask current_rays = active_rays;
+
+    RayMask hit_rays = 0;
+
+    while (true)
+    {
+        const FlatBVHNode& node = m_nodes[current_node_index];
+        const double box_min[3] = { node.bounds_min[0], node.bounds_min[1], node.bounds_min[2] };
+        const double box_max[3] = { node.bounds_max[0], node.bounds_max[1], node.bounds_max[2] };
+
+        RayMask node_rays = 0;
+        if (packet.MayHitBox(box_min, box_max, ray_t_min, packet.MaxRayT(current_rays, ray_t_max)))
+        {
+            if (node.num_primitives > 0)
+            {
+                // Leaf, test each ray against the box before its primitives
+                std::size_t num_leaf_rays = 0;
+                for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
+                {
+                    const RayMask ray_bit = RayMask(1) << ray_index;
+                    const Ray& ray = packet.m_rays[ray_index];
+                    if (!(current_rays & ray_bit) || !FlatBVHNodeHit(node, ray, ray_t_min, ray_t_max[ray_index]))
+                    {
+                        continue;
+                    }
+
+                    num_leaf_rays++;
+                    if (m_primitive_store.Hit(&m_primitives[node.offset], node.num_primitives, ray, Interval(ray_t_min, ray_t_max[ray_index]), out_results[ray_index]))
+                    {
+                        ray_t_max[ray_index] = out_results[ray_index].m_t;
+                        hit_rays |= ray_bit;
+                    }
+                }
+
+                RecordPacketNodeTraversal(packet.m_size, num_leaf_rays);
+            }
+            else
+            {
+                // Interior node, accepted for the packet as soon as one ray hits its box
+                // Rays before that one missed and are dropped, the rest are carried into the children untested
+                node_rays = current_rays;
+                for (std::size_t ray_index = 0; ray_index < packet.m_size && node_rays != 0; ray_index++)
+                {
+                    const RayMask ray_bit = RayMask(1) << ray_index;
+                    if (!(node_rays & ray_bit))
+                    {
+                        continue;
+                    }
+                    if (FlatBVHNodeHit(node, packet.m_rays[ray_index], ray_t_min, ray_t_max[ray_index]))
+                    {
+                        break;
+                    }
+                    node_rays &= ~ray_bit;
+                }
+            }
+        }
+
+        if (node_rays != 0)
+        {
+            const std::size_t num_node_rays = std::bitset<RayPacket::MAX_SIZE>(node_rays).count();
+            RecordPacketNodeTraversal(packet.m_size, num_node_rays);
+
+            // Every ray shares the packet's direction signs, so the near child is the same for all of them
+            const bool second_child_is_near = packet.m_direction_is_negative[node.split_axis];
+            const uint32_t near_child_index = second_child_is_near ? node.offset : current_node_index + 1;
+            const uint32_t far_child_index = second_child_is_near ? current_node_index + 1 : node.offset;
+
+            if (num_node_rays >= RayPacket::MIN_ACTIVE_RAYS)
+            {
+                nodes_to_visit[num_nodes_to_visit] = far_child_index;
+                rays_to_visit[num_nodes_to_visit++] = node_rays;
+                current_node_index = near_child_index;
+                current_rays = node_rays;
+                continue;
+            }
+
+            // Too few rays left to share the node tests, finish the subtree one ray at a time
+            for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
+            {
+                const RayMask ray_bit = RayMask(1) << ray_index;
+                if (!(node_rays & ray_bit))
+                {
+                    continue;
+                }
+
+                const Ray& ray = packet.m_rays[ray_index];
+                RayHitResult& result = out_results[ray_index];
+                if (HitSubtree(near_child_index, ray, Interval(ray_t_min, ray_t_max[ray_index]), result))
+                {
+                    ray_t_max[ray_index] = result.m_t;
+                    hit_rays |= ray_bit;
+                }
+                if (HitSubtree(far_child_index, ray, Interval(ray_t_min, ray_t_max[ray_index]), result))
+                {
+                    ray_t_max[ray_index] = result.m_t;
+                    hit_rays |= ray_bit;
+                }
+            }
+        }
+
+        if (num_nodes_to_visit == 0)
+        {
+            break;
+        }
+        num_nodes_to_visit--;
+        current_node_index = nodes_to_visit[num_nodes_to_visit];
+        current_rays = rays_to_visit[num_nodes_to_visit];
+    }
+
+    return hit_rays;
+}
+
+AABB FlatBVH::BoundingBox() const
+{
+    return m_bounding_box;
+}
+
+std::size_t FlatBVH::MemoryUsedBytes() const
+{
+    return (m_nodes.size() * sizeof(FlatBVHNode)) + (m_primitives.size() * sizeof(PrimitiveId)) + m_primitive_store.MemoryUsedBytes();
+}
+
+const std::vector<FlatBVHNode>& FlatBVH::GetNodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<PrimitiveId>& FlatBVH::GetPrimitives() const
+{
+    return m_primitives;
+}
+
+const PrimitiveStore& FlatBVH::GetPrimitiveStore() const
+{
+    return m_primitive_store;
+}
+
+} // namespace ART
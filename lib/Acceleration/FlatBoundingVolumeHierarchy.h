@@ -0,0 +1,85 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Acceleration/BVHBuilder.h>
+#include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
+#include <Maths/Interval.h>
+#include <Maths/Vec3.h>
+#include <RayTracing/IRayHittable.h>
+#include <RayTracing/RayHitResult.h>
+
+namespace ART
+{
+
+// Compact BVH node, two per cache line
+// Bounds are stored in single precision, rounded outwards so they never shrink
+struct alignas(32) FlatBVHNode
+{
+public:
+    float bounds_min[3];
+    // Interior: index of second child (first child is always the next node)
+    // Leaf: index of first primitive in the primitive array
+    uint32_t offset;
+    float bounds_max[3];
+    // Zero for interior nodes
+    uint16_t num_primitives;
+    uint8_t split_axis;
+    uint8_t padding;
+};
+
+static_assert(sizeof(FlatBVHNode) == 32, "FlatBVHNode should be 32 bytes");
+
+// BVH stored as one contiguous array of nodes in depth-first order
+// Built with the same BVHBuilder splits as BVHNode, traversed with an explicit stack
+class FlatBVH : public IRayHittable
+{
+public:
+    FlatBVH(std::vector<IRayHittable*>& objects);
+
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Visits children in stored order rather than nearest first, any hit ends the traversal
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    // Culls each node for the whole packet with one interval test and enters it once any ray hits its box
+    // Rays are only tested one at a time against the boxes of leaves
+    RayMask HitPacketDeferred(const RayPacket& packet, RayMask active_rays, double ray_t_min, double* ray_t_max, RayHitResult* out_results) const override;
+
+    AABB BoundingBox() const override;
+
+    std::size_t MemoryUsedBytes() const;
+
+    const std::vector<FlatBVHNode>& GetNodes() const;
+
+    const std::vector<PrimitiveId>& GetPrimitives() const;
+
+    const PrimitiveStore& GetPrimitiveStore() const;
+
+    // Max number of nodes on the path from root to any leaf
+    // Covers SAH builds (MAX_SAH_DEPTH + 32 levels) and Morton builds (63 code bits + 32 index bits) of up to 2^32 objects
+    static constexpr std::size_t MAX_TREE_DEPTH = 128;
+
+protected:
+    // For derived structures that build the tree some other way
+    FlatBVH() = default;
+
+    // Flattens a finished binary tree, build_nodes[0] being the root
+    void Initialise(const std::vector<BVHBuildNode>& build_nodes, const std::vector<IRayHittable*>& ordered_objects);
+
+    // Recursively emits the builder's subtree rooted at build_node_index in depth-first order
+    // Returns index of the subtree's root node
+    uint32_t Flatten(const std::vector<BVHBuildNode>& build_nodes, uint32_t build_node_index);
+
+    // HitDeferred within the subtree rooted at root_node_index
+    bool HitSubtree(uint32_t root_node_index, const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
+
+    AABB m_bounding_box;
+    std::vector<FlatBVHNode> m_nodes;
+    // Primitive data in leaf order
+    PrimitiveStore m_primitive_store;
+    // Primitives reordered so each leaf references a contiguous range
+    std::vector<PrimitiveId> m_primitives;
+};
+
+} // namespace ART
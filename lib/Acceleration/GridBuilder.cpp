@@ -0,0 +1,246 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/GridBuilder.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include <Core/Constants.h>
+
+namespace ART
+{
+
+AABB GridBuilder::ComputeBounds(const std::vector<IRayHittable*>& objects, std::vector<AABB>& out_bounding_boxes)
+{
+    const std::size_t num_objects = objects.size();
+    out_bounding_boxes.resize(num_objects);
+
+    const std::int64_t num_chunks = std::max<std::int64_t>(1, std::min<std::int64_t>(omp_get_max_threads(), num_objects / MIN_CHUNK_SIZE));
+    std::vector<AABB> chunk_bounds(num_chunks);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+    {
+        const std::size_t begin = (num_objects * chunk_index) / num_chunks;
+        const std::size_t end = (num_objects * (chunk_index + 1)) / num_chunks;
+        for (std::size_t object_index = begin; object_index < end; object_index++)
+        {
+            out_bounding_boxes[object_index] = objects[object_index]->BoundingBox();
+            chunk_bounds[chunk_index] = AABB(chunk_bounds[chunk_index], out_bounding_boxes[object_index]);
+        }
+    }
+
+    AABB bounds;
+    for (const AABB& bounding_box : chunk_bounds)
+    {
+        bounds = AABB(bounds, bounding_box);
+    }
+    return bounds;
+}
+
+void GridBuilder::BinObjects(const std::vector<AABB>& bounding_boxes, const AABB& grid_bounds, const Vec3Int& num_cells, GridBins& out_bins)
+{
+    const std::size_t num_objects = bounding_boxes.size();
+    const std::size_t num_yz_cells = static_cast<std::size_t>(num_cells.m_y) * static_cast<std::size_t>(num_cells.m_z);
+    const std::size_t num_grid_cells = static_cast<std::size_t>(num_cells.m_x) * num_yz_cells;
+
+    std::vector<Vec3Int> cell_ranges_min(num_objects);
+    std::vector<Vec3Int> cell_ranges_max(num_objects);
+
+    // Counts per cell, then reused as each cell's write cursor during the scatter
+    std::unique_ptr<std::atomic<std::size_t>[]> cell_counters = std::make_unique<std::atomic<std::size_t>[]>(num_grid_cells);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t cell_index = 0; cell_index < static_cast<std::int64_t>(num_grid_cells); cell_index++)
+    {
+        cell_counters[cell_index].store(0, std::memory_order_relaxed);
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t object_index = 0; object_index < static_cast<std::int64_t>(num_objects); object_index++)
+    {
+        CellRange(bounding_boxes[object_index], grid_bounds, num_cells, cell_ranges_min[object_index], cell_ranges_max[object_index]);
+
+        const Vec3Int& range_min = cell_ranges_min[object_index];
+        const Vec3Int& range_max = cell_ranges_max[object_index];
+        for (int x = range_min.m_x; x <= range_max.m_x; x++)
+        {
+            for (int y = range_min.m_y; y <= range_max.m_y; y++)
+            {
+                for (int z = range_min.m_z; z <= range_max.m_z; z++)
+                {
+                    const std::size_t cell_index = (x * num_yz_cells) + (y * static_cast<std::size_t>(num_cells.m_z)) + z;
+                    cell_counters[cell_index].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    out_bins.cell_offsets.resize(num_grid_cells + 1);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t cell_index = 0; cell_index < static_cast<std::int64_t>(num_grid_cells); cell_index++)
+    {
+        out_bins.cell_offsets[cell_index] = cell_counters[cell_index].load(std::memory_order_relaxed);
+    }
+
+    const std::size_t num_references = ExclusiveScan(out_bins.cell_offsets.data(), num_grid_cells);
+    out_bins.cell_offsets[num_grid_cells] = num_references;
+    out_bins.object_indices.resize(num_references);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t cell_index = 0; cell_index < static_cast<std::int64_t>(num_grid_cells); cell_index++)
+    {
+        cell_counters[cell_index].store(out_bins.cell_offsets[cell_index], std::memory_order_relaxed);
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t object_index = 0; object_index < static_cast<std::int64_t>(num_objects); object_index++)
+    {
+        const Vec3Int& range_min = cell_ranges_min[object_index];
+        const Vec3Int& range_max = cell_ranges_max[object_index];
+        for (int x = range_min.m_x; x <= range_max.m_x; x++)
+        {
+            for (int y = range_min.m_y; y <= range_max.m_y; y++)
+            {
+                for (int z = range_min.m_z; z <= range_max.m_z; z++)
+                {
+                    const std::size_t cell_index = (x * num_yz_cells) + (y * static_cast<std::size_t>(num_cells.m_z)) + z;
+                    out_bins.object_indices[cell_counters[cell_index].fetch_add(1, std::memory_order_relaxed)] = static_cast<uint32_t>(object_index);
+                }
+            }
+        }
+    }
+
+    // Threads scatter into a cell in any order, restore input order so builds are deterministic
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (std::int64_t cell_index = 0; cell_index < static_cast<std::int64_t>(num_grid_cells); cell_index++)
+    {
+        std::sort(out_bins.object_indices.begin() + out_bins.cell_offsets[cell_index], out_bins.object_indices.begin() + out_bins.cell_offsets[cell_index + 1]);
+    }
+}
+
+std::size_t GridBuilder::ExclusiveScan(std::size_t* values, std::size_t count)
+{
+    const std::int64_t num_chunks = std::max<std::int64_t>(1, std::min<std::int64_t>(omp_get_max_threads(), count / MIN_CHUNK_SIZE));
+    std::vector<std::size_t> chunk_offsets(num_chunks);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+    {
+        const std::size_t begin = (count * chunk_index) / num_chunks;
+        const std::size_t end = (count * (chunk_index + 1)) / num_chunks;
+        std::size_t chunk_sum = 0;
+        for (std::size_t value_index = begin; value_index < end; value_index++)
+        {
+            chunk_sum += values[value_index];
+        }
+        chunk_offsets[chunk_index] = chunk_sum;
+    }
+
+    std::size_t total = 0;
+    for (std::size_t& chunk_offset : chunk_offsets)
+    {
+        const std::size_t chunk_sum = chunk_offset;
+        chunk_offset = total;
+        total += chunk_sum;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+    {
+        const std::size_t begin = (count * chunk_index) / num_chunks;
+        const std::size_t end = (count * (chunk_index + 1)) / num_chunks;
+        std::size_t running_sum = chunk_offsets[chunk_index];
+        for (std::size_t value_index = begin; value_index < end; value_index++)
+        {
+            const std::size_t value = values[value_index];
+            values[value_index] = running_sum;
+            running_sum += value;
+        }
+    }
+
+    return total;
+}
+
+std::size_t GridBuilder::CountReferences(const std::vector<AABB>& bounding_boxes, const AABB& grid_bounds, const Vec3Int& num_cells)
+{
+    std::size_t num_references = 0;
+
+    #pragma omp parallel for schedule(static) reduction(+:num_references)
+    for (std::int64_t object_index = 0; object_index < static_cast<std::int64_t>(bounding_boxes.size()); object_index++)
+    {
+        Vec3Int range_min;
+        Vec3Int range_max;
+        CellRange(bounding_boxes[object_index], grid_bounds, num_cells, range_min, range_max);
+        num_references += static_cast<std::size_t>(range_max.m_x - range_min.m_x + 1) * (range_max.m_y - range_min.m_y + 1) * (range_max.m_z - range_min.m_z + 1);
+    }
+
+    return num_references;
+}
+
+Vec3Int GridBuilder::LimitReferences(const std::vector<AABB>& bounding_boxes, const AABB& grid_bounds, Vec3Int num_cells, double max_references_per_object)
+{
+    const double max_references = max_references_per_object * static_cast<double>(bounding_boxes.size());
+    while ((num_cells.m_x > 1 || num_cells.m_y > 1 || num_cells.m_z > 1) && static_cast<double>(CountReferences(bounding_boxes, grid_bounds, num_cells)) > max_references)
+    {
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            num_cells[axis] = std::max(1, num_cells[axis] / 2);
+        }
+    }
+
+    return num_cells;
+}
+
+void GridBuilder::CellRange(const AABB& bounding_box, const AABB& grid_bounds, const Vec3Int& num_cells, Vec3Int& out_min, Vec3Int& out_max)
+{
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const double cell_size = grid_bounds[axis].Size() / num_cells[axis];
+        const double max_cell = static_cast<double>(num_cells[axis] - 1);
+        if (!(cell_size > 0.0))
+        {
+            out_min[axis] = 0;
+            out_max[axis] = 0;
+            continue;
+        }
+
+        // Clamp before converting so positions far outside the grid can't overflow
+        const double min_position = (bounding_box[axis].m_min - grid_bounds[axis].m_min) / cell_size;
+        const double max_position = (bounding_box[axis].m_max - grid_bounds[axis].m_min) / cell_size;
+        out_min[axis] = static_cast<int>(std::clamp(min_position, 0.0, max_cell));
+        out_max[axis] = static_cast<int>(std::clamp(max_position, 0.0, max_cell));
+    }
+}
+
+void GridWalk::Start(const Ray& ray, double t, const Point3& origin, const Vec3& cell_size, const int cell_min[3], const int cell_max[3])
+{
+    const Point3 position = ray.At(t);
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        cell[axis] = std::clamp(static_cast<int>(std::floor((position[axis] - origin[axis]) / cell_size[axis])), cell_min[axis], cell_max[axis]);
+
+        const double direction = ray.m_direction[axis];
+        if (direction > 0.0)
+        {
+            step[axis] = 1;
+            t_next[axis] = (origin[axis] + ((cell[axis] + 1) * cell_size[axis]) - ray.m_origin[axis]) / direction;
+            t_delta[axis] = cell_size[axis] / direction;
+        }
+        else if (direction < 0.0)
+        {
+            step[axis] = -1;
+            t_next[axis] = (origin[axis] + (cell[axis] * cell_size[axis]) - ray.m_origin[axis]) / direction;
+            t_delta[axis] = -cell_size[axis] / direction;
+        }
+        else
+        {
+            step[axis] = 0;
+            t_next[axis] = infinity;
+            t_delta[axis] = infinity;
+        }
+    }
+}
+
+} // namespace ART
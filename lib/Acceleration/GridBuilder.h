@@ -0,0 +1,85 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <algorithm>
+
+#include <Core/Common.h>
+#include <Geometry/AxisAlignedBoundingBox.h>
+#include <Maths/Ray.h>
+#include <Maths/Vec3.h>
+#include <Maths/Vec3Int.h>
+#include <RayTracing/IRayHittable.h>
+
+namespace ART
+{
+
+// Objects binned into the cells of a grid, cells are indexed x * (Y * Z) + y * Z + z
+struct GridBins
+{
+public:
+    // One entry per cell plus a final total, cell i references object_indices[cell_offsets[i], cell_offsets[i + 1])
+    std::vector<std::size_t> cell_offsets;
+    // Objects of each cell are in input order
+    std::vector<uint32_t> object_indices;
+};
+
+// 3D-DDA (Amanatides & Woo) over the cells of a grid within an inclusive range of cell coordinates
+// Shared by the grids that walk their cells explicitly, cells may differ in size per axis
+struct GridWalk
+{
+public:
+    int cell[3];
+    int step[3];
+    double t_next[3];
+    double t_delta[3];
+
+    // Starts in the cell containing the ray at t, clamped to the range
+    void Start(const Ray& ray, double t, const Point3& origin, const Vec3& cell_size, const int cell_min[3], const int cell_max[3]);
+
+    // Distance along the ray at which it leaves the current cell
+    double ExitT() const
+    {
+        return std::min({ t_next[0], t_next[1], t_next[2] });
+    }
+
+    // Moves to the next cell along the ray, returns false once it leaves the range
+    bool Step(const int cell_min[3], const int cell_max[3])
+    {
+        std::size_t axis = (t_next[0] < t_next[1]) ? 0 : 1;
+        axis = (t_next[2] < t_next[axis]) ? 2 : axis;
+
+        cell[axis] += step[axis];
+        t_next[axis] += t_delta[axis];
+        return cell[axis] >= cell_min[axis] && cell[axis] <= cell_max[axis];
+    }
+};
+
+// Parallel grid construction shared by the uniform grids: objects are counted into cells with atomic counters,
+// the counts are turned into offsets with a parallel exclusive scan, then objects are scattered into place
+class GridBuilder
+{
+public:
+    // Fills out_bounding_boxes with the bounds of each object, returns their union
+    static AABB ComputeBounds(const std::vector<IRayHittable*>& objects, std::vector<AABB>& out_bounding_boxes);
+
+    // Bins every object into each cell its bounding box overlaps, of a grid of num_cells cells covering grid_bounds
+    static void BinObjects(const std::vector<AABB>& bounding_boxes, const AABB& grid_bounds, const Vec3Int& num_cells, GridBins& out_bins);
+
+    // Replaces each value with the sum of the values before it, returns the sum of all values
+    static std::size_t ExclusiveScan(std::size_t* values, std::size_t count);
+
+    // Number of object references when binning bounding_boxes into the grid, counting each object once per cell it overlaps
+    static std::size_t CountReferences(const std::vector<AABB>& bounding_boxes, const AABB& grid_bounds, const Vec3Int& num_cells);
+
+    // Halves the resolution until the objects average at most max_references_per_object cells each
+    // Large overlapping objects gain nothing from finer cells and would otherwise multiply the references
+    static Vec3Int LimitReferences(const std::vector<AABB>& bounding_boxes, const AABB& grid_bounds, Vec3Int num_cells, double max_references_per_object);
+
+    // Inclusive range of cells overlapped by bounding_box, clamped to the grid
+    static void CellRange(const AABB& bounding_box, const AABB& grid_bounds, const Vec3Int& num_cells, Vec3Int& out_min, Vec3Int& out_max);
+
+    // Below this many items per thread the work is done serially
+    static constexpr std::size_t MIN_CHUNK_SIZE = 4096;
+};
+
+} // namespace ART
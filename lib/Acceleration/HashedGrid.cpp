@@ -0,0 +1,497 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/HashedGrid.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <Acceleration/GridBuilder.h>
+#include <Acceleration/RayMailbox.h>
+#include <Core/Constants.h>
+#include <Core/TraversalStats.h>
+
+namespace ART
+{
+
+HashedGrid::HashedGrid(std::vector<IRayHittable*>& objects)
+    : m_num_object_ids(objects.size())
+{
+    if (objects.empty())
+    {
+        return;
+    }
+
+    std::vector<AABB> bounding_boxes;
+    std::vector<double> extents;
+    bounding_boxes.reserve(objects.size());
+    extents.reserve(objects.size());
+    for (IRayHittable* object : objects)
+    {
+        const AABB bounding_box = object->BoundingBox();
+        m_bounding_box = AABB(m_bounding_box, bounding_box);
+        bounding_boxes.push_back(bounding_box);
+        extents.push_back(std::max({ bounding_box.m_x.Size(), bounding_box.m_y.Size(), bounding_box.m_z.Size() }));
+    }
+
+    m_origin = Point3(m_bounding_box.m_x.m_min, m_bounding_box.m_y.m_min, m_bounding_box.m_z.m_min);
+
+    // The median ignores a few huge objects, which would otherwise make cells too coarse for everything else
+    std::nth_element(extents.begin(), extents.begin() + (extents.size() / 2), extents.end());
+    const double median_extent = extents[extents.size() / 2];
+    const double max_size = std::max({ m_bounding_box.m_x.Size(), m_bounding_box.m_y.Size(), m_bounding_box.m_z.Size() });
+    const double min_cell_size = max_size / static_cast<double>(MAX_CELLS_PER_AXIS - 1);
+
+    m_cell_size = CELL_SIZE_SCALE * median_extent;
+    if (m_cell_size <= 0.0)
+    {
+        // Point-like objects, fall back to roughly one object per cell of the bounds
+        m_cell_size = max_size / std::cbrt(static_cast<double>(objects.size()));
+    }
+    else
+    {
+        // Objects too large for the finer cells count once, they move to a coarser level
+        const double max_references = MAX_REFERENCES_PER_OBJECT * static_cast<double>(objects.size());
+        for (int halving = 0; halving < MAX_CELL_SIZE_HALVINGS && 0.5 * m_cell_size >= min_cell_size; halving++)
+        {
+            const double cell_size = 0.5 * m_cell_size;
+            int num_cells[3];
+            NumCells(cell_size, num_cells);
+
+            std::size_t num_references = 0;
+            for (const AABB& bounding_box : bounding_boxes)
+            {
+                int cell_min[3];
+                int cell_max[3];
+                const std::size_t num_cells_covered = CellRange(bounding_box, cell_size, num_cells, cell_min, cell_max);
+                num_references += (num_cells_covered > MAX_CELLS_PER_OBJECT) ? 1 : num_cells_covered;
+            }
+
+            if (static_cast<double>(num_references) > max_references)
+            {
+                break;
+            }
+            m_cell_size = cell_size;
+        }
+    }
+    m_cell_size = std::max(m_cell_size, min_cell_size);
+    if (m_cell_size <= 0.0)
+    {
+        m_cell_size = 1.0;
+    }
+
+    m_primitive_store = PrimitiveStore(objects);
+
+    // Each object goes to the finest level where it covers at most MAX_CELLS_PER_OBJECT cells
+    std::vector<uint32_t> remaining_objects(objects.size());
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    {
+        remaining_objects[object_index] = static_cast<uint32_t>(object_index);
+    }
+
+    double cell_size = m_cell_size;
+    for (std::size_t level_index = 0; level_index < MAX_LEVELS && !remaining_objects.empty(); level_index++)
+    {
+        HashedGridLevel level;
+        level.cell_size = cell_size;
+        NumCells(cell_size, level.num_cells);
+
+        std::vector<uint32_t> level_objects;
+        std::vector<uint32_t> larger_objects;
+        for (uint32_t object_index : remaining_objects)
+        {
+            int cell_min[3];
+            int cell_max[3];
+            if (CellRange(bounding_boxes[object_index], cell_size, level.num_cells, cell_min, cell_max) > MAX_CELLS_PER_OBJECT)
+            {
+                larger_objects.push_back(object_index);
+            }
+            else
+            {
+                level_objects.push_back(object_index);
+            }
+        }
+
+        if (!level_objects.empty())
+        {
+            CreateLevel(level, bounding_boxes, level_objects);
+            m_levels.push_back(std::move(level));
+        }
+        remaining_objects = std::move(larger_objects);
+        cell_size *= LEVEL_CELL_SIZE_SCALE;
+    }
+
+    m_large_objects.reserve(remaining_objects.size());
+    for (uint32_t object_index : remaining_objects)
+    {
+        m_large_objects.push_back(m_primitive_store.GetId(object_index));
+    }
+}
+
+bool HashedGrid::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    return Traverse<false>(ray, ray_t, out_result);
+}
+
+bool HashedGrid::HitAny(const Ray& ray, Interval ray_t) const
+{
+    RayHitResult result;
+    return Traverse<true>(ray, ray_t, result);
+}
+
+template <bool ANY_HIT>
+bool HashedGrid::Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    bool hit_anything = false;
+    double closest_t = ray_t.m_max;
+
+    if constexpr (ANY_HIT)
+    {
+        if (m_primitive_store.HitAny(m_large_objects.data(), m_large_objects.size(), ray, ray_t))
+        {
+            return true;
+        }
+    }
+    else if (m_primitive_store.Hit(m_large_objects.data(), m_large_objects.size(), ray, ray_t, out_result))
+    {
+        hit_anything = true;
+        closest_t = out_result.m_t;
+    }
+
+    if (m_levels.empty())
+    {
+        return hit_anything;
+    }
+
+    // Each object is in one level only, so one query covers them all
+    const RayMailboxQuery mailbox_query(m_num_object_ids);
+
+    // Coarsest level first, its few large objects often give a close hit that cuts short the walk through the finer levels
+    for (auto level = m_levels.rbegin(); level != m_levels.rend(); ++level)
+    {
+        if (TraverseLevel<ANY_HIT>(*level, ray, ray_t, closest_t, out_result))
+        {
+            if constexpr (ANY_HIT)
+            {
+                return true;
+            }
+            hit_anything = true;
+        }
+    }
+
+    return hit_anything;
+}
+
+template <bool ANY_HIT>
+bool HashedGrid::TraverseLevel(const HashedGridLevel& level, const Ray& ray, Interval ray_t, double& closest_t, RayHitResult& out_result) const
+{
+    bool hit_anything = false;
+
+    // Clip the ray to the occupied part of the level
+    double t_enter = ray_t.m_min;
+    double t_exit = closest_t;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const double t0 = (level.bounding_box[axis].m_min - ray.m_origin[axis]) * ray.m_inverse_direction[axis];
+        const double t1 = (level.bounding_box[axis].m_max - ray.m_origin[axis]) * ray.m_inverse_direction[axis];
+        t_enter = std::max(t_enter, std::min(t0, t1));
+        t_exit = std::min(t_exit, std::max(t0, t1));
+    }
+
+    if (!(t_enter <= t_exit))
+    {
+        return false;
+    }
+
+    const int block_min[3] = { 0, 0, 0 };
+    const int block_max[3] =
+    {
+        (level.num_cells[0] - 1) >> BLOCK_SIZE_LOG2,
+        (level.num_cells[1] - 1) >> BLOCK_SIZE_LOG2,
+        (level.num_cells[2] - 1) >> BLOCK_SIZE_LOG2
+    };
+
+    GridWalk block_walk;
+    block_walk.Start(ray, t_enter, m_origin, Vec3(level.cell_size * BLOCK_SIZE), block_min, block_max);
+    double t_block_enter = t_enter;
+
+    while (true)
+    {
+        RecordNodeTraversal();
+        const double t_block_exit = block_walk.ExitT();
+
+        // Empty blocks are crossed in one step
+        if (IsBlockOccupied(level, PackKey(block_walk.cell[0], block_walk.cell[1], block_walk.cell[2])))
+        {
+            int cell_min[3];
+            int cell_max[3];
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                cell_min[axis] = block_walk.cell[axis] << BLOCK_SIZE_LOG2;
+                cell_max[axis] = std::min(cell_min[axis] + BLOCK_SIZE - 1, level.num_cells[axis] - 1);
+            }
+
+            GridWalk cell_walk;
+            cell_walk.Start(ray, t_block_enter, m_origin, Vec3(level.cell_size), cell_min, cell_max);
+            while (true)
+            {
+                const HashedGridCell* cell = FindCell(level, PackKey(cell_walk.cell[0], cell_walk.cell[1], cell_walk.cell[2]));
+                if (cell != nullptr)
+                {
+                    RecordNodeTraversal();
+                    // Objects already tested in an earlier cell are skipped, any hit they had was recorded then
+                    const uint32_t* object_ids = &level.object_ids[cell->objects_offset];
+                    const auto skip = [object_ids](std::size_t object_offset)
+                    {
+                        return tl_ray_mailbox.CheckAndMark(object_ids[object_offset]);
+                    };
+
+                    if constexpr (ANY_HIT)
+                    {
+                        if (m_primitive_store.HitAny(&level.objects[cell->objects_offset], cell->num_objects, ray, ray_t, skip))
+                        {
+                            return true;
+                        }
+                    }
+                    else if (m_primitive_store.Hit(&level.objects[cell->objects_offset], cell->num_objects, ray, Interval(ray_t.m_min, closest_t), out_result, skip))
+                    {
+                        hit_anything = true;
+                        closest_t = out_result.m_t;
+                    }
+                }
+
+                // Stop if the closest hit is before the next cell boundary
+                const double t_cell_exit = cell_walk.ExitT();
+                if (closest_t <= t_cell_exit || t_cell_exit > t_exit)
+                {
+                    return hit_anything;
+                }
+
+                if (!cell_walk.Step(cell_min, cell_max))
+                {
+                    break;
+                }
+            }
+        }
+
+        if (closest_t <= t_block_exit || t_block_exit > t_exit)
+        {
+            return hit_anything;
+        }
+
+        if (!block_walk.Step(block_min, block_max))
+        {
+            return hit_anything;
+        }
+        t_block_enter = t_block_exit;
+    }
+}
+
+AABB HashedGrid::BoundingBox() const
+{
+    return m_bounding_box;
+}
+
+std::size_t HashedGrid::MemoryUsedBytes() const
+{
+    std::size_t memory_used_bytes = (m_levels.size() * sizeof(HashedGridLevel)) +
+        (m_large_objects.size() * sizeof(PrimitiveId)) +
+        m_primitive_store.MemoryUsedBytes();
+    for (const HashedGridLevel& level : m_levels)
+    {
+        memory_used_bytes += (level.cells.size() * sizeof(HashedGridCell)) +
+            (level.blocks.size() * sizeof(uint64_t)) +
+            (level.objects.size() * (sizeof(PrimitiveId) + sizeof(uint32_t)));
+    }
+    return memory_used_bytes;
+}
+
+std::size_t HashedGrid::GetNumOccupiedCells() const
+{
+    std::size_t num_occupied_cells = 0;
+    for (const HashedGridLevel& level : m_levels)
+    {
+        num_occupied_cells += level.num_occupied_cells;
+    }
+    return num_occupied_cells;
+}
+
+std::size_t HashedGrid::GetNumOccupiedBlocks() const
+{
+    std::size_t num_occupied_blocks = 0;
+    for (const HashedGridLevel& level : m_levels)
+    {
+        num_occupied_blocks += level.num_occupied_blocks;
+    }
+    return num_occupied_blocks;
+}
+
+double HashedGrid::GetCellSize() const
+{
+    return m_cell_size;
+}
+
+const std::vector<HashedGridLevel>& HashedGrid::GetLevels() const
+{
+    return m_levels;
+}
+
+const std::vector<PrimitiveId>& HashedGrid::GetLargeObjects() const
+{
+    return m_large_objects;
+}
+
+const PrimitiveStore& HashedGrid::GetPrimitiveStore() const
+{
+    return m_primitive_store;
+}
+
+std::size_t HashedGrid::CellRange(const AABB& bounding_box, double cell_size, const int num_cells[3], int out_min[3], int out_max[3]) const
+{
+    std::size_t num_cells_covered = 1;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        out_min[axis] = std::clamp(static_cast<int>(std::floor((bounding_box[axis].m_min - m_origin[axis]) / cell_size)), 0, num_cells[axis] - 1);
+        out_max[axis] = std::clamp(static_cast<int>(std::floor((bounding_box[axis].m_max - m_origin[axis]) / cell_size)), 0, num_cells[axis] - 1);
+        num_cells_covered *= static_cast<std::size_t>(out_max[axis] - out_min[axis] + 1);
+    }
+    return num_cells_covered;
+}
+
+void HashedGrid::NumCells(double cell_size, int out_num_cells[3]) const
+{
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const int num_cells = static_cast<int>(std::ceil(m_bounding_box[axis].Size() / cell_size));
+        out_num_cells[axis] = std::clamp(num_cells, 1, MAX_CELLS_PER_AXIS);
+    }
+}
+
+void HashedGrid::CreateLevel(HashedGridLevel& level, const std::vector<AABB>& bounding_boxes, const std::vector<uint32_t>& object_indices)
+{
+    // (cell key, object index) for every cell each object overlaps, sorted so each cell's objects are contiguous
+    std::vector<std::pair<uint64_t, uint32_t>> references;
+    for (uint32_t object_index : object_indices)
+    {
+        const AABB& bounding_box = bounding_boxes[object_index];
+        level.bounding_box = AABB(level.bounding_box, bounding_box);
+
+        int cell_min[3];
+        int cell_max[3];
+        CellRange(bounding_box, level.cell_size, level.num_cells, cell_min, cell_max);
+        for (int x = cell_min[0]; x <= cell_max[0]; x++)
+        {
+            for (int y = cell_min[1]; y <= cell_max[1]; y++)
+            {
+                for (int z = cell_min[2]; z <= cell_max[2]; z++)
+                {
+                    references.emplace_back(PackKey(x, y, z), object_index);
+                }
+            }
+        }
+    }
+
+    std::sort(references.begin(), references.end());
+
+    std::vector<HashedGridCell> occupied_cells;
+    std::vector<uint64_t> occupied_blocks;
+    level.objects.reserve(references.size());
+    level.object_ids.reserve(references.size());
+    for (std::size_t reference_index = 0; reference_index < references.size(); reference_index++)
+    {
+        const uint64_t key = references[reference_index].first;
+        if (occupied_cells.empty() || occupied_cells.back().key != key)
+        {
+            occupied_cells.push_back({ key, static_cast<uint32_t>(level.objects.size()), 0 });
+
+            const int x = static_cast<int>((key >> 42) & 0x1FFFFF);
+            const int y = static_cast<int>((key >> 21) & 0x1FFFFF);
+            const int z = static_cast<int>(key & 0x1FFFFF);
+            occupied_blocks.push_back(PackKey(x >> BLOCK_SIZE_LOG2, y >> BLOCK_SIZE_LOG2, z >> BLOCK_SIZE_LOG2));
+        }
+
+        level.objects.push_back(m_primitive_store.GetId(references[reference_index].second));
+        level.object_ids.push_back(references[reference_index].second);
+        occupied_cells.back().num_objects++;
+    }
+
+    std::sort(occupied_blocks.begin(), occupied_blocks.end());
+    occupied_blocks.erase(std::unique(occupied_blocks.begin(), occupied_blocks.end()), occupied_blocks.end());
+
+    level.num_occupied_cells = occupied_cells.size();
+    level.num_occupied_blocks = occupied_blocks.size();
+
+    // Linear probing
+    level.cells_capacity_log2 = TableCapacityLog2(level.num_occupied_cells);
+    level.cells.assign(std::size_t(1) << level.cells_capacity_log2, { EMPTY_KEY, 0, 0 });
+    const std::size_t cells_mask = level.cells.size() - 1;
+    for (const HashedGridCell& cell : occupied_cells)
+    {
+        std::size_t slot = HashKey(cell.key, level.cells_capacity_log2);
+        while (level.cells[slot].key != EMPTY_KEY)
+        {
+            slot = (slot + 1) & cells_mask;
+        }
+        level.cells[slot] = cell;
+    }
+
+    level.blocks_capacity_log2 = TableCapacityLog2(level.num_occupied_blocks);
+    level.blocks.assign(std::size_t(1) << level.blocks_capacity_log2, EMPTY_KEY);
+    const std::size_t blocks_mask = level.blocks.size() - 1;
+    for (uint64_t block_key : occupied_blocks)
+    {
+        std::size_t slot = HashKey(block_key, level.blocks_capacity_log2);
+        while (level.blocks[slot] != EMPTY_KEY)
+        {
+            slot = (slot + 1) & blocks_mask;
+        }
+        level.blocks[slot] = block_key;
+    }
+}
+
+uint64_t HashedGrid::PackKey(int x, int y, int z)
+{
+    return (static_cast<uint64_t>(x) << 42) | (static_cast<uint64_t>(y) << 21) | static_cast<uint64_t>(z);
+}
+
+std::size_t HashedGrid::HashKey(uint64_t key, int capacity_log2)
+{
+    return static_cast<std::size_t>((key * HASH_MULTIPLIER) >> (64 - capacity_log2));
+}
+
+int HashedGrid::TableCapacityLog2(std::size_t num_keys)
+{
+    int capacity_log2 = 1;
+    while ((std::size_t(1) << capacity_log2) < 2 * num_keys)
+    {
+        capacity_log2++;
+    }
+    return capacity_log2;
+}
+
+const HashedGridCell* HashedGrid::FindCell(const HashedGridLevel& level, uint64_t key)
+{
+    const std::size_t mask = level.cells.size() - 1;
+    for (std::size_t slot = HashKey(key, level.cells_capacity_log2); level.cells[slot].key != EMPTY_KEY; slot = (slot + 1) & mask)
+    {
+        if (level.cells[slot].key == key)
+        {
+            return &level.cells[slot];
+        }
+    }
+    return nullptr;
+}
+
+bool HashedGrid::IsBlockOccupied(const HashedGridLevel& level, uint64_t key)
+{
+    const std::size_t mask = level.blocks.size() - 1;
+    for (std::size_t slot = HashKey(key, level.blocks_capacity_log2); level.blocks[slot] != EMPTY_KEY; slot = (slot + 1) & mask)
+    {
+        if (level.blocks[slot] == key)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace ART
@@ -0,0 +1,140 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
+#include <Maths/Interval.h>
+#include <Maths/Vec3.h>
+#include <RayTracing/IRayHittable.h>
+#include <RayTracing/RayHitResult.h>
+
+namespace ART
+{
+
+// Occupied cell of a HashedGrid
+struct HashedGridCell
+{
+public:
+    // Packed cell coordinates, EMPTY_KEY for free slots of the table
+    uint64_t key;
+    uint32_t objects_offset;
+    uint32_t num_objects;
+};
+
+// One level of a HashedGrid, a uniform grid of cubic cells of which only the occupied ones are stored
+struct HashedGridLevel
+{
+public:
+    double cell_size = 0.0;
+    int num_cells[3] = { 0, 0, 0 };
+    // Bounds of the objects stored in this level
+    AABB bounding_box;
+    std::vector<HashedGridCell> cells;
+    int cells_capacity_log2 = 0;
+    std::vector<uint64_t> blocks;
+    int blocks_capacity_log2 = 0;
+    std::size_t num_occupied_cells = 0;
+    std::size_t num_occupied_blocks = 0;
+    // Objects of all occupied cells, each cell's objects are contiguous
+    std::vector<PrimitiveId> objects;
+    // Mailbox id of each entry of objects, its index in the constructor's objects
+    std::vector<uint32_t> object_ids;
+};
+
+// Uniform grid that stores only its occupied cells, in an open-addressing hash table keyed by cell coordinates
+// Cells are grouped into cubic blocks, and a second table of occupied blocks lets traversal step over empty blocks whole
+// Memory grows with the number of occupied cells instead of the volume of the scene's bounds
+// Objects covering too many cells of a level go to the next level, whose cells are LEVEL_CELL_SIZE_SCALE times larger
+class HashedGrid : public IRayHittable
+{
+public:
+    HashedGrid(std::vector<IRayHittable*>& objects);
+
+    // Objects spanning several cells are tested at most once per ray, see RayMailbox
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Blocks and cells are walked front to back as for HitDeferred, returning at the first object hit
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    AABB BoundingBox() const override;
+
+    std::size_t MemoryUsedBytes() const;
+
+    // Summed over all levels
+    std::size_t GetNumOccupiedCells() const;
+
+    // Summed over all levels
+    std::size_t GetNumOccupiedBlocks() const;
+
+    // Cell size of the finest level
+    double GetCellSize() const;
+
+    // Finest level first
+    const std::vector<HashedGridLevel>& GetLevels() const;
+
+    // Objects covering more than MAX_CELLS_PER_OBJECT cells of the coarsest level, tested by every ray
+    const std::vector<PrimitiveId>& GetLargeObjects() const;
+
+    const PrimitiveStore& GetPrimitiveStore() const;
+
+    // Starting cell size of the finest level relative to the median object extent
+    static constexpr double CELL_SIZE_SCALE = 2.0;
+    // The finest level's cells are halved up to this many times while the objects average at most
+    // MAX_REFERENCES_PER_OBJECT cells each, so the cell size follows the cells objects actually cover
+    // rather than the median alone, which is far too coarse for elongated or flat objects
+    // An object as large as a cell covers 8 of them, so scenes of similar sized objects keep the median based size
+    static constexpr int MAX_CELL_SIZE_HALVINGS = 3;
+    static constexpr double MAX_REFERENCES_PER_OBJECT = 6.0;
+    static constexpr std::size_t MAX_CELLS_PER_OBJECT = 4096;
+    // MAX_CELLS_PER_OBJECT cells of one level fit in about one cell of the next
+    static constexpr double LEVEL_CELL_SIZE_SCALE = 16.0;
+    static constexpr std::size_t MAX_LEVELS = 3;
+    // Cell coordinates are packed into 21 bits per axis
+    static constexpr int MAX_CELLS_PER_AXIS = 1 << 21;
+    static constexpr int BLOCK_SIZE_LOG2 = 3;
+    static constexpr int BLOCK_SIZE = 1 << BLOCK_SIZE_LOG2;
+    static constexpr uint64_t EMPTY_KEY = ~uint64_t(0);
+
+protected:
+    // Closest hit, or with ANY_HIT the first hit found, out_result then left unwritten
+    template <bool ANY_HIT>
+    bool Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
+
+    // Walks the blocks and cells of one level, closest_t is narrowed by each hit
+    template <bool ANY_HIT>
+    bool TraverseLevel(const HashedGridLevel& level, const Ray& ray, Interval ray_t, double& closest_t, RayHitResult& out_result) const;
+
+    // Inclusive range of the level's cells overlapped by bounding_box, returns the number of cells
+    std::size_t CellRange(const AABB& bounding_box, double cell_size, const int num_cells[3], int out_min[3], int out_max[3]) const;
+
+    // Number of cells of the given size along each axis of the grid's bounds
+    void NumCells(double cell_size, int out_num_cells[3]) const;
+
+    // Fills level with the objects whose indices are given, in the order given
+    void CreateLevel(HashedGridLevel& level, const std::vector<AABB>& bounding_boxes, const std::vector<uint32_t>& object_indices);
+
+    static uint64_t PackKey(int x, int y, int z);
+
+    static std::size_t HashKey(uint64_t key, int capacity_log2);
+
+    // Table capacity giving a load factor of at most a half
+    static int TableCapacityLog2(std::size_t num_keys);
+
+    static const HashedGridCell* FindCell(const HashedGridLevel& level, uint64_t key);
+
+    static bool IsBlockOccupied(const HashedGridLevel& level, uint64_t key);
+
+    AABB m_bounding_box;
+    // Shared by all levels
+    Point3 m_origin;
+    double m_cell_size = 0.0;
+    std::vector<HashedGridLevel> m_levels;
+    PrimitiveStore m_primitive_store;
+    std::size_t m_num_object_ids = 0;
+    std::vector<PrimitiveId> m_large_objects;
+
+    // Fibonacci hashing
+    static constexpr uint64_t HASH_MULTIPLIER = 11400714819323198485ull;
+};
+
+} // namespace ART
@@ -1,6 +1,8 @@
 // Copyright Mia Rolfe. All rights reserved.
 #include <Acceleration/HierarchicalUniformGrid.h>
 
+#include <Acceleration/GridBuilder.h>
+#include <Acceleration/RayMailbox.h>
 #include <Acceleration/UniformGrid.h>
 #include <Core/TraversalStats.h>
 #include <RayTracing/IRayHittable.h>
@@ -9,15 +11,13 @@
 namespace ART
 {
 
-HierarchicalUniformGrid::HierarchicalUniformGrid(std::vector<IRayHittable*>& objects)
-    : m_is_grid_valid(false), m_grid(nullptr), m_num_x_cells(0), m_num_y_cells(0), m_num_z_cells(0)
+HierarchicalUniformGrid::HierarchicalUniformGrid(std::vector<IRayHittable*>& objects, const UniformGridConfig& subgrid_config)
+    : m_is_grid_valid(false), m_num_x_cells(0), m_num_y_cells(0), m_num_z_cells(0)
 {
-    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
-    {
-        m_bounding_box = AABB(m_bounding_box, objects[object_index]->BoundingBox());
-    }
+    std::vector<AABB> bounding_boxes;
+    m_bounding_box = GridBuilder::ComputeBounds(objects, bounding_boxes);
 
-    Create(objects);
+    Create(objects, bounding_boxes, subgrid_config);
 }
 
 HierarchicalUniformGrid::~HierarchicalUniformGrid()
@@ -25,9 +25,21 @@ HierarchicalUniformGrid::~HierarchicalUniformGrid()
     Destroy();
 }
 
-bool HierarchicalUniformGrid::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+bool HierarchicalUniformGrid::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    return Traverse<false>(ray, ray_t, out_result);
+}
+
+bool HierarchicalUniformGrid::HitAny(const Ray& ray, Interval ray_t) const
+{
+    RayHitResult result;
+    return Traverse<true>(ray, ray_t, result);
+}
+
+template <bool ANY_HIT>
+bool HierarchicalUniformGrid::Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
-    if (!m_grid || !m_is_grid_valid)
+    if (m_grid.empty() || !m_is_grid_valid)
     {
         return false;
     }
@@ -37,8 +49,20 @@ bool HierarchicalUniformGrid::Hit(const Ray& ray, Interval ray_t, RayHitResult&
         return false;
     }
 
-    // Starting point inside the bounding box
-    const Vec3 entry_point = ray.At(ray_t.m_min);
+    // One query across all subgrids, objects are duplicated into every subgrid they overlap
+    const RayMailboxQuery mailbox_query(m_num_object_ids);
+
+    // Starting point inside the bounding box, where the ray enters it if it starts outside
+    double t_entry = ray_t.m_min;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const double t_near = std::min((m_bounding_box[axis].m_min - ray.m_origin[axis]) / ray.m_direction[axis], (m_bounding_box[axis].m_max - ray.m_origin[axis]) / ray.m_direction[axis]);
+        if (t_near > t_entry)
+        {
+            t_entry = t_near;
+        }
+    }
+    const Vec3 entry_point = ray.At(t_entry);
     Vec3Int current_cell = Calculate3DIndex(entry_point);
 
     // Clamp to grid
@@ -91,7 +115,6 @@ bool HierarchicalUniformGrid::Hit(const Ray& ray, Interval ray_t, RayHitResult&
 
     bool hit_anything = false;
     double closest_t = ray_t.m_max;
-    RayHitResult temp_result;
 
     // 3DDDA (Amanatides & Woo)
     while
@@ -103,11 +126,20 @@ bool HierarchicalUniformGrid::Hit(const Ray& ray, Interval ray_t, RayHitResult&
     {
         const std::size_t cell_index = Calculate1DIndex(current_cell);
         RecordNodeTraversal();
-        if (CellHit(m_grid[cell_index], ray, Interval(ray_t.m_min, closest_t), temp_result))
+        if (CellHit<ANY_HIT>(m_grid[cell_index], ray, Interval(ray_t.m_min, closest_t), out_result))
         {
+            if constexpr (ANY_HIT)
+            {
+                return true;
+            }
             hit_anything = true;
-            closest_t = temp_result.m_t;
-            out_result = temp_result;
+            closest_t = out_result.m_t;
+        }
+
+        // Stop if closest hit is before the boundary of this cell, later cells can't hold a closer hit
+        if (closest_t <= std::min(t_max.m_x, std::min(t_max.m_y, t_max.m_z)))
+        {
+            break;
         }
 
         // Step to next cell
@@ -137,12 +169,6 @@ bool HierarchicalUniformGrid::Hit(const Ray& ray, Interval ray_t, RayHitResult&
                 t_max.m_z += t_delta.m_z;
             }
         }
-
-        // Stop if closest hit is before next cell boundary
-        if (hit_anything && closest_t < std::min(t_max.m_x, std::min(t_max.m_y, t_max.m_z)))
-        {
-            break;
-        }
     }
 
     return hit_anything;
@@ -153,120 +179,64 @@ AABB HierarchicalUniformGrid::BoundingBox() const
     return m_bounding_box;
 }
 
-void HierarchicalUniformGrid::Create(std::vector<IRayHittable*>& objects)
+void HierarchicalUniformGrid::Create(std::vector<IRayHittable*>& objects, const std::vector<AABB>& bounding_boxes, const UniformGridConfig& subgrid_config)
 {
-    m_cell_size = DetermineCellSize(objects.size());
-
-    m_num_x_cells = std::max(static_cast<std::size_t>(1), static_cast<std::size_t>(std::round(m_bounding_box.m_x.Size() / m_cell_size.m_x)));
-    m_num_y_cells = std::max(static_cast<std::size_t>(1), static_cast<std::size_t>(std::round(m_bounding_box.m_y.Size() / m_cell_size.m_y)));
-    m_num_z_cells = std::max(static_cast<std::size_t>(1), static_cast<std::size_t>(std::round(m_bounding_box.m_z.Size() / m_cell_size.m_z)));
+    m_num_object_ids = objects.size();
+    // Per-axis resolution from the object density, so flat or elongated scenes don't get cubic cells sized by their longest axis
+    const Vec3Int resolution = UniformGrid::DetermineResolution(m_bounding_box, objects.size(), TOP_LEVEL_DENSITY);
+    m_num_x_cells = static_cast<std::size_t>(resolution.m_x);
+    m_num_y_cells = static_cast<std::size_t>(resolution.m_y);
+    m_num_z_cells = static_cast<std::size_t>(resolution.m_z);
+
+    // Exact cell extents, so traversal steps line up with the cells objects were binned into
+    m_cell_size = Vec3
+    (
+        m_bounding_box.m_x.Size() / m_num_x_cells,
+        m_bounding_box.m_y.Size() / m_num_y_cells,
+        m_bounding_box.m_z.Size() / m_num_z_cells
+    );
 
     const std::size_t num_cells = m_num_x_cells * m_num_y_cells * m_num_z_cells;
-    m_grid = new HierarchicalUniformGridEntry[num_cells];
+    m_grid.resize(num_cells);
 
-    // Count objects per cell first to allocate exact sizes
-    std::size_t* objects_per_cell_count = new std::size_t[num_cells]();
+    GridBins bins;
+    GridBuilder::BinObjects(bounding_boxes, m_bounding_box, Vec3Int(static_cast<int>(m_num_x_cells), static_cast<int>(m_num_y_cells), static_cast<int>(m_num_z_cells)), bins);
 
-    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    std::vector<std::size_t> occupied_cells;
+    for (std::size_t cell_index = 0; cell_index < num_cells; cell_index++)
     {
-        const AABB bounding_box = objects[object_index]->BoundingBox();
-
-        const Vec3 min_bound = Vec3(bounding_box.m_x.m_min, bounding_box.m_y.m_min, bounding_box.m_z.m_min);
-        const Vec3 max_bound = Vec3(bounding_box.m_x.m_max, bounding_box.m_y.m_max, bounding_box.m_z.m_max);
-
-        Vec3Int min_bound_grid_index = Calculate3DIndex(min_bound);
-        Vec3Int max_bound_grid_index = Calculate3DIndex(max_bound);
-
-        // Clamp indices to valid grid bounds
-        min_bound_grid_index.m_x = std::clamp(min_bound_grid_index.m_x, 0, static_cast<int>(m_num_x_cells) - 1);
-        min_bound_grid_index.m_y = std::clamp(min_bound_grid_index.m_y, 0, static_cast<int>(m_num_y_cells) - 1);
-        min_bound_grid_index.m_z = std::clamp(min_bound_grid_index.m_z, 0, static_cast<int>(m_num_z_cells) - 1);
-        max_bound_grid_index.m_x = std::clamp(max_bound_grid_index.m_x, 0, static_cast<int>(m_num_x_cells) - 1);
-        max_bound_grid_index.m_y = std::clamp(max_bound_grid_index.m_y, 0, static_cast<int>(m_num_y_cells) - 1);
-        max_bound_grid_index.m_z = std::clamp(max_bound_grid_index.m_z, 0, static_cast<int>(m_num_z_cells) - 1);
-
-        for (int i = min_bound_grid_index.m_x; i <= max_bound_grid_index.m_x; i++)
+        if (bins.cell_offsets[cell_index + 1] > bins.cell_offsets[cell_index])
         {
-            for (int j = min_bound_grid_index.m_y; j <= max_bound_grid_index.m_y; j++)
-            {
-                for (int k = min_bound_grid_index.m_z; k <= max_bound_grid_index.m_z; k++)
-                {
-                    const std::size_t one_dimensional_index = Calculate1DIndex(Vec3Int(i, j, k));
-                    objects_per_cell_count[one_dimensional_index]++;
-                }
-            }
+            occupied_cells.push_back(cell_index);
         }
     }
 
-    // Calculate offset for each cell in hittables buffer
-    std::size_t* cell_buffer_offsets = new std::size_t[num_cells];
-    std::size_t num_object_references = 0;
-    for (std::size_t i = 0; i < num_cells; i++)
-    {
-        cell_buffer_offsets[i] = num_object_references;
-        num_object_references += objects_per_cell_count[i];
-    }
-
-    IRayHittable** objects_buffer = new IRayHittable*[num_object_references];
-    std::size_t* objects_count_per_cell = new std::size_t[num_cells]();
-
-    // Distribute objects to cells
-    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
-    {
-        const AABB bounding_box = objects[object_index]->BoundingBox();
-
-        const Vec3 min_bound = Vec3(bounding_box.m_x.m_min, bounding_box.m_y.m_min, bounding_box.m_z.m_min);
-        const Vec3 max_bound = Vec3(bounding_box.m_x.m_max, bounding_box.m_y.m_max, bounding_box.m_z.m_max);
-
-        Vec3Int min_bound_grid_index = Calculate3DIndex(min_bound);
-        Vec3Int max_bound_grid_index = Calculate3DIndex(max_bound);
-
-        // Clamp indices to valid grid bounds
-        min_bound_grid_index.m_x = std::clamp(min_bound_grid_index.m_x, 0, static_cast<int>(m_num_x_cells) - 1);
-        min_bound_grid_index.m_y = std::clamp(min_bound_grid_index.m_y, 0, static_cast<int>(m_num_y_cells) - 1);
-        min_bound_grid_index.m_z = std::clamp(min_bound_grid_index.m_z, 0, static_cast<int>(m_num_z_cells) - 1);
-        max_bound_grid_index.m_x = std::clamp(max_bound_grid_index.m_x, 0, static_cast<int>(m_num_x_cells) - 1);
-        max_bound_grid_index.m_y = std::clamp(max_bound_grid_index.m_y, 0, static_cast<int>(m_num_y_cells) - 1);
-        max_bound_grid_index.m_z = std::clamp(max_bound_grid_index.m_z, 0, static_cast<int>(m_num_z_cells) - 1);
+    UniformGridConfig limited_subgrid_config = subgrid_config;
+    limited_subgrid_config.max_references_per_object = SUBGRID_MAX_REFERENCES_PER_OBJECT;
 
-        for (int i = min_bound_grid_index.m_x; i <= max_bound_grid_index.m_x; i++)
-        {
-            for (int j = min_bound_grid_index.m_y; j <= max_bound_grid_index.m_y; j++)
-            {
-                for (int k = min_bound_grid_index.m_z; k <= max_bound_grid_index.m_z; k++)
-                {
-                    const std::size_t one_dimensional_index = Calculate1DIndex(Vec3Int(i, j, k));
-                    const std::size_t buffer_index = cell_buffer_offsets[one_dimensional_index] + objects_count_per_cell[one_dimensional_index];
-                    objects_count_per_cell[one_dimensional_index] += 1;
-                    objects_buffer[buffer_index] = objects[object_index];
-                }
-            }
-        }
-    }
-
-    // Create subgrids for occupied cells
-    for (std::size_t i = 0; i < num_cells; i++)
+    // Subgrids vary widely in size, so hand them out one at a time; each subgrid builds serially inside this region
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (std::int64_t occupied_index = 0; occupied_index < static_cast<std::int64_t>(occupied_cells.size()); occupied_index++)
     {
-        if (objects_per_cell_count[i] > 0)
+        const std::size_t cell_index = occupied_cells[occupied_index];
+        const std::size_t begin = bins.cell_offsets[cell_index];
+        const std::size_t end = bins.cell_offsets[cell_index + 1];
+
+        std::vector<IRayHittable*> subgrid_objects(end - begin);
+        // Subgrids share the ids of the top level objects, so one mailbox query covers all of them
+        std::vector<uint32_t> subgrid_object_ids(end - begin);
+        for (std::size_t reference_index = begin; reference_index < end; reference_index++)
         {
-            std::vector<IRayHittable*> objects_vec(objects_buffer + cell_buffer_offsets[i], objects_buffer + cell_buffer_offsets[i] + objects_per_cell_count[i]);
-            m_grid[i].subgrid = new UniformGrid(objects_vec);
+            subgrid_objects[reference_index - begin] = objects[bins.object_indices[reference_index]];
+            subgrid_object_ids[reference_index - begin] = bins.object_indices[reference_index];
         }
+        m_grid[cell_index].subgrid = new UniformGrid(subgrid_objects, subgrid_object_ids, m_num_object_ids, limited_subgrid_config);
     }
 
-    // Clean up temporary arrays
-    delete[] objects_buffer;
-    delete[] cell_buffer_offsets;
-    delete[] objects_per_cell_count;
-    delete[] objects_count_per_cell;
-
     m_memory_used_bytes = num_cells * sizeof(HierarchicalUniformGridEntry);
-    for (std::size_t i = 0; i < num_cells; i++)
+    for (const std::size_t cell_index : occupied_cells)
     {
-        if (m_grid[i].subgrid != nullptr)
-        {
-            m_memory_used_bytes += m_grid[i].subgrid->MemoryUsedBytes();
-        }
+        m_memory_used_bytes += m_grid[cell_index].subgrid->MemoryUsedBytes();
     }
 
     m_is_grid_valid = true;
@@ -274,33 +244,24 @@ void HierarchicalUniformGrid::Create(std::vector<IRayHittable*>& objects)
 
 void HierarchicalUniformGrid::Destroy()
 {
-    if (m_grid && m_is_grid_valid)
+    for (HierarchicalUniformGridEntry& entry : m_grid)
     {
-        const std::size_t total_cells = m_num_x_cells * m_num_y_cells * m_num_z_cells;
-
-        // Destroy subgrids
-        for (std::size_t i = 0; i < total_cells; i++)
-        {
-            if (m_grid[i].subgrid != nullptr)
-            {
-                delete m_grid[i].subgrid;
-                m_grid[i].subgrid = nullptr;
-            }
-        }
-
-        delete[] m_grid;
-        m_grid = nullptr;
+        delete entry.subgrid;
+        entry.subgrid = nullptr;
     }
+    m_grid.clear();
 
     m_bounding_box = AABB();
     m_cell_size = Vec3(0.0);
     m_num_x_cells = 0;
     m_num_y_cells = 0;
     m_num_z_cells = 0;
+    m_num_object_ids = 0;
     m_is_grid_valid = false;
     m_memory_used_bytes = 0;
 }
 
+template <bool ANY_HIT>
 bool HierarchicalUniformGrid::CellHit(const HierarchicalUniformGridEntry& entry, const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
     if (entry.subgrid == nullptr)
@@ -308,15 +269,14 @@ bool HierarchicalUniformGrid::CellHit(const HierarchicalUniformGridEntry& entry,
         return false;
     }
 
-    return entry.subgrid->Hit(ray, ray_t, out_result);
-}
-
-Vec3 HierarchicalUniformGrid::DetermineCellSize(std::size_t num_objects) const
-{
-    const double cube_root_n = std::cbrt(static_cast<double>(num_objects));
-    const double cell_size = 3.0 * std::max(m_bounding_box.m_x.Size(), std::max(m_bounding_box.m_y.Size(), m_bounding_box.m_z.Size())) / std::max(1.0, cube_root_n);
-
-    return Vec3(cell_size);
+    if constexpr (ANY_HIT)
+    {
+        return entry.subgrid->HitAnyInCurrentQuery(ray, ray_t);
+    }
+    else
+    {
+        return entry.subgrid->HitInCurrentQuery(ray, ray_t, out_result);
+    }
 }
 
 Vec3Int HierarchicalUniformGrid::Calculate3DIndex(Vec3 position) const
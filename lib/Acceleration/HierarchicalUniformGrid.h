@@ -20,24 +20,40 @@ public:
 class HierarchicalUniformGrid : public IRayHittable
 {
 public:
-    HierarchicalUniformGrid(std::vector<IRayHittable*>& objects);
+    // subgrid_config sets the resolution of the subgrids, the top level is a coarse grid sized per axis by TOP_LEVEL_DENSITY
+    HierarchicalUniformGrid(std::vector<IRayHittable*>& objects, const UniformGridConfig& subgrid_config = UniformGridConfig());
 
     ~HierarchicalUniformGrid();
 
-    bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+    // Objects spanning several cells or subgrids are tested at most once per ray, see RayMailbox
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Cells and subgrid cells are walked front to back as for HitDeferred, returning at the first object hit
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
 
     AABB BoundingBox() const override;
 
     std::size_t MemoryUsedBytes() const;
 
+    // Objects overlapping a whole top level cell would be referenced by every cell of its subgrid, so subgrids are coarsened
+    // until their objects average at most this many cells, see GridBuilder::LimitReferences
+    static constexpr double SUBGRID_MAX_REFERENCES_PER_OBJECT = 8.0;
+
+    // Top level cells per object, see UniformGrid::DetermineResolution
+    static constexpr double TOP_LEVEL_DENSITY = 0.125;
+
 protected:
-    void Create(std::vector<IRayHittable*>& objects);
+    // Bins objects into cells in parallel, see GridBuilder, then builds the subgrids of occupied cells in parallel
+    void Create(std::vector<IRayHittable*>& objects, const std::vector<AABB>& bounding_boxes, const UniformGridConfig& subgrid_config);
 
     void Destroy();
 
-    bool CellHit(const HierarchicalUniformGridEntry& entry, const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
+    // Closest hit, or with ANY_HIT the first hit found, out_result then left unwritten
+    template <bool ANY_HIT>
+    bool Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
 
-    Vec3 DetermineCellSize(std::size_t num_objects) const;
+    template <bool ANY_HIT>
+    bool CellHit(const HierarchicalUniformGridEntry& entry, const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
 
     Vec3Int Calculate3DIndex(Vec3 position) const;
 
@@ -48,11 +64,13 @@ protected:
     std::size_t Calculate1DIndex(Vec3Int three_dimensional_index) const;
 
     AABB m_bounding_box;
-    HierarchicalUniformGridEntry* m_grid = nullptr;
+    std::vector<HierarchicalUniformGridEntry> m_grid;
     Vec3 m_cell_size;
     std::size_t m_num_x_cells = 0;
     std::size_t m_num_y_cells = 0;
     std::size_t m_num_z_cells = 0;
+    // Every object's index in the constructor's objects is its mailbox id
+    std::size_t m_num_object_ids = 0;
     bool m_is_grid_valid = false;
     std::size_t m_memory_used_bytes = 0;
 };
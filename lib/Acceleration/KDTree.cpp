@@ -2,6 +2,7 @@
 #include <Acceleration/KDTree.h>
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include <Core/TraversalStats.h>
@@ -9,234 +10,446 @@
 namespace ART
 {
 
-KDTreeNode::KDTreeNode(std::vector<IRayHittable*>& objects)
-    : m_allocator(nullptr), m_left(nullptr), m_right(nullptr)
+static bool KDTreeEventLess(const KDTreeEvent& a, const KDTreeEvent& b)
 {
-    // KD-tree has at most 2N-1 nodes for N objects
-    const std::size_t arena_size = (2 * objects.size()) * sizeof(KDTreeNode);
-    m_allocator = new ArenaAllocator(arena_size);
-
-    Create(objects.data(), objects.size(), *m_allocator);
+    if (a.axis != b.axis)
+    {
+        return a.axis < b.axis;
+    }
+    if (a.position != b.position)
+    {
+        return a.position < b.position;
+    }
+    return a.type < b.type;
 }
 
-KDTreeNode::KDTreeNode(IRayHittable** objects, std::size_t count, ArenaAllocator& allocator)
-    : m_allocator(nullptr), m_left(nullptr), m_right(nullptr)
+// Clips [t_min, t_max] to the part of the ray inside box
+static inline bool ClipRayToBox(const AABB& box, const Ray& ray, double& t_min, double& t_max)
 {
-    Create(objects, count, allocator);
+    const double t0_x = (box.m_x.m_min - ray.m_origin.m_x) * ray.m_inverse_direction.m_x;
+    const double t1_x = (box.m_x.m_max - ray.m_origin.m_x) * ray.m_inverse_direction.m_x;
+    const double t0_y = (box.m_y.m_min - ray.m_origin.m_y) * ray.m_inverse_direction.m_y;
+    const double t1_y = (box.m_y.m_max - ray.m_origin.m_y) * ray.m_inverse_direction.m_y;
+    const double t0_z = (box.m_z.m_min - ray.m_origin.m_z) * ray.m_inverse_direction.m_z;
+    const double t1_z = (box.m_z.m_max - ray.m_origin.m_z) * ray.m_inverse_direction.m_z;
+
+    const double t_near_x = t0_x < t1_x ? t0_x : t1_x;
+    const double t_far_x  = t0_x > t1_x ? t0_x : t1_x;
+    const double t_near_y = t0_y < t1_y ? t0_y : t1_y;
+    const double t_far_y  = t0_y > t1_y ? t0_y : t1_y;
+    const double t_near_z = t0_z < t1_z ? t0_z : t1_z;
+    const double t_far_z  = t0_z > t1_z ? t0_z : t1_z;
+
+    t_min = t_near_x > t_min ? t_near_x : t_min;
+    t_min = t_near_y > t_min ? t_near_y : t_min;
+    t_min = t_near_z > t_min ? t_near_z : t_min;
+
+    t_max = t_far_x < t_max ? t_far_x : t_max;
+    t_max = t_far_y < t_max ? t_far_y : t_max;
+    t_max = t_far_z < t_max ? t_far_z : t_max;
+
+    return t_min <= t_max;
 }
 
-KDTreeNode::~KDTreeNode()
+KDTreeNode::KDTreeNode(std::vector<IRayHittable*>& objects)
 {
-    // Only root node owns and deletes allocator
-    if (m_allocator)
+    if (objects.empty())
     {
-        delete m_allocator;
-        m_allocator = nullptr;
+        return;
     }
-}
 
-void KDTreeNode::Create(IRayHittable** objects, std::size_t count, ArenaAllocator& allocator)
-{
-    // Compute bounding box for all objects
-    for (std::size_t object_index = 0; object_index < count; object_index++)
-    {
-        m_bounding_box = AABB(m_bounding_box, objects[object_index]->BoundingBox());
-    }
+    m_primitive_store = PrimitiveStore(objects);
+    m_objects = &objects;
+    m_object_bounds.resize(objects.size());
+    m_object_sides.resize(objects.size(), PrimitiveSide::BOTH);
 
-    // Only one object, store directly as leaf
-    if (count == 1)
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
     {
-        m_left = objects[0];
-        m_right = nullptr;
-        return;
+        m_object_bounds[object_index] = objects[object_index]->BoundingBox();
+        m_bounding_box = AABB(m_bounding_box, m_object_bounds[object_index]);
     }
 
-    // Two objects, store directly as leaves
-    if (count == 2)
+    // Sorted once here, children inherit sorted lists by splicing so the build stays O(N log N)
+    std::vector<KDTreeEvent> events;
+    events.reserve(6 * objects.size());
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
     {
-        m_left = objects[0];
-        m_right = objects[1];
-        return;
+        AddClippedEvents(static_cast<uint32_t>(object_index), m_bounding_box, events);
     }
+    std::sort(events.begin(), events.end(), KDTreeEventLess);
 
-    std::size_t split = SplitSAH(objects, count);
+    // Havran's depth limit heuristic
+    const std::size_t max_depth = std::min
+    (
+        MAX_TREE_DEPTH,
+        static_cast<std::size_t>(8.0 + 1.3 * std::log2(static_cast<double>(objects.size())))
+    );
 
-    // If SAH split fails use fallback method
-    if (split == 0 || split >= count)
-    {
-        split = SplitLongestAxis(objects, count);
-    }
+    Build(m_bounding_box, events, objects.size(), max_depth);
 
-    m_left = allocator.Create<KDTreeNode>(objects, split, allocator);
-    m_right = allocator.Create<KDTreeNode>(objects + split, count - split, allocator);
+    m_objects = nullptr;
+    std::vector<AABB>().swap(m_object_bounds);
+    std::vector<PrimitiveSide>().swap(m_object_sides);
 }
 
-std::size_t KDTreeNode::SplitSAH(IRayHittable** objects, std::size_t count)
+void KDTreeNode::AddClippedEvents(uint32_t primitive_index, const AABB& voxel, std::vector<KDTreeEvent>& out_events) const
 {
-    const double parent_node_surface_area = m_bounding_box.SurfaceArea();
-    const double leaf_cost = count * HITTABLE_INTERSECT_COST;
-
-    double best_cost = std::numeric_limits<double>::max();
-    double best_split_pos_along_best_axis = 0.0;
-    std::size_t best_axis = 0;
+    const AABB& bounds = m_object_bounds[primitive_index];
 
-    // Evaluate SAH for each axis
     for (std::size_t axis = 0; axis < 3; axis++)
     {
-        double min_centroid = std::numeric_limits<double>::max();
-        double max_centroid = std::numeric_limits<double>::lowest();
+        const double clipped_min = std::max(bounds[axis].m_min, voxel[axis].m_min);
+        const double clipped_max = std::min(bounds[axis].m_max, voxel[axis].m_max);
 
-        for (std::size_t object_index = 0; object_index < count; object_index++)
+        if (clipped_min >= clipped_max)
         {
-            const Interval interval = objects[object_index]->BoundingBox()[axis];
-            const double centroid = 0.5 * (interval.m_min + interval.m_max);
-            min_centroid = std::min(min_centroid, centroid);
-            max_centroid = std::max(max_centroid, centroid);
+            out_events.push_back({ clipped_min, primitive_index, static_cast<uint8_t>(axis), KDTreeEventType::PLANAR });
         }
-
-        const double extent = max_centroid - min_centroid;
-        static constexpr double fp_tolerance = 1e-10;
-        if (extent < fp_tolerance)
+        else
         {
-            continue;
+            out_events.push_back({ clipped_min, primitive_index, static_cast<uint8_t>(axis), KDTreeEventType::START });
+            out_events.push_back({ clipped_max, primitive_index, static_cast<uint8_t>(axis), KDTreeEventType::END });
         }
+    }
+}
 
-        // Assign objects to buckets
-        SplitBucket buckets[NUM_SAH_BUCKETS];
-        for (std::size_t object_index = 0; object_index < count; object_index++)
-        {
-            const Interval interval = objects[object_index]->BoundingBox()[axis];
-            const double centroid = 0.5 * (interval.m_min + interval.m_max);
-            std::size_t bucket_index = static_cast<std::size_t>(NUM_SAH_BUCKETS * ((centroid - min_centroid) / extent));
-            if (bucket_index >= NUM_SAH_BUCKETS)
-            {
-                bucket_index = NUM_SAH_BUCKETS - 1;
-            }
-            buckets[bucket_index].num_hittables++;
-            buckets[bucket_index].bounding_box = AABB(buckets[bucket_index].bounding_box, objects[object_index]->BoundingBox());
-        }
+double KDTreeNode::SplitCost(double probability_below, double probability_above, std::size_t num_below, std::size_t num_above) const
+{
+    // Favour planes that cut off empty space, rays passing through it are culled for free
+    const double bonus_factor = (num_below == 0 || num_above == 0) ? (1.0 - EMPTY_SPACE_BONUS) : 1.0;
+    return bonus_factor * (NODE_TRAVERSAL_COST + HITTABLE_INTERSECT_COST * (probability_below * num_below + probability_above * num_above));
+}
+
+bool KDTreeNode::FindSplit(const AABB& voxel, const std::vector<KDTreeEvent>& events, std::size_t num_primitives, SplitPlane& out_split) const
+{
+    const double voxel_surface_area = voxel.SurfaceArea();
+    if (voxel_surface_area <= 0.0)
+    {
+        return false;
+    }
+
+    const double inverse_voxel_surface_area = 1.0 / voxel_surface_area;
+    const double extent[3] = { voxel.m_x.Size(), voxel.m_y.Size(), voxel.m_z.Size() };
+
+    bool found_split = false;
+    out_split.cost = std::numeric_limits<double>::max();
 
-        // Evaluate split positions
-        for (std::size_t split = 1; split < NUM_SAH_BUCKETS; split++)
+    std::size_t event_index = 0;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const Interval& voxel_interval = voxel[axis];
+        // Split plane area and perimeter are constant along the axis
+        const double plane_area = extent[(axis + 1) % 3] * extent[(axis + 2) % 3];
+        const double plane_perimeter = extent[(axis + 1) % 3] + extent[(axis + 2) % 3];
+
+        std::size_t num_below = 0;
+        std::size_t num_above = num_primitives;
+
+        while (event_index < events.size() && events[event_index].axis == axis)
         {
-            AABB left_bounding_box;
-            AABB right_bounding_box;
-            std::size_t left_num_hittables = 0;
-            std::size_t right_num_hittables = 0;
+            const double position = events[event_index].position;
 
-            for (std::size_t bucket_index = 0; bucket_index < split; bucket_index++)
+            // Gather all events lying in this plane
+            std::size_t num_ending = 0;
+            std::size_t num_planar = 0;
+            std::size_t num_starting = 0;
+            while (event_index < events.size() && events[event_index].axis == axis && events[event_index].position == position)
             {
-                if (buckets[bucket_index].num_hittables > 0)
+                switch (events[event_index].type)
                 {
-                    left_bounding_box = AABB(left_bounding_box, buckets[bucket_index].bounding_box);
-                    left_num_hittables += buckets[bucket_index].num_hittables;
+                    case KDTreeEventType::END:
+                        num_ending++;
+                        break;
+                    case KDTreeEventType::PLANAR:
+                        num_planar++;
+                        break;
+                    case KDTreeEventType::START:
+                        num_starting++;
+                        break;
                 }
+                event_index++;
             }
-            for (std::size_t bucket_index = split; bucket_index < NUM_SAH_BUCKETS; bucket_index++)
+
+            num_above -= num_planar + num_ending;
+
+            // Planes on the voxel boundary would create a child identical to the parent
+            if (position > voxel_interval.m_min && position < voxel_interval.m_max)
             {
-                if (buckets[bucket_index].num_hittables > 0)
+                const double below_surface_area = 2.0 * (plane_area + (position - voxel_interval.m_min) * plane_perimeter);
+                const double above_surface_area = 2.0 * (plane_area + (voxel_interval.m_max - position) * plane_perimeter);
+                const double probability_below = below_surface_area * inverse_voxel_surface_area;
+                const double probability_above = above_surface_area * inverse_voxel_surface_area;
+
+                const double cost_planar_below = SplitCost(probability_below, probability_above, num_below + num_planar, num_above);
+                const double cost_planar_above = SplitCost(probability_below, probability_above, num_below, num_above + num_planar);
+                const bool planar_below = cost_planar_below <= cost_planar_above;
+                const double cost = planar_below ? cost_planar_below : cost_planar_above;
+
+                if (cost < out_split.cost)
                 {
-                    right_bounding_box = AABB(right_bounding_box, buckets[bucket_index].bounding_box);
-                    right_num_hittables += buckets[bucket_index].num_hittables;
+                    found_split = true;
+                    out_split.cost = cost;
+                    out_split.position = position;
+                    out_split.axis = axis;
+                    out_split.planar_below = planar_below;
                 }
             }
 
-            if (left_num_hittables == 0 || right_num_hittables == 0)
-            {
-                continue;
-            }
+            num_below += num_starting + num_planar;
+        }
+    }
 
-            const double cost_of_left_subtree = (left_bounding_box.SurfaceArea() / parent_node_surface_area) * left_num_hittables * HITTABLE_INTERSECT_COST;
-            const double cost_of_right_subtree = (right_bounding_box.SurfaceArea() / parent_node_surface_area) * right_num_hittables * HITTABLE_INTERSECT_COST;
-            const double total_cost = NODE_TRAVERSAL_COST + cost_of_left_subtree + cost_of_right_subtree;
+    return found_split && out_split.cost < HITTABLE_INTERSECT_COST * num_primitives;
+}
 
-            if (total_cost < best_cost)
-            {
-                best_cost = total_cost;
-                best_axis = axis;
-                best_split_pos_along_best_axis = min_centroid + (split * extent / NUM_SAH_BUCKETS);
-            }
+void KDTreeNode::EmitLeaf(const std::vector<KDTreeEvent>& events, std::size_t num_primitives)
+{
+    FlatKDTreeNode node{};
+    node.offset = static_cast<uint32_t>(m_primitives.size());
+    node.flags = (static_cast<uint32_t>(num_primitives) << 2) | FlatKDTreeNode::LEAF_FLAG;
+    m_nodes.push_back(node);
+
+    // Each primitive reference has exactly one START or PLANAR event per axis
+    for (const KDTreeEvent& event : events)
+    {
+        if (event.axis == 0 && event.type != KDTreeEventType::END)
+        {
+            m_primitives.push_back(m_primitive_store.GetId(event.primitive_index));
         }
     }
+}
+
+void KDTreeNode::Build(const AABB& voxel, std::vector<KDTreeEvent>& events, std::size_t num_primitives, std::size_t depth)
+{
+    SplitPlane split;
+    if (depth == 0 || num_primitives == 0 || !FindSplit(voxel, events, num_primitives, split))
+    {
+        EmitLeaf(events, num_primitives);
+        return;
+    }
 
-    // No worthwhile split found
-    if (best_cost >= leaf_cost)
+    // Classify primitive references against the split plane
+    for (const KDTreeEvent& event : events)
+    {
+        if (event.axis == 0 && event.type != KDTreeEventType::END)
+        {
+            m_object_sides[event.primitive_index] = PrimitiveSide::BOTH;
+        }
+    }
+    for (const KDTreeEvent& event : events)
     {
-        return 0;
+        if (event.axis != split.axis)
+        {
+            continue;
+        }
+
+        if (event.type == KDTreeEventType::END && event.position <= split.position)
+        {
+            m_object_sides[event.primitive_index] = PrimitiveSide::BELOW_ONLY;
+        }
+        else if (event.type == KDTreeEventType::START && event.position >= split.position)
+        {
+            m_object_sides[event.primitive_index] = PrimitiveSide::ABOVE_ONLY;
+        }
+        else if (event.type == KDTreeEventType::PLANAR)
+        {
+            const bool below = (event.position < split.position) || (event.position == split.position && split.planar_below);
+            m_object_sides[event.primitive_index] = below ? PrimitiveSide::BELOW_ONLY : PrimitiveSide::ABOVE_ONLY;
+        }
     }
 
-    // Record split axis and position for traversal
-    m_split_axis = best_axis;
-    m_split_position_along_split_axis = best_split_pos_along_best_axis;
+    // Events of one-sided references keep their order, so these lists are already sorted
+    std::vector<KDTreeEvent> below_only_events;
+    std::vector<KDTreeEvent> above_only_events;
+    std::vector<uint32_t> straddling_primitives;
+    std::size_t num_below = 0;
+    std::size_t num_above = 0;
+    for (const KDTreeEvent& event : events)
+    {
+        switch (m_object_sides[event.primitive_index])
+        {
+            case PrimitiveSide::BELOW_ONLY:
+                below_only_events.push_back(event);
+                break;
+            case PrimitiveSide::ABOVE_ONLY:
+                above_only_events.push_back(event);
+                break;
+            case PrimitiveSide::BOTH:
+                if (event.axis == 0 && event.type != KDTreeEventType::END)
+                {
+                    straddling_primitives.push_back(event.primitive_index);
+                }
+                break;
+        }
 
-    // Partition objects at the best split position
-    IRayHittable** mid = std::partition
-    (
-        objects, objects + count,
-        [best_axis, best_split_pos_along_best_axis](IRayHittable* obj)
+        if (event.axis == 0 && event.type != KDTreeEventType::END)
         {
-            const Interval interval = obj->BoundingBox()[best_axis];
-            return 0.5 * (interval.m_min + interval.m_max) < best_split_pos_along_best_axis;
+            const PrimitiveSide side = m_object_sides[event.primitive_index];
+            num_below += (side != PrimitiveSide::ABOVE_ONLY) ? 1 : 0;
+            num_above += (side != PrimitiveSide::BELOW_ONLY) ? 1 : 0;
         }
+    }
+
+    AABB below_voxel = voxel;
+    AABB above_voxel = voxel;
+    below_voxel[split.axis].m_max = split.position;
+    above_voxel[split.axis].m_min = split.position;
+
+    // Only straddling references need new events, and there are few of them, so sorting them is cheap
+    std::vector<KDTreeEvent> straddling_below_events;
+    std::vector<KDTreeEvent> straddling_above_events;
+    for (const uint32_t primitive_index : straddling_primitives)
+    {
+        AddClippedEvents(primitive_index, below_voxel, straddling_below_events);
+        AddClippedEvents(primitive_index, above_voxel, straddling_above_events);
+    }
+    std::sort(straddling_below_events.begin(), straddling_below_events.end(), KDTreeEventLess);
+    std::sort(straddling_above_events.begin(), straddling_above_events.end(), KDTreeEventLess);
+
+    std::vector<KDTreeEvent> below_events(below_only_events.size() + straddling_below_events.size());
+    std::merge
+    (
+        below_only_events.begin(), below_only_events.end(),
+        straddling_below_events.begin(), straddling_below_events.end(),
+        below_events.begin(), KDTreeEventLess
+    );
+    std::vector<KDTreeEvent> above_events(above_only_events.size() + straddling_above_events.size());
+    std::merge
+    (
+        above_only_events.begin(), above_only_events.end(),
+        straddling_above_events.begin(), straddling_above_events.end(),
+        above_events.begin(), KDTreeEventLess
     );
 
-    const std::size_t split_index = static_cast<std::size_t>(mid - objects);
-    return split_index;
+    // Release before recursing, only the lists along the current path stay alive
+    std::vector<KDTreeEvent>().swap(events);
+    std::vector<KDTreeEvent>().swap(below_only_events);
+    std::vector<KDTreeEvent>().swap(above_only_events);
+    std::vector<KDTreeEvent>().swap(straddling_below_events);
+    std::vector<KDTreeEvent>().swap(straddling_above_events);
+
+    const std::size_t node_index = m_nodes.size();
+    FlatKDTreeNode node{};
+    node.split_position = split.position;
+    node.flags = static_cast<uint32_t>(split.axis);
+    m_nodes.push_back(node);
+
+    // Child below the plane is stored directly after its parent
+    Build(below_voxel, below_events, num_below, depth - 1);
+    m_nodes[node_index].offset = static_cast<uint32_t>(m_nodes.size());
+    Build(above_voxel, above_events, num_above, depth - 1);
 }
 
-std::size_t KDTreeNode::SplitLongestAxis(IRayHittable** objects, std::size_t count)
+bool KDTreeNode::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
-    const std::size_t axis = m_bounding_box.LongestAxis();
-    m_split_axis = axis;
-
-    std::sort(objects, objects + count, [axis](IRayHittable* a, IRayHittable* b)
-    {
-        const Interval a_interval = a->BoundingBox()[axis];
-        const Interval b_interval = b->BoundingBox()[axis];
-        // Cheaper but equivalent for sorting comparison to comparing (2 * a_centroid) to (2 * b_centroid)
-        return (a_interval.m_min + a_interval.m_max) < (b_interval.m_min + b_interval.m_max);
-    });
-
-    const std::size_t split_index = count / 2;
-    const Interval mid_interval = objects[split_index]->BoundingBox()[axis];
-    m_split_position_along_split_axis = 0.5 * (mid_interval.m_min + mid_interval.m_max);
+    return Traverse<false>(ray, ray_t, out_result);
+}
 
-    return split_index;
+bool KDTreeNode::HitAny(const Ray& ray, Interval ray_t) const
+{
+    RayHitResult result;
+    return Traverse<true>(ray, ray_t, result);
 }
 
-bool KDTreeNode::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+template <bool ANY_HIT>
+bool KDTreeNode::Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
-    // First check if ray intersects our bounding box
-    if (!m_bounding_box.Hit(ray, ray_t))
+    if (m_nodes.empty())
     {
         return false;
     }
 
-    RecordNodeTraversal();
-
-    // Leaf node with only one child
-    if (m_right == nullptr)
+    double t_min = ray_t.m_min;
+    double t_max = ray_t.m_max;
+    if (!ClipRayToBox(m_bounding_box, ray, t_min, t_max))
     {
-        return m_left->Hit(ray, ray_t, out_result);
+        return false;
     }
 
-    // Determine traversal order based on ray direction
-    const double ray_origin_along_axis = ray.m_origin[m_split_axis];
-    const double ray_direction_along_axis = ray.m_direction[m_split_axis];
+    const double origin[3] = { ray.m_origin.m_x, ray.m_origin.m_y, ray.m_origin.m_z };
+    const double direction[3] = { ray.m_direction.m_x, ray.m_direction.m_y, ray.m_direction.m_z };
+    const double inverse_direction[3] = { ray.m_inverse_direction.m_x, ray.m_inverse_direction.m_y, ray.m_inverse_direction.m_z };
+
+    struct NodeToVisit
+    {
+        uint32_t node_index;
+        double t_min;
+        double t_max;
+    };
+    NodeToVisit nodes_to_visit[MAX_TREE_DEPTH];
+    std::size_t num_nodes_to_visit = 0;
+    uint32_t current_node_index = 0;
+
+    bool hit_anything = false;
+    double closest_so_far = ray_t.m_max;
+
+    while (true)
+    {
+        // Nodes are visited front to back, once a hit lies before this node's interval nothing further can be closer
+        if (closest_so_far < t_min)
+        {
+            break;
+        }
+
+        const FlatKDTreeNode& node = m_nodes[current_node_index];
+        RecordNodeTraversal();
 
-    // If ray is going in negative direction along split axis, or
-    // if ray origin is past split position, swap order
-    const bool should_swap_child_order = (ray_direction_along_axis < 0.0) ||
-        (ray_direction_along_axis == 0.0 && ray_origin_along_axis > m_split_position_along_split_axis);
+        if (!node.IsLeaf())
+        {
+            const std::size_t axis = node.SplitAxis();
+            const double t_split = (node.split_position - origin[axis]) * inverse_direction[axis];
 
-    IRayHittable* first_child = should_swap_child_order ? m_right : m_left;
-    IRayHittable* second_child = should_swap_child_order ? m_left : m_right;
+            // Child containing the ray origin is in front
+            const bool below_first = (origin[axis] < node.split_position) ||
+                (origin[axis] == node.split_position && direction[axis] <= 0.0);
+            const uint32_t first_child = below_first ? current_node_index + 1 : node.offset;
+            const uint32_t second_child = below_first ? node.offset : current_node_index + 1;
 
-    // Find closest hit of child nodes
-    const bool hit_left = first_child->Hit(ray, ray_t, out_result);
-    const bool hit_right = second_child->Hit(ray, Interval(ray_t.m_min, hit_left ? out_result.m_t : ray_t.m_max), out_result);
+            if (direction[axis] == 0.0 || t_split > t_max || t_split <= 0.0)
+            {
+                // Ray never reaches the plane within its interval
+                current_node_index = first_child;
+            }
+            else if (t_split < t_min)
+            {
+                // Ray has already crossed the plane
+                current_node_index = second_child;
+            }
+            else
+            {
+                nodes_to_visit[num_nodes_to_visit++] = { second_child, t_split, t_max };
+                current_node_index = first_child;
+                t_max = t_split;
+            }
+            continue;
+        }
 
-    return hit_left || hit_right;
+        // Empty leaves may have an offset one past the last reference, so index through data()
+        const PrimitiveId* leaf_primitives = m_primitives.data() + node.offset;
+        if constexpr (ANY_HIT)
+        {
+            if (m_primitive_store.HitAny(leaf_primitives, node.NumPrimitives(), ray, ray_t))
+            {
+                return true;
+            }
+        }
+        else if (m_primitive_store.Hit(leaf_primitives, node.NumPrimitives(), ray, Interval(ray_t.m_min, closest_so_far), out_result))
+        {
+            hit_anything = true;
+            closest_so_far = out_result.m_t;
+        }
+
+        if (num_nodes_to_visit == 0)
+        {
+            break;
+        }
+        const NodeToVisit& next = nodes_to_visit[--num_nodes_to_visit];
+        current_node_index = next.node_index;
+        t_min = next.t_min;
+        t_max = next.t_max;
+    }
+
+    return hit_anything;
 }
 
 AABB KDTreeNode::BoundingBox() const
@@ -246,7 +459,22 @@ AABB KDTreeNode::BoundingBox() const
 
 std::size_t KDTreeNode::MemoryUsedBytes() const
 {
-    return m_allocator ? m_allocator->MemoryUsedBytes() : 0;
+    return (m_nodes.size() * sizeof(FlatKDTreeNode)) + (m_primitives.size() * sizeof(PrimitiveId)) + m_primitive_store.MemoryUsedBytes();
+}
+
+const std::vector<FlatKDTreeNode>& KDTreeNode::GetNodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<PrimitiveId>& KDTreeNode::GetPrimitives() const
+{
+    return m_primitives;
+}
+
+const PrimitiveStore& KDTreeNode::GetPrimitiveStore() const
+{
+    return m_primitive_store;
 }
 
 } // namespace ART
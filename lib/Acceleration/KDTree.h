@@ -1,9 +1,8 @@
 // Copyright Mia Rolfe. All rights reserved.
 #pragma once
 
-#include <Acceleration/SplitBucket.h>
-#include <Core/ArenaAllocator.h>
 #include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
 #include <Maths/Interval.h>
 #include <Maths/Vec3.h>
 #include <RayTracing/IRayHittable.h>
@@ -12,43 +11,125 @@
 namespace ART
 {
 
+// Compact k-d tree node, interior nodes and leaves share one layout
+// Interior nodes hold a split plane only, there is no per-node bounding box
+struct alignas(16) FlatKDTreeNode
+{
+public:
+    // Interior: position of the split plane along the split axis
+    double split_position;
+    // Interior: index of the child above the split plane (the child below is always the next node)
+    // Leaf: index of first primitive reference in the primitive reference array
+    uint32_t offset;
+    // Low 2 bits: split axis (0=x, 1=y, 2=z), or LEAF_FLAG for leaves
+    // Remaining bits: number of primitive references in a leaf
+    uint32_t flags;
+
+    static constexpr uint32_t LEAF_FLAG = 3;
+
+    bool IsLeaf() const { return (flags & 3) == LEAF_FLAG; }
+    std::size_t SplitAxis() const { return flags & 3; }
+    uint32_t NumPrimitives() const { return flags >> 2; }
+};
+
+static_assert(sizeof(FlatKDTreeNode) == 16, "FlatKDTreeNode should be 16 bytes");
+
+enum class KDTreeEventType : uint8_t
+{
+    // Ordered so events at the same position are processed END, PLANAR, START
+    END = 0,
+    PLANAR = 1,
+    START = 2
+};
+
+// Bound of one primitive reference (clipped to the current voxel) along one axis
+struct KDTreeEvent
+{
+public:
+    double position;
+    uint32_t primitive_index;
+    uint8_t axis;
+    KDTreeEventType type;
+};
+
+// Spatial k-d tree
+// Primitives straddling a split plane are referenced from both sides
+// Built with the O(N log N) sorted event sweep SAH of Wald & Havran, traversed front-to-back with a t_split stack
 class KDTreeNode : public IRayHittable
 {
 public:
     KDTreeNode(std::vector<IRayHittable*>& objects);
 
-    ~KDTreeNode();
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
 
-    bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+    // Nodes are visited front to back as for HitDeferred, returning at the first primitive hit
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
 
     AABB BoundingBox() const override;
 
     std::size_t MemoryUsedBytes() const;
 
-    KDTreeNode(IRayHittable** objects, std::size_t count, ArenaAllocator& allocator);
+    const std::vector<FlatKDTreeNode>& GetNodes() const;
+
+    // Primitive references of all leaves, a primitive appears once per leaf it overlaps
+    const std::vector<PrimitiveId>& GetPrimitives() const;
+
+    const PrimitiveStore& GetPrimitiveStore() const;
+
+    // Hard limit on depth, also bounds the traversal stack
+    static constexpr std::size_t MAX_TREE_DEPTH = 64;
+
+    static constexpr double NODE_TRAVERSAL_COST     = 1.0;
+    static constexpr double HITTABLE_INTERSECT_COST = 1.5;
+    // Fraction of cost discounted for splits that cut off an empty child
+    static constexpr double EMPTY_SPACE_BONUS       = 0.2;
 
 protected:
-    void Create(IRayHittable** objects, std::size_t count, ArenaAllocator& allocator);
+    struct SplitPlane
+    {
+        double position = 0.0;
+        std::size_t axis = 0;
+        // Whether primitives lying in the split plane go below it
+        bool planar_below = true;
+        double cost = 0.0;
+    };
 
-    // Split objects using surface-area heuristic
-    // Returns index of split, 0 if no beneficial split found
-    std::size_t SplitSAH(IRayHittable** objects, std::size_t count);
+    enum class PrimitiveSide : uint8_t
+    {
+        BOTH,
+        BELOW_ONLY,
+        ABOVE_ONLY
+    };
 
-    // Fallback if SplitSAH couldn't find a good split
-    std::size_t SplitLongestAxis(IRayHittable** objects, std::size_t count);
+    // Closest hit, or with ANY_HIT the first hit found, out_result then left unwritten
+    template <bool ANY_HIT>
+    bool Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
+
+    // Recursively builds the subtree for voxel, emitting nodes depth-first
+    // events must be sorted by (axis, position, type) and are released before recursing
+    void Build(const AABB& voxel, std::vector<KDTreeEvent>& events, std::size_t num_primitives, std::size_t depth);
+
+    // Sweeps the sorted events of each axis to find the cheapest split plane strictly inside voxel
+    // Returns false if no plane is cheaper than making a leaf
+    bool FindSplit(const AABB& voxel, const std::vector<KDTreeEvent>& events, std::size_t num_primitives, SplitPlane& out_split) const;
+
+    void EmitLeaf(const std::vector<KDTreeEvent>& events, std::size_t num_primitives);
+
+    // Appends events for the primitive's bounds clipped to voxel
+    void AddClippedEvents(uint32_t primitive_index, const AABB& voxel, std::vector<KDTreeEvent>& out_events) const;
+
+    double SplitCost(double probability_below, double probability_above, std::size_t num_below, std::size_t num_above) const;
 
     AABB m_bounding_box;
-    // Only root node owns allocator
-    ArenaAllocator* m_allocator = nullptr;
-    IRayHittable* m_left = nullptr;
-    IRayHittable* m_right = nullptr;
-    // Split axis (0=x, 1=y, 2=z) and position for internal nodes
-    std::size_t m_split_axis = 0;
-    double m_split_position_along_split_axis = 0.0;
+    std::vector<FlatKDTreeNode> m_nodes;
+    // Primitive data in the order of the constructor's objects
+    PrimitiveStore m_primitive_store;
+    std::vector<PrimitiveId> m_primitives;
 
-    static constexpr double NODE_TRAVERSAL_COST     = 1.0;
-    static constexpr double HITTABLE_INTERSECT_COST = 1.0;
-    static constexpr std::size_t NUM_SAH_BUCKETS    = 12;
+    // Build-time only
+    const std::vector<IRayHittable*>* m_objects = nullptr;
+    std::vector<AABB> m_object_bounds;
+    std::vector<PrimitiveSide> m_object_sides;
 };
 
 } // namespace ART
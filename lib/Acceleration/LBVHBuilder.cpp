@@ -0,0 +1,513 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/LBVHBuilder.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ART
+{
+
+static inline int CountLeadingZeros(uint64_t value)
+{
+    if (value == 0)
+    {
+        return 64;
+    }
+#if defined(_MSC_VER)
+    unsigned long highest_set_bit = 0;
+    _BitScanReverse64(&highest_set_bit, value);
+    return 63 - static_cast<int>(highest_set_bit);
+#else
+    return __builtin_clzll(value);
+#endif
+}
+
+// Spreads the lowest 21 bits of value out so there are two zero bits between each
+static inline uint64_t ExpandBits(uint64_t value)
+{
+    value &= 0x1fffff;
+    value = (value | (value << 32)) & 0x1f00000000ffff;
+    value = (value | (value << 16)) & 0x1f0000ff0000ff;
+    value = (value | (value << 8)) & 0x100f00f00f00f00f;
+    value = (value | (value << 4)) & 0x10c30c30c30c30c3;
+    value = (value | (value << 2)) & 0x1249249249249249;
+    return value;
+}
+
+LBVHBuilder::LBVHBuilder(const std::vector<IRayHittable*>& objects, bool optimise_treelets)
+    : m_objects(objects), m_optimise_treelets(optimise_treelets)
+{
+    const std::size_t num_objects = objects.size();
+    if (num_objects == 0)
+    {
+        return;
+    }
+
+    const std::size_t num_nodes = (2 * num_objects) - 1;
+    const std::size_t first_leaf = num_objects - 1;
+
+    // Object bounds and centroid bounds, reduced per chunk
+    std::vector<AABB> object_bounding_boxes(num_objects);
+    const std::int64_t num_chunks = std::max<std::int64_t>(1, std::min<std::int64_t>(omp_get_max_threads(), num_objects / RADIX_SORT_MIN_CHUNK_SIZE));
+    std::vector<AABB> chunk_centroid_bounds(num_chunks);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+    {
+        const std::size_t begin = (num_objects * chunk_index) / num_chunks;
+        const std::size_t end = (num_objects * (chunk_index + 1)) / num_chunks;
+        AABB& centroid_bounds = chunk_centroid_bounds[chunk_index];
+        for (std::size_t object_index = begin; object_index < end; object_index++)
+        {
+            const AABB bounding_box = objects[object_index]->BoundingBox();
+            object_bounding_boxes[object_index] = bounding_box;
+            const double centroid_x = 0.5 * (bounding_box.m_x.m_min + bounding_box.m_x.m_max);
+            const double centroid_y = 0.5 * (bounding_box.m_y.m_min + bounding_box.m_y.m_max);
+            const double centroid_z = 0.5 * (bounding_box.m_z.m_min + bounding_box.m_z.m_max);
+            centroid_bounds.m_x = Interval(std::min(centroid_bounds.m_x.m_min, centroid_x), std::max(centroid_bounds.m_x.m_max, centroid_x));
+            centroid_bounds.m_y = Interval(std::min(centroid_bounds.m_y.m_min, centroid_y), std::max(centroid_bounds.m_y.m_max, centroid_y));
+            centroid_bounds.m_z = Interval(std::min(centroid_bounds.m_z.m_min, centroid_z), std::max(centroid_bounds.m_z.m_max, centroid_z));
+        }
+    }
+
+    AABB centroid_bounds;
+    for (std::int64_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+    {
+        centroid_bounds = AABB(centroid_bounds, chunk_centroid_bounds[chunk_index]);
+    }
+
+    // Quantise centroids onto a 2^21 grid per axis
+    static constexpr double MORTON_GRID_SIZE = static_cast<double>(1 << 21);
+    double grid_scale[3];
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const double extent = centroid_bounds[axis].Size();
+        grid_scale[axis] = (extent > 0.0) ? (MORTON_GRID_SIZE / extent) : 0.0;
+    }
+
+    m_sorted_primitives.resize(num_objects);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t object_index = 0; object_index < static_cast<std::int64_t>(num_objects); object_index++)
+    {
+        const AABB& bounding_box = object_bounding_boxes[object_index];
+        const double centroid_x = 0.5 * (bounding_box.m_x.m_min + bounding_box.m_x.m_max);
+        const double centroid_y = 0.5 * (bounding_box.m_y.m_min + bounding_box.m_y.m_max);
+        const double centroid_z = 0.5 * (bounding_box.m_z.m_min + bounding_box.m_z.m_max);
+        const double grid_x = std::min((centroid_x - centroid_bounds.m_x.m_min) * grid_scale[0], MORTON_GRID_SIZE - 1.0);
+        const double grid_y = std::min((centroid_y - centroid_bounds.m_y.m_min) * grid_scale[1], MORTON_GRID_SIZE - 1.0);
+        const double grid_z = std::min((centroid_z - centroid_bounds.m_z.m_min) * grid_scale[2], MORTON_GRID_SIZE - 1.0);
+
+        MortonPrimitive& primitive = m_sorted_primitives[object_index];
+        primitive.object_index = static_cast<uint32_t>(object_index);
+        primitive.morton_code = MortonCode(static_cast<uint32_t>(grid_x), static_cast<uint32_t>(grid_y), static_cast<uint32_t>(grid_z));
+    }
+
+    RadixSort(m_sorted_primitives);
+
+    m_left.resize(first_leaf);
+    m_right.resize(first_leaf);
+    m_parent.resize(num_nodes);
+    m_bounding_boxes.resize(num_nodes);
+    m_costs.resize(num_nodes);
+    m_num_primitives.resize(num_nodes);
+    m_heights.resize(num_nodes);
+    m_refit_visits = std::make_unique<std::atomic<uint32_t>[]>(first_leaf);
+    m_parent[0] = INVALID_NODE;
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t leaf_index = 0; leaf_index < static_cast<std::int64_t>(num_objects); leaf_index++)
+    {
+        m_bounding_boxes[first_leaf + leaf_index] = object_bounding_boxes[m_sorted_primitives[leaf_index].object_index];
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t node_index = 0; node_index < static_cast<std::int64_t>(first_leaf); node_index++)
+    {
+        EmitInternalNode(static_cast<uint32_t>(node_index));
+    }
+
+    // Work per leaf varies with how far up it gets before meeting an unfinished sibling
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (std::int64_t leaf_index = 0; leaf_index < static_cast<std::int64_t>(num_objects); leaf_index++)
+    {
+        Refit(static_cast<uint32_t>(first_leaf + leaf_index));
+    }
+
+    m_build_nodes.reserve(num_nodes);
+    m_build_nodes.emplace_back();
+    m_ordered_objects.reserve(num_objects);
+    Convert(0, 0);
+}
+
+const std::vector<BVHBuildNode>& LBVHBuilder::GetNodes() const
+{
+    return m_build_nodes;
+}
+
+const std::vector<IRayHittable*>& LBVHBuilder::GetOrderedObjects() const
+{
+    return m_ordered_objects;
+}
+
+void LBVHBuilder::RadixSort(std::vector<MortonPrimitive>& primitives)
+{
+    const std::size_t count = primitives.size();
+    std::vector<MortonPrimitive> scratch(count);
+
+    const std::int64_t num_chunks = std::max<std::int64_t>(1, std::min<std::int64_t>(4 * omp_get_max_threads(), count / RADIX_SORT_MIN_CHUNK_SIZE));
+    std::vector<std::size_t> chunk_offsets(num_chunks * RADIX_SIZE);
+
+    // Least significant digit first, each pass is stable
+    for (std::size_t shift = 0; shift < 64; shift += RADIX_BITS)
+    {
+        std::fill(chunk_offsets.begin(), chunk_offsets.end(), 0);
+
+        #pragma omp parallel for schedule(static)
+        for (std::int64_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+        {
+            const std::size_t begin = (count * chunk_index) / num_chunks;
+            const std::size_t end = (count * (chunk_index + 1)) / num_chunks;
+            std::size_t* histogram = chunk_offsets.data() + (chunk_index * RADIX_SIZE);
+            for (std::size_t primitive_index = begin; primitive_index < end; primitive_index++)
+            {
+                histogram[(primitives[primitive_index].morton_code >> shift) & (RADIX_SIZE - 1)]++;
+            }
+        }
+
+        // Turn counts into scatter offsets, ordered by digit then by chunk to keep the sort stable
+        std::size_t offset = 0;
+        bool all_in_one_digit = false;
+        for (std::size_t digit = 0; digit < RADIX_SIZE; digit++)
+        {
+            const std::size_t digit_start = offset;
+            for (std::int64_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+            {
+                const std::size_t digit_count = chunk_offsets[(chunk_index * RADIX_SIZE) + digit];
+                chunk_offsets[(chunk_index * RADIX_SIZE) + digit] = offset;
+                offset += digit_count;
+            }
+            all_in_one_digit = all_in_one_digit || (offset - digit_start == count);
+        }
+
+        // Pass wouldn't move anything
+        if (all_in_one_digit)
+        {
+            continue;
+        }
+
+        #pragma omp parallel for schedule(static)
+        for (std::int64_t chunk_index = 0; chunk_index < num_chunks; chunk_index++)
+        {
+            const std::size_t begin = (count * chunk_index) / num_chunks;
+            const std::size_t end = (count * (chunk_index + 1)) / num_chunks;
+            std::size_t* offsets = chunk_offsets.data() + (chunk_index * RADIX_SIZE);
+            for (std::size_t primitive_index = begin; primitive_index < end; primitive_index++)
+            {
+                const MortonPrimitive& primitive = primitives[primitive_index];
+                scratch[offsets[(primitive.morton_code >> shift) & (RADIX_SIZE - 1)]++] = primitive;
+            }
+        }
+
+        primitives.swap(scratch);
+    }
+}
+
+uint64_t LBVHBuilder::MortonCode(uint32_t x, uint32_t y, uint32_t z)
+{
+    return (ExpandBits(x) << 2) | (ExpandBits(y) << 1) | ExpandBits(z);
+}
+
+int LBVHBuilder::CommonPrefixLength(int64_t i, int64_t j) const
+{
+    if (j < 0 || j >= static_cast<int64_t>(m_sorted_primitives.size()))
+    {
+        return -1;
+    }
+
+    const uint64_t code_i = m_sorted_primitives[i].morton_code;
+    const uint64_t code_j = m_sorted_primitives[j].morton_code;
+
+    // Duplicate codes are made unique by appending the key's index
+    if (code_i == code_j)
+    {
+        return 64 + CountLeadingZeros(static_cast<uint64_t>(i ^ j));
+    }
+    return CountLeadingZeros(code_i ^ code_j);
+}
+
+void LBVHBuilder::EmitInternalNode(uint32_t node_index)
+{
+    const int64_t first_leaf = static_cast<int64_t>(m_sorted_primitives.size()) - 1;
+    const int64_t i = node_index;
+
+    // Range extends towards the neighbour sharing the longer prefix
+    const int64_t direction = (CommonPrefixLength(i, i + 1) - CommonPrefixLength(i, i - 1)) >= 0 ? 1 : -1;
+
+    // Find other end of range with an exponential then binary search
+    const int min_prefix_length = CommonPrefixLength(i, i - direction);
+    int64_t max_length = 2;
+    while (CommonPrefixLength(i, i + (max_length * direction)) > min_prefix_length)
+    {
+        max_length *= 2;
+    }
+
+    int64_t length = 0;
+    for (int64_t step = max_length / 2; step >= 1; step /= 2)
+    {
+        if (CommonPrefixLength(i, i + ((length + step) * direction)) > min_prefix_length)
+        {
+            length += step;
+        }
+    }
+    const int64_t j = i + (length * direction);
+
+    // Find where the first differing bit of the range flips
+    const int node_prefix_length = CommonPrefixLength(i, j);
+    int64_t split_offset = 0;
+    int64_t step = length;
+    do
+    {
+        step = (step + 1) / 2;
+        if (CommonPrefixLength(i, i + ((split_offset + step) * direction)) > node_prefix_length)
+        {
+            split_offset += step;
+        }
+    }
+    while (step > 1);
+    const int64_t split = i + (split_offset * direction) + std::min<int64_t>(direction, 0);
+
+    const uint32_t left = static_cast<uint32_t>((std::min(i, j) == split) ? first_leaf + split : split);
+    const uint32_t right = static_cast<uint32_t>((std::max(i, j) == split + 1) ? first_leaf + split + 1 : split + 1);
+
+    m_left[node_index] = left;
+    m_right[node_index] = right;
+    m_parent[left] = node_index;
+    m_parent[right] = node_index;
+}
+
+void LBVHBuilder::Refit(uint32_t leaf_index)
+{
+    m_costs[leaf_index] = HITTABLE_INTERSECT_COST * m_bounding_boxes[leaf_index].SurfaceArea();
+    m_num_primitives[leaf_index] = 1;
+    m_heights[leaf_index] = 1;
+
+    uint32_t node = m_parent[leaf_index];
+    while (node != INVALID_NODE)
+    {
+        // First child to finish stops here, the second carries on upwards
+        if (m_refit_visits[node].fetch_add(1, std::memory_order_acq_rel) == 0)
+        {
+            return;
+        }
+
+        const uint32_t left = m_left[node];
+        const uint32_t right = m_right[node];
+        m_bounding_boxes[node] = AABB(m_bounding_boxes[left], m_bounding_boxes[right]);
+        m_costs[node] = (NODE_TRAVERSAL_COST * m_bounding_boxes[node].SurfaceArea()) + m_costs[left] + m_costs[right];
+        m_num_primitives[node] = m_num_primitives[left] + m_num_primitives[right];
+        m_heights[node] = 1 + std::max(m_heights[left], m_heights[right]);
+
+        if (m_optimise_treelets)
+        {
+            OptimiseTreelet(node);
+        }
+
+        node = m_parent[node];
+    }
+}
+
+void LBVHBuilder::OptimiseTreelet(uint32_t root)
+{
+    uint32_t treelet_leaves[TREELET_SIZE];
+    uint32_t treelet_internals[TREELET_SIZE - 1];
+    std::size_t num_treelet_leaves = 2;
+    std::size_t num_treelet_internals = 1;
+    treelet_leaves[0] = m_left[root];
+    treelet_leaves[1] = m_right[root];
+    treelet_internals[0] = root;
+
+    // Grow treelet by opening the largest internal node, which has the most to gain from restructuring
+    while (num_treelet_leaves < TREELET_SIZE)
+    {
+        std::size_t leaf_to_open = TREELET_SIZE;
+        double largest_surface_area = -1.0;
+        for (std::size_t treelet_leaf_index = 0; treelet_leaf_index < num_treelet_leaves; treelet_leaf_index++)
+        {
+            const uint32_t node = treelet_leaves[treelet_leaf_index];
+            if (!IsLeaf(node) && m_bounding_boxes[node].SurfaceArea() > largest_surface_area)
+            {
+                largest_surface_area = m_bounding_boxes[node].SurfaceArea();
+                leaf_to_open = treelet_leaf_index;
+            }
+        }
+
+        if (leaf_to_open == TREELET_SIZE)
+        {
+            break;
+        }
+
+        const uint32_t opened = treelet_leaves[leaf_to_open];
+        treelet_internals[num_treelet_internals++] = opened;
+        treelet_leaves[leaf_to_open] = m_left[opened];
+        treelet_leaves[num_treelet_leaves++] = m_right[opened];
+    }
+
+    // Two leaves only have one topology
+    if (num_treelet_leaves < 3)
+    {
+        return;
+    }
+
+    // Optimal topology for every subset of treelet leaves, smaller subsets first
+    static constexpr std::size_t MAX_SUBSETS = 1 << TREELET_SIZE;
+    AABB subset_bounding_boxes[MAX_SUBSETS];
+    double subset_costs[MAX_SUBSETS];
+    uint32_t subset_partitions[MAX_SUBSETS];
+    uint32_t subset_heights[MAX_SUBSETS];
+    uint32_t subset_num_primitives[MAX_SUBSETS];
+
+    const uint32_t full_subset = (1u << num_treelet_leaves) - 1;
+    for (uint32_t subset = 1; subset <= full_subset; subset++)
+    {
+        std::size_t lowest_leaf_index = 0;
+        while ((subset & (1u << lowest_leaf_index)) == 0)
+        {
+            lowest_leaf_index++;
+        }
+        const uint32_t lowest_bit = 1u << lowest_leaf_index;
+        const uint32_t lowest_leaf = treelet_leaves[lowest_leaf_index];
+
+        if (subset == lowest_bit)
+        {
+            subset_bounding_boxes[subset] = m_bounding_boxes[lowest_leaf];
+            subset_costs[subset] = m_costs[lowest_leaf];
+            subset_heights[subset] = m_heights[lowest_leaf];
+            subset_num_primitives[subset] = m_num_primitives[lowest_leaf];
+            continue;
+        }
+
+        subset_bounding_boxes[subset] = AABB(subset_bounding_boxes[subset ^ lowest_bit], m_bounding_boxes[lowest_leaf]);
+        subset_num_primitives[subset] = subset_num_primitives[subset ^ lowest_bit] + m_num_primitives[lowest_leaf];
+
+        // Only partitions holding the lowest leaf, the others are mirror images of them
+        double best_children_cost = std::numeric_limits<double>::max();
+        uint32_t best_partition = 0;
+        for (uint32_t partition = (subset - 1) & subset; partition != 0; partition = (partition - 1) & subset)
+        {
+            if ((partition & lowest_bit) == 0)
+            {
+                continue;
+            }
+
+            const double children_cost = subset_costs[partition] + subset_costs[subset ^ partition];
+            if (children_cost < best_children_cost)
+            {
+                best_children_cost = children_cost;
+                best_partition = partition;
+            }
+        }
+
+        subset_costs[subset] = (NODE_TRAVERSAL_COST * subset_bounding_boxes[subset].SurfaceArea()) + best_children_cost;
+        subset_partitions[subset] = best_partition;
+        subset_heights[subset] = 1 + std::max(subset_heights[best_partition], subset_heights[subset ^ best_partition]);
+    }
+
+    // Keep current topology unless the new one is strictly better, and never grow the tree's height
+    static constexpr double relative_tolerance = 1e-9;
+    if (subset_costs[full_subset] >= m_costs[root] * (1.0 - relative_tolerance) || subset_heights[full_subset] > m_heights[root])
+    {
+        return;
+    }
+
+    // Rebuild top down, reusing the treelet's internal nodes
+    struct PendingNode
+    {
+        uint32_t node;
+        uint32_t subset;
+    };
+
+    PendingNode pending_nodes[TREELET_SIZE];
+    std::size_t num_pending_nodes = 0;
+    std::size_t num_internals_used = 1;
+    pending_nodes[num_pending_nodes++] = {root, full_subset};
+
+    while (num_pending_nodes > 0)
+    {
+        const PendingNode pending = pending_nodes[--num_pending_nodes];
+        const uint32_t partition = subset_partitions[pending.subset];
+        const uint32_t child_subsets[2] = {partition, pending.subset ^ partition};
+
+        uint32_t children[2];
+        for (std::size_t side = 0; side < 2; side++)
+        {
+            const uint32_t child_subset = child_subsets[side];
+            if ((child_subset & (child_subset - 1)) == 0)
+            {
+                std::size_t leaf_index = 0;
+                while (child_subset != (1u << leaf_index))
+                {
+                    leaf_index++;
+                }
+                children[side] = treelet_leaves[leaf_index];
+            }
+            else
+            {
+                children[side] = treelet_internals[num_internals_used++];
+                pending_nodes[num_pending_nodes++] = {children[side], child_subset};
+            }
+            m_parent[children[side]] = pending.node;
+        }
+
+        m_left[pending.node] = children[0];
+        m_right[pending.node] = children[1];
+        m_bounding_boxes[pending.node] = subset_bounding_boxes[pending.subset];
+        m_costs[pending.node] = subset_costs[pending.subset];
+        m_heights[pending.node] = subset_heights[pending.subset];
+        m_num_primitives[pending.node] = subset_num_primitives[pending.subset];
+    }
+}
+
+void LBVHBuilder::Convert(uint32_t node, uint32_t build_node_index)
+{
+    m_build_nodes[build_node_index].bounding_box = m_bounding_boxes[node];
+
+    if (m_num_primitives[node] <= BVHBuilder::MAX_PRIMITIVES_PER_LEAF)
+    {
+        m_build_nodes[build_node_index].offset = static_cast<uint32_t>(m_ordered_objects.size());
+        m_build_nodes[build_node_index].num_primitives = m_num_primitives[node];
+        GatherObjects(node);
+        return;
+    }
+
+    // Children are emitted as a pair so the second is always directly after the first
+    const uint32_t first_child_index = static_cast<uint32_t>(m_build_nodes.size());
+    m_build_nodes.emplace_back();
+    m_build_nodes.emplace_back();
+    m_build_nodes[build_node_index].offset = first_child_index;
+    m_build_nodes[build_node_index].num_primitives = 0;
+
+    Convert(m_left[node], first_child_index);
+    Convert(m_right[node], first_child_index + 1);
+}
+
+void LBVHBuilder::GatherObjects(uint32_t node)
+{
+    if (IsLeaf(node))
+    {
+        const std::size_t first_leaf = m_sorted_primitives.size() - 1;
+        m_ordered_objects.push_back(m_objects[m_sorted_primitives[node - first_leaf].object_index]);
+        return;
+    }
+
+    GatherObjects(m_left[node]);
+    GatherObjects(m_right[node]);
+}
+
+bool LBVHBuilder::IsLeaf(uint32_t node) const
+{
+    return node >= m_sorted_primitives.size() - 1;
+}
+
+} // namespace ART
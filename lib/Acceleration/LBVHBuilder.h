@@ -0,0 +1,92 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <atomic>
+
+#include <Acceleration/BVHBuilder.h>
+#include <Core/Common.h>
+#include <Geometry/AxisAlignedBoundingBox.h>
+#include <RayTracing/IRayHittable.h>
+
+namespace ART
+{
+
+// Object index tagged with the Morton code of its centroid
+struct MortonPrimitive
+{
+public:
+    uint64_t morton_code = 0;
+    uint32_t object_index = 0;
+};
+
+// Linear BVH build: objects are sorted along a 63-bit Morton curve with a parallel radix sort,
+// then the hierarchy is emitted in a single parallel pass (Karras 2012)
+// Optionally restructures small treelets to minimise SAH cost (Karras and Aila 2013)
+// Produces the same output as BVHBuilder so the result can be flattened the same way
+class LBVHBuilder
+{
+public:
+    LBVHBuilder(const std::vector<IRayHittable*>& objects, bool optimise_treelets);
+
+    // Root is the first node, empty if there were no objects
+    const std::vector<BVHBuildNode>& GetNodes() const;
+
+    // Objects reordered so each leaf references a contiguous range
+    const std::vector<IRayHittable*>& GetOrderedObjects() const;
+
+    // Sorts by Morton code, stable with respect to the input order
+    static void RadixSort(std::vector<MortonPrimitive>& primitives);
+
+    // Interleaves the lowest 21 bits of each coordinate, x in the highest position
+    static uint64_t MortonCode(uint32_t x, uint32_t y, uint32_t z);
+
+protected:
+    // Finds children of internal node i from the sorted codes
+    void EmitInternalNode(uint32_t node_index);
+
+    // Length of the longest common prefix of sorted keys i and j, -1 if j is out of range
+    int CommonPrefixLength(int64_t i, int64_t j) const;
+
+    // Computes bounds and SAH cost from the leaves up, optimising treelets on the way
+    void Refit(uint32_t leaf_index);
+
+    // Finds the SAH optimal topology over up to TREELET_SIZE descendants of root
+    // Applied only if it is cheaper and no taller, so the tree stays within the Karras depth bound
+    void OptimiseTreelet(uint32_t root);
+
+    // Emits node into m_build_nodes[build_node_index], collapsing small subtrees into leaves
+    void Convert(uint32_t node, uint32_t build_node_index);
+
+    // Appends the objects below node to m_ordered_objects
+    void GatherObjects(uint32_t node);
+
+    bool IsLeaf(uint32_t node) const;
+
+    const std::vector<IRayHittable*>& m_objects;
+    std::vector<MortonPrimitive> m_sorted_primitives;
+
+    // Nodes [0, N-1) are internal, nodes [N-1, 2N-1) are leaves in sorted order
+    std::vector<uint32_t> m_left;
+    std::vector<uint32_t> m_right;
+    std::vector<uint32_t> m_parent;
+    std::vector<AABB> m_bounding_boxes;
+    std::vector<double> m_costs;
+    std::vector<uint32_t> m_num_primitives;
+    std::vector<uint32_t> m_heights;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_refit_visits;
+    bool m_optimise_treelets;
+
+    std::vector<BVHBuildNode> m_build_nodes;
+    std::vector<IRayHittable*> m_ordered_objects;
+
+    static constexpr uint32_t INVALID_NODE = std::numeric_limits<uint32_t>::max();
+    static constexpr double NODE_TRAVERSAL_COST = 1.0;
+    static constexpr double HITTABLE_INTERSECT_COST = 1.0;
+    // Number of leaves in a restructured treelet, 5 keeps the exhaustive search to 3^5 partitions
+    static constexpr std::size_t TREELET_SIZE = 5;
+    static constexpr std::size_t RADIX_BITS = 8;
+    static constexpr std::size_t RADIX_SIZE = 1 << RADIX_BITS;
+    static constexpr std::size_t RADIX_SORT_MIN_CHUNK_SIZE = 1 << 14;
+};
+
+} // namespace ART
@@ -0,0 +1,15 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/LinearBoundingVolumeHierarchy.h>
+
+#include <Acceleration/LBVHBuilder.h>
+
+namespace ART
+{
+
+LinearBVH::LinearBVH(std::vector<IRayHittable*>& objects, bool optimise_treelets)
+{
+    const LBVHBuilder builder(objects, optimise_treelets);
+    Initialise(builder.GetNodes(), builder.GetOrderedObjects());
+}
+
+} // namespace ART
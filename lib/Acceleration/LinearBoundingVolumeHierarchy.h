@@ -0,0 +1,19 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Acceleration/FlatBoundingVolumeHierarchy.h>
+#include <Core/Common.h>
+#include <RayTracing/IRayHittable.h>
+
+namespace ART
+{
+
+// FlatBVH whose tree is built by LBVHBuilder (Morton order) instead of the binned SAH builder
+// Much faster to build, slower to trace; treelet optimisation recovers some of the trace speed
+class LinearBVH : public FlatBVH
+{
+public:
+    LinearBVH(std::vector<IRayHittable*>& objects, bool optimise_treelets = false);
+};
+
+} // namespace ART
@@ -0,0 +1,456 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/LinearOctree.h>
+
+#include <algorithm>
+#include <bitset>
+
+#include <Acceleration/LBVHBuilder.h>
+#include <Core/TraversalStats.h>
+#include <Core/Utility.h>
+
+namespace ART
+{
+
+// Slab test against a node's single precision bounds, evaluated in double precision
+static inline bool LinearOctreeNodeHit(const LinearOctreeNode& node, const Ray& ray, double ray_t_min, double ray_t_max)
+{
+    const double t0_x = (static_cast<double>(node.bounds_min[0]) - ray.m_origin.m_x) * ray.m_inverse_direction.m_x;
+    const double t1_x = (static_cast<double>(node.bounds_max[0]) - ray.m_origin.m_x) * ray.m_inverse_direction.m_x;
+    const double t0_y = (static_cast<double>(node.bounds_min[1]) - ray.m_origin.m_y) * ray.m_inverse_direction.m_y;
+    const double t1_y = (static_cast<double>(node.bounds_max[1]) - ray.m_origin.m_y) * ray.m_inverse_direction.m_y;
+    const double t0_z = (static_cast<double>(node.bounds_min[2]) - ray.m_origin.m_z) * ray.m_inverse_direction.m_z;
+    const double t1_z = (static_cast<double>(node.bounds_max[2]) - ray.m_origin.m_z) * ray.m_inverse_direction.m_z;
+
+    ray_t_min = std::max({ ray_t_min, std::min(t0_x, t1_x), std::min(t0_y, t1_y), std::min(t0_z, t1_z) });
+    ray_t_max = std::min({ ray_t_max, std::max(t0_x, t1_x), std::max(t0_y, t1_y), std::max(t0_z, t1_z) });
+
+    return ray_t_min <= ray_t_max;
+}
+
+static inline AABB LinearOctreeNodeBounds(const LinearOctreeNode& node)
+{
+    return AABB
+    (
+        node.bounds_min[0], node.bounds_max[0],
+        node.bounds_min[1], node.bounds_max[1],
+        node.bounds_min[2], node.bounds_max[2]
+    );
+}
+
+// Octal digit of code that picks a child at depth + 1
+static inline uint32_t MortonDigit(uint64_t morton_code, std::size_t depth)
+{
+    return static_cast<uint32_t>(morton_code >> (3 * (LinearOctree::MAX_DEPTH - 1 - depth))) & 7;
+}
+
+LinearOctree::LinearOctree(std::vector<IRayHittable*>& objects)
+{
+    const std::size_t num_objects = objects.size();
+    if (num_objects == 0)
+    {
+        return;
+    }
+
+    std::vector<AABB> object_bounding_boxes(num_objects);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t object_index = 0; object_index < static_cast<std::int64_t>(num_objects); object_index++)
+    {
+        object_bounding_boxes[object_index] = objects[object_index]->BoundingBox();
+    }
+
+    AABB centroid_bounds;
+    for (const AABB& bounding_box : object_bounding_boxes)
+    {
+        m_bounding_box = AABB(m_bounding_box, bounding_box);
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            const double centroid = 0.5 * (bounding_box[axis].m_min + bounding_box[axis].m_max);
+            centroid_bounds[axis] = Interval(std::min(centroid_bounds[axis].m_min, centroid), std::max(centroid_bounds[axis].m_max, centroid));
+        }
+    }
+
+    // Quantise centroids onto a 2^21 grid per axis, each octal digit of the code then picks an octant one level down
+    static constexpr double MORTON_GRID_SIZE = static_cast<double>(1 << MAX_DEPTH);
+    double grid_scale[3];
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const double extent = centroid_bounds[axis].Size();
+        grid_scale[axis] = (extent > 0.0) ? (MORTON_GRID_SIZE / extent) : 0.0;
+    }
+
+    std::vector<MortonPrimitive> sorted_primitives(num_objects);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t object_index = 0; object_index < static_cast<std::int64_t>(num_objects); object_index++)
+    {
+        const AABB& bounding_box = object_bounding_boxes[object_index];
+        const double centroid_x = 0.5 * (bounding_box.m_x.m_min + bounding_box.m_x.m_max);
+        const double centroid_y = 0.5 * (bounding_box.m_y.m_min + bounding_box.m_y.m_max);
+        const double centroid_z = 0.5 * (bounding_box.m_z.m_min + bounding_box.m_z.m_max);
+        const double grid_x = std::min((centroid_x - centroid_bounds.m_x.m_min) * grid_scale[0], MORTON_GRID_SIZE - 1.0);
+        const double grid_y = std::min((centroid_y - centroid_bounds.m_y.m_min) * grid_scale[1], MORTON_GRID_SIZE - 1.0);
+        const double grid_z = std::min((centroid_z - centroid_bounds.m_z.m_min) * grid_scale[2], MORTON_GRID_SIZE - 1.0);
+
+        MortonPrimitive& primitive = sorted_primitives[object_index];
+        primitive.object_index = static_cast<uint32_t>(object_index);
+        primitive.morton_code = LBVHBuilder::MortonCode(static_cast<uint32_t>(grid_x), static_cast<uint32_t>(grid_y), static_cast<uint32_t>(grid_z));
+    }
+
+    LBVHBuilder::RadixSort(sorted_primitives);
+
+    std::vector<uint64_t> sorted_morton_codes(num_objects);
+    std::vector<AABB> sorted_bounding_boxes(num_objects);
+    std::vector<IRayHittable*> sorted_objects(num_objects);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t primitive_index = 0; primitive_index < static_cast<std::int64_t>(num_objects); primitive_index++)
+    {
+        const MortonPrimitive& primitive = sorted_primitives[primitive_index];
+        sorted_morton_codes[primitive_index] = primitive.morton_code;
+        sorted_bounding_boxes[primitive_index] = object_bounding_boxes[primitive.object_index];
+        sorted_objects[primitive_index] = objects[primitive.object_index];
+    }
+
+    m_primitive_store = PrimitiveStore(sorted_objects);
+    m_primitives.resize(num_objects);
+    for (std::size_t primitive_index = 0; primitive_index < num_objects; primitive_index++)
+    {
+        m_primitives[primitive_index] = m_primitive_store.GetId(primitive_index);
+    }
+
+    // Emit the tree one level at a time, every node in a level is independent
+    std::vector<uint32_t> level_starts;
+    std::vector<NodeRange> level_ranges = { { 0, static_cast<uint32_t>(num_objects), 0 } };
+    m_nodes.resize(1);
+
+    while (!level_ranges.empty())
+    {
+        const std::size_t level_size = level_ranges.size();
+        const uint32_t level_start = static_cast<uint32_t>(m_nodes.size() - level_size);
+        level_starts.push_back(level_start);
+
+        std::vector<NodeRange> child_ranges(8 * level_size);
+        std::vector<uint32_t> child_offsets(level_size + 1);
+
+        #pragma omp parallel for schedule(static)
+        for (std::int64_t range_index = 0; range_index < static_cast<std::int64_t>(level_size); range_index++)
+        {
+            const NodeRange& range = level_ranges[range_index];
+            LinearOctreeNode& node = m_nodes[level_start + range_index];
+            node.depth = static_cast<uint8_t>(range.depth);
+
+            const std::size_t num_children = FindChildRanges(sorted_morton_codes, range, child_ranges.data() + (8 * range_index), node.child_mask);
+            if (num_children == 0)
+            {
+                node.offset = range.begin;
+                node.num_primitives = static_cast<uint16_t>(range.end - range.begin);
+            }
+            child_offsets[range_index + 1] = static_cast<uint32_t>(num_children);
+        }
+
+        // Children of each node follow the whole level, in the same order as their parents
+        const uint32_t next_level_start = level_start + static_cast<uint32_t>(level_size);
+        child_offsets[0] = next_level_start;
+        for (std::size_t range_index = 0; range_index < level_size; range_index++)
+        {
+            child_offsets[range_index + 1] += child_offsets[range_index];
+        }
+
+        const std::size_t next_level_size = child_offsets[level_size] - next_level_start;
+        std::vector<NodeRange> next_level_ranges(next_level_size);
+        m_nodes.resize(m_nodes.size() + next_level_size);
+
+        #pragma omp parallel for schedule(static)
+        for (std::int64_t range_index = 0; range_index < static_cast<std::int64_t>(level_size); range_index++)
+        {
+            LinearOctreeNode& node = m_nodes[level_start + range_index];
+            const uint32_t num_children = child_offsets[range_index + 1] - child_offsets[range_index];
+            if (num_children == 0)
+            {
+                continue;
+            }
+
+            node.offset = child_offsets[range_index];
+            for (uint32_t child_index = 0; child_index < num_children; child_index++)
+            {
+                next_level_ranges[node.offset - next_level_start + child_index] = child_ranges[(8 * range_index) + child_index];
+            }
+        }
+
+        level_ranges.swap(next_level_ranges);
+    }
+
+    // Bounds from the deepest level up, a level's children are all finished before it
+    level_starts.push_back(static_cast<uint32_t>(m_nodes.size()));
+    for (std::size_t level = level_starts.size() - 1; level-- > 0;)
+    {
+        #pragma omp parallel for schedule(static)
+        for (std::int64_t node_index = level_starts[level]; node_index < static_cast<std::int64_t>(level_starts[level + 1]); node_index++)
+        {
+            LinearOctreeNode& node = m_nodes[node_index];
+            AABB bounding_box;
+            if (node.child_mask == 0)
+            {
+                for (uint32_t primitive_index = node.offset; primitive_index < node.offset + node.num_primitives; primitive_index++)
+                {
+                    bounding_box = AABB(bounding_box, sorted_bounding_boxes[primitive_index]);
+                }
+                node.bounds_min[0] = RoundDownToFloat(bounding_box.m_x.m_min);
+                node.bounds_min[1] = RoundDownToFloat(bounding_box.m_y.m_min);
+                node.bounds_min[2] = RoundDownToFloat(bounding_box.m_z.m_min);
+                node.bounds_max[0] = RoundUpToFloat(bounding_box.m_x.m_max);
+                node.bounds_max[1] = RoundUpToFloat(bounding_box.m_y.m_max);
+                node.bounds_max[2] = RoundUpToFloat(bounding_box.m_z.m_max);
+                continue;
+            }
+
+            const uint32_t num_children = static_cast<uint32_t>(std::bitset<8>(node.child_mask).count());
+            const LinearOctreeNode& first_child = m_nodes[node.offset];
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                node.bounds_min[axis] = first_child.bounds_min[axis];
+                node.bounds_max[axis] = first_child.bounds_max[axis];
+            }
+            for (uint32_t child_index = node.offset + 1; child_index < node.offset + num_children; child_index++)
+            {
+                const LinearOctreeNode& child = m_nodes[child_index];
+                for (std::size_t axis = 0; axis < 3; axis++)
+                {
+                    node.bounds_min[axis] = std::min(node.bounds_min[axis], child.bounds_min[axis]);
+                    node.bounds_max[axis] = std::max(node.bounds_max[axis], child.bounds_max[axis]);
+                }
+            }
+        }
+    }
+}
+
+std::size_t LinearOctree::FindChildRanges(const std::vector<uint64_t>& sorted_morton_codes, const NodeRange& range, NodeRange out_child_ranges[8], uint8_t& out_child_mask)
+{
+    out_child_mask = 0;
+    const uint32_t count = range.end - range.begin;
+    if (count <= MAX_OBJECTS_PER_LEAF)
+    {
+        return 0;
+    }
+
+    // Codes in range share every digit above depth, so the digits at depth are sorted too
+    // A level where all codes share a digit would be a node with a single child, skip it
+    std::size_t depth = range.depth;
+    const uint64_t first_code = sorted_morton_codes[range.begin];
+    const uint64_t last_code = sorted_morton_codes[range.end - 1];
+    while (depth < MAX_DEPTH && MortonDigit(first_code, depth) == MortonDigit(last_code, depth))
+    {
+        depth++;
+    }
+
+    if (depth >= MAX_DEPTH)
+    {
+        if (count <= std::numeric_limits<uint16_t>::max())
+        {
+            return 0;
+        }
+
+        // Coincident centroids can't be separated, split them into chunks that fit in a leaf
+        out_child_mask = 0xFF;
+        for (uint32_t chunk_index = 0; chunk_index < 8; chunk_index++)
+        {
+            out_child_ranges[chunk_index] =
+            {
+                range.begin + static_cast<uint32_t>((static_cast<uint64_t>(count) * chunk_index) / 8),
+                range.begin + static_cast<uint32_t>((static_cast<uint64_t>(count) * (chunk_index + 1)) / 8),
+                std::max(range.depth, MAX_DEPTH) + 1
+            };
+        }
+        return 8;
+    }
+
+    std::size_t num_children = 0;
+    uint32_t child_begin = range.begin;
+    while (child_begin < range.end)
+    {
+        const uint32_t digit = MortonDigit(sorted_morton_codes[child_begin], depth);
+        const uint32_t child_end = static_cast<uint32_t>(std::partition_point
+        (
+            sorted_morton_codes.begin() + child_begin,
+            sorted_morton_codes.begin() + range.end,
+            [depth, digit](uint64_t morton_code) { return MortonDigit(morton_code, depth) == digit; }
+        ) - sorted_morton_codes.begin());
+
+        out_child_mask |= static_cast<uint8_t>(1 << digit);
+        out_child_ranges[num_children++] = { child_begin, child_end, depth + 1 };
+        child_begin = child_end;
+    }
+    return num_children;
+}
+
+bool LinearOctree::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    // Morton digits hold x in bit 2 and z in bit 0
+    const uint32_t direction_mask =
+        (static_cast<uint32_t>(ray.m_direction.m_x < 0.0) << 2) |
+        (static_cast<uint32_t>(ray.m_direction.m_y < 0.0) << 1) |
+        static_cast<uint32_t>(ray.m_direction.m_z < 0.0);
+
+    bool hit_anything = false;
+    double closest_so_far = ray_t.m_max;
+
+    uint32_t node_stack[MAX_STACK_SIZE];
+    std::size_t stack_size = 0;
+    node_stack[stack_size++] = 0;
+
+    while (stack_size > 0)
+    {
+        const LinearOctreeNode& node = m_nodes[node_stack[--stack_size]];
+
+        if (!LinearOctreeNodeHit(node, ray, ray_t.m_min, closest_so_far))
+        {
+            continue;
+        }
+
+        RecordNodeTraversal();
+
+        if (node.child_mask == 0)
+        {
+            if (m_primitive_store.Hit(&m_primitives[node.offset], node.num_primitives, ray, Interval(ray_t.m_min, closest_so_far), out_result))
+            {
+                hit_anything = true;
+                closest_so_far = out_result.m_t;
+            }
+            continue;
+        }
+
+        // Child of each occupied octant is offset plus the number of occupied octants before it
+        uint32_t child_indices[8];
+        uint32_t child_index = node.offset;
+        for (uint32_t digit = 0; digit < 8; digit++)
+        {
+            child_indices[digit] = child_index;
+            child_index += (node.child_mask >> digit) & 1;
+        }
+
+        // Push far children first so the nearest octant is popped next
+        for (uint32_t i = 8; i-- > 0;)
+        {
+            const uint32_t digit = i ^ direction_mask;
+            if (node.child_mask & (1 << digit))
+            {
+                node_stack[stack_size++] = child_indices[digit];
+            }
+        }
+    }
+
+    return hit_anything;
+}
+
+bool LinearOctree::HitAny(const Ray& ray, Interval ray_t) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    uint32_t node_stack[MAX_STACK_SIZE];
+    std::size_t stack_size = 0;
+    node_stack[stack_size++] = 0;
+
+    while (stack_size > 0)
+    {
+        const LinearOctreeNode& node = m_nodes[node_stack[--stack_size]];
+
+        if (!LinearOctreeNodeHit(node, ray, ray_t.m_min, ray_t.m_max))
+        {
+            continue;
+        }
+
+        RecordNodeTraversal();
+
+        if (node.child_mask == 0)
+        {
+            if (m_primitive_store.HitAny(&m_primitives[node.offset], node.num_primitives, ray, ray_t))
+            {
+                return true;
+            }
+            continue;
+        }
+
+        const uint32_t num_children = static_cast<uint32_t>(std::bitset<8>(node.child_mask).count());
+        for (uint32_t child_index = 0; child_index < num_children; child_index++)
+        {
+            node_stack[stack_size++] = node.offset + child_index;
+        }
+    }
+
+    return false;
+}
+
+AABB LinearOctree::BoundingBox() const
+{
+    return m_bounding_box;
+}
+
+std::size_t LinearOctree::MemoryUsedBytes() const
+{
+    return (m_nodes.size() * sizeof(LinearOctreeNode)) + (m_primitives.size() * sizeof(PrimitiveId)) + m_primitive_store.MemoryUsedBytes();
+}
+
+OctreeOverlapStats LinearOctree::ComputeOverlapStats() const
+{
+    OctreeOverlapStats stats;
+    double total_sibling_overlap = 0.0;
+    std::size_t num_interior_nodes = 0;
+
+    stats.num_nodes = m_nodes.size();
+    for (const LinearOctreeNode& node : m_nodes)
+    {
+        stats.max_depth = std::max(stats.max_depth, static_cast<std::size_t>(node.depth));
+        stats.num_overflow_nodes += (node.depth > MAX_DEPTH) ? 1 : 0;
+        if (node.child_mask == 0)
+        {
+            continue;
+        }
+
+        const std::size_t num_children = std::bitset<8>(node.child_mask).count();
+        double sibling_overlap = 0.0;
+        for (std::size_t child_a = 0; child_a < num_children; child_a++)
+        {
+            const AABB box_a = LinearOctreeNodeBounds(m_nodes[node.offset + child_a]);
+            for (std::size_t child_b = child_a + 1; child_b < num_children; child_b++)
+            {
+                sibling_overlap += box_a.OverlapVolume(LinearOctreeNodeBounds(m_nodes[node.offset + child_b]));
+            }
+        }
+
+        const double volume = LinearOctreeNodeBounds(node).Volume();
+        total_sibling_overlap += (volume > 0.0) ? sibling_overlap / volume : 0.0;
+        num_interior_nodes++;
+    }
+
+    if (num_interior_nodes > 0)
+    {
+        stats.average_sibling_overlap = total_sibling_overlap / static_cast<double>(num_interior_nodes);
+    }
+    return stats;
+}
+
+const std::vector<LinearOctreeNode>& LinearOctree::GetNodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<PrimitiveId>& LinearOctree::GetPrimitives() const
+{
+    return m_primitives;
+}
+
+const PrimitiveStore& LinearOctree::GetPrimitiveStore() const
+{
+    return m_primitive_store;
+}
+
+} // namespace ART
@@ -0,0 +1,93 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Acceleration/Octree.h>
+#include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
+#include <Maths/Interval.h>
+#include <Maths/Vec3.h>
+#include <RayTracing/IRayHittable.h>
+#include <RayTracing/RayHitResult.h>
+
+namespace ART
+{
+
+// Compact octree node, two per cache line
+// Children of a node are stored contiguously in octant order, empty octants are not stored
+// Bounds are stored in single precision, rounded outwards so they never shrink
+struct alignas(32) LinearOctreeNode
+{
+public:
+    float bounds_min[3];
+    // Interior: index of first child
+    // Leaf: index of first primitive in the primitive array
+    uint32_t offset;
+    float bounds_max[3];
+    // Zero for interior nodes
+    uint16_t num_primitives;
+    // Bit per occupied octant, indexed by Morton digit (bit 2: x >= centre, bit 1: y >= centre, bit 0: z >= centre)
+    // 0 for leaves
+    uint8_t child_mask;
+    uint8_t depth;
+};
+
+static_assert(sizeof(LinearOctreeNode) == 32, "LinearOctreeNode should be 32 bytes");
+
+// Octree without child pointers, built from objects sorted by the Morton codes of their centroids
+// Each node covers a contiguous run of the sorted objects, and its children are the sub-runs sharing the next octal digit
+// Nodes are emitted one level at a time in Morton order, so a node's children are found from its child mask and offset
+class LinearOctree : public IRayHittable
+{
+public:
+    LinearOctree(std::vector<IRayHittable*>& objects);
+
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Children are pushed in Morton order rather than nearest octant first, as any hit ends the query
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    AABB BoundingBox() const override;
+
+    std::size_t MemoryUsedBytes() const;
+
+    OctreeOverlapStats ComputeOverlapStats() const;
+
+    const std::vector<LinearOctreeNode>& GetNodes() const;
+
+    // Objects sorted by Morton code, each leaf references a contiguous range
+    const std::vector<PrimitiveId>& GetPrimitives() const;
+
+    const PrimitiveStore& GetPrimitiveStore() const;
+
+    // One level per octal digit of a 63-bit Morton code
+    static constexpr std::size_t MAX_DEPTH = 21;
+    // Leaves at MAX_DEPTH hold at most 2^16 - 1 objects, so up to 2^32 coincident objects need 6 more levels of chunks
+    static constexpr std::size_t MAX_TREE_DEPTH = MAX_DEPTH + 6;
+    static constexpr std::size_t MAX_OBJECTS_PER_LEAF = 4;
+
+protected:
+    // Run of sorted objects covered by a node that is yet to be emitted
+    struct NodeRange
+    {
+    public:
+        uint32_t begin;
+        uint32_t end;
+        std::size_t depth;
+    };
+
+    // Splits range into runs sharing the next octal digit, skipping levels where every object shares one
+    // Runs at MAX_DEPTH have identical codes and are split into equal chunks instead
+    // Returns the number of runs, 0 if range should be a leaf
+    static std::size_t FindChildRanges(const std::vector<uint64_t>& sorted_morton_codes, const NodeRange& range, NodeRange out_child_ranges[8], uint8_t& out_child_mask);
+
+    AABB m_bounding_box;
+    std::vector<LinearOctreeNode> m_nodes;
+    // Primitive data in Morton order
+    PrimitiveStore m_primitive_store;
+    std::vector<PrimitiveId> m_primitives;
+
+    // Every level of the tree pushes at most 7 deferred children
+    static constexpr std::size_t MAX_STACK_SIZE = (MAX_TREE_DEPTH * 7) + 1;
+};
+
+} // namespace ART
@@ -0,0 +1,318 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/LooseOctree.h>
+
+#include <algorithm>
+
+#include <Core/TraversalStats.h>
+
+namespace ART
+{
+
+LooseOctree::LooseOctree(std::vector<IRayHittable*>& objects, double looseness)
+    : m_looseness(std::clamp(looseness, MIN_LOOSENESS, MAX_LOOSENESS))
+{
+    if (objects.empty())
+    {
+        return;
+    }
+
+    m_primitive_store = PrimitiveStore(objects);
+
+    std::vector<BuildObject> build_objects;
+    build_objects.reserve(objects.size());
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    {
+        const AABB bounding_box = objects[object_index]->BoundingBox();
+        m_bounding_box = AABB(m_bounding_box, bounding_box);
+
+        const Point3 centre
+        (
+            0.5 * (bounding_box.m_x.m_min + bounding_box.m_x.m_max),
+            0.5 * (bounding_box.m_y.m_min + bounding_box.m_y.m_max),
+            0.5 * (bounding_box.m_z.m_min + bounding_box.m_z.m_max)
+        );
+        build_objects.push_back({ m_primitive_store.GetId(object_index), bounding_box, centre, 0 });
+    }
+
+    // Cells are cubes so an object's level depends only on its size
+    const double root_size = std::max({ m_bounding_box.m_x.Size(), m_bounding_box.m_y.Size(), m_bounding_box.m_z.Size() });
+    const Point3 root_centre
+    (
+        0.5 * (m_bounding_box.m_x.m_min + m_bounding_box.m_x.m_max),
+        0.5 * (m_bounding_box.m_y.m_min + m_bounding_box.m_y.m_max),
+        0.5 * (m_bounding_box.m_z.m_min + m_bounding_box.m_z.m_max)
+    );
+
+    // An object centred in a cell of size s stays inside the loose cell while its extent is at most (looseness - 1) * s
+    for (BuildObject& build_object : build_objects)
+    {
+        const double extent = std::max({ build_object.bounding_box.m_x.Size(), build_object.bounding_box.m_y.Size(), build_object.bounding_box.m_z.Size() });
+        double child_cell_size = 0.5 * root_size;
+        while (build_object.max_depth < MAX_DEPTH && extent <= (m_looseness - 1.0) * child_cell_size)
+        {
+            build_object.max_depth++;
+            child_cell_size *= 0.5;
+        }
+    }
+
+    m_nodes.resize(1);
+    Create(0, build_objects, root_centre, 0.5 * root_size, 0);
+}
+
+void LooseOctree::Create(uint32_t node_index, std::vector<BuildObject>& objects, const Point3& centre, double half_size, std::size_t depth)
+{
+    LooseOctreeNode node{};
+    node.depth = static_cast<uint8_t>(depth);
+
+    std::size_t num_movable = 0;
+    for (const BuildObject& build_object : objects)
+    {
+        num_movable += static_cast<std::size_t>(build_object.max_depth > depth);
+    }
+
+    const bool subdivide = objects.size() > MAX_OBJECTS_PER_LEAF && depth < MAX_DEPTH && num_movable > 0;
+
+    // Objects too large for a child stay here, the rest go to the child containing their centre
+    std::vector<BuildObject> objects_per_octant[8];
+    node.objects_offset = static_cast<uint32_t>(m_objects.size());
+    for (const BuildObject& build_object : objects)
+    {
+        node.bounding_box = AABB(node.bounding_box, build_object.bounding_box);
+
+        if (subdivide && build_object.max_depth > depth)
+        {
+            const std::size_t octant =
+                static_cast<std::size_t>(build_object.centre.m_x >= centre.m_x) |
+                (static_cast<std::size_t>(build_object.centre.m_y >= centre.m_y) << 1) |
+                (static_cast<std::size_t>(build_object.centre.m_z >= centre.m_z) << 2);
+            objects_per_octant[octant].push_back(build_object);
+        }
+        else
+        {
+            m_objects.push_back(build_object.id);
+        }
+    }
+    node.num_objects = static_cast<uint32_t>(m_objects.size()) - node.objects_offset;
+
+    std::size_t num_children = 0;
+    for (std::size_t octant = 0; octant < 8; octant++)
+    {
+        if (!objects_per_octant[octant].empty())
+        {
+            node.child_mask |= static_cast<uint8_t>(1 << octant);
+            num_children++;
+        }
+    }
+
+    // Children are siblings in one contiguous block
+    node.first_child = static_cast<uint32_t>(m_nodes.size());
+    m_nodes[node_index] = node;
+    if (num_children == 0)
+    {
+        return;
+    }
+    m_nodes.resize(m_nodes.size() + num_children);
+
+    std::vector<BuildObject>().swap(objects);
+
+    const double child_half_size = 0.5 * half_size;
+    uint32_t child_index = node.first_child;
+    for (std::size_t octant = 0; octant < 8; octant++)
+    {
+        if (objects_per_octant[octant].empty())
+        {
+            continue;
+        }
+
+        const Point3 child_centre
+        (
+            centre.m_x + ((octant & 1) ? child_half_size : -child_half_size),
+            centre.m_y + ((octant & 2) ? child_half_size : -child_half_size),
+            centre.m_z + ((octant & 4) ? child_half_size : -child_half_size)
+        );
+        Create(child_index++, objects_per_octant[octant], child_centre, child_half_size, depth + 1);
+    }
+}
+
+bool LooseOctree::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    const std::size_t direction_x_is_negative = static_cast<std::size_t>(ray.m_direction.m_x < 0);
+    const std::size_t direction_y_is_negative = static_cast<std::size_t>(ray.m_direction.m_y < 0);
+    const std::size_t direction_z_is_negative = static_cast<std::size_t>(ray.m_direction.m_z < 0);
+    const std::size_t direction_mask = direction_x_is_negative | (direction_y_is_negative << 1) | (direction_z_is_negative << 2);
+
+    bool hit_anything = false;
+    double closest_so_far = ray_t.m_max;
+
+    uint32_t node_stack[STACK_SIZE];
+    std::size_t stack_size = 0;
+    node_stack[stack_size++] = 0;
+
+    while (stack_size > 0)
+    {
+        const LooseOctreeNode& node = m_nodes[node_stack[--stack_size]];
+
+        // Loose cells overlap, so every child box is tested rather than stepping between cells
+        if (!node.bounding_box.Hit(ray, Interval(ray_t.m_min, closest_so_far)))
+        {
+            continue;
+        }
+
+        RecordNodeTraversal();
+
+        // Interior nodes may hold no objects, with an offset one past the last one, so index through data()
+        if (m_primitive_store.Hit(m_objects.data() + node.objects_offset, node.num_objects, ray, Interval(ray_t.m_min, closest_so_far), out_result))
+        {
+            hit_anything = true;
+            closest_so_far = out_result.m_t;
+        }
+
+        if (node.child_mask == 0)
+        {
+            continue;
+        }
+
+        uint32_t child_indices[8];
+        uint32_t child_index = node.first_child;
+        for (std::size_t octant = 0; octant < 8; octant++)
+        {
+            child_indices[octant] = child_index;
+            child_index += (node.child_mask >> octant) & 1;
+        }
+
+        // Push far children first so the nearest octant is popped next
+        for (std::size_t i = 8; i-- > 0;)
+        {
+            const std::size_t octant = i ^ direction_mask;
+            if (node.child_mask & (1 << octant))
+            {
+                node_stack[stack_size++] = child_indices[octant];
+            }
+        }
+    }
+
+    return hit_anything;
+}
+
+bool LooseOctree::HitAny(const Ray& ray, Interval ray_t) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    uint32_t node_stack[STACK_SIZE];
+    std::size_t stack_size = 0;
+    node_stack[stack_size++] = 0;
+
+    while (stack_size > 0)
+    {
+        const LooseOctreeNode& node = m_nodes[node_stack[--stack_size]];
+
+        if (!node.bounding_box.Hit(ray, ray_t))
+        {
+            continue;
+        }
+
+        RecordNodeTraversal();
+
+        if (m_primitive_store.HitAny(m_objects.data() + node.objects_offset, node.num_objects, ray, ray_t))
+        {
+            return true;
+        }
+
+        uint32_t child_index = node.first_child;
+        for (std::size_t octant = 0; octant < 8; octant++)
+        {
+            if (node.child_mask & (1 << octant))
+            {
+                node_stack[stack_size++] = child_index++;
+            }
+        }
+    }
+
+    return false;
+}
+
+AABB LooseOctree::BoundingBox() const
+{
+    return m_bounding_box;
+}
+
+std::size_t LooseOctree::MemoryUsedBytes() const
+{
+    return (m_nodes.size() * sizeof(LooseOctreeNode)) + (m_objects.size() * sizeof(PrimitiveId)) + m_primitive_store.MemoryUsedBytes();
+}
+
+OctreeOverlapStats LooseOctree::ComputeOverlapStats() const
+{
+    OctreeOverlapStats stats;
+    double total_sibling_overlap = 0.0;
+    std::size_t num_interior_nodes = 0;
+
+    stats.num_nodes = m_nodes.size();
+    for (const LooseOctreeNode& node : m_nodes)
+    {
+        stats.max_depth = std::max(stats.max_depth, static_cast<std::size_t>(node.depth));
+        if (node.child_mask == 0)
+        {
+            continue;
+        }
+
+        stats.num_interior_objects += node.num_objects;
+
+        std::size_t num_children = 0;
+        for (std::size_t octant = 0; octant < 8; octant++)
+        {
+            num_children += (node.child_mask >> octant) & 1;
+        }
+
+        double sibling_overlap = 0.0;
+        for (std::size_t child_a = 0; child_a < num_children; child_a++)
+        {
+            for (std::size_t child_b = child_a + 1; child_b < num_children; child_b++)
+            {
+                const AABB& box_a = m_nodes[node.first_child + child_a].bounding_box;
+                const AABB& box_b = m_nodes[node.first_child + child_b].bounding_box;
+                sibling_overlap += box_a.OverlapVolume(box_b);
+            }
+        }
+
+        const double volume = node.bounding_box.Volume();
+        total_sibling_overlap += (volume > 0.0) ? sibling_overlap / volume : 0.0;
+        num_interior_nodes++;
+    }
+
+    if (num_interior_nodes > 0)
+    {
+        stats.average_sibling_overlap = total_sibling_overlap / static_cast<double>(num_interior_nodes);
+    }
+    return stats;
+}
+
+const std::vector<LooseOctreeNode>& LooseOctree::GetNodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<PrimitiveId>& LooseOctree::GetObjects() const
+{
+    return m_objects;
+}
+
+const PrimitiveStore& LooseOctree::GetPrimitiveStore() const
+{
+    return m_primitive_store;
+}
+
+double LooseOctree::GetLooseness() const
+{
+    return m_looseness;
+}
+
+} // namespace ART
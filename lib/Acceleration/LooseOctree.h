@@ -0,0 +1,89 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Acceleration/Octree.h>
+#include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
+#include <Maths/Interval.h>
+#include <Maths/Vec3.h>
+#include <RayTracing/IRayHittable.h>
+#include <RayTracing/RayHitResult.h>
+
+namespace ART
+{
+
+// Children of a node are stored contiguously in octant order, empty octants are not stored
+struct LooseOctreeNode
+{
+public:
+    // Bounds of everything stored in the subtree, never larger than the node's loose cell
+    AABB bounding_box;
+    uint32_t first_child;
+    uint32_t objects_offset;
+    uint32_t num_objects;
+    // Bit per occupied octant (bit 0: x >= centre, bit 1: y >= centre, bit 2: z >= centre), 0 for leaves
+    uint8_t child_mask;
+    uint8_t depth;
+};
+
+// Octree of cubic cells where each cell accepts objects reaching up to looseness times its size
+// Every object is stored exactly once, in the deepest cell it fits in that contains its centre, so interior nodes hold
+// objects too large for their children instead of duplicating or chaining them
+class LooseOctree : public IRayHittable
+{
+public:
+    // A looseness of 1 gives tight cells, below the root only point-sized objects fit in them
+    // looseness is clamped to [MIN_LOOSENESS, MAX_LOOSENESS]
+    LooseOctree(std::vector<IRayHittable*>& objects, double looseness = DEFAULT_LOOSENESS);
+
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Nodes are popped in storage order rather than nearest octant first, as any hit ends the query
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    AABB BoundingBox() const override;
+
+    std::size_t MemoryUsedBytes() const;
+
+    OctreeOverlapStats ComputeOverlapStats() const;
+
+    const std::vector<LooseOctreeNode>& GetNodes() const;
+
+    // Objects of all nodes, each node's objects are contiguous
+    const std::vector<PrimitiveId>& GetObjects() const;
+
+    const PrimitiveStore& GetPrimitiveStore() const;
+
+    double GetLooseness() const;
+
+    static constexpr double DEFAULT_LOOSENESS = 2.0;
+    static constexpr double MIN_LOOSENESS = 1.0;
+    static constexpr double MAX_LOOSENESS = 4.0;
+    static constexpr std::size_t MAX_DEPTH = 20;
+    static constexpr std::size_t MAX_OBJECTS_PER_LEAF = 4;
+
+protected:
+    struct BuildObject
+    {
+    public:
+        PrimitiveId id;
+        AABB bounding_box;
+        Point3 centre;
+        // Deepest level whose loose cells are large enough to hold the object
+        std::size_t max_depth;
+    };
+
+    // Builds the subtree for the cube at centre into m_nodes[node_index], objects is released before recursing
+    void Create(uint32_t node_index, std::vector<BuildObject>& objects, const Point3& centre, double half_size, std::size_t depth);
+
+    AABB m_bounding_box;
+    double m_looseness;
+    std::vector<LooseOctreeNode> m_nodes;
+    // Primitive data in the order of the constructor's objects
+    PrimitiveStore m_primitive_store;
+    std::vector<PrimitiveId> m_objects;
+
+    static constexpr std::size_t STACK_SIZE = 8 * (MAX_DEPTH + 1);
+};
+
+} // namespace ART
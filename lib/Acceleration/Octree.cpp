@@ -1,6 +1,8 @@
 // Copyright Mia Rolfe. All rights reserved.
 #include <Acceleration/Octree.h>
 
+#include <algorithm>
+
 #include <Core/TraversalStats.h>
 
 namespace ART
@@ -12,20 +14,32 @@ OctreeNode::OctreeNode(std::vector<IRayHittable*>& objects)
     const std::size_t arena_size = (8 * objects.size()) * sizeof(OctreeNode);
     m_allocator = new ArenaAllocator(arena_size);
 
-    Create(objects.data(), objects.size(), 0, *m_allocator);
+    PrimitiveStore* primitive_store = new PrimitiveStore(objects);
+    PrimitiveId* primitives = static_cast<PrimitiveId*>
+    (
+        m_allocator->Alloc(objects.size() * sizeof(PrimitiveId), alignof(PrimitiveId))
+    );
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    {
+        primitives[object_index] = primitive_store->GetId(object_index);
+    }
+
+    Create(primitives, objects.size(), 0, *m_allocator, *primitive_store);
 }
 
-OctreeNode::OctreeNode(IRayHittable** objects, std::size_t count, std::size_t depth, ArenaAllocator& allocator)
+OctreeNode::OctreeNode(PrimitiveId* primitives, std::size_t count, std::size_t depth, ArenaAllocator& allocator, const PrimitiveStore& primitive_store)
     : m_allocator(nullptr)
 {
-    Create(objects, count, depth, allocator);
+    Create(primitives, count, depth, allocator, primitive_store);
 }
 
 OctreeNode::~OctreeNode()
 {
-    // Only root node owns the allocator
+    // Only root node owns the allocator and the primitive store
     if (m_allocator)
     {
+        delete m_primitive_store;
+        m_primitive_store = nullptr;
         delete m_allocator;
         m_allocator = nullptr;
     }
@@ -49,12 +63,14 @@ std::size_t OctreeNode::GetOctant(const AABB& bounding_box) const
     return (x_bit | (y_bit << 1) | (z_bit << 2));
 }
 
-void OctreeNode::Create(IRayHittable** objects, std::size_t count, std::size_t depth, ArenaAllocator& allocator)
+void OctreeNode::Create(PrimitiveId* primitives, std::size_t count, std::size_t depth, ArenaAllocator& allocator, const PrimitiveStore& primitive_store)
 {
+    m_primitive_store = &primitive_store;
+
     // Compute bounding box for this node
     for (std::size_t object_index = 0; object_index < count; object_index++)
     {
-        m_bounding_box = AABB(m_bounding_box, objects[object_index]->BoundingBox());
+        m_bounding_box = AABB(m_bounding_box, primitive_store.BoundingBox(primitives[object_index]));
     }
 
     // Split point must be at centre of bounding box
@@ -65,23 +81,18 @@ void OctreeNode::Create(IRayHittable** objects, std::size_t count, std::size_t d
         0.5 * (m_bounding_box.m_z.m_min + m_bounding_box.m_z.m_max)
     );
 
-    // Create leaf node if object density low enough (and fits in eight children)
+    // Create leaf node if object density low enough
     if (count <= MAX_OBJECTS_PER_LEAF)
     {
-        m_leaf_count = count;
-        for (std::size_t i = 0; i < count; i++)
-        {
-            m_children[i] = objects[i];
-        }
+        m_primitives = primitives;
+        m_num_primitives = count;
         return;
     }
 
-    // At max depth or all objects in same octant, can't subdivide more
-    // Chain overflow into child nodes
     std::size_t object_count_per_octant[8] = {0};
     for (std::size_t object_index = 0; object_index < count; object_index++)
     {
-        object_count_per_octant[GetOctant(objects[object_index]->BoundingBox())]++;
+        object_count_per_octant[GetOctant(primitive_store.BoundingBox(primitives[object_index]))]++;
     }
 
     std::size_t num_occupied_octants = 0;
@@ -90,26 +101,11 @@ void OctreeNode::Create(IRayHittable** objects, std::size_t count, std::size_t d
         num_occupied_octants += static_cast<std::size_t>(object_count_per_octant[octant_index] > 0);
     }
 
+    // At max depth or all objects in same octant, can't subdivide more, so the leaf takes all of them
     if (depth >= MAX_DEPTH || num_occupied_octants <= 1)
     {
-        if (count <= 8)
-        {
-            m_leaf_count = count;
-            for (std::size_t i = 0; i < count; i++)
-            {
-                m_children[i] = objects[i];
-            }
-        }
-        else
-        {
-            // Store first 7 objects directly, chain remainder into a child node
-            m_leaf_count = 8;
-            for (std::size_t i = 0; i < 7; i++)
-            {
-                m_children[i] = objects[i];
-            }
-            m_children[7] = allocator.Create<OctreeNode>(objects + 7, count - 7, depth, allocator);
-        }
+        m_primitives = primitives;
+        m_num_primitives = count;
         return;
     }
 
@@ -127,15 +123,15 @@ void OctreeNode::Create(IRayHittable** objects, std::size_t count, std::size_t d
         octant_next_free_index[i] = octant_start_offsets[i];
     }
 
-    IRayHittable** objects_sorted_by_octant = static_cast<IRayHittable**>
+    PrimitiveId* primitives_sorted_by_octant = static_cast<PrimitiveId*>
     (
-        allocator.Alloc(count * sizeof(IRayHittable*), alignof(IRayHittable*))
+        allocator.Alloc(count * sizeof(PrimitiveId), alignof(PrimitiveId))
     );
 
     for (std::size_t object_index = 0; object_index < count; object_index++)
     {
-        const std::size_t octant = GetOctant(objects[object_index]->BoundingBox());
-        objects_sorted_by_octant[octant_next_free_index[octant]++] = objects[object_index];
+        const std::size_t octant = GetOctant(primitive_store.BoundingBox(primitives[object_index]));
+        primitives_sorted_by_octant[octant_next_free_index[octant]++] = primitives[object_index];
     }
 
     // Create child nodes
@@ -145,16 +141,17 @@ void OctreeNode::Create(IRayHittable** objects, std::size_t count, std::size_t d
         {
             m_children[octant] = allocator.Create<OctreeNode>
             (
-                objects_sorted_by_octant + octant_start_offsets[octant],
+                primitives_sorted_by_octant + octant_start_offsets[octant],
                 object_count_per_octant[octant],
                 depth + 1,
-                allocator
+                allocator,
+                primitive_store
             );
         }
     }
 }
 
-bool OctreeNode::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+bool OctreeNode::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
     if (!m_bounding_box.Hit(ray, ray_t))
     {
@@ -164,20 +161,9 @@ bool OctreeNode::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) c
     RecordNodeTraversal();
 
     // Leaf node: test stored objects
-    if (m_leaf_count > 0)
+    if (m_num_primitives > 0)
     {
-        bool hit_anything = false;
-        double closest_so_far = ray_t.m_max;
-
-        for (std::size_t object_index = 0; object_index < m_leaf_count; object_index++)
-        {
-            if (m_children[object_index]->Hit(ray, Interval(ray_t.m_min, closest_so_far), out_result))
-            {
-                hit_anything = true;
-                closest_so_far = out_result.m_t;
-            }
-        }
-        return hit_anything;
+        return m_primitive_store->Hit(m_primitives, m_num_primitives, ray, ray_t, out_result);
     }
 
     const std::size_t direction_x_is_negative = static_cast<std::size_t>(ray.m_direction.m_x < 0);
@@ -191,7 +177,7 @@ bool OctreeNode::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) c
     for (std::size_t i = 0; i < 8; i++)
     {
         const std::size_t octant = i ^ direction_mask;
-        if (m_children[octant] && m_children[octant]->Hit(ray, Interval(ray_t.m_min, closest_so_far), out_result))
+        if (m_children[octant] && m_children[octant]->HitDeferred(ray, Interval(ray_t.m_min, closest_so_far), out_result))
         {
             hit_anything = true;
             closest_so_far = out_result.m_t;
@@ -201,6 +187,32 @@ bool OctreeNode::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) c
     return hit_anything;
 }
 
+bool OctreeNode::HitAny(const Ray& ray, Interval ray_t) const
+{
+    if (!m_bounding_box.Hit(ray, ray_t))
+    {
+        return false;
+    }
+
+    RecordNodeTraversal();
+
+    if (m_num_primitives > 0)
+    {
+        return m_primitive_store->HitAny(m_primitives, m_num_primitives, ray, ray_t);
+    }
+
+    // Any hit ends the query, so children are tested in storage order rather than front to back
+    for (std::size_t child_index = 0; child_index < 8; child_index++)
+    {
+        if (m_children[child_index] && m_children[child_index]->HitAny(ray, ray_t))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 AABB OctreeNode::BoundingBox() const
 {
     return m_bounding_box;
@@ -208,7 +220,59 @@ AABB OctreeNode::BoundingBox() const
 
 std::size_t OctreeNode::MemoryUsedBytes() const
 {
-    return m_allocator ? m_allocator->MemoryUsedBytes() : 0;
+    return m_allocator ? m_allocator->MemoryUsedBytes() + m_primitive_store->MemoryUsedBytes() : 0;
+}
+
+const PrimitiveStore& OctreeNode::GetPrimitiveStore() const
+{
+    return *m_primitive_store;
+}
+
+OctreeOverlapStats OctreeNode::ComputeOverlapStats() const
+{
+    OctreeOverlapStats stats;
+    double total_sibling_overlap = 0.0;
+    std::size_t num_interior_nodes = 0;
+    AccumulateOverlapStats(stats, 0, total_sibling_overlap, num_interior_nodes);
+
+    if (num_interior_nodes > 0)
+    {
+        stats.average_sibling_overlap = total_sibling_overlap / static_cast<double>(num_interior_nodes);
+    }
+    return stats;
+}
+
+void OctreeNode::AccumulateOverlapStats(OctreeOverlapStats& stats, std::size_t depth, double& total_sibling_overlap, std::size_t& num_interior_nodes) const
+{
+    stats.num_nodes++;
+    stats.max_depth = std::max(stats.max_depth, depth);
+
+    if (m_num_primitives > 0)
+    {
+        stats.num_overflow_nodes += (m_num_primitives > MAX_OBJECTS_PER_LEAF) ? 1 : 0;
+        return;
+    }
+
+    double sibling_overlap = 0.0;
+    for (std::size_t octant_a = 0; octant_a < 8; octant_a++)
+    {
+        if (!m_children[octant_a])
+        {
+            continue;
+        }
+        for (std::size_t octant_b = octant_a + 1; octant_b < 8; octant_b++)
+        {
+            if (m_children[octant_b])
+            {
+                sibling_overlap += m_children[octant_a]->BoundingBox().OverlapVolume(m_children[octant_b]->BoundingBox());
+            }
+        }
+        m_children[octant_a]->AccumulateOverlapStats(stats, depth + 1, total_sibling_overlap, num_interior_nodes);
+    }
+
+    const double volume = m_bounding_box.Volume();
+    total_sibling_overlap += (volume > 0.0) ? sibling_overlap / volume : 0.0;
+    num_interior_nodes++;
 }
 
 } // namespace ART
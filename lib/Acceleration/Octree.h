@@ -3,6 +3,7 @@
 
 #include <Core/ArenaAllocator.h>
 #include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
 #include <Maths/Interval.h>
 #include <Maths/Vec3.h>
 #include <RayTracing/IRayHittable.h>
@@ -11,6 +12,21 @@
 namespace ART
 {
 
+// Shape of an octree, used to compare how much sibling nodes overlap between octree variants
+struct OctreeOverlapStats
+{
+public:
+    std::size_t num_nodes = 0;
+    std::size_t max_depth = 0;
+    // Objects held by interior nodes because they were too large for any child
+    std::size_t num_interior_objects = 0;
+    // Leaves over the per-leaf object limit because they couldn't be split any further, or the nodes such a leaf's
+    // objects are chained into where a variant caps leaf size
+    std::size_t num_overflow_nodes = 0;
+    // Mean over interior nodes of the volume shared by pairs of children, relative to the parent's volume
+    double average_sibling_overlap = 0.0;
+};
+
 class OctreeNode : public IRayHittable
 {
 public:
@@ -18,24 +34,43 @@ public:
 
     ~OctreeNode();
 
-    bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+    // Can't be copied, the root owns and frees the arena and primitive store every node points into
+    OctreeNode(const OctreeNode&) = delete;
+    OctreeNode& operator=(const OctreeNode&) = delete;
+
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
 
     AABB BoundingBox() const override;
 
     std::size_t MemoryUsedBytes() const;
 
-    OctreeNode(IRayHittable** objects, std::size_t count, std::size_t depth, ArenaAllocator& allocator);
+    OctreeOverlapStats ComputeOverlapStats() const;
+
+    // Primitive data in the order of the constructor's objects, shared by every node
+    const PrimitiveStore& GetPrimitiveStore() const;
+
+    // Leaves keep pointers into primitives, so it must live as long as the tree
+    OctreeNode(PrimitiveId* primitives, std::size_t count, std::size_t depth, ArenaAllocator& allocator, const PrimitiveStore& primitive_store);
 
 protected:
-    void Create(IRayHittable** objects, std::size_t count, std::size_t depth, ArenaAllocator& allocator);
+    void Create(PrimitiveId* primitives, std::size_t count, std::size_t depth, ArenaAllocator& allocator, const PrimitiveStore& primitive_store);
 
     std::size_t GetOctant(const AABB& box) const;
 
+    void AccumulateOverlapStats(OctreeOverlapStats& stats, std::size_t depth, double& total_sibling_overlap, std::size_t& num_interior_nodes) const;
+
     AABB m_bounding_box;
+    // Only root node owns allocator and primitive store
     ArenaAllocator* m_allocator = nullptr;
-    IRayHittable* m_children[8] = {nullptr};
+    const PrimitiveStore* m_primitive_store = nullptr;
+    // Interior nodes only
+    OctreeNode* m_children[8] = {nullptr};
     Point3 m_split_centre;
-    std::size_t m_leaf_count = 0;
+    // Leaf nodes only, tested together through the store
+    const PrimitiveId* m_primitives = nullptr;
+    std::size_t m_num_primitives = 0;
 
     static constexpr std::size_t MAX_DEPTH = 20;
     static constexpr std::size_t MAX_OBJECTS_PER_LEAF = 4;
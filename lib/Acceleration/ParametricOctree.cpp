@@ -0,0 +1,365 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/ParametricOctree.h>
+
+#include <algorithm>
+
+#include <Core/TraversalStats.h>
+
+namespace ART
+{
+
+ParametricOctree::ParametricOctree(std::vector<IRayHittable*>& objects)
+{
+    if (objects.empty())
+    {
+        return;
+    }
+
+    m_primitive_store = PrimitiveStore(objects);
+
+    std::vector<PrimitiveId> root_objects(objects.size());
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    {
+        root_objects[object_index] = m_primitive_store.GetId(object_index);
+        m_bounding_box = AABB(m_bounding_box, m_primitive_store.BoundingBox(root_objects[object_index]));
+    }
+
+    m_nodes.resize(1);
+    Create(0, root_objects, m_bounding_box, 0);
+}
+
+void ParametricOctree::Create(uint32_t node_index, std::vector<PrimitiveId>& objects, const AABB& cell, std::size_t depth)
+{
+    ParametricOctreeNode node{};
+
+    const double centre[3] =
+    {
+        0.5 * (cell.m_x.m_min + cell.m_x.m_max),
+        0.5 * (cell.m_y.m_min + cell.m_y.m_max),
+        0.5 * (cell.m_z.m_min + cell.m_z.m_max)
+    };
+
+    std::vector<PrimitiveId> objects_per_octant[8];
+    bool subdivide = objects.size() > MAX_OBJECTS_PER_LEAF && depth < MAX_DEPTH;
+
+    if (subdivide)
+    {
+        // Objects go in every octant their bounds overlap
+        for (PrimitiveId object : objects)
+        {
+            const AABB bounding_box = m_primitive_store.BoundingBox(object);
+            const bool in_low_half[3] =
+            {
+                bounding_box.m_x.m_min <= centre[0],
+                bounding_box.m_y.m_min <= centre[1],
+                bounding_box.m_z.m_min <= centre[2]
+            };
+            const bool in_high_half[3] =
+            {
+                bounding_box.m_x.m_max >= centre[0],
+                bounding_box.m_y.m_max >= centre[1],
+                bounding_box.m_z.m_max >= centre[2]
+            };
+
+            for (std::size_t octant = 0; octant < 8; octant++)
+            {
+                const bool overlaps =
+                    ((octant & 1) ? in_high_half[0] : in_low_half[0]) &&
+                    ((octant & 2) ? in_high_half[1] : in_low_half[1]) &&
+                    ((octant & 4) ? in_high_half[2] : in_low_half[2]);
+                if (overlaps)
+                {
+                    objects_per_octant[octant].push_back(object);
+                }
+            }
+        }
+
+        // Duplicated references can make subdividing cost more than it saves, so only split if the SAH says so
+        // Each octant has a quarter of the cell's surface area
+        std::size_t num_child_references = 0;
+        for (std::size_t octant = 0; octant < 8; octant++)
+        {
+            num_child_references += objects_per_octant[octant].size();
+        }
+        const double split_cost = NODE_TRAVERSAL_COST + 0.25 * num_child_references * HITTABLE_INTERSECT_COST;
+        subdivide = split_cost < objects.size() * HITTABLE_INTERSECT_COST;
+    }
+
+    if (!subdivide)
+    {
+        node.offset = static_cast<uint32_t>(m_primitives.size());
+        node.num_primitives = static_cast<uint32_t>(objects.size());
+        m_primitives.insert(m_primitives.end(), objects.begin(), objects.end());
+        m_nodes[node_index] = node;
+        return;
+    }
+
+    std::size_t num_children = 0;
+    for (std::size_t octant = 0; octant < 8; octant++)
+    {
+        if (!objects_per_octant[octant].empty())
+        {
+            node.child_mask |= static_cast<uint8_t>(1 << octant);
+            num_children++;
+        }
+    }
+
+    // Children are siblings in one contiguous block
+    node.offset = static_cast<uint32_t>(m_nodes.size());
+    m_nodes[node_index] = node;
+    m_nodes.resize(m_nodes.size() + num_children);
+
+    std::vector<PrimitiveId>().swap(objects);
+
+    uint32_t child_index = node.offset;
+    for (std::size_t octant = 0; octant < 8; octant++)
+    {
+        if (objects_per_octant[octant].empty())
+        {
+            continue;
+        }
+
+        const AABB child_cell
+        (
+            (octant & 1) ? centre[0] : cell.m_x.m_min, (octant & 1) ? cell.m_x.m_max : centre[0],
+            (octant & 2) ? centre[1] : cell.m_y.m_min, (octant & 2) ? cell.m_y.m_max : centre[1],
+            (octant & 4) ? centre[2] : cell.m_z.m_min, (octant & 4) ? cell.m_z.m_max : centre[2]
+        );
+        Create(child_index++, objects_per_octant[octant], child_cell, depth + 1);
+    }
+}
+
+template <bool ANY_HIT>
+bool ParametricOctree::HitNode
+(
+    const Ray& ray,
+    uint32_t node_index,
+    const double t_near[3],
+    const double t_far[3],
+    const double cell_min[3],
+    const double cell_max[3],
+    double ray_t_min,
+    double& closest_so_far,
+    RayHitResult& out_result
+) const
+{
+    RecordNodeTraversal();
+
+    const ParametricOctreeNode& node = m_nodes[node_index];
+
+    if (node.child_mask == 0)
+    {
+        const PrimitiveId* leaf_primitives = m_primitives.data() + node.offset;
+        if constexpr (ANY_HIT)
+        {
+            return m_primitive_store.HitAny(leaf_primitives, node.num_primitives, ray, Interval(ray_t_min, closest_so_far));
+        }
+        else
+        {
+            if (!m_primitive_store.Hit(leaf_primitives, node.num_primitives, ray, Interval(ray_t_min, closest_so_far), out_result))
+            {
+                return false;
+            }
+            closest_so_far = out_result.m_t;
+            return true;
+        }
+    }
+
+    const double origin[3] = { ray.m_origin.m_x, ray.m_origin.m_y, ray.m_origin.m_z };
+    const double direction[3] = { ray.m_direction.m_x, ray.m_direction.m_y, ray.m_direction.m_z };
+    const double inverse_direction[3] = { ray.m_inverse_direction.m_x, ray.m_inverse_direction.m_y, ray.m_inverse_direction.m_z };
+
+    double centre[3];
+    double t_mid[3];
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        centre[axis] = 0.5 * (cell_min[axis] + cell_max[axis]);
+        if (direction[axis] != 0.0)
+        {
+            t_mid[axis] = (centre[axis] - origin[axis]) * inverse_direction[axis];
+        }
+        else
+        {
+            // Ray parallel to the plane stays in whichever half its origin is in
+            t_mid[axis] = (origin[axis] < centre[axis]) ? infinity : -infinity;
+        }
+    }
+
+    // Octants are tracked relative to the ray, bit set meaning the half further along the ray
+    // XOR with the mirror mask maps them back to real octants
+    const std::size_t mirror_mask =
+        static_cast<std::size_t>(direction[0] < 0.0) |
+        (static_cast<std::size_t>(direction[1] < 0.0) << 1) |
+        (static_cast<std::size_t>(direction[2] < 0.0) << 2);
+
+    // First child is found from the plane the ray enters the cell through
+    const double t_entry = std::max(t_near[0], std::max(t_near[1], t_near[2]));
+    std::size_t relative_octant = 0;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        if (t_mid[axis] < t_entry)
+        {
+            relative_octant |= static_cast<std::size_t>(1) << axis;
+        }
+    }
+
+    bool hit_anything = false;
+
+    while (true)
+    {
+        double child_t_near[3];
+        double child_t_far[3];
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            const bool far_half = (relative_octant >> axis) & 1;
+            child_t_near[axis] = far_half ? t_mid[axis] : t_near[axis];
+            child_t_far[axis] = far_half ? t_far[axis] : t_mid[axis];
+        }
+        const double child_t_entry = std::max(child_t_near[0], std::max(child_t_near[1], child_t_near[2]));
+        const double child_t_exit = std::min(child_t_far[0], std::min(child_t_far[1], child_t_far[2]));
+
+        if (child_t_entry > closest_so_far)
+        {
+            break;
+        }
+
+        const std::size_t octant = relative_octant ^ mirror_mask;
+        if (((node.child_mask >> octant) & 1) && child_t_exit >= ray_t_min && child_t_entry <= child_t_exit)
+        {
+            // Only occupied octants are stored, so skip over earlier occupied siblings
+            uint32_t child_index = node.offset;
+            for (std::size_t earlier_octant = 0; earlier_octant < octant; earlier_octant++)
+            {
+                child_index += (node.child_mask >> earlier_octant) & 1;
+            }
+
+            double child_cell_min[3];
+            double child_cell_max[3];
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                const bool high_half = (octant >> axis) & 1;
+                child_cell_min[axis] = high_half ? centre[axis] : cell_min[axis];
+                child_cell_max[axis] = high_half ? cell_max[axis] : centre[axis];
+            }
+
+            if (HitNode<ANY_HIT>(ray, child_index, child_t_near, child_t_far, child_cell_min, child_cell_max, ray_t_min, closest_so_far, out_result))
+            {
+                if constexpr (ANY_HIT)
+                {
+                    return true;
+                }
+                hit_anything = true;
+            }
+        }
+
+        // Every later child starts where this one ends
+        if (closest_so_far <= child_t_exit)
+        {
+            break;
+        }
+
+        // Step across the plane the ray leaves this child through
+        std::size_t exit_axis = 0;
+        if (child_t_far[1] < child_t_far[exit_axis])
+        {
+            exit_axis = 1;
+        }
+        if (child_t_far[2] < child_t_far[exit_axis])
+        {
+            exit_axis = 2;
+        }
+        const std::size_t exit_bit = static_cast<std::size_t>(1) << exit_axis;
+        if (relative_octant & exit_bit)
+        {
+            break;
+        }
+        relative_octant |= exit_bit;
+    }
+
+    return hit_anything;
+}
+
+bool ParametricOctree::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    return Traverse<false>(ray, ray_t, out_result);
+}
+
+bool ParametricOctree::HitAny(const Ray& ray, Interval ray_t) const
+{
+    RayHitResult result;
+    return Traverse<true>(ray, ray_t, result);
+}
+
+template <bool ANY_HIT>
+bool ParametricOctree::Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    const double origin[3] = { ray.m_origin.m_x, ray.m_origin.m_y, ray.m_origin.m_z };
+    const double direction[3] = { ray.m_direction.m_x, ray.m_direction.m_y, ray.m_direction.m_z };
+    const double inverse_direction[3] = { ray.m_inverse_direction.m_x, ray.m_inverse_direction.m_y, ray.m_inverse_direction.m_z };
+    const double cell_min[3] = { m_bounding_box.m_x.m_min, m_bounding_box.m_y.m_min, m_bounding_box.m_z.m_min };
+    const double cell_max[3] = { m_bounding_box.m_x.m_max, m_bounding_box.m_y.m_max, m_bounding_box.m_z.m_max };
+
+    double t_near[3];
+    double t_far[3];
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        if (direction[axis] != 0.0)
+        {
+            const double t0 = (cell_min[axis] - origin[axis]) * inverse_direction[axis];
+            const double t1 = (cell_max[axis] - origin[axis]) * inverse_direction[axis];
+            t_near[axis] = std::min(t0, t1);
+            t_far[axis] = std::max(t0, t1);
+        }
+        else if (origin[axis] >= cell_min[axis] && origin[axis] <= cell_max[axis])
+        {
+            t_near[axis] = -infinity;
+            t_far[axis] = infinity;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    const double t_entry = std::max(ray_t.m_min, std::max(t_near[0], std::max(t_near[1], t_near[2])));
+    const double t_exit = std::min(ray_t.m_max, std::min(t_far[0], std::min(t_far[1], t_far[2])));
+    if (t_entry > t_exit)
+    {
+        return false;
+    }
+
+    double closest_so_far = ray_t.m_max;
+    return HitNode<ANY_HIT>(ray, 0, t_near, t_far, cell_min, cell_max, ray_t.m_min, closest_so_far, out_result);
+}
+
+AABB ParametricOctree::BoundingBox() const
+{
+    return m_bounding_box;
+}
+
+std::size_t ParametricOctree::MemoryUsedBytes() const
+{
+    return (m_nodes.size() * sizeof(ParametricOctreeNode)) + (m_primitives.size() * sizeof(PrimitiveId)) + m_primitive_store.MemoryUsedBytes();
+}
+
+const std::vector<ParametricOctreeNode>& ParametricOctree::GetNodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<PrimitiveId>& ParametricOctree::GetPrimitives() const
+{
+    return m_primitives;
+}
+
+const PrimitiveStore& ParametricOctree::GetPrimitiveStore() const
+{
+    return m_primitive_store;
+}
+
+} // namespace ART
@@ -0,0 +1,88 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
+#include <Maths/Interval.h>
+#include <Maths/Vec3.h>
+#include <RayTracing/IRayHittable.h>
+#include <RayTracing/RayHitResult.h>
+
+namespace ART
+{
+
+// Children of a node are stored contiguously in octant order, empty octants are not stored
+struct ParametricOctreeNode
+{
+public:
+    // Interior: index of first child
+    // Leaf: index of first primitive reference
+    uint32_t offset;
+    uint32_t num_primitives;
+    // Bit per occupied octant (bit 0: x >= centre, bit 1: y >= centre, bit 2: z >= centre), 0 for leaves
+    uint8_t child_mask;
+};
+
+// Octree that subdivides space rather than objects, referencing objects from every cell they overlap
+// Children are visited in ray order using the t values where the ray crosses each cell's centre planes (Revelles et al.)
+// with no per-child box tests
+// Not a traversal mode of OctreeNode: that octree puts each object in the one octant holding its centre and bounds each
+// child by its objects, so child cells aren't the octants of their parent and centre-plane t values would skip objects
+// reaching across them
+class ParametricOctree : public IRayHittable
+{
+public:
+    ParametricOctree(std::vector<IRayHittable*>& objects);
+
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Children are visited front to back as for HitDeferred, returning at the first primitive hit
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    AABB BoundingBox() const override;
+
+    std::size_t MemoryUsedBytes() const;
+
+    const std::vector<ParametricOctreeNode>& GetNodes() const;
+
+    // Primitive references of all leaves, a primitive appears once per leaf it overlaps
+    const std::vector<PrimitiveId>& GetPrimitives() const;
+
+    const PrimitiveStore& GetPrimitiveStore() const;
+
+    static constexpr std::size_t MAX_DEPTH = 20;
+    static constexpr std::size_t MAX_OBJECTS_PER_LEAF = 4;
+    static constexpr double NODE_TRAVERSAL_COST     = 1.0;
+    static constexpr double HITTABLE_INTERSECT_COST = 1.0;
+
+protected:
+    // Builds the subtree for cell into m_nodes[node_index], objects is released before recursing
+    void Create(uint32_t node_index, std::vector<PrimitiveId>& objects, const AABB& cell, std::size_t depth);
+
+    // Closest hit, or with ANY_HIT the first hit found, out_result then left unwritten
+    template <bool ANY_HIT>
+    bool Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
+
+    // t_near/t_far are where the ray enters and leaves the cell's slabs on each axis
+    template <bool ANY_HIT>
+    bool HitNode
+    (
+        const Ray& ray,
+        uint32_t node_index,
+        const double t_near[3],
+        const double t_far[3],
+        const double cell_min[3],
+        const double cell_max[3],
+        double ray_t_min,
+        double& closest_so_far,
+        RayHitResult& out_result
+    ) const;
+
+    AABB m_bounding_box;
+    std::vector<ParametricOctreeNode> m_nodes;
+    // Primitive data in the order of the constructor's objects
+    PrimitiveStore m_primitive_store;
+    std::vector<PrimitiveId> m_primitives;
+};
+
+} // namespace ART
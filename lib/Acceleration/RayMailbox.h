@@ -0,0 +1,81 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ART
+{
+
+// Per-thread record of the objects already intersection tested by the current ray query
+// Objects are identified by dense ids assigned by the structure being traversed, each id has a stamp holding the
+// id of the last query that tested it, so starting a query never has to clear anything
+class RayMailbox
+{
+public:
+    // Returns true if object_id was already tested in the current query, otherwise marks it as tested
+    bool CheckAndMark(uint32_t object_id)
+    {
+        uint64_t& stamp = m_stamps[object_id];
+        if (stamp == m_query_id)
+        {
+            return true;
+        }
+
+        stamp = m_query_id;
+        return false;
+    }
+
+    // Gives the current query a new id and room for num_object_ids ids, returns the id of the query it interrupts
+    uint64_t BeginQuery(std::size_t num_object_ids)
+    {
+        if (m_stamps.size() < num_object_ids)
+        {
+            m_stamps.resize(num_object_ids, 0);
+        }
+
+        const uint64_t previous_query_id = m_query_id;
+        m_query_id = m_next_query_id++;
+        return previous_query_id;
+    }
+
+    void EndQuery(uint64_t previous_query_id)
+    {
+        m_query_id = previous_query_id;
+    }
+
+protected:
+    std::vector<uint64_t> m_stamps;
+    // Stamps start at 0, which is never a query id
+    uint64_t m_query_id = 0;
+    uint64_t m_next_query_id = 1;
+};
+
+// Thread-local mailbox shared by every grid traversed on this thread
+inline thread_local RayMailbox tl_ray_mailbox;
+
+// Starts a new query on this thread's mailbox for its lifetime, restoring the enclosing query when it ends
+// Queries never share an id, so a nested query, e.g. a grid stored inside another structure, can't hide objects from
+// the outer one, at worst the outer query tests an object again
+class RayMailboxQuery
+{
+public:
+    RayMailboxQuery(std::size_t num_object_ids)
+        : m_previous_query_id(tl_ray_mailbox.BeginQuery(num_object_ids))
+    {
+    }
+
+    ~RayMailboxQuery()
+    {
+        tl_ray_mailbox.EndQuery(m_previous_query_id);
+    }
+
+    RayMailboxQuery(const RayMailboxQuery&) = delete;
+    RayMailboxQuery& operator=(const RayMailboxQuery&) = delete;
+
+protected:
+    uint64_t m_previous_query_id;
+};
+
+} // namespace ART
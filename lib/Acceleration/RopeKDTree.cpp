@@ -0,0 +1,270 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/RopeKDTree.h>
+
+#include <algorithm>
+
+#include <Core/TraversalStats.h>
+
+namespace ART
+{
+
+RopeKDTree::RopeKDTree(std::vector<IRayHittable*>& objects)
+    : KDTreeNode(objects)
+{
+    if (m_nodes.empty())
+    {
+        return;
+    }
+
+    std::size_t num_leaves = 0;
+    for (const FlatKDTreeNode& node : m_nodes)
+    {
+        num_leaves += node.IsLeaf() ? 1 : 0;
+    }
+    m_leaves.reserve(num_leaves);
+
+    uint32_t ropes[6] =
+    {
+        RopeKDTreeLeaf::NO_ROPE, RopeKDTreeLeaf::NO_ROPE,
+        RopeKDTreeLeaf::NO_ROPE, RopeKDTreeLeaf::NO_ROPE,
+        RopeKDTreeLeaf::NO_ROPE, RopeKDTreeLeaf::NO_ROPE
+    };
+    BuildRopes(0, ropes, m_bounding_box);
+}
+
+uint32_t RopeKDTree::OptimiseRope(uint32_t rope, std::size_t face, const AABB& voxel) const
+{
+    const std::size_t face_axis = face / 2;
+    const bool face_is_min_side = (face % 2) == 0;
+
+    while (rope != RopeKDTreeLeaf::NO_ROPE && !m_nodes[rope].IsLeaf())
+    {
+        const FlatKDTreeNode& node = m_nodes[rope];
+        const std::size_t axis = node.SplitAxis();
+        const uint32_t below_child = rope + 1;
+        const uint32_t above_child = node.offset;
+
+        if (axis == face_axis)
+        {
+            // Plane parallel to the face, only the child nearest the face touches it
+            rope = face_is_min_side ? above_child : below_child;
+        }
+        else if (node.split_position <= voxel[axis].m_min)
+        {
+            rope = above_child;
+        }
+        else if (node.split_position >= voxel[axis].m_max)
+        {
+            rope = below_child;
+        }
+        else
+        {
+            // Plane cuts through the face, both children are needed
+            break;
+        }
+    }
+
+    return rope;
+}
+
+void RopeKDTree::BuildRopes(uint32_t node_index, uint32_t ropes[6], const AABB& voxel)
+{
+    for (std::size_t face = 0; face < 6; face++)
+    {
+        ropes[face] = OptimiseRope(ropes[face], face, voxel);
+    }
+
+    FlatKDTreeNode& node = m_nodes[node_index];
+
+    if (node.IsLeaf())
+    {
+        RopeKDTreeLeaf leaf{};
+        leaf.bounds_min[0] = voxel.m_x.m_min;
+        leaf.bounds_min[1] = voxel.m_y.m_min;
+        leaf.bounds_min[2] = voxel.m_z.m_min;
+        leaf.bounds_max[0] = voxel.m_x.m_max;
+        leaf.bounds_max[1] = voxel.m_y.m_max;
+        leaf.bounds_max[2] = voxel.m_z.m_max;
+        for (std::size_t face = 0; face < 6; face++)
+        {
+            leaf.ropes[face] = ropes[face];
+        }
+        leaf.primitives_offset = node.offset;
+        leaf.num_primitives = node.NumPrimitives();
+
+        node.offset = static_cast<uint32_t>(m_leaves.size());
+        m_leaves.push_back(leaf);
+        return;
+    }
+
+    const std::size_t axis = node.SplitAxis();
+    const uint32_t below_child = node_index + 1;
+    const uint32_t above_child = node.offset;
+
+    AABB below_voxel = voxel;
+    AABB above_voxel = voxel;
+    below_voxel[axis].m_max = node.split_position;
+    above_voxel[axis].m_min = node.split_position;
+
+    // Children link to each other across the split plane
+    uint32_t below_ropes[6];
+    uint32_t above_ropes[6];
+    for (std::size_t face = 0; face < 6; face++)
+    {
+        below_ropes[face] = ropes[face];
+        above_ropes[face] = ropes[face];
+    }
+    below_ropes[2 * axis + 1] = above_child;
+    above_ropes[2 * axis] = below_child;
+
+    BuildRopes(below_child, below_ropes, below_voxel);
+    BuildRopes(above_child, above_ropes, above_voxel);
+}
+
+bool RopeKDTree::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    return Traverse<false>(ray, ray_t, out_result);
+}
+
+bool RopeKDTree::HitAny(const Ray& ray, Interval ray_t) const
+{
+    RayHitResult result;
+    return Traverse<true>(ray, ray_t, result);
+}
+
+template <bool ANY_HIT>
+bool RopeKDTree::Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    const double origin[3] = { ray.m_origin.m_x, ray.m_origin.m_y, ray.m_origin.m_z };
+    const double direction[3] = { ray.m_direction.m_x, ray.m_direction.m_y, ray.m_direction.m_z };
+    const double inverse_direction[3] = { ray.m_inverse_direction.m_x, ray.m_inverse_direction.m_y, ray.m_inverse_direction.m_z };
+
+    // Clip ray to the root voxel to find where it enters the tree
+    double t_entry = ray_t.m_min;
+    double t_max = ray_t.m_max;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const Interval& interval = m_bounding_box[axis];
+        const double t0 = (interval.m_min - origin[axis]) * inverse_direction[axis];
+        const double t1 = (interval.m_max - origin[axis]) * inverse_direction[axis];
+        t_entry = std::max(t_entry, std::min(t0, t1));
+        t_max = std::min(t_max, std::max(t0, t1));
+    }
+    if (!(t_entry <= t_max))
+    {
+        return false;
+    }
+
+    bool hit_anything = false;
+    double closest_so_far = ray_t.m_max;
+    uint32_t current_node_index = 0;
+    double entry_point[3] =
+    {
+        origin[0] + t_entry * direction[0],
+        origin[1] + t_entry * direction[1],
+        origin[2] + t_entry * direction[2]
+    };
+
+    while (true)
+    {
+        // Descend from the rope target to the leaf containing the entry point
+        while (!m_nodes[current_node_index].IsLeaf())
+        {
+            RecordNodeTraversal();
+
+            const FlatKDTreeNode& node = m_nodes[current_node_index];
+            const std::size_t axis = node.SplitAxis();
+            // Points on the plane belong to the side the ray is heading into
+            const bool go_below = (entry_point[axis] < node.split_position) ||
+                (entry_point[axis] == node.split_position && direction[axis] < 0.0);
+            current_node_index = go_below ? current_node_index + 1 : node.offset;
+        }
+
+        RecordNodeTraversal();
+
+        const RopeKDTreeLeaf& leaf = m_leaves[m_nodes[current_node_index].offset];
+        const PrimitiveId* leaf_primitives = m_primitives.data() + leaf.primitives_offset;
+        if constexpr (ANY_HIT)
+        {
+            if (m_primitive_store.HitAny(leaf_primitives, leaf.num_primitives, ray, ray_t))
+            {
+                return true;
+            }
+        }
+        else if (m_primitive_store.Hit(leaf_primitives, leaf.num_primitives, ray, Interval(ray_t.m_min, closest_so_far), out_result))
+        {
+            hit_anything = true;
+            closest_so_far = out_result.m_t;
+        }
+
+        // Find the face the ray leaves the leaf through
+        double t_exit = infinity;
+        std::size_t exit_face = 0;
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            if (direction[axis] > 0.0)
+            {
+                const double t = (leaf.bounds_max[axis] - origin[axis]) * inverse_direction[axis];
+                if (t < t_exit)
+                {
+                    t_exit = t;
+                    exit_face = 2 * axis + 1;
+                }
+            }
+            else if (direction[axis] < 0.0)
+            {
+                const double t = (leaf.bounds_min[axis] - origin[axis]) * inverse_direction[axis];
+                if (t < t_exit)
+                {
+                    t_exit = t;
+                    exit_face = 2 * axis;
+                }
+            }
+        }
+
+        // Leaves are visited in ray order, so a hit before the exit can't be beaten by any later leaf
+        if (closest_so_far <= t_exit || t_exit >= t_max)
+        {
+            break;
+        }
+
+        current_node_index = leaf.ropes[exit_face];
+        if (current_node_index == RopeKDTreeLeaf::NO_ROPE)
+        {
+            break;
+        }
+
+        // Through an edge or corner the ray leaves several leaves at the same t, and rounding can put t_exit
+        // slightly before t_entry, so t never moves backwards
+        t_entry = std::max(t_entry, t_exit);
+
+        // Recomputed from t alone, rounding can put the entry point on the wrong side of a plane below the rope,
+        // sending the descent to a leaf beside the face rather than across it
+        // Placed exactly on the exit face and kept within the face's bounds, it always reaches a leaf across the face
+        const std::size_t exit_axis = exit_face / 2;
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            entry_point[axis] = std::clamp(origin[axis] + t_entry * direction[axis], leaf.bounds_min[axis], leaf.bounds_max[axis]);
+        }
+        entry_point[exit_axis] = (exit_face % 2 == 1) ? leaf.bounds_max[exit_axis] : leaf.bounds_min[exit_axis];
+    }
+
+    return hit_anything;
+}
+
+std::size_t RopeKDTree::MemoryUsedBytes() const
+{
+    return KDTreeNode::MemoryUsedBytes() + (m_leaves.size() * sizeof(RopeKDTreeLeaf));
+}
+
+const std::vector<RopeKDTreeLeaf>& RopeKDTree::GetLeaves() const
+{
+    return m_leaves;
+}
+
+} // namespace ART
@@ -0,0 +1,61 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Acceleration/KDTree.h>
+#include <Core/Common.h>
+#include <Maths/Interval.h>
+#include <Maths/Vec3.h>
+#include <RayTracing/IRayHittable.h>
+#include <RayTracing/RayHitResult.h>
+
+namespace ART
+{
+
+// Per-leaf data needed to walk from leaf to leaf
+struct RopeKDTreeLeaf
+{
+public:
+    // Leaf voxel, exactly bounded by the split planes above it
+    double bounds_min[3];
+    double bounds_max[3];
+    // Node on the other side of each face, ordered -x, +x, -y, +y, -z, +z
+    // Points at the smallest node that covers the whole face, or NO_ROPE on the tree boundary
+    uint32_t ropes[6];
+    uint32_t primitives_offset;
+    uint32_t num_primitives;
+
+    static constexpr uint32_t NO_ROPE = 0xFFFFFFFF;
+};
+
+// Spatial k-d tree with neighbour links (ropes) on each leaf face
+// Rays walk leaf to leaf through the faces they exit, with no traversal stack and no restarts from the root
+class RopeKDTree : public KDTreeNode
+{
+public:
+    RopeKDTree(std::vector<IRayHittable*>& objects);
+
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Leaves are walked along the ray as for HitDeferred, returning at the first primitive hit
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    std::size_t MemoryUsedBytes() const;
+
+    // Leaf nodes in GetNodes() store their index into this array as their offset
+    const std::vector<RopeKDTreeLeaf>& GetLeaves() const;
+
+protected:
+    // Closest hit, or with ANY_HIT the first hit found, out_result then left unwritten
+    template <bool ANY_HIT>
+    bool Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
+
+    // Recursively assigns ropes, pushing each one down to the smallest node still covering the whole face
+    void BuildRopes(uint32_t node_index, uint32_t ropes[6], const AABB& voxel);
+
+    // Follows rope down the tree while a single child covers the face it is attached to
+    uint32_t OptimiseRope(uint32_t rope, std::size_t face, const AABB& voxel) const;
+
+    std::vector<RopeKDTreeLeaf> m_leaves;
+};
+
+} // namespace ART
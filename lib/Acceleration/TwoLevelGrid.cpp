@@ -0,0 +1,350 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/TwoLevelGrid.h>
+
+#include <Acceleration/GridBuilder.h>
+#include <Acceleration/RayMailbox.h>
+#include <Acceleration/UniformGrid.h>
+#include <Core/Constants.h>
+#include <Core/TraversalStats.h>
+
+namespace ART
+{
+
+TwoLevelGrid::TwoLevelGrid(std::vector<IRayHittable*>& objects)
+{
+    Create(objects);
+}
+
+TwoLevelGrid::~TwoLevelGrid()
+{
+    Destroy();
+}
+
+bool TwoLevelGrid::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    return Traverse<false>(ray, ray_t, out_result);
+}
+
+bool TwoLevelGrid::HitAny(const Ray& ray, Interval ray_t) const
+{
+    RayHitResult result;
+    return Traverse<true>(ray, ray_t, result);
+}
+
+template <bool ANY_HIT>
+bool TwoLevelGrid::Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    if (m_cells == nullptr)
+    {
+        return false;
+    }
+
+    if (!m_bounding_box.Hit(ray, ray_t))
+    {
+        return false;
+    }
+
+    const RayMailboxQuery mailbox_query(m_num_object_ids);
+
+    // Where the ray enters the grid if it starts outside
+    double t_entry = ray_t.m_min;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const double t_near = std::min((m_bounding_box[axis].m_min - ray.m_origin[axis]) / ray.m_direction[axis], (m_bounding_box[axis].m_max - ray.m_origin[axis]) / ray.m_direction[axis]);
+        if (t_near > t_entry)
+        {
+            t_entry = t_near;
+        }
+    }
+
+    const Point3 origin(m_bounding_box.m_x.m_min, m_bounding_box.m_y.m_min, m_bounding_box.m_z.m_min);
+    const int cell_min[3] = { 0, 0, 0 };
+    const int cell_max[3] = { m_num_cells[0] - 1, m_num_cells[1] - 1, m_num_cells[2] - 1 };
+
+    GridWalk walk;
+    walk.Start(ray, t_entry, origin, m_cell_size, cell_min, cell_max);
+
+    bool hit_anything = false;
+    double closest_t = ray_t.m_max;
+    double t_cell_entry = t_entry;
+
+    do
+    {
+        RecordNodeTraversal();
+        const TwoLevelGridCell& cell = m_cells[(((walk.cell[0] * m_num_cells[1]) + walk.cell[1]) * m_num_cells[2]) + walk.cell[2]];
+        if (cell.resolution[0] != 0 && CellHit<ANY_HIT>(cell, walk.cell, ray, ray_t, t_cell_entry, closest_t, out_result))
+        {
+            if constexpr (ANY_HIT)
+            {
+                return true;
+            }
+            hit_anything = true;
+        }
+
+        // Later cells can't hold a closer hit
+        t_cell_entry = walk.ExitT();
+        if (closest_t <= t_cell_entry)
+        {
+            break;
+        }
+    }
+    while (walk.Step(cell_min, cell_max));
+
+    return hit_anything;
+}
+
+AABB TwoLevelGrid::BoundingBox() const
+{
+    return m_bounding_box;
+}
+
+std::size_t TwoLevelGrid::MemoryUsedBytes() const
+{
+    return m_allocator ? (m_allocator->MemoryUsedBytes() + m_primitive_store.MemoryUsedBytes()) : 0;
+}
+
+Vec3Int TwoLevelGrid::GetNumCells() const
+{
+    return Vec3Int(m_num_cells[0], m_num_cells[1], m_num_cells[2]);
+}
+
+std::size_t TwoLevelGrid::GetNumLeafCells() const
+{
+    return m_num_leaf_cells;
+}
+
+std::size_t TwoLevelGrid::GetNumObjectReferences() const
+{
+    return m_num_object_references;
+}
+
+void TwoLevelGrid::Create(std::vector<IRayHittable*>& objects)
+{
+    m_num_object_ids = objects.size();
+    if (objects.empty())
+    {
+        return;
+    }
+
+    std::vector<AABB> bounding_boxes;
+    m_bounding_box = GridBuilder::ComputeBounds(objects, bounding_boxes);
+
+    const Vec3Int resolution = UniformGrid::DetermineResolution(m_bounding_box, objects.size(), TOP_LEVEL_DENSITY);
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        m_num_cells[axis] = resolution[axis];
+        m_cell_size[axis] = m_bounding_box[axis].Size() / m_num_cells[axis];
+    }
+    const std::size_t num_cells = static_cast<std::size_t>(m_num_cells[0]) * m_num_cells[1] * m_num_cells[2];
+
+    GridBins bins;
+    GridBuilder::BinObjects(bounding_boxes, m_bounding_box, resolution, bins);
+
+    auto cell_bounds = [&](std::size_t cell_index)
+    {
+        const int x = static_cast<int>(cell_index / (static_cast<std::size_t>(m_num_cells[1]) * m_num_cells[2]));
+        const int y = static_cast<int>((cell_index / m_num_cells[2]) % m_num_cells[1]);
+        const int z = static_cast<int>(cell_index % m_num_cells[2]);
+        return AABB
+        (
+            Interval(m_bounding_box.m_x.m_min + (x * m_cell_size.m_x), m_bounding_box.m_x.m_min + ((x + 1) * m_cell_size.m_x)),
+            Interval(m_bounding_box.m_y.m_min + (y * m_cell_size.m_y), m_bounding_box.m_y.m_min + ((y + 1) * m_cell_size.m_y)),
+            Interval(m_bounding_box.m_z.m_min + (z * m_cell_size.m_z), m_bounding_box.m_z.m_min + ((z + 1) * m_cell_size.m_z))
+        );
+    };
+
+    // Leaf grid of each top level cell sized to its own number of objects
+    std::vector<Vec3Int> leaf_resolutions(num_cells, Vec3Int(0, 0, 0));
+    std::vector<std::size_t> leaf_cell_offsets(num_cells + 1, 0);
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (std::int64_t cell_index = 0; cell_index < static_cast<std::int64_t>(num_cells); cell_index++)
+    {
+        const std::size_t num_cell_objects = bins.cell_offsets[cell_index + 1] - bins.cell_offsets[cell_index];
+        if (num_cell_objects == 0)
+        {
+            continue;
+        }
+
+        const AABB bounds = cell_bounds(cell_index);
+        Vec3Int leaf_resolution = UniformGrid::DetermineResolution(bounds, num_cell_objects, LEAF_DENSITY);
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            leaf_resolution[axis] = std::clamp(leaf_resolution[axis], 1, MAX_LEAF_CELLS_PER_AXIS);
+        }
+
+        std::vector<AABB> cell_bounding_boxes(num_cell_objects);
+        for (std::size_t object_offset = 0; object_offset < num_cell_objects; object_offset++)
+        {
+            cell_bounding_boxes[object_offset] = bounding_boxes[bins.object_indices[bins.cell_offsets[cell_index] + object_offset]];
+        }
+        leaf_resolution = GridBuilder::LimitReferences(cell_bounding_boxes, bounds, leaf_resolution, MAX_LEAF_REFERENCES_PER_OBJECT);
+        leaf_resolutions[cell_index] = leaf_resolution;
+        leaf_cell_offsets[cell_index] = static_cast<std::size_t>(leaf_resolution.m_x) * leaf_resolution.m_y * leaf_resolution.m_z;
+    }
+
+    m_num_leaf_cells = GridBuilder::ExclusiveScan(leaf_cell_offsets.data(), num_cells);
+    leaf_cell_offsets[num_cells] = m_num_leaf_cells;
+
+    // Count the objects of each leaf cell, every top level cell owns its leaf cells so cells can be counted in parallel
+    std::vector<uint32_t> leaf_cell_counts(m_num_leaf_cells, 0);
+    std::vector<std::size_t> cell_reference_offsets(num_cells + 1, 0);
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (std::int64_t cell_index = 0; cell_index < static_cast<std::int64_t>(num_cells); cell_index++)
+    {
+        const Vec3Int& leaf_resolution = leaf_resolutions[cell_index];
+        const AABB bounds = cell_bounds(cell_index);
+        std::size_t num_cell_references = 0;
+
+        for (std::size_t reference_index = bins.cell_offsets[cell_index]; reference_index < bins.cell_offsets[cell_index + 1]; reference_index++)
+        {
+            Vec3Int range_min;
+            Vec3Int range_max;
+            GridBuilder::CellRange(bounding_boxes[bins.object_indices[reference_index]], bounds, leaf_resolution, range_min, range_max);
+            for (int x = range_min.m_x; x <= range_max.m_x; x++)
+            {
+                for (int y = range_min.m_y; y <= range_max.m_y; y++)
+                {
+                    for (int z = range_min.m_z; z <= range_max.m_z; z++)
+                    {
+                        leaf_cell_counts[leaf_cell_offsets[cell_index] + (((x * leaf_resolution.m_y) + y) * leaf_resolution.m_z) + z]++;
+                        num_cell_references++;
+                    }
+                }
+            }
+        }
+
+        cell_reference_offsets[cell_index] = num_cell_references;
+    }
+
+    m_num_object_references = GridBuilder::ExclusiveScan(cell_reference_offsets.data(), num_cells);
+    cell_reference_offsets[num_cells] = m_num_object_references;
+
+    // Both levels and the object references share one arena
+    const std::size_t arena_size =
+        (num_cells * sizeof(TwoLevelGridCell)) +
+        (m_num_leaf_cells * sizeof(TwoLevelGridLeafCell)) +
+        (m_num_object_references * (sizeof(PrimitiveId) + sizeof(uint32_t))) +
+        (4 * alignof(std::max_align_t));
+    m_allocator = new ArenaAllocator(arena_size);
+    m_cells = static_cast<TwoLevelGridCell*>(m_allocator->Alloc(num_cells * sizeof(TwoLevelGridCell), alignof(TwoLevelGridCell)));
+    m_leaf_cells = static_cast<TwoLevelGridLeafCell*>(m_allocator->Alloc(m_num_leaf_cells * sizeof(TwoLevelGridLeafCell), alignof(TwoLevelGridLeafCell)));
+    m_objects = static_cast<PrimitiveId*>(m_allocator->Alloc(m_num_object_references * sizeof(PrimitiveId), alignof(PrimitiveId)));
+    m_primitive_store = PrimitiveStore(objects);
+    m_object_ids = static_cast<uint32_t*>(m_allocator->Alloc(m_num_object_references * sizeof(uint32_t), alignof(uint32_t)));
+
+    // Scatter references in input order, the leaf cell counts are rebuilt as write cursors
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (std::int64_t cell_index = 0; cell_index < static_cast<std::int64_t>(num_cells); cell_index++)
+    {
+        const Vec3Int& leaf_resolution = leaf_resolutions[cell_index];
+        TwoLevelGridCell& cell = m_cells[cell_index];
+        cell.leaf_cells_offset = static_cast<uint32_t>(leaf_cell_offsets[cell_index]);
+        cell.resolution[0] = static_cast<uint8_t>(leaf_resolution.m_x);
+        cell.resolution[1] = static_cast<uint8_t>(leaf_resolution.m_y);
+        cell.resolution[2] = static_cast<uint8_t>(leaf_resolution.m_z);
+
+        std::size_t objects_offset = cell_reference_offsets[cell_index];
+        for (std::size_t leaf_cell_index = leaf_cell_offsets[cell_index]; leaf_cell_index < leaf_cell_offsets[cell_index + 1]; leaf_cell_index++)
+        {
+            m_leaf_cells[leaf_cell_index].objects_offset = static_cast<uint32_t>(objects_offset);
+            m_leaf_cells[leaf_cell_index].num_objects = 0;
+            objects_offset += leaf_cell_counts[leaf_cell_index];
+        }
+
+        const AABB bounds = cell_bounds(cell_index);
+        for (std::size_t reference_index = bins.cell_offsets[cell_index]; reference_index < bins.cell_offsets[cell_index + 1]; reference_index++)
+        {
+            const uint32_t object_index = bins.object_indices[reference_index];
+            Vec3Int range_min;
+            Vec3Int range_max;
+            GridBuilder::CellRange(bounding_boxes[object_index], bounds, leaf_resolution, range_min, range_max);
+            for (int x = range_min.m_x; x <= range_max.m_x; x++)
+            {
+                for (int y = range_min.m_y; y <= range_max.m_y; y++)
+                {
+                    for (int z = range_min.m_z; z <= range_max.m_z; z++)
+                    {
+                        TwoLevelGridLeafCell& leaf_cell = m_leaf_cells[leaf_cell_offsets[cell_index] + (((x * leaf_resolution.m_y) + y) * leaf_resolution.m_z) + z];
+                        const std::size_t object_reference_index = leaf_cell.objects_offset + leaf_cell.num_objects;
+                        leaf_cell.num_objects++;
+                        m_objects[object_reference_index] = m_primitive_store.GetId(object_index);
+                        m_object_ids[object_reference_index] = object_index;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void TwoLevelGrid::Destroy()
+{
+    if (m_allocator)
+    {
+        delete m_allocator;
+        m_allocator = nullptr;
+    }
+
+    m_cells = nullptr;
+    m_leaf_cells = nullptr;
+    m_primitive_store = PrimitiveStore();
+    m_objects = nullptr;
+    m_object_ids = nullptr;
+    m_num_leaf_cells = 0;
+    m_num_object_references = 0;
+    m_num_object_ids = 0;
+}
+
+template <bool ANY_HIT>
+bool TwoLevelGrid::CellHit(const TwoLevelGridCell& cell, const int cell_coordinates[3], const Ray& ray, Interval ray_t, double t_cell_entry, double& closest_t, RayHitResult& out_result) const
+{
+    const int leaf_min[3] = { 0, 0, 0 };
+    const int leaf_max[3] = { cell.resolution[0] - 1, cell.resolution[1] - 1, cell.resolution[2] - 1 };
+    const Point3 cell_origin
+    (
+        m_bounding_box.m_x.m_min + (cell_coordinates[0] * m_cell_size.m_x),
+        m_bounding_box.m_y.m_min + (cell_coordinates[1] * m_cell_size.m_y),
+        m_bounding_box.m_z.m_min + (cell_coordinates[2] * m_cell_size.m_z)
+    );
+    const Vec3 leaf_cell_size(m_cell_size.m_x / cell.resolution[0], m_cell_size.m_y / cell.resolution[1], m_cell_size.m_z / cell.resolution[2]);
+
+    GridWalk walk;
+    walk.Start(ray, t_cell_entry, cell_origin, leaf_cell_size, leaf_min, leaf_max);
+
+    bool has_ray_hit_any_object = false;
+
+    do
+    {
+        RecordNodeTraversal();
+        const TwoLevelGridLeafCell& leaf_cell = m_leaf_cells[cell.leaf_cells_offset + (((walk.cell[0] * cell.resolution[1]) + walk.cell[1]) * cell.resolution[2]) + walk.cell[2]];
+        const uint32_t* object_ids = m_object_ids + leaf_cell.objects_offset;
+        const auto skip = [object_ids](std::size_t object_offset)
+        {
+            return tl_ray_mailbox.CheckAndMark(object_ids[object_offset]);
+        };
+
+        if constexpr (ANY_HIT)
+        {
+            if (m_primitive_store.HitAny(m_objects + leaf_cell.objects_offset, leaf_cell.num_objects, ray, ray_t, skip))
+            {
+                return true;
+            }
+        }
+        else if (m_primitive_store.Hit(m_objects + leaf_cell.objects_offset, leaf_cell.num_objects, ray, Interval(ray_t.m_min, closest_t), out_result, skip))
+        {
+            has_ray_hit_any_object = true;
+            closest_t = out_result.m_t;
+        }
+
+        if (closest_t <= walk.ExitT())
+        {
+            break;
+        }
+    }
+    while (walk.Step(leaf_min, leaf_max));
+
+    return has_ray_hit_any_object;
+}
+
+} // namespace ART
@@ -0,0 +1,101 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Core/ArenaAllocator.h>
+#include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
+#include <Maths/Interval.h>
+#include <Maths/Vec3.h>
+#include <Maths/Vec3Int.h>
+#include <RayTracing/IRayHittable.h>
+#include <RayTracing/RayHitResult.h>
+
+namespace ART
+{
+
+// Top level cell of a TwoLevelGrid, split into its own grid of leaf cells
+struct TwoLevelGridCell
+{
+public:
+    uint32_t leaf_cells_offset;
+    // Leaf cells per axis, all 0 for empty cells
+    uint8_t resolution[3];
+};
+
+// Leaf cell of a TwoLevelGrid
+struct TwoLevelGridLeafCell
+{
+public:
+    uint32_t objects_offset;
+    uint32_t num_objects;
+};
+
+// Two-level grid (Kalojanov et al. 2011): a coarse top level grid whose cells each hold a grid sized to their own number of objects,
+// so dense regions get fine cells without refining empty space
+// Cells and object references of both levels are flat arrays in a single arena, and traversal steps into the leaf grids inline
+class TwoLevelGrid : public IRayHittable
+{
+public:
+    TwoLevelGrid(std::vector<IRayHittable*>& objects);
+
+    ~TwoLevelGrid();
+
+    // Can't be copied, the arena holding both levels is owned and freed by the grid
+    TwoLevelGrid(const TwoLevelGrid&) = delete;
+    TwoLevelGrid& operator=(const TwoLevelGrid&) = delete;
+
+    // Objects spanning several cells are tested at most once per ray, see RayMailbox
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Top cells and their leaf cells are walked front to back as for HitDeferred, returning at the first object hit
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    AABB BoundingBox() const override;
+
+    std::size_t MemoryUsedBytes() const;
+
+    Vec3Int GetNumCells() const;
+
+    std::size_t GetNumLeafCells() const;
+
+    std::size_t GetNumObjectReferences() const;
+
+    // Top level cells per object
+    static constexpr double TOP_LEVEL_DENSITY = 0.0625;
+    // Leaf cells per object of each top level cell
+    static constexpr double LEAF_DENSITY = 2.0;
+    static constexpr int MAX_LEAF_CELLS_PER_AXIS = 32;
+    // Leaf grids are coarsened until their objects average at most this many leaf cells, see GridBuilder::LimitReferences
+    static constexpr double MAX_LEAF_REFERENCES_PER_OBJECT = 8.0;
+
+protected:
+    void Create(std::vector<IRayHittable*>& objects);
+
+    void Destroy();
+
+    // Closest hit, or with ANY_HIT the first hit found, out_result then left unwritten
+    template <bool ANY_HIT>
+    bool Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
+
+    // Tests the leaf cells of a top level cell crossed by the ray from t_cell_entry, returns true if closest_t was reduced
+    // (with ANY_HIT, true at the first object hit)
+    template <bool ANY_HIT>
+    bool CellHit(const TwoLevelGridCell& cell, const int cell_coordinates[3], const Ray& ray, Interval ray_t, double t_cell_entry, double& closest_t, RayHitResult& out_result) const;
+
+    AABB m_bounding_box;
+    Vec3 m_cell_size;
+    int m_num_cells[3] = { 0, 0, 0 };
+    ArenaAllocator* m_allocator = nullptr;
+    TwoLevelGridCell* m_cells = nullptr;
+    TwoLevelGridLeafCell* m_leaf_cells = nullptr;
+    PrimitiveStore m_primitive_store;
+    // Objects of all leaf cells, each leaf cell's objects are contiguous
+    PrimitiveId* m_objects = nullptr;
+    // Mailbox id of each entry of m_objects, its index in the constructor's objects
+    uint32_t* m_object_ids = nullptr;
+    std::size_t m_num_leaf_cells = 0;
+    std::size_t m_num_object_references = 0;
+    std::size_t m_num_object_ids = 0;
+};
+
+} // namespace ART
@@ -1,6 +1,11 @@
 // Copyright Mia Rolfe. All rights reserved.
 #include <Acceleration/UniformGrid.h>
 
+#include <numeric>
+
+#include <Acceleration/GridBuilder.h>
+#include <Acceleration/RayMailbox.h>
+#include <Core/Constants.h>
 #include <Core/TraversalStats.h>
 #include <RayTracing/IRayHittable.h>
 #include <RayTracing/RayHitResult.h>
@@ -8,15 +13,25 @@
 namespace ART
 {
 
-UniformGrid::UniformGrid(std::vector<IRayHittable*>& objects)
-    : m_is_grid_valid(false), m_grid(nullptr), m_num_x_cells(0), m_num_y_cells(0), m_num_z_cells(0)
+UniformGrid::UniformGrid(std::vector<IRayHittable*>& objects, const UniformGridConfig& config)
+    : m_is_grid_valid(false), m_num_x_cells(0), m_num_y_cells(0), m_num_z_cells(0), m_num_object_ids(objects.size())
 {
-    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
-    {
-        m_bounding_box = AABB(m_bounding_box, objects[object_index]->BoundingBox());
-    }
+    std::vector<AABB> bounding_boxes;
+    m_bounding_box = GridBuilder::ComputeBounds(objects, bounding_boxes);
+
+    std::vector<uint32_t> object_ids(objects.size());
+    std::iota(object_ids.begin(), object_ids.end(), 0);
+
+    Create(objects, bounding_boxes, object_ids, config);
+}
+
+UniformGrid::UniformGrid(std::vector<IRayHittable*>& objects, const std::vector<uint32_t>& object_ids, std::size_t num_object_ids, const UniformGridConfig& config)
+    : m_is_grid_valid(false), m_num_x_cells(0), m_num_y_cells(0), m_num_z_cells(0), m_num_object_ids(num_object_ids)
+{
+    std::vector<AABB> bounding_boxes;
+    m_bounding_box = GridBuilder::ComputeBounds(objects, bounding_boxes);
 
-    Create(objects);
+    Create(objects, bounding_boxes, object_ids, config);
 }
 
 UniformGrid::~UniformGrid()
@@ -24,9 +39,33 @@ UniformGrid::~UniformGrid()
     Destroy();
 }
 
-bool UniformGrid::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+bool UniformGrid::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    const RayMailboxQuery mailbox_query(m_num_object_ids);
+    return HitInCurrentQuery(ray, ray_t, out_result);
+}
+
+bool UniformGrid::HitAny(const Ray& ray, Interval ray_t) const
+{
+    const RayMailboxQuery mailbox_query(m_num_object_ids);
+    return HitAnyInCurrentQuery(ray, ray_t);
+}
+
+bool UniformGrid::HitInCurrentQuery(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
-    if (!m_grid || !m_is_grid_valid)
+    return Traverse<false>(ray, ray_t, out_result);
+}
+
+bool UniformGrid::HitAnyInCurrentQuery(const Ray& ray, Interval ray_t) const
+{
+    RayHitResult result;
+    return Traverse<true>(ray, ray_t, result);
+}
+
+template <bool ANY_HIT>
+bool UniformGrid::Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    if (m_grid.empty() || !m_is_grid_valid)
     {
         return false;
     }
@@ -36,8 +75,17 @@ bool UniformGrid::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result)
         return false;
     }
 
-    // Starting point inside the bounding box
-    const Vec3 entry_point = ray.At(ray_t.m_min);
+    // Starting point inside the bounding box, where the ray enters it if it starts outside
+    double t_entry = ray_t.m_min;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const double t_near = std::min((m_bounding_box[axis].m_min - ray.m_origin[axis]) / ray.m_direction[axis], (m_bounding_box[axis].m_max - ray.m_origin[axis]) / ray.m_direction[axis]);
+        if (t_near > t_entry)
+        {
+            t_entry = t_near;
+        }
+    }
+    const Vec3 entry_point = ray.At(t_entry);
     Vec3Int current_cell = Calculate3DIndex(entry_point);
 
     // Clamp to grid
@@ -90,7 +138,6 @@ bool UniformGrid::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result)
 
     bool hit_anything = false;
     double closest_t = ray_t.m_max;
-    RayHitResult temp_result;
 
     // 3DDDA (Amanatides & Woo)
     while
@@ -102,11 +149,20 @@ bool UniformGrid::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result)
     {
         const std::size_t cell_index = Calculate1DIndex(current_cell);
         RecordNodeTraversal();
-        if (CellHit(m_grid[cell_index], ray, Interval(ray_t.m_min, closest_t), temp_result))
+        if (CellHit<ANY_HIT>(m_grid[cell_index], ray, Interval(ray_t.m_min, closest_t), out_result))
         {
+            if constexpr (ANY_HIT)
+            {
+                return true;
+            }
             hit_anything = true;
-            closest_t = temp_result.m_t;
-            out_result = temp_result;
+            closest_t = out_result.m_t;
+        }
+
+        // Stop if closest hit is before the boundary of this cell, later cells can't hold a closer hit
+        if (closest_t <= std::min(t_max.m_x, std::min(t_max.m_y, t_max.m_z)))
+        {
+            break;
         }
 
         // Step to next cell
@@ -136,12 +192,6 @@ bool UniformGrid::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result)
                 t_max.m_z += t_delta.m_z;
             }
         }
-
-        // Stop if closest hit is before next cell boundary
-        if (closest_t < std::min(t_max.m_x, std::min(t_max.m_y, t_max.m_z)))
-        {
-            break;
-        }
     }
 
     return hit_anything;
@@ -152,151 +202,198 @@ AABB UniformGrid::BoundingBox() const
     return m_bounding_box;
 }
 
-void UniformGrid::Create(std::vector<IRayHittable*>& objects)
+void UniformGrid::Create(std::vector<IRayHittable*>& objects, const std::vector<AABB>& bounding_boxes, const std::vector<uint32_t>& object_ids, const UniformGridConfig& config)
 {
-    m_cell_size = DetermineCellSize(objects.size());
+    // Bounds of a planar scene have no extent on one axis, padding them as AABB's constructors do keeps every cell size non-zero
+    m_bounding_box = AABB(m_bounding_box.m_x, m_bounding_box.m_y, m_bounding_box.m_z);
 
-    m_num_x_cells = std::max(static_cast<std::size_t>(1), static_cast<std::size_t>(std::round(m_bounding_box.m_x.Size() / m_cell_size.m_x)));
-    m_num_y_cells = std::max(static_cast<std::size_t>(1), static_cast<std::size_t>(std::round(m_bounding_box.m_y.Size() / m_cell_size.m_y)));
-    m_num_z_cells = std::max(static_cast<std::size_t>(1), static_cast<std::size_t>(std::round(m_bounding_box.m_z.Size() / m_cell_size.m_z)));
+    m_density = config.auto_tune_density ? AutoTuneDensity(bounding_boxes, m_bounding_box) : std::clamp(config.density, UniformGridConfig::MIN_DENSITY, UniformGridConfig::MAX_DENSITY);
 
-    const std::size_t num_cells = m_num_x_cells * m_num_y_cells * m_num_z_cells;
-    m_grid = new UniformGridEntry[num_cells];
-
-    // Count objects per cell first to allocate exact sizes
-    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    Vec3Int resolution = DetermineResolution(m_bounding_box, objects.size(), m_density);
+    if (config.max_references_per_object > 0.0)
     {
-        const AABB bounding_box = objects[object_index]->BoundingBox();
+        resolution = GridBuilder::LimitReferences(bounding_boxes, m_bounding_box, resolution, config.max_references_per_object);
+    }
+    m_num_x_cells = static_cast<std::size_t>(resolution.m_x);
+    m_num_y_cells = static_cast<std::size_t>(resolution.m_y);
+    m_num_z_cells = static_cast<std::size_t>(resolution.m_z);
 
-        const Vec3 min_bound = Vec3(bounding_box.m_x.m_min, bounding_box.m_y.m_min, bounding_box.m_z.m_min);
-        const Vec3 max_bound = Vec3(bounding_box.m_x.m_max, bounding_box.m_y.m_max, bounding_box.m_z.m_max);
+    // Exact cell extents, so traversal steps line up with the cells objects were binned into
+    m_cell_size = Vec3
+    (
+        m_bounding_box.m_x.Size() / m_num_x_cells,
+        m_bounding_box.m_y.Size() / m_num_y_cells,
+        m_bounding_box.m_z.Size() / m_num_z_cells
+    );
 
-        Vec3Int min_bound_grid_index = Calculate3DIndex(min_bound);
-        Vec3Int max_bound_grid_index = Calculate3DIndex(max_bound);
+    const std::size_t num_cells = m_num_x_cells * m_num_y_cells * m_num_z_cells;
 
-        // Clamp indices to valid grid bounds
-        min_bound_grid_index.m_x = std::clamp(min_bound_grid_index.m_x, 0, static_cast<int>(m_num_x_cells) - 1);
-        min_bound_grid_index.m_y = std::clamp(min_bound_grid_index.m_y, 0, static_cast<int>(m_num_y_cells) - 1);
-        min_bound_grid_index.m_z = std::clamp(min_bound_grid_index.m_z, 0, static_cast<int>(m_num_z_cells) - 1);
-        max_bound_grid_index.m_x = std::clamp(max_bound_grid_index.m_x, 0, static_cast<int>(m_num_x_cells) - 1);
-        max_bound_grid_index.m_y = std::clamp(max_bound_grid_index.m_y, 0, static_cast<int>(m_num_y_cells) - 1);
-        max_bound_grid_index.m_z = std::clamp(max_bound_grid_index.m_z, 0, static_cast<int>(m_num_z_cells) - 1);
+    GridBins bins;
+    GridBuilder::BinObjects(bounding_boxes, m_bounding_box, Vec3Int(static_cast<int>(m_num_x_cells), static_cast<int>(m_num_y_cells), static_cast<int>(m_num_z_cells)), bins);
 
-        for (int i = min_bound_grid_index.m_x; i <= max_bound_grid_index.m_x; i++)
-        {
-            for (int j = min_bound_grid_index.m_y; j <= max_bound_grid_index.m_y; j++)
-            {
-                for (int k = min_bound_grid_index.m_z; k <= max_bound_grid_index.m_z; k++)
-                {
-                    const std::size_t one_dimensional_index = Calculate1DIndex(Vec3Int(i, j, k));
-                    m_grid[one_dimensional_index].num_hittables++;
-                }
-            }
-        }
-    }
+    const std::size_t num_object_references = bins.object_indices.size();
+    m_grid.resize(num_cells);
+    m_primitive_store = PrimitiveStore(objects);
+    m_hittables_buffer.resize(num_object_references);
+    m_object_ids_buffer.resize(num_object_references);
 
-    std::size_t num_object_references = 0;
-    for (std::size_t cell_index = 0; cell_index < num_cells; cell_index++)
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t cell_index = 0; cell_index < static_cast<std::int64_t>(num_cells); cell_index++)
     {
-        m_grid[cell_index].hittables_buffer_offset = num_object_references;
-        num_object_references += m_grid[cell_index].num_hittables;
+        m_grid[cell_index].hittables_buffer_offset = bins.cell_offsets[cell_index];
+        m_grid[cell_index].num_hittables = bins.cell_offsets[cell_index + 1] - bins.cell_offsets[cell_index];
     }
 
-    m_hittables_buffer = new IRayHittable*[num_object_references];
-
-    m_memory_used_bytes = (num_cells * sizeof(UniformGridEntry)) + (num_object_references * sizeof(IRayHittable*));
-
-    std::size_t* objects_count_per_cell = new std::size_t[num_cells]();
-
-    // Distribute objects to cells
-    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t reference_index = 0; reference_index < static_cast<std::int64_t>(num_object_references); reference_index++)
     {
-        const AABB bounding_box = objects[object_index]->BoundingBox();
-
-        const Vec3 min_bound = Vec3(bounding_box.m_x.m_min, bounding_box.m_y.m_min, bounding_box.m_z.m_min);
-        const Vec3 max_bound = Vec3(bounding_box.m_x.m_max, bounding_box.m_y.m_max, bounding_box.m_z.m_max);
-
-        Vec3Int min_bound_grid_index = Calculate3DIndex(min_bound);
-        Vec3Int max_bound_grid_index = Calculate3DIndex(max_bound);
-
-        // Clamp indices to valid grid bounds
-        min_bound_grid_index.m_x = std::clamp(min_bound_grid_index.m_x, 0, static_cast<int>(m_num_x_cells) - 1);
-        min_bound_grid_index.m_y = std::clamp(min_bound_grid_index.m_y, 0, static_cast<int>(m_num_y_cells) - 1);
-        min_bound_grid_index.m_z = std::clamp(min_bound_grid_index.m_z, 0, static_cast<int>(m_num_z_cells) - 1);
-        max_bound_grid_index.m_x = std::clamp(max_bound_grid_index.m_x, 0, static_cast<int>(m_num_x_cells) - 1);
-        max_bound_grid_index.m_y = std::clamp(max_bound_grid_index.m_y, 0, static_cast<int>(m_num_y_cells) - 1);
-        max_bound_grid_index.m_z = std::clamp(max_bound_grid_index.m_z, 0, static_cast<int>(m_num_z_cells) - 1);
-
-        for (int i = min_bound_grid_index.m_x; i <= max_bound_grid_index.m_x; i++)
-        {
-            for (int j = min_bound_grid_index.m_y; j <= max_bound_grid_index.m_y; j++)
-            {
-                for (int k = min_bound_grid_index.m_z; k <= max_bound_grid_index.m_z; k++)
-                {
-                    const std::size_t one_dimensional_index = Calculate1DIndex(Vec3Int(i, j, k));
-                    const std::size_t hittables_buffer_index = m_grid[one_dimensional_index].hittables_buffer_offset + objects_count_per_cell[one_dimensional_index];
-                    objects_count_per_cell[one_dimensional_index] += 1;
-                    m_hittables_buffer[hittables_buffer_index] = objects[object_index];
-                }
-            }
-        }
+        const uint32_t object_index = bins.object_indices[reference_index];
+        m_hittables_buffer[reference_index] = m_primitive_store.GetId(object_index);
+        m_object_ids_buffer[reference_index] = object_ids[object_index];
     }
 
-    delete[] objects_count_per_cell;
+    m_memory_used_bytes = (num_cells * sizeof(UniformGridEntry)) + (num_object_references * (sizeof(PrimitiveId) + sizeof(uint32_t))) + m_primitive_store.MemoryUsedBytes();
 
     m_is_grid_valid = true;
 }
 
 void UniformGrid::Destroy()
 {
-    if (m_is_grid_valid)
-    {
-        delete[] m_grid;
-        m_grid = nullptr;
-
-        delete[] m_hittables_buffer;
-        m_hittables_buffer = nullptr;
-    }
+    m_grid.clear();
+    m_primitive_store = PrimitiveStore();
+    m_hittables_buffer.clear();
+    m_object_ids_buffer.clear();
 
     m_bounding_box = AABB();
     m_cell_size = Vec3(0.0);
+    m_density = 0.0;
     m_num_x_cells = 0;
     m_num_y_cells = 0;
     m_num_z_cells = 0;
+    m_num_object_ids = 0;
     m_is_grid_valid = false;
     m_memory_used_bytes = 0;
 }
 
+template <bool ANY_HIT>
 bool UniformGrid::CellHit(const UniformGridEntry& entry, const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
-    RayHitResult temp_result;
-    bool has_ray_hit_any_object = false;
-    double closest_distance = ray_t.m_max;
+    const uint32_t* object_ids = m_object_ids_buffer.data() + entry.hittables_buffer_offset;
+    const PrimitiveId* primitives = m_hittables_buffer.data() + entry.hittables_buffer_offset;
+
+    // Objects already tested in an earlier cell are skipped, any hit they had was recorded then
+    const auto skip = [object_ids](std::size_t object_offset)
+    {
+        return tl_ray_mailbox.CheckAndMark(object_ids[object_offset]);
+    };
 
-    for (std::size_t object_offset = 0; object_offset < entry.num_hittables; object_offset++)
+    if constexpr (ANY_HIT)
     {
-        if (m_hittables_buffer[entry.hittables_buffer_offset + object_offset]->Hit(ray, Interval(ray_t.m_min, closest_distance), temp_result))
+        return m_primitive_store.HitAny(primitives, entry.num_hittables, ray, ray_t, skip);
+    }
+    else
+    {
+        return m_primitive_store.Hit(primitives, entry.num_hittables, ray, ray_t, out_result, skip);
+    }
+}
+
+Vec3Int UniformGrid::DetermineResolution(const AABB& bounds, std::size_t num_objects, double density)
+{
+    const double max_extent = std::max(bounds.m_x.Size(), std::max(bounds.m_y.Size(), bounds.m_z.Size()));
+
+    double volume = 1.0;
+    int num_volume_axes = 0;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        if (bounds[axis].Size() > max_extent * FLAT_AXIS_RATIO)
         {
-            has_ray_hit_any_object = true;
-            closest_distance = temp_result.m_t;
-            out_result = temp_result;
+            volume *= bounds[axis].Size();
+            num_volume_axes++;
         }
     }
 
-    return has_ray_hit_any_object;
+    Vec3Int resolution(1, 1, 1);
+    if (num_objects == 0 || num_volume_axes == 0)
+    {
+        return resolution;
+    }
+
+    const double num_target_cells = std::min(density * static_cast<double>(num_objects), static_cast<double>(MAX_CELLS));
+    const double cells_per_unit_length = std::pow(num_target_cells / volume, 1.0 / num_volume_axes);
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        if (bounds[axis].Size() > max_extent * FLAT_AXIS_RATIO)
+        {
+            resolution[axis] = static_cast<int>(std::clamp(std::round(bounds[axis].Size() * cells_per_unit_length), 1.0, static_cast<double>(MAX_CELLS)));
+        }
+    }
+
+    return resolution;
+}
+
+double UniformGrid::EstimateCost(const std::vector<AABB>& bounding_boxes, const AABB& bounds, const Vec3Int& num_cells)
+{
+    const double num_grid_cells = static_cast<double>(num_cells.m_x) * num_cells.m_y * num_cells.m_z;
+    if (num_grid_cells > static_cast<double>(MAX_CELLS))
+    {
+        return infinity;
+    }
+
+    const double cell_x = bounds.m_x.Size() / num_cells.m_x;
+    const double cell_y = bounds.m_y.Size() / num_cells.m_y;
+    const double cell_z = bounds.m_z.Size() / num_cells.m_z;
+    const double grid_surface_area = bounds.SurfaceArea();
+    if (!(grid_surface_area > 0.0))
+    {
+        return 0.0;
+    }
+
+    // Objects are mailboxed, so an object is tested once by any ray crossing one of its cells, which together form a box
+    double object_cells_surface_area = 0.0;
+
+    #pragma omp parallel for schedule(static) reduction(+:object_cells_surface_area)
+    for (std::int64_t object_index = 0; object_index < static_cast<std::int64_t>(bounding_boxes.size()); object_index++)
+    {
+        Vec3Int range_min;
+        Vec3Int range_max;
+        GridBuilder::CellRange(bounding_boxes[object_index], bounds, num_cells, range_min, range_max);
+
+        const double size_x = (range_max.m_x - range_min.m_x + 1) * cell_x;
+        const double size_y = (range_max.m_y - range_min.m_y + 1) * cell_y;
+        const double size_z = (range_max.m_z - range_min.m_z + 1) * cell_z;
+        object_cells_surface_area += 2.0 * ((size_x * size_y) + (size_y * size_z) + (size_z * size_x));
+    }
+
+    const double cell_surface_area = 2.0 * ((cell_x * cell_y) + (cell_y * cell_z) + (cell_z * cell_x));
+
+    return ((NODE_TRAVERSAL_COST * num_grid_cells * cell_surface_area) + (HITTABLE_INTERSECT_COST * object_cells_surface_area)) / grid_surface_area;
 }
 
-Vec3 UniformGrid::DetermineCellSize(std::size_t num_objects) const
+double UniformGrid::AutoTuneDensity(const std::vector<AABB>& bounding_boxes, const AABB& bounds)
 {
-    const double x_size = m_bounding_box.m_x.Size();
-    const double y_size = m_bounding_box.m_y.Size();
-    const double z_size = m_bounding_box.m_z.Size();
+    double best_density = UniformGridConfig::DEFAULT_DENSITY;
+    double best_cost = infinity;
+    Vec3Int previous_resolution(0, 0, 0);
 
-    // Calculate optimal cell size based on heuristic
-    const double cube_root_n = std::cbrt(static_cast<double>(num_objects));
-    const double cell_size = 3.0 * std::max(x_size, std::max(y_size, z_size)) / cube_root_n;
+    for (double density = MIN_AUTO_TUNE_DENSITY; density <= MAX_AUTO_TUNE_DENSITY * 1.0001; density *= AUTO_TUNE_DENSITY_STEP)
+    {
+        const Vec3Int resolution = DetermineResolution(bounds, bounding_boxes.size(), density);
+        // Small scenes round neighbouring densities to the same grid
+        if (resolution.m_x == previous_resolution.m_x && resolution.m_y == previous_resolution.m_y && resolution.m_z == previous_resolution.m_z)
+        {
+            continue;
+        }
+        previous_resolution = resolution;
 
-    return Vec3(cell_size);
+        const double cost = EstimateCost(bounding_boxes, bounds, resolution);
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            best_density = density;
+        }
+    }
+
+    return best_density;
 }
 
 Vec3Int UniformGrid::Calculate3DIndex(Vec3 position) const
@@ -342,4 +439,19 @@ std::size_t UniformGrid::MemoryUsedBytes() const
     return m_memory_used_bytes;
 }
 
+double UniformGrid::GetDensity() const
+{
+    return m_density;
+}
+
+Vec3Int UniformGrid::GetNumCells() const
+{
+    return Vec3Int(static_cast<int>(m_num_x_cells), static_cast<int>(m_num_y_cells), static_cast<int>(m_num_z_cells));
+}
+
+Vec3 UniformGrid::GetCellSize() const
+{
+    return m_cell_size;
+}
+
 } // namespace ART
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
 #include <Maths/Vec3.h>
 #include <Maths/Vec3Int.h>
 #include <RayTracing/IRayHittable.h>
@@ -17,27 +18,88 @@ public:
     std::size_t num_hittables = 0;
 };
 
+// Resolution settings of a UniformGrid
+struct UniformGridConfig
+{
+public:
+    // Target number of cells per object, the grid has about density * N cells
+    double density = DEFAULT_DENSITY;
+    // Choose the density by estimated traversal cost instead of using density
+    bool auto_tune_density = false;
+    // If non-zero, the grid is coarsened until objects average at most this many cells, see GridBuilder::LimitReferences
+    double max_references_per_object = 0.0;
+
+    static constexpr double DEFAULT_DENSITY = 2.0;
+    static constexpr double MIN_DENSITY = 0.01;
+    static constexpr double MAX_DENSITY = 64.0;
+};
+
 class UniformGrid : public IRayHittable
 {
 public:
-    UniformGrid(std::vector<IRayHittable*>& objects);
+    UniformGrid(std::vector<IRayHittable*>& objects, const UniformGridConfig& config = UniformGridConfig());
+
+    // Objects are mailboxed by object_ids, which are below num_object_ids, so grids sharing ids can be traversed in one query
+    UniformGrid(std::vector<IRayHittable*>& objects, const std::vector<uint32_t>& object_ids, std::size_t num_object_ids, const UniformGridConfig& config = UniformGridConfig());
 
     ~UniformGrid();
 
-    bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+    // Objects spanning several cells are tested at most once per ray, see RayMailbox
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Cells are walked front to back as for HitDeferred, returning at the first object hit
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    // HitDeferred as part of the caller's mailbox query, for structures that traverse several grids for one ray
+    bool HitInCurrentQuery(const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
+
+    // HitAny as part of the caller's mailbox query
+    bool HitAnyInCurrentQuery(const Ray& ray, Interval ray_t) const;
 
     AABB BoundingBox() const override;
 
     std::size_t MemoryUsedBytes() const;
 
+    // Density the grid was built with, chosen by the cost estimate when auto-tuning
+    double GetDensity() const;
+
+    Vec3Int GetNumCells() const;
+
+    Vec3 GetCellSize() const;
+
+    // Cells per axis for about density * num_objects cells shaped like the bounds, cells_per_axis = extent_axis * cbrt(density * N / volume)
+    // Axes with no extent get a single cell and the remaining axes share the cells, so flat scenes get a 2D grid
+    static Vec3Int DetermineResolution(const AABB& bounds, std::size_t num_objects, double density);
+
+    // SAH-like expected cost of a ray crossing the grid: a cell is pierced with probability proportional to its surface area,
+    // and with mailboxing an object is tested once if any of its cells is pierced, so by the surface area of the box of its cells
+    static double EstimateCost(const std::vector<AABB>& bounding_boxes, const AABB& bounds, const Vec3Int& num_cells);
+
+    // Density in [MIN_AUTO_TUNE_DENSITY, MAX_AUTO_TUNE_DENSITY] with the lowest estimated cost
+    static double AutoTuneDensity(const std::vector<AABB>& bounding_boxes, const AABB& bounds);
+
+    static constexpr double NODE_TRAVERSAL_COST     = 1.0;
+    static constexpr double HITTABLE_INTERSECT_COST = 1.5;
+    static constexpr double MIN_AUTO_TUNE_DENSITY = 0.0625;
+    static constexpr double MAX_AUTO_TUNE_DENSITY = 16.0;
+    // Candidate densities are spaced by this factor
+    static constexpr double AUTO_TUNE_DENSITY_STEP = 1.4142135623730951;
+    static constexpr std::size_t MAX_CELLS = 1 << 22;
+    // Axes shorter than this fraction of the longest axis are treated as flat
+    static constexpr double FLAT_AXIS_RATIO = 1e-3;
+
 protected:
-    void Create(std::vector<IRayHittable*>& objects);
+    // Bins objects into cells in parallel, see GridBuilder
+    void Create(std::vector<IRayHittable*>& objects, const std::vector<AABB>& bounding_boxes, const std::vector<uint32_t>& object_ids, const UniformGridConfig& config);
 
     void Destroy();
 
-    bool CellHit(const UniformGridEntry& entry, const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
+    // Closest hit, or with ANY_HIT the first hit found, out_result then left unwritten
+    template <bool ANY_HIT>
+    bool Traverse(const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
 
-    Vec3 DetermineCellSize(std::size_t num_objects) const;
+    template <bool ANY_HIT>
+    bool CellHit(const UniformGridEntry& entry, const Ray& ray, Interval ray_t, RayHitResult& out_result) const;
 
     Vec3Int Calculate3DIndex(Vec3 position) const;
 
@@ -48,9 +110,14 @@ protected:
     std::size_t Calculate1DIndex(Vec3Int three_dimensional_index) const;
 
     AABB m_bounding_box;
-    UniformGridEntry* m_grid = nullptr;
-    IRayHittable** m_hittables_buffer = nullptr;
+    std::vector<UniformGridEntry> m_grid;
+    PrimitiveStore m_primitive_store;
+    std::vector<PrimitiveId> m_hittables_buffer;
+    // Mailbox id of each entry of m_hittables_buffer
+    std::vector<uint32_t> m_object_ids_buffer;
+    std::size_t m_num_object_ids = 0;
     Vec3 m_cell_size;
+    double m_density = 0.0;
     std::size_t m_num_x_cells = 0;
     std::size_t m_num_y_cells = 0;
     std::size_t m_num_z_cells = 0;
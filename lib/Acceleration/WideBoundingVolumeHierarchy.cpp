@@ -0,0 +1,439 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Acceleration/WideBoundingVolumeHierarchy.h>
+
+#include <Core/CPUFeatures.h>
+#include <Core/TraversalStats.h>
+
+#if defined(ART_X86_64)
+#include <immintrin.h>
+#endif
+
+namespace ART
+{
+
+// Child bounds are widened to double before the slab test so results match the scalar double precision structures
+
+template <std::size_t WIDTH>
+static uint32_t IntersectChildrenScalar(const WideBVHNode<WIDTH>& node, const Ray& ray, double ray_t_min, double ray_t_max, double* out_t_near)
+{
+    uint32_t hit_mask = 0;
+
+    for (std::size_t child_index = 0; child_index < node.num_children; child_index++)
+    {
+        const double t0_x = (static_cast<double>(node.bounds_min_x[child_index]) - ray.m_origin.m_x) * ray.m_inverse_direction.m_x;
+        const double t1_x = (static_cast<double>(node.bounds_max_x[child_index]) - ray.m_origin.m_x) * ray.m_inverse_direction.m_x;
+        const double t0_y = (static_cast<double>(node.bounds_min_y[child_index]) - ray.m_origin.m_y) * ray.m_inverse_direction.m_y;
+        const double t1_y = (static_cast<double>(node.bounds_max_y[child_index]) - ray.m_origin.m_y) * ray.m_inverse_direction.m_y;
+        const double t0_z = (static_cast<double>(node.bounds_min_z[child_index]) - ray.m_origin.m_z) * ray.m_inverse_direction.m_z;
+        const double t1_z = (static_cast<double>(node.bounds_max_z[child_index]) - ray.m_origin.m_z) * ray.m_inverse_direction.m_z;
+
+        double t_min = ray_t_min;
+        t_min = std::max(t_min, std::min(t0_x, t1_x));
+        t_min = std::max(t_min, std::min(t0_y, t1_y));
+        t_min = std::max(t_min, std::min(t0_z, t1_z));
+
+        double t_max = ray_t_max;
+        t_max = std::min(t_max, std::max(t0_x, t1_x));
+        t_max = std::min(t_max, std::max(t0_y, t1_y));
+        t_max = std::min(t_max, std::max(t0_z, t1_z));
+
+        if (t_min <= t_max)
+        {
+            hit_mask |= 1u << child_index;
+            out_t_near[child_index] = t_min;
+        }
+    }
+
+    return hit_mask;
+}
+
+#if defined(ART_X86_64)
+
+// Two children per iteration, SSE2 is part of the x86-64 baseline
+template <std::size_t WIDTH>
+static uint32_t IntersectChildrenSSE2(const WideBVHNode<WIDTH>& node, const Ray& ray, double ray_t_min, double ray_t_max, double* out_t_near)
+{
+    const __m128d origin_x = _mm_set1_pd(ray.m_origin.m_x);
+    const __m128d origin_y = _mm_set1_pd(ray.m_origin.m_y);
+    const __m128d origin_z = _mm_set1_pd(ray.m_origin.m_z);
+    const __m128d inverse_direction_x = _mm_set1_pd(ray.m_inverse_direction.m_x);
+    const __m128d inverse_direction_y = _mm_set1_pd(ray.m_inverse_direction.m_y);
+    const __m128d inverse_direction_z = _mm_set1_pd(ray.m_inverse_direction.m_z);
+    const __m128d t_min_initial = _mm_set1_pd(ray_t_min);
+    const __m128d t_max_initial = _mm_set1_pd(ray_t_max);
+
+    uint32_t hit_mask = 0;
+
+    for (std::size_t lane = 0; lane < WIDTH; lane += 4)
+    {
+        const __m128 min_x = _mm_load_ps(node.bounds_min_x + lane);
+        const __m128 min_y = _mm_load_ps(node.bounds_min_y + lane);
+        const __m128 min_z = _mm_load_ps(node.bounds_min_z + lane);
+        const __m128 max_x = _mm_load_ps(node.bounds_max_x + lane);
+        const __m128 max_y = _mm_load_ps(node.bounds_max_y + lane);
+        const __m128 max_z = _mm_load_ps(node.bounds_max_z + lane);
+
+        for (std::size_t half = 0; half < 2; half++)
+        {
+            // Second half moves the upper two floats down before widening
+            const __m128d min_x_d = _mm_cvtps_pd(half == 0 ? min_x : _mm_movehl_ps(min_x, min_x));
+            const __m128d min_y_d = _mm_cvtps_pd(half == 0 ? min_y : _mm_movehl_ps(min_y, min_y));
+            const __m128d min_z_d = _mm_cvtps_pd(half == 0 ? min_z : _mm_movehl_ps(min_z, min_z));
+            const __m128d max_x_d = _mm_cvtps_pd(half == 0 ? max_x : _mm_movehl_ps(max_x, max_x));
+            const __m128d max_y_d = _mm_cvtps_pd(half == 0 ? max_y : _mm_movehl_ps(max_y, max_y));
+            const __m128d max_z_d = _mm_cvtps_pd(half == 0 ? max_z : _mm_movehl_ps(max_z, max_z));
+
+            const __m128d t0_x = _mm_mul_pd(_mm_sub_pd(min_x_d, origin_x), inverse_direction_x);
+            const __m128d t1_x = _mm_mul_pd(_mm_sub_pd(max_x_d, origin_x), inverse_direction_x);
+            const __m128d t0_y = _mm_mul_pd(_mm_sub_pd(min_y_d, origin_y), inverse_direction_y);
+            const __m128d t1_y = _mm_mul_pd(_mm_sub_pd(max_y_d, origin_y), inverse_direction_y);
+            const __m128d t0_z = _mm_mul_pd(_mm_sub_pd(min_z_d, origin_z), inverse_direction_z);
+            const __m128d t1_z = _mm_mul_pd(_mm_sub_pd(max_z_d, origin_z), inverse_direction_z);
+
+            __m128d t_min = t_min_initial;
+            t_min = _mm_max_pd(_mm_min_pd(t0_x, t1_x), t_min);
+            t_min = _mm_max_pd(_mm_min_pd(t0_y, t1_y), t_min);
+            t_min = _mm_max_pd(_mm_min_pd(t0_z, t1_z), t_min);
+
+            __m128d t_max = t_max_initial;
+            t_max = _mm_min_pd(_mm_max_pd(t0_x, t1_x), t_max);
+            t_max = _mm_min_pd(_mm_max_pd(t0_y, t1_y), t_max);
+            t_max = _mm_min_pd(_mm_max_pd(t0_z, t1_z), t_max);
+
+            const std::size_t first_child = lane + (half * 2);
+            _mm_storeu_pd(out_t_near + first_child, t_min);
+            hit_mask |= static_cast<uint32_t>(_mm_movemask_pd(_mm_cmple_pd(t_min, t_max))) << first_child;
+        }
+    }
+
+    return hit_mask & ((1u << node.num_children) - 1);
+}
+
+// Four children per iteration
+template <std::size_t WIDTH>
+ART_TARGET_AVX2 static uint32_t IntersectChildrenAVX2(const WideBVHNode<WIDTH>& node, const Ray& ray, double ray_t_min, double ray_t_max, double* out_t_near)
+{
+    const __m256d origin_x = _mm256_set1_pd(ray.m_origin.m_x);
+    const __m256d origin_y = _mm256_set1_pd(ray.m_origin.m_y);
+    const __m256d origin_z = _mm256_set1_pd(ray.m_origin.m_z);
+    const __m256d inverse_direction_x = _mm256_set1_pd(ray.m_inverse_direction.m_x);
+    const __m256d inverse_direction_y = _mm256_set1_pd(ray.m_inverse_direction.m_y);
+    const __m256d inverse_direction_z = _mm256_set1_pd(ray.m_inverse_direction.m_z);
+    const __m256d t_min_initial = _mm256_set1_pd(ray_t_min);
+    const __m256d t_max_initial = _mm256_set1_pd(ray_t_max);
+
+    uint32_t hit_mask = 0;
+
+    for (std::size_t lane = 0; lane < WIDTH; lane += 4)
+    {
+        const __m256d min_x = _mm256_cvtps_pd(_mm_load_ps(node.bounds_min_x + lane));
+        const __m256d min_y = _mm256_cvtps_pd(_mm_load_ps(node.bounds_min_y + lane));
+        const __m256d min_z = _mm256_cvtps_pd(_mm_load_ps(node.bounds_min_z + lane));
+        const __m256d max_x = _mm256_cvtps_pd(_mm_load_ps(node.bounds_max_x + lane));
+        const __m256d max_y = _mm256_cvtps_pd(_mm_load_ps(node.bounds_max_y + lane));
+        const __m256d max_z = _mm256_cvtps_pd(_mm_load_ps(node.bounds_max_z + lane));
+
+        const __m256d t0_x = _mm256_mul_pd(_mm256_sub_pd(min_x, origin_x), inverse_direction_x);
+        const __m256d t1_x = _mm256_mul_pd(_mm256_sub_pd(max_x, origin_x), inverse_direction_x);
+        const __m256d t0_y = _mm256_mul_pd(_mm256_sub_pd(min_y, origin_y), inverse_direction_y);
+        const __m256d t1_y = _mm256_mul_pd(_mm256_sub_pd(max_y, origin_y), inverse_direction_y);
+        const __m256d t0_z = _mm256_mul_pd(_mm256_sub_pd(min_z, origin_z), inverse_direction_z);
+        const __m256d t1_z = _mm256_mul_pd(_mm256_sub_pd(max_z, origin_z), inverse_direction_z);
+
+        __m256d t_min = t_min_initial;
+        t_min = _mm256_max_pd(_mm256_min_pd(t0_x, t1_x), t_min);
+        t_min = _mm256_max_pd(_mm256_min_pd(t0_y, t1_y), t_min);
+        t_min = _mm256_max_pd(_mm256_min_pd(t0_z, t1_z), t_min);
+
+        __m256d t_max = t_max_initial;
+        t_max = _mm256_min_pd(_mm256_max_pd(t0_x, t1_x), t_max);
+        t_max = _mm256_min_pd(_mm256_max_pd(t0_y, t1_y), t_max);
+        t_max = _mm256_min_pd(_mm256_max_pd(t0_z, t1_z), t_max);
+
+        _mm256_storeu_pd(out_t_near + lane, t_min);
+        hit_mask |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_cmp_pd(t_min, t_max, _CMP_LE_OQ))) << lane;
+    }
+
+    return hit_mask & ((1u << node.num_children) - 1);
+}
+
+#endif
+
+template <std::size_t WIDTH>
+static typename WideBVH<WIDTH>::IntersectChildrenFunction SelectIntersectChildrenFunction()
+{
+#if defined(ART_X86_64)
+    if (CPUSupportsAVX2())
+    {
+        return &IntersectChildrenAVX2<WIDTH>;
+    }
+    return &IntersectChildrenSSE2<WIDTH>;
+#else
+    return &IntersectChildrenScalar<WIDTH>;
+#endif
+}
+
+static float SurfaceArea(const FlatBVHNode& node)
+{
+    const float extent_x = node.bounds_max[0] - node.bounds_min[0];
+    const float extent_y = node.bounds_max[1] - node.bounds_min[1];
+    const float extent_z = node.bounds_max[2] - node.bounds_min[2];
+    return 2.0f * ((extent_x * extent_y) + (extent_y * extent_z) + (extent_z * extent_x));
+}
+
+template <std::size_t WIDTH>
+static void SetChild(WideBVHNode<WIDTH>& node, std::size_t child_index, const FlatBVHNode& binary_child)
+{
+    node.bounds_min_x[child_index] = binary_child.bounds_min[0];
+    node.bounds_min_y[child_index] = binary_child.bounds_min[1];
+    node.bounds_min_z[child_index] = binary_child.bounds_min[2];
+    node.bounds_max_x[child_index] = binary_child.bounds_max[0];
+    node.bounds_max_y[child_index] = binary_child.bounds_max[1];
+    node.bounds_max_z[child_index] = binary_child.bounds_max[2];
+    node.child_num_primitives[child_index] = static_cast<uint8_t>(binary_child.num_primitives);
+    // Leaf offset is already a primitive index, interior offset is patched by the caller
+    node.child_offset[child_index] = binary_child.offset;
+}
+
+template <std::size_t WIDTH>
+WideBVH<WIDTH>::WideBVH(std::vector<IRayHittable*>& objects)
+    : m_intersect_children(SelectIntersectChildrenFunction<WIDTH>())
+{
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    {
+        m_bounding_box = AABB(m_bounding_box, objects[object_index]->BoundingBox());
+    }
+
+    if (objects.empty())
+    {
+        return;
+    }
+
+    const FlatBVH binary_bvh(objects);
+    const std::vector<FlatBVHNode>& binary_nodes = binary_bvh.GetNodes();
+    m_primitive_store = binary_bvh.GetPrimitiveStore();
+    m_primitives = binary_bvh.GetPrimitives();
+
+    if (binary_nodes[0].num_primitives > 0)
+    {
+        // Whole scene fits in one leaf, root holds it as its only child
+        WideBVHNode<WIDTH> root{};
+        SetChild(root, 0, binary_nodes[0]);
+        root.num_children = 1;
+        m_nodes.push_back(root);
+        return;
+    }
+
+    Collapse(binary_nodes, 0);
+}
+
+template <std::size_t WIDTH>
+uint32_t WideBVH<WIDTH>::Collapse(const std::vector<FlatBVHNode>& binary_nodes, uint32_t binary_node_index)
+{
+    uint32_t children[WIDTH];
+    std::size_t num_children = 2;
+    children[0] = binary_node_index + 1;
+    children[1] = binary_nodes[binary_node_index].offset;
+
+    // Repeatedly replace the interior child with the largest surface area (most likely to be hit) by its two children
+    while (num_children < WIDTH)
+    {
+        std::size_t child_to_open = WIDTH;
+        float largest_surface_area = -1.0f;
+        for (std::size_t child_index = 0; child_index < num_children; child_index++)
+        {
+            const FlatBVHNode& binary_child = binary_nodes[children[child_index]];
+            if (binary_child.num_primitives == 0 && SurfaceArea(binary_child) > largest_surface_area)
+            {
+                largest_surface_area = SurfaceArea(binary_child);
+                child_to_open = child_index;
+            }
+        }
+
+        // Only leaves left
+        if (child_to_open == WIDTH)
+        {
+            break;
+        }
+
+        const uint32_t opened_index = children[child_to_open];
+        children[child_to_open] = opened_index + 1;
+        children[num_children++] = binary_nodes[opened_index].offset;
+    }
+
+    const uint32_t node_index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    // Can't hold references into m_nodes across recursion, emplace_back may reallocate
+    WideBVHNode<WIDTH> node{};
+    node.num_children = static_cast<uint8_t>(num_children);
+    for (std::size_t child_index = 0; child_index < num_children; child_index++)
+    {
+        const FlatBVHNode& binary_child = binary_nodes[children[child_index]];
+        SetChild(node, child_index, binary_child);
+        if (binary_child.num_primitives == 0)
+        {
+            node.child_offset[child_index] = Collapse(binary_nodes, children[child_index]);
+        }
+    }
+
+    m_nodes[node_index] = node;
+    return node_index;
+}
+
+template <std::size_t WIDTH>
+bool WideBVH<WIDTH>::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    struct StackEntry
+    {
+        uint32_t node_index;
+        double t_near;
+    };
+
+    StackEntry nodes_to_visit[MAX_STACK_SIZE];
+    std::size_t num_nodes_to_visit = 0;
+    nodes_to_visit[num_nodes_to_visit++] = {0, ray_t.m_min};
+
+    bool hit_anything = false;
+    double closest_so_far = ray_t.m_max;
+
+    double t_near[WIDTH];
+    uint32_t hit_children[WIDTH];
+
+    while (num_nodes_to_visit > 0)
+    {
+        const StackEntry entry = nodes_to_visit[--num_nodes_to_visit];
+
+        // A closer hit was found after this node was deferred
+        if (entry.t_near > closest_so_far)
+        {
+            continue;
+        }
+
+        const WideBVHNode<WIDTH>& node = m_nodes[entry.node_index];
+        RecordNodeTraversal();
+
+        const uint32_t hit_mask = m_intersect_children(node, ray, ray_t.m_min, closest_so_far, t_near);
+        if (hit_mask == 0)
+        {
+            continue;
+        }
+
+        // Insertion sort hit children nearest first
+        std::size_t num_hit_children = 0;
+        for (uint32_t child_index = 0; child_index < node.num_children; child_index++)
+        {
+            if ((hit_mask & (1u << child_index)) == 0)
+            {
+                continue;
+            }
+
+            std::size_t insert_index = num_hit_children++;
+            while (insert_index > 0 && t_near[hit_children[insert_index - 1]] > t_near[child_index])
+            {
+                hit_children[insert_index] = hit_children[insert_index - 1];
+                insert_index--;
+            }
+            hit_children[insert_index] = child_index;
+        }
+
+        // Leaves are tested straight away, so a hit can cull the interior children behind it
+        for (std::size_t hit_index = 0; hit_index < num_hit_children; hit_index++)
+        {
+            const uint32_t child_index = hit_children[hit_index];
+            const std::size_t num_primitives = node.child_num_primitives[child_index];
+            if (num_primitives == 0 || t_near[child_index] > closest_so_far)
+            {
+                continue;
+            }
+
+            if (m_primitive_store.Hit(&m_primitives[node.child_offset[child_index]], num_primitives, ray, Interval(ray_t.m_min, closest_so_far), out_result))
+            {
+                hit_anything = true;
+                closest_so_far = out_result.m_t;
+            }
+        }
+
+        // Push interior children farthest first so the nearest is visited next
+        for (std::size_t hit_index = num_hit_children; hit_index > 0; hit_index--)
+        {
+            const uint32_t child_index = hit_children[hit_index - 1];
+            if (node.child_num_primitives[child_index] == 0 && t_near[child_index] <= closest_so_far)
+            {
+                nodes_to_visit[num_nodes_to_visit++] = {node.child_offset[child_index], t_near[child_index]};
+            }
+        }
+    }
+
+    return hit_anything;
+}
+
+template <std::size_t WIDTH>
+bool WideBVH<WIDTH>::HitAny(const Ray& ray, Interval ray_t) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    uint32_t nodes_to_visit[MAX_STACK_SIZE];
+    std::size_t num_nodes_to_visit = 0;
+    nodes_to_visit[num_nodes_to_visit++] = 0;
+
+    double t_near[WIDTH];
+
+    while (num_nodes_to_visit > 0)
+    {
+        const WideBVHNode<WIDTH>& node = m_nodes[nodes_to_visit[--num_nodes_to_visit]];
+        RecordNodeTraversal();
+
+        const uint32_t hit_mask = m_intersect_children(node, ray, ray_t.m_min, ray_t.m_max, t_near);
+        for (uint32_t child_index = 0; child_index < node.num_children; child_index++)
+        {
+            if ((hit_mask & (1u << child_index)) == 0)
+            {
+                continue;
+            }
+
+            const std::size_t num_primitives = node.child_num_primitives[child_index];
+            if (num_primitives == 0)
+            {
+                nodes_to_visit[num_nodes_to_visit++] = node.child_offset[child_index];
+            }
+            else if (m_primitive_store.HitAny(&m_primitives[node.child_offset[child_index]], num_primitives, ray, ray_t))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+template <std::size_t WIDTH>
+AABB WideBVH<WIDTH>::BoundingBox() const
+{
+    return m_bounding_box;
+}
+
+template <std::size_t WIDTH>
+std::size_t WideBVH<WIDTH>::MemoryUsedBytes() const
+{
+    return (m_nodes.size() * sizeof(WideBVHNode<WIDTH>)) + (m_primitives.size() * sizeof(PrimitiveId)) + m_primitive_store.MemoryUsedBytes();
+}
+
+template <std::size_t WIDTH>
+const std::vector<WideBVHNode<WIDTH>>& WideBVH<WIDTH>::GetNodes() const
+{
+    return m_nodes;
+}
+
+template class WideBVH<4>;
+template class WideBVH<8>;
+
+} // namespace ART
@@ -0,0 +1,80 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Acceleration/FlatBoundingVolumeHierarchy.h>
+#include <Core/Common.h>
+#include <Geometry/PrimitiveStore.h>
+#include <Maths/Interval.h>
+#include <Maths/Vec3.h>
+#include <RayTracing/IRayHittable.h>
+#include <RayTracing/RayHitResult.h>
+
+namespace ART
+{
+
+// WIDTH-ary BVH node, child bounds stored as SoA lanes so all children can be tested at once
+// Bounds are stored in single precision, rounded outwards so they never shrink
+template <std::size_t WIDTH>
+struct alignas(32) WideBVHNode
+{
+public:
+    float bounds_min_x[WIDTH];
+    float bounds_min_y[WIDTH];
+    float bounds_min_z[WIDTH];
+    float bounds_max_x[WIDTH];
+    float bounds_max_y[WIDTH];
+    float bounds_max_z[WIDTH];
+    // Interior child: index of child node
+    // Leaf child: index of first primitive in the primitive array
+    uint32_t child_offset[WIDTH];
+    // Zero for interior children
+    uint8_t child_num_primitives[WIDTH];
+    // Children [0, num_children) are valid, the remaining lanes are ignored
+    uint8_t num_children;
+};
+
+// BVH with WIDTH children per node, built by collapsing the binary SAH tree of FlatBVH
+// Each node's child boxes are tested together with SSE2, or AVX2 when the CPU supports it
+template <std::size_t WIDTH>
+class WideBVH : public IRayHittable
+{
+public:
+    static_assert(WIDTH == 4 || WIDTH == 8, "WideBVH supports 4 or 8 children per node");
+
+    WideBVH(std::vector<IRayHittable*>& objects);
+
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Visits hit children in stored order without sorting them, any hit ends the traversal
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    AABB BoundingBox() const override;
+
+    std::size_t MemoryUsedBytes() const;
+
+    const std::vector<WideBVHNode<WIDTH>>& GetNodes() const;
+
+    // Tests ray against every child box of node
+    // Returns bitmask of hit children, writes entry distances of hit children to out_t_near
+    using IntersectChildrenFunction = uint32_t (*)(const WideBVHNode<WIDTH>& node, const Ray& ray, double ray_t_min, double ray_t_max, double* out_t_near);
+
+protected:
+    // Recursively emits a wide node gathering up to WIDTH descendants of the binary interior node
+    // Returns index of the emitted node
+    uint32_t Collapse(const std::vector<FlatBVHNode>& binary_nodes, uint32_t binary_node_index);
+
+    AABB m_bounding_box;
+    std::vector<WideBVHNode<WIDTH>> m_nodes;
+    PrimitiveStore m_primitive_store;
+    std::vector<PrimitiveId> m_primitives;
+    // Chosen at construction time depending on CPU support
+    IntersectChildrenFunction m_intersect_children;
+
+    // Every level of the tree pushes at most WIDTH - 1 deferred children
+    static constexpr std::size_t MAX_STACK_SIZE = FlatBVH::MAX_TREE_DEPTH * (WIDTH - 1) + 1;
+};
+
+using BVH4 = WideBVH<4>;
+using BVH8 = WideBVH<8>;
+
+} // namespace ART
@@ -0,0 +1,90 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Core/CPUFeatures.h>
+
+#if defined(ART_X86_64)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace ART
+{
+
+#if defined(ART_X86_64)
+
+static void CPUID(unsigned int leaf, unsigned int subleaf, unsigned int registers[4])
+{
+#if defined(_MSC_VER)
+    int msvc_registers[4];
+    __cpuidex(msvc_registers, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int register_index = 0; register_index < 4; register_index++)
+    {
+        registers[register_index] = static_cast<unsigned int>(msvc_registers[register_index]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// Reads extended control register 0, which says which register states the OS saves
+static unsigned long long ReadXCR0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0;
+    unsigned int edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+static bool DetectAVX2()
+{
+    unsigned int registers[4] = {};
+
+    CPUID(0, 0, registers);
+    const unsigned int max_leaf = registers[0];
+    if (max_leaf < 7)
+    {
+        return false;
+    }
+
+    // Leaf 1 ECX: bit 27 OSXSAVE, bit 28 AVX
+    CPUID(1, 0, registers);
+    const bool has_osxsave = (registers[2] & (1u << 27)) != 0;
+    const bool has_avx = (registers[2] & (1u << 28)) != 0;
+    if (!has_osxsave || !has_avx)
+    {
+        return false;
+    }
+
+    // OS must save both XMM (bit 1) and YMM (bit 2) state
+    if ((ReadXCR0() & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    // Leaf 7 EBX: bit 5 AVX2
+    CPUID(7, 0, registers);
+    return (registers[1] & (1u << 5)) != 0;
+}
+
+bool CPUSupportsAVX2()
+{
+    static const bool supports_avx2 = DetectAVX2();
+    return supports_avx2;
+}
+
+#else
+
+bool CPUSupportsAVX2()
+{
+    return false;
+}
+
+#endif
+
+} // namespace ART
@@ -0,0 +1,22 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ART_X86_64
+#endif
+
+// Marks a function as using AVX2 instructions so it can be compiled without enabling AVX2 globally
+// Such functions must only be called after checking CPUSupportsAVX2()
+#if defined(ART_X86_64) && (defined(__GNUC__) || defined(__clang__))
+#define ART_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ART_TARGET_AVX2
+#endif
+
+namespace ART
+{
+
+// True if both the CPU and the OS support AVX2 (checked once, then cached)
+bool CPUSupportsAVX2();
+
+} // namespace ART
@@ -4,6 +4,7 @@
 #include <Core/ArenaAllocator.h>
 #include <Core/Common.h>
 #include <Core/Constants.h>
+#include <Core/CPUFeatures.h>
 #include <Core/Logger.h>
 #include <Core/Random.h>
 #include <Core/Timer.h>
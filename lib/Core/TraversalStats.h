@@ -13,12 +13,24 @@ struct TraversalCounters
     uint64_t nodes_traversed = 0;
     uint64_t intersection_tests = 0;
     uint64_t rays_cast = 0;
+    // Rays a packet could carry into each node it visited, and how many it did
+    uint64_t packet_ray_slots = 0;
+    uint64_t packet_active_rays = 0;
+    // Occlusion (any hit) queries and the nodes and intersection tests they took, kept out of the closest hit counts
+    uint64_t occlusion_rays_cast = 0;
+    uint64_t occlusion_nodes_traversed = 0;
+    uint64_t occlusion_intersection_tests = 0;
 
     void Reset()
     {
         nodes_traversed = 0;
         intersection_tests = 0;
         rays_cast = 0;
+        packet_ray_slots = 0;
+        packet_active_rays = 0;
+        occlusion_rays_cast = 0;
+        occlusion_nodes_traversed = 0;
+        occlusion_intersection_tests = 0;
     }
 
     TraversalCounters& operator+=(const TraversalCounters& other)
@@ -26,6 +38,11 @@ struct TraversalCounters
         nodes_traversed += other.nodes_traversed;
         intersection_tests += other.intersection_tests;
         rays_cast += other.rays_cast;
+        packet_ray_slots += other.packet_ray_slots;
+        packet_active_rays += other.packet_active_rays;
+        occlusion_rays_cast += other.occlusion_rays_cast;
+        occlusion_nodes_traversed += other.occlusion_nodes_traversed;
+        occlusion_intersection_tests += other.occlusion_intersection_tests;
         return *this;
     }
 };
@@ -36,6 +53,15 @@ struct TraversalStats
     uint64_t total_nodes_traversed = 0;
     uint64_t total_intersection_tests = 0;
     uint64_t total_rays_cast = 0;
+    uint64_t total_packet_ray_slots = 0;
+    uint64_t total_packet_active_rays = 0;
+    // Secondary rays reordered before tracing by a wavefront render, and the time spent sorting them
+    uint64_t total_rays_sorted = 0;
+    double ray_sort_time_ms = 0.0;
+    // Occlusion queries, counted apart from the closest hit rays above
+    uint64_t total_occlusion_rays_cast = 0;
+    uint64_t total_occlusion_nodes_traversed = 0;
+    uint64_t total_occlusion_intersection_tests = 0;
 
     double AvgNodesTraversedPerRay() const
     {
@@ -46,6 +72,22 @@ struct TraversalStats
     {
         return (total_rays_cast > 0) ? static_cast<double>(total_intersection_tests) / total_rays_cast : 0.0;
     }
+
+    double AvgNodesTraversedPerOcclusionRay() const
+    {
+        return (total_occlusion_rays_cast > 0) ? static_cast<double>(total_occlusion_nodes_traversed) / total_occlusion_rays_cast : 0.0;
+    }
+
+    double AvgIntersectionTestsPerOcclusionRay() const
+    {
+        return (total_occlusion_rays_cast > 0) ? static_cast<double>(total_occlusion_intersection_tests) / total_occlusion_rays_cast : 0.0;
+    }
+
+    // Fraction of packet rays still active in the nodes their packet visited, zero if no packets were traced
+    double PacketUtilisation() const
+    {
+        return (total_packet_ray_slots > 0) ? static_cast<double>(total_packet_active_rays) / total_packet_ray_slots : 0.0;
+    }
 };
 
 // Thread-local counters accessed during traversal
@@ -56,4 +98,13 @@ inline void RecordNodeTraversal() { tl_traversal_counters.nodes_traversed++; }
 inline void RecordIntersectionTest() { tl_traversal_counters.intersection_tests++; }
 inline void RecordRayCast() { tl_traversal_counters.rays_cast++; }
 
+// A packet of packet_size rays visited a node with num_active_rays of them still active
+// Each active ray counts as one node traversed, as when traced on its own
+inline void RecordPacketNodeTraversal(std::size_t packet_size, std::size_t num_active_rays)
+{
+    tl_traversal_counters.nodes_traversed += num_active_rays;
+    tl_traversal_counters.packet_ray_slots += packet_size;
+    tl_traversal_counters.packet_active_rays += num_active_rays;
+}
+
 } // namespace ART
@@ -18,6 +18,26 @@ double DegreesToRadians(double degrees)
     return degrees * pi / 180.0;
 }
 
+float RoundDownToFloat(double value)
+{
+    float rounded = static_cast<float>(value);
+    if (static_cast<double>(rounded) > value)
+    {
+        rounded = std::nextafter(rounded, -std::numeric_limits<float>::infinity());
+    }
+    return rounded;
+}
+
+float RoundUpToFloat(double value)
+{
+    float rounded = static_cast<float>(value);
+    if (static_cast<double>(rounded) < value)
+    {
+        rounded = std::nextafter(rounded, std::numeric_limits<float>::infinity());
+    }
+    return rounded;
+}
+
 const std::string AccelerationStructureToString(AccelerationStructure acceleration_structure)
 {
     switch (acceleration_structure)
@@ -28,14 +48,38 @@ const std::string AccelerationStructureToString(AccelerationStructure accelerati
         return "Uniform grid";
     case AccelerationStructure::HIERARCHICAL_UNIFORM_GRID:
         return "Hierarchical uniform grid";
+    case AccelerationStructure::HASHED_GRID:
+        return "Hashed grid";
+    case AccelerationStructure::TWO_LEVEL_GRID:
+        return "Two-level grid";
     case AccelerationStructure::OCTREE:
         return "Octree";
+    case AccelerationStructure::PARAMETRIC_OCTREE:
+        return "Parametric octree";
+    case AccelerationStructure::LOOSE_OCTREE:
+        return "Loose octree";
+    case AccelerationStructure::LINEAR_OCTREE:
+        return "Linear octree";
     case AccelerationStructure::BSP_TREE:
         return "BSP tree";
+    case AccelerationStructure::ADAPTIVE_BSP_TREE:
+        return "Adaptive BSP tree";
     case AccelerationStructure::K_D_TREE:
         return "k-d tree";
+    case AccelerationStructure::ROPE_K_D_TREE:
+        return "Rope k-d tree";
     case AccelerationStructure::BOUNDING_VOLUME_HIERARCHY:
         return "Bounding volume hierarchy";
+    case AccelerationStructure::FLAT_BOUNDING_VOLUME_HIERARCHY:
+        return "Flattened bounding volume hierarchy";
+    case AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_4:
+        return "4-wide bounding volume hierarchy";
+    case AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_8:
+        return "8-wide bounding volume hierarchy";
+    case AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY:
+        return "Linear bounding volume hierarchy";
+    case AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY_OPTIMISED:
+        return "Treelet optimised linear bounding volume hierarchy";
     }
 
     assert(false);
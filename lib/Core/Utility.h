@@ -10,15 +10,35 @@ namespace ART
 
 double DegreesToRadians(double degrees);
 
+// Returns the largest float that is <= value
+// Used when storing conservative (never shrunk) lower bounds in single precision
+float RoundDownToFloat(double value);
+
+// Returns the smallest float that is >= value
+// Used when storing conservative (never shrunk) upper bounds in single precision
+float RoundUpToFloat(double value);
+
 enum class AccelerationStructure
 {
     NONE,
     UNIFORM_GRID,
     HIERARCHICAL_UNIFORM_GRID,
+    HASHED_GRID,
+    TWO_LEVEL_GRID,
     OCTREE,
+    PARAMETRIC_OCTREE,
+    LOOSE_OCTREE,
+    LINEAR_OCTREE,
     BSP_TREE,
+    ADAPTIVE_BSP_TREE,
     K_D_TREE,
-    BOUNDING_VOLUME_HIERARCHY
+    ROPE_K_D_TREE,
+    BOUNDING_VOLUME_HIERARCHY,
+    FLAT_BOUNDING_VOLUME_HIERARCHY,
+    WIDE_BOUNDING_VOLUME_HIERARCHY_4,
+    WIDE_BOUNDING_VOLUME_HIERARCHY_8,
+    LINEAR_BOUNDING_VOLUME_HIERARCHY,
+    LINEAR_BOUNDING_VOLUME_HIERARCHY_OPTIMISED
 };
 
 const std::string AccelerationStructureToString(AccelerationStructure acceleration_structure);
@@ -1,6 +1,8 @@
 // Copyright Mia Rolfe. All rights reserved.
 #include <Geometry/AxisAlignedBoundingBox.h>
 
+#include <algorithm>
+
 namespace ART
 {
 
@@ -131,7 +133,7 @@ bool AABB::Hit(const Ray& ray, Interval rayT) const
     return t_min <= t_max;
 }
 
-std::size_t AABB::LongestAxis()
+std::size_t AABB::LongestAxis() const
 {
     if (m_x.Size() > m_y.Size())
     {
@@ -151,6 +153,27 @@ double AABB::SurfaceArea() const
     return 2.0 * (dx * dy + dy * dz + dz * dx);
 }
 
+double AABB::Volume() const
+{
+    return m_x.Size() * m_y.Size() * m_z.Size();
+}
+
+double AABB::OverlapVolume(const AABB& other) const
+{
+    double volume = 1.0;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const double overlap_min = std::max((*this)[axis].m_min, other[axis].m_min);
+        const double overlap_max = std::min((*this)[axis].m_max, other[axis].m_max);
+        if (overlap_max <= overlap_min)
+        {
+            return 0.0;
+        }
+        volume *= overlap_max - overlap_min;
+    }
+    return volume;
+}
+
 void AABB::PadToMinimums()
 {
     static constexpr double delta = 0.0001;
@@ -62,11 +62,17 @@ public:
 
     // Return the longest axis of the AABB as an index where
     // x = 0, y = 1, z = 2
-    std::size_t LongestAxis();
+    std::size_t LongestAxis() const;
 
     // Calculate surface area of the AABB
     double SurfaceArea() const;
 
+    // Calculate volume of the AABB
+    double Volume() const;
+
+    // Calculate volume of the region shared with another AABB, 0 if they are disjoint
+    double OverlapVolume(const AABB& other) const;
+
     void PadToMinimums();
 };
 
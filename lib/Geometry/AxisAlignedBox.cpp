@@ -1,18 +1,33 @@
 // Copyright Mia Rolfe. All rights reserved.
 #include <Geometry/AxisAlignedBox.h>
 
+#include <Core/Random.h>
 #include <Core/TraversalStats.h>
 
 namespace ART
 {
 
+// Area of the box's faces perpendicular to axis
+static double FaceArea(const AABB& box, std::size_t axis)
+{
+    return box[(axis + 1) % 3].Size() * box[(axis + 2) % 3].Size();
+}
+
+// Whether origin sees a face perpendicular to axis, and which one
+// Origin sees at most one of each pair, and none of either while between them
+static bool FaceVisible(const AABB& box, const Point3& origin, std::size_t axis, bool& out_max_face)
+{
+    out_max_face = origin[axis] > box[axis].m_max;
+    return out_max_face || origin[axis] < box[axis].m_min;
+}
+
 AxisAlignedBox::AxisAlignedBox(const Point3& min, const Point3& max, Material* material)
     : m_bounding_box(min, max), m_material(material) {}
 
 AxisAlignedBox::AxisAlignedBox(const AABB& bounding_box, Material* material)
     : m_bounding_box(bounding_box), m_material(material) {}
 
-bool AxisAlignedBox::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+bool AxisAlignedBox::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
     RecordIntersectionTest();
 
@@ -22,9 +37,6 @@ bool AxisAlignedBox::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_resul
     // Earliest exit point across all slabs
     double t_max = ray_t.m_max;
 
-    std::size_t hit_axis = 0;
-    bool hit_max_face = false;
-
     for (std::size_t axis = 0; axis < 3; axis++)
     {
         const Interval& axis_interval = m_bounding_box[axis];
@@ -35,13 +47,7 @@ bool AxisAlignedBox::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_resul
         const double t_near = ((ray_direction_is_negative ? axis_interval.m_max : axis_interval.m_min) - ray.m_origin[axis]) * inverse_ray_direction;
         const double t_far  = ((ray_direction_is_negative ? axis_interval.m_min : axis_interval.m_max) - ray.m_origin[axis]) * inverse_ray_direction;
 
-        if (t_near > t_min)
-        {
-            t_min = t_near;
-            hit_axis = axis;
-            hit_max_face = ray_direction_is_negative;
-        }
-
+        t_min = std::max(t_min, t_near);
         t_max = std::min(t_max, t_far);
 
         // Ray misses by exiting one slab before entering another
@@ -57,7 +63,38 @@ bool AxisAlignedBox::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_resul
     }
 
     out_result.m_t = t_min;
-    out_result.m_point = ray.At(t_min);
+    out_result.m_hit_object = this;
+    return true;
+}
+
+bool AxisAlignedBox::HitAny(const Ray& ray, Interval ray_t) const
+{
+    RayHitResult result;
+    return HitDeferred(ray, ray_t, result);
+}
+
+void AxisAlignedBox::SetHitAttributes(const Ray& ray, RayHitResult& out_result) const
+{
+    out_result.m_point = ray.At(out_result.m_t);
+
+    // The hit face is on the first slab whose entry distance is the hit distance, the same arithmetic as HitDeferred
+    // gives exactly equal distances
+    std::size_t hit_axis = 0;
+    bool hit_max_face = false;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const Interval& axis_interval = m_bounding_box[axis];
+        const double inverse_ray_direction = 1.0 / ray.m_direction[axis];
+        const bool ray_direction_is_negative = inverse_ray_direction < 0;
+        const double t_near = ((ray_direction_is_negative ? axis_interval.m_max : axis_interval.m_min) - ray.m_origin[axis]) * inverse_ray_direction;
+
+        if (t_near == out_result.m_t)
+        {
+            hit_axis = axis;
+            hit_max_face = ray_direction_is_negative;
+            break;
+        }
+    }
 
     Vec3 outward_normal(0.0);
     if (hit_max_face)
@@ -77,7 +114,111 @@ bool AxisAlignedBox::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_resul
     out_result.m_v = (out_result.m_point[v_axis] - m_bounding_box[v_axis].m_min) / m_bounding_box[v_axis].Size();
 
     out_result.m_material = m_material;
-    return true;
+}
+
+double AxisAlignedBox::DirectionPdf(const Point3& origin, const Vec3& direction) const
+{
+    double visible_area = 0.0;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        bool max_face = false;
+        if (FaceVisible(m_bounding_box, origin, axis, max_face))
+        {
+            visible_area += FaceArea(m_bounding_box, axis);
+        }
+    }
+
+    if (visible_area <= 0.0)
+    {
+        return 0.0;
+    }
+
+    // Entry through the visible faces, the same slab test as HitDeferred without recording an intersection test
+    const Vec3 unit_direction = Normalised(direction);
+    double t_min = 0.0;
+    double t_max = infinity;
+    std::size_t entry_axis = 0;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const Interval& axis_interval = m_bounding_box[axis];
+        const double inverse_ray_direction = 1.0 / unit_direction[axis];
+        const bool ray_direction_is_negative = inverse_ray_direction < 0;
+        const double t_near = ((ray_direction_is_negative ? axis_interval.m_max : axis_interval.m_min) - origin[axis]) * inverse_ray_direction;
+        const double t_far  = ((ray_direction_is_negative ? axis_interval.m_min : axis_interval.m_max) - origin[axis]) * inverse_ray_direction;
+
+        if (t_near > t_min)
+        {
+            t_min = t_near;
+            entry_axis = axis;
+        }
+        t_max = std::min(t_max, t_far);
+
+        if (t_min > t_max)
+        {
+            return 0.0;
+        }
+    }
+
+    // Area density converted to solid angle by distance squared over the cosine at the face
+    const double cosine = std::fabs(unit_direction[entry_axis]);
+    if (t_min <= 0.0 || cosine <= 0.0)
+    {
+        return 0.0;
+    }
+    return (t_min * t_min) / (cosine * visible_area);
+}
+
+Vec3 AxisAlignedBox::SampleDirection(const Point3& origin) const
+{
+    double face_areas[3] = { 0.0, 0.0, 0.0 };
+    bool max_faces[3] = { false, false, false };
+    double visible_area = 0.0;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        if (FaceVisible(m_bounding_box, origin, axis, max_faces[axis]))
+        {
+            face_areas[axis] = FaceArea(m_bounding_box, axis);
+            visible_area += face_areas[axis];
+        }
+    }
+
+    if (visible_area <= 0.0)
+    {
+        return RandomNormalised();
+    }
+
+    // Face chosen in proportion to its area, so the point is uniform over all visible faces
+    double choice = RandomCanonicalDouble() * visible_area;
+    std::size_t face_axis = 0;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        if (face_areas[axis] <= 0.0)
+        {
+            continue;
+        }
+        face_axis = axis;
+        if (choice < face_areas[axis])
+        {
+            break;
+        }
+        choice -= face_areas[axis];
+    }
+
+    Point3 point;
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const Interval& axis_interval = m_bounding_box[axis];
+        if (axis == face_axis)
+        {
+            point[axis] = max_faces[axis] ? axis_interval.m_max : axis_interval.m_min;
+        }
+        else
+        {
+            point[axis] = axis_interval.m_min + (RandomCanonicalDouble() * axis_interval.Size());
+        }
+    }
+
+    return point - origin;
 }
 
 AABB AxisAlignedBox::BoundingBox() const
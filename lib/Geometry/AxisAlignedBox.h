@@ -19,7 +19,19 @@ public:
 
     AxisAlignedBox(const AABB& bounding_box, Material* material);
 
-    bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // A box reports a single hit, so any hit is its closest hit without the attributes
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    // Fills the point, normal, UV and material of a hit on this box
+    void SetHitAttributes(const Ray& ray, RayHitResult& out_result) const override;
+
+    // Directions are drawn towards a uniform point on the faces facing origin, 0 from inside the box
+    double DirectionPdf(const Point3& origin, const Vec3& direction) const override;
+
+    Vec3 SampleDirection(const Point3& origin) const override;
+
     AABB BoundingBox() const override;
 };
 
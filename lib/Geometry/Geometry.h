@@ -3,4 +3,5 @@
 
 #include <Geometry/AxisAlignedBoundingBox.h>
 #include <Geometry/AxisAlignedBox.h>
+#include <Geometry/PrimitiveStore.h>
 #include <Geometry/Sphere.h>
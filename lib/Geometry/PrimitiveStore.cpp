@@ -0,0 +1,276 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Geometry/PrimitiveStore.h>
+
+#if defined(ART_X86_64)
+#include <immintrin.h>
+#endif
+
+namespace ART
+{
+
+PrimitiveStore::PrimitiveStore(const std::vector<IRayHittable*>& objects)
+{
+    m_ids.reserve(objects.size());
+
+    for (IRayHittable* object : objects)
+    {
+        if (const Sphere* sphere = dynamic_cast<const Sphere*>(object))
+        {
+            m_ids.push_back(MakeId(PrimitiveType::SPHERE, static_cast<uint32_t>(m_sphere_radii.size())));
+            m_sphere_centre_x.push_back(sphere->m_centre.m_x);
+            m_sphere_centre_y.push_back(sphere->m_centre.m_y);
+            m_sphere_centre_z.push_back(sphere->m_centre.m_z);
+            m_sphere_radii.push_back(sphere->m_radius);
+            m_sphere_objects.push_back(sphere);
+        }
+        else if (const AxisAlignedBox* box = dynamic_cast<const AxisAlignedBox*>(object))
+        {
+            m_ids.push_back(MakeId(PrimitiveType::BOX, static_cast<uint32_t>(m_box_objects.size())));
+            m_box_min_x.push_back(box->m_bounding_box.m_x.m_min);
+            m_box_min_y.push_back(box->m_bounding_box.m_y.m_min);
+            m_box_min_z.push_back(box->m_bounding_box.m_z.m_min);
+            m_box_max_x.push_back(box->m_bounding_box.m_x.m_max);
+            m_box_max_y.push_back(box->m_bounding_box.m_y.m_max);
+            m_box_max_z.push_back(box->m_bounding_box.m_z.m_max);
+            m_box_objects.push_back(box);
+        }
+        else
+        {
+            m_ids.push_back(MakeId(PrimitiveType::HITTABLE, static_cast<uint32_t>(m_hittables.size())));
+            m_hittables.push_back(object);
+        }
+    }
+
+    assert(objects.size() <= INDEX_MASK);
+}
+
+PrimitiveId PrimitiveStore::GetId(std::size_t object_index) const
+{
+    return m_ids[object_index];
+}
+
+const PrimitiveId* PrimitiveStore::GetIds() const
+{
+    return m_ids.data();
+}
+
+std::size_t PrimitiveStore::Size() const
+{
+    return m_ids.size();
+}
+
+std::size_t PrimitiveStore::GetNumSpheres() const
+{
+    return m_sphere_radii.size();
+}
+
+std::size_t PrimitiveStore::GetNumBoxes() const
+{
+    return m_box_objects.size();
+}
+
+std::size_t PrimitiveStore::GetNumHittables() const
+{
+    return m_hittables.size();
+}
+
+AABB PrimitiveStore::BoundingBox(PrimitiveId id) const
+{
+    const uint32_t index = GetIndex(id);
+    switch (GetType(id))
+    {
+    case PrimitiveType::SPHERE:
+    {
+        const Point3 centre(m_sphere_centre_x[index], m_sphere_centre_y[index], m_sphere_centre_z[index]);
+        const Vec3 radius_vec = Vec3(m_sphere_radii[index]);
+        return AABB(centre - radius_vec, centre + radius_vec);
+    }
+    case PrimitiveType::BOX:
+    {
+        // Box bounds were padded when the box was created, assign them directly so they aren't padded again
+        AABB bounding_box;
+        bounding_box.m_x = Interval(m_box_min_x[index], m_box_max_x[index]);
+        bounding_box.m_y = Interval(m_box_min_y[index], m_box_max_y[index]);
+        bounding_box.m_z = Interval(m_box_min_z[index], m_box_max_z[index]);
+        return bounding_box;
+    }
+    default:
+        return m_hittables[index]->BoundingBox();
+    }
+}
+
+int PrimitiveStore::IntersectSpheresScalar(const PrimitiveStore& store, const uint32_t* sphere_indices, std::size_t num_spheres, const Ray& ray, double ray_t_min, double ray_t_max, double& out_t)
+{
+    const double a = (ray.m_direction.m_x * ray.m_direction.m_x) + (ray.m_direction.m_y * ray.m_direction.m_y) + (ray.m_direction.m_z * ray.m_direction.m_z);
+    int nearest_position = -1;
+
+    for (std::size_t position = 0; position < num_spheres; position++)
+    {
+        const uint32_t index = sphere_indices[position];
+        const double oc_x = store.m_sphere_centre_x[index] - ray.m_origin.m_x;
+        const double oc_y = store.m_sphere_centre_y[index] - ray.m_origin.m_y;
+        const double oc_z = store.m_sphere_centre_z[index] - ray.m_origin.m_z;
+        const double radius = store.m_sphere_radii[index];
+        const double h = (ray.m_direction.m_x * oc_x) + (ray.m_direction.m_y * oc_y) + (ray.m_direction.m_z * oc_z);
+        const double c = ((oc_x * oc_x) + (oc_y * oc_y) + (oc_z * oc_z)) - (radius * radius);
+        const double discriminant = (h * h) - (a * c);
+
+        if (discriminant < 0)
+        {
+            continue;
+        }
+
+        const double square_root_of_discriminant = std::sqrt(discriminant);
+
+        double root = (h - square_root_of_discriminant) / a;
+        if (!(ray_t_min < root && root < ray_t_max))
+        {
+            root = (h + square_root_of_discriminant) / a;
+        }
+
+        if (ray_t_min < root && root < ray_t_max)
+        {
+            // Later spheres only need to beat this hit, as in a sequence of Sphere::HitDeferred calls
+            ray_t_max = root;
+            nearest_position = static_cast<int>(position);
+        }
+    }
+
+    out_t = ray_t_max;
+    return nearest_position;
+}
+
+#if defined(ART_X86_64)
+
+// Four spheres per instruction in double precision, so hits match the scalar kernel and Sphere::HitDeferred exactly
+ART_TARGET_AVX2 int PrimitiveStore::IntersectSpheresAVX2(const PrimitiveStore& store, const uint32_t* sphere_indices, std::size_t num_spheres, const Ray& ray, double ray_t_min, double ray_t_max, double& out_t)
+{
+    // Lanes past num_spheres repeat the first sphere and are masked out of the result. The lanes are loaded straight
+    // into registers, packing them through memory first would stall on store forwarding
+    uint32_t lane_indices[SPHERE_BLOCK_WIDTH];
+    for (std::size_t lane = 0; lane < SPHERE_BLOCK_WIDTH; lane++)
+    {
+        lane_indices[lane] = sphere_indices[lane < num_spheres ? lane : 0];
+    }
+
+    const double a_scalar = (ray.m_direction.m_x * ray.m_direction.m_x) + (ray.m_direction.m_y * ray.m_direction.m_y) + (ray.m_direction.m_z * ray.m_direction.m_z);
+    const __m256d a = _mm256_set1_pd(a_scalar);
+    const __m256d direction_x = _mm256_set1_pd(ray.m_direction.m_x);
+    const __m256d direction_y = _mm256_set1_pd(ray.m_direction.m_y);
+    const __m256d direction_z = _mm256_set1_pd(ray.m_direction.m_z);
+    const __m256d t_min = _mm256_set1_pd(ray_t_min);
+    const __m256d t_max = _mm256_set1_pd(ray_t_max);
+
+    const double* centre_x = store.m_sphere_centre_x.data();
+    const double* centre_y = store.m_sphere_centre_y.data();
+    const double* centre_z = store.m_sphere_centre_z.data();
+    const double* radii = store.m_sphere_radii.data();
+    const uint32_t i0 = lane_indices[0];
+    const uint32_t i1 = lane_indices[1];
+    const uint32_t i2 = lane_indices[2];
+    const uint32_t i3 = lane_indices[3];
+
+    __m256d lane_centre_x;
+    __m256d lane_centre_y;
+    __m256d lane_centre_z;
+    __m256d radius;
+    if (i1 == i0 + 1 && i2 == i0 + 2 && i3 == i0 + 3)
+    {
+        // Leaves of the BVHs and the octree store their spheres in leaf order, so whole blocks are usually contiguous
+        lane_centre_x = _mm256_loadu_pd(centre_x + i0);
+        lane_centre_y = _mm256_loadu_pd(centre_y + i0);
+        lane_centre_z = _mm256_loadu_pd(centre_z + i0);
+        radius = _mm256_loadu_pd(radii + i0);
+    }
+    else
+    {
+        lane_centre_x = _mm256_set_pd(centre_x[i3], centre_x[i2], centre_x[i1], centre_x[i0]);
+        lane_centre_y = _mm256_set_pd(centre_y[i3], centre_y[i2], centre_y[i1], centre_y[i0]);
+        lane_centre_z = _mm256_set_pd(centre_z[i3], centre_z[i2], centre_z[i1], centre_z[i0]);
+        radius = _mm256_set_pd(radii[i3], radii[i2], radii[i1], radii[i0]);
+    }
+
+    const __m256d oc_x = _mm256_sub_pd(lane_centre_x, _mm256_set1_pd(ray.m_origin.m_x));
+    const __m256d oc_y = _mm256_sub_pd(lane_centre_y, _mm256_set1_pd(ray.m_origin.m_y));
+    const __m256d oc_z = _mm256_sub_pd(lane_centre_z, _mm256_set1_pd(ray.m_origin.m_z));
+
+    const __m256d h = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(direction_x, oc_x), _mm256_mul_pd(direction_y, oc_y)), _mm256_mul_pd(direction_z, oc_z));
+    const __m256d oc_length_squared = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(oc_x, oc_x), _mm256_mul_pd(oc_y, oc_y)), _mm256_mul_pd(oc_z, oc_z));
+    const __m256d c = _mm256_sub_pd(oc_length_squared, _mm256_mul_pd(radius, radius));
+    const __m256d discriminant = _mm256_sub_pd(_mm256_mul_pd(h, h), _mm256_mul_pd(a, c));
+
+    // Most blocks miss every sphere, skip the square roots and divisions for them
+    const __m256d real_roots = _mm256_cmp_pd(discriminant, _mm256_setzero_pd(), _CMP_GE_OQ);
+    const int lane_mask = (1 << num_spheres) - 1;
+    if ((_mm256_movemask_pd(real_roots) & lane_mask) == 0)
+    {
+        return -1;
+    }
+
+    // Lanes with a negative discriminant take the square root of a negative number, they are masked out below
+    const __m256d square_root_of_discriminant = _mm256_sqrt_pd(discriminant);
+    const __m256d near_root = _mm256_div_pd(_mm256_sub_pd(h, square_root_of_discriminant), a);
+    const __m256d far_root = _mm256_div_pd(_mm256_add_pd(h, square_root_of_discriminant), a);
+
+    const __m256d near_in_range = _mm256_and_pd(_mm256_cmp_pd(t_min, near_root, _CMP_LT_OQ), _mm256_cmp_pd(near_root, t_max, _CMP_LT_OQ));
+    const __m256d far_in_range = _mm256_and_pd(_mm256_cmp_pd(t_min, far_root, _CMP_LT_OQ), _mm256_cmp_pd(far_root, t_max, _CMP_LT_OQ));
+    const __m256d root = _mm256_blendv_pd(far_root, near_root, near_in_range);
+    const __m256d hit = _mm256_and_pd(real_roots, _mm256_or_pd(near_in_range, far_in_range));
+
+    const int hit_mask = _mm256_movemask_pd(hit) & lane_mask;
+    if (hit_mask == 0)
+    {
+        return -1;
+    }
+
+    alignas(32) double roots[SPHERE_BLOCK_WIDTH];
+    _mm256_store_pd(roots, root);
+
+    int nearest_lane = -1;
+    for (int lane = 0; lane < static_cast<int>(SPHERE_BLOCK_WIDTH); lane++)
+    {
+        if ((hit_mask & (1 << lane)) && roots[lane] < ray_t_max)
+        {
+            ray_t_max = roots[lane];
+            nearest_lane = lane;
+        }
+    }
+
+    out_t = ray_t_max;
+    return nearest_lane;
+}
+
+#endif
+
+PrimitiveStore::IntersectSpheresFunction PrimitiveStore::s_intersect_spheres_override = nullptr;
+
+PrimitiveStore::IntersectSpheresFunction PrimitiveStore::SelectIntersectSpheresFunction()
+{
+    if (s_intersect_spheres_override != nullptr)
+    {
+        return s_intersect_spheres_override;
+    }
+
+#if defined(ART_X86_64)
+    if (CPUSupportsAVX2())
+    {
+        return &IntersectSpheresAVX2;
+    }
+#endif
+    return &IntersectSpheresScalar;
+}
+
+void PrimitiveStore::SetIntersectSpheresOverride(IntersectSpheresFunction intersect_spheres)
+{
+    s_intersect_spheres_override = intersect_spheres;
+}
+
+std::size_t PrimitiveStore::MemoryUsedBytes() const
+{
+    return (GetNumSpheres() * ((4 * sizeof(double)) + sizeof(IRayHittable*))) +
+        (GetNumBoxes() * ((6 * sizeof(double)) + sizeof(IRayHittable*))) +
+        (GetNumHittables() * sizeof(IRayHittable*)) +
+        (m_ids.size() * sizeof(PrimitiveId));
+}
+
+} // namespace ART
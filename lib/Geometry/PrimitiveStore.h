@@ -0,0 +1,354 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Core/CPUFeatures.h>
+#include <Core/Common.h>
+#include <Core/TraversalStats.h>
+#include <Geometry/AxisAlignedBoundingBox.h>
+#include <Geometry/AxisAlignedBox.h>
+#include <Geometry/Sphere.h>
+#include <Maths/Interval.h>
+#include <Maths/Ray.h>
+#include <RayTracing/IRayHittable.h>
+#include <RayTracing/RayHitResult.h>
+
+namespace ART
+{
+
+enum class PrimitiveType : uint32_t
+{
+    SPHERE,
+    BOX,
+    // Any other IRayHittable, tested through its virtual Hit
+    HITTABLE
+};
+
+// Reference to a primitive of a PrimitiveStore, the primitive's type in the top 2 bits and its index into that
+// type's arrays in the rest
+using PrimitiveId = uint32_t;
+
+// Primitives of a scene stored by type in structure of arrays form, so acceleration structures can keep 4 byte
+// PrimitiveIds in their leaves and test a leaf with a type-switched loop over contiguous data rather than one
+// virtual call per heap-allocated object
+class PrimitiveStore
+{
+public:
+    PrimitiveStore() = default;
+
+    // Spheres and axis-aligned boxes are copied into the store, any other object is kept by pointer
+    // Hits record the original object, which computes the surface attributes of the closest hit
+    PrimitiveStore(const std::vector<IRayHittable*>& objects);
+
+    static constexpr uint32_t TYPE_SHIFT = 30;
+    static constexpr uint32_t INDEX_MASK = (1u << TYPE_SHIFT) - 1;
+
+    static PrimitiveId MakeId(PrimitiveType type, uint32_t index)
+    {
+        return (static_cast<uint32_t>(type) << TYPE_SHIFT) | index;
+    }
+
+    static PrimitiveType GetType(PrimitiveId id)
+    {
+        return static_cast<PrimitiveType>(id >> TYPE_SHIFT);
+    }
+
+    static uint32_t GetIndex(PrimitiveId id)
+    {
+        return id & INDEX_MASK;
+    }
+
+    // Spheres tested together by one SIMD intersection test
+    static constexpr std::size_t SPHERE_BLOCK_WIDTH = 4;
+
+    // Id of objects[object_index] as passed to the constructor
+    PrimitiveId GetId(std::size_t object_index) const;
+
+    // Ids of all the constructor's objects, in their order
+    const PrimitiveId* GetIds() const;
+
+    std::size_t Size() const;
+
+    std::size_t GetNumSpheres() const;
+
+    std::size_t GetNumBoxes() const;
+
+    std::size_t GetNumHittables() const;
+
+    AABB BoundingBox(PrimitiveId id) const;
+
+    // Like IRayHittable::HitDeferred, fills only out_result.m_t and out_result.m_hit_object
+    bool Hit(PrimitiveId id, const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+    {
+        const uint32_t index = GetIndex(id);
+        switch (GetType(id))
+        {
+        case PrimitiveType::SPHERE:
+            return SphereHit(index, ray, ray_t, out_result);
+        case PrimitiveType::BOX:
+            return BoxHit(index, ray, ray_t, out_result);
+        default:
+            return m_hittables[index]->HitDeferred(ray, ray_t, out_result);
+        }
+    }
+
+    // Tests count contiguous primitives, e.g. a leaf, keeping the closest hit within ray_t
+    // Spheres are gathered into blocks of SPHERE_BLOCK_WIDTH and tested a block at a time, other primitives one at a time
+    bool Hit(const PrimitiveId* ids, std::size_t count, const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+    {
+        return Hit(ids, count, ray, ray_t, out_result, [](std::size_t) { return false; });
+    }
+
+    // As above, skipping each primitive ids[i] for which skip(i) returns true, e.g. when mailboxed
+    template <typename SkipFunction>
+    bool Hit(const PrimitiveId* ids, std::size_t count, const Ray& ray, Interval ray_t, RayHitResult& out_result, SkipFunction skip) const
+    {
+        bool hit_anything = false;
+        uint32_t block_sphere_indices[SPHERE_BLOCK_WIDTH];
+        std::size_t num_block_spheres = 0;
+
+        for (std::size_t id_index = 0; id_index < count; id_index++)
+        {
+            if (skip(id_index))
+            {
+                continue;
+            }
+
+            const PrimitiveId id = ids[id_index];
+            if (GetType(id) == PrimitiveType::SPHERE)
+            {
+                block_sphere_indices[num_block_spheres++] = GetIndex(id);
+                if (num_block_spheres == SPHERE_BLOCK_WIDTH)
+                {
+                    hit_anything |= HitSpheres(block_sphere_indices, num_block_spheres, ray, ray_t, out_result);
+                    num_block_spheres = 0;
+                }
+                continue;
+            }
+
+            if (Hit(id, ray, ray_t, out_result))
+            {
+                hit_anything = true;
+                ray_t.m_max = out_result.m_t;
+            }
+        }
+
+        // A partial block measured slower than testing its few spheres one at a time
+        for (std::size_t position = 0; position < num_block_spheres; position++)
+        {
+            if (SphereHit(block_sphere_indices[position], ray, ray_t, out_result))
+            {
+                hit_anything = true;
+                ray_t.m_max = out_result.m_t;
+            }
+        }
+
+        return hit_anything;
+    }
+
+    // Like IRayHittable::HitAny, whether primitive id is hit within ray_t
+    bool HitAny(PrimitiveId id, const Ray& ray, Interval ray_t) const
+    {
+        RayHitResult result;
+        const uint32_t index = GetIndex(id);
+        switch (GetType(id))
+        {
+        case PrimitiveType::SPHERE:
+            return SphereHit(index, ray, ray_t, result);
+        case PrimitiveType::BOX:
+            return BoxHit(index, ray, ray_t, result);
+        default:
+            return m_hittables[index]->HitAny(ray, ray_t);
+        }
+    }
+
+    // Whether any of count contiguous primitives is hit within ray_t, returning at the first hit found
+    bool HitAny(const PrimitiveId* ids, std::size_t count, const Ray& ray, Interval ray_t) const
+    {
+        return HitAny(ids, count, ray, ray_t, [](std::size_t) { return false; });
+    }
+
+    // As above, skipping each primitive ids[i] for which skip(i) returns true, e.g. when mailboxed
+    template <typename SkipFunction>
+    bool HitAny(const PrimitiveId* ids, std::size_t count, const Ray& ray, Interval ray_t, SkipFunction skip) const
+    {
+        RayHitResult result;
+        uint32_t block_sphere_indices[SPHERE_BLOCK_WIDTH];
+        std::size_t num_block_spheres = 0;
+
+        for (std::size_t id_index = 0; id_index < count; id_index++)
+        {
+            if (skip(id_index))
+            {
+                continue;
+            }
+
+            const PrimitiveId id = ids[id_index];
+            if (GetType(id) == PrimitiveType::SPHERE)
+            {
+                block_sphere_indices[num_block_spheres++] = GetIndex(id);
+                if (num_block_spheres == SPHERE_BLOCK_WIDTH)
+                {
+                    if (HitSpheres(block_sphere_indices, num_block_spheres, ray, ray_t, result))
+                    {
+                        return true;
+                    }
+                    num_block_spheres = 0;
+                }
+                continue;
+            }
+
+            if (HitAny(id, ray, ray_t))
+            {
+                return true;
+            }
+        }
+
+        for (std::size_t position = 0; position < num_block_spheres; position++)
+        {
+            if (SphereHit(block_sphere_indices[position], ray, ray_t, result))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Tests the num_spheres spheres of sphere_indices against ray within ray_t, with the same arithmetic as Sphere::HitDeferred
+    // Returns the position in sphere_indices of the nearest hit, lowest first on ties, or -1 if no sphere is hit
+    using IntersectSpheresFunction = int (*)(const PrimitiveStore& store, const uint32_t* sphere_indices, std::size_t num_spheres, const Ray& ray, double ray_t_min, double ray_t_max, double& out_t);
+
+    static int IntersectSpheresScalar(const PrimitiveStore& store, const uint32_t* sphere_indices, std::size_t num_spheres, const Ray& ray, double ray_t_min, double ray_t_max, double& out_t);
+
+#if defined(ART_X86_64)
+    static int IntersectSpheresAVX2(const PrimitiveStore& store, const uint32_t* sphere_indices, std::size_t num_spheres, const Ray& ray, double ray_t_min, double ray_t_max, double& out_t);
+#endif
+
+    // The override if one is set, otherwise the AVX2 kernel if the CPU supports it, otherwise the scalar kernel
+    static IntersectSpheresFunction SelectIntersectSpheresFunction();
+
+    // Kernel for stores constructed from now on, so a whole acceleration structure can be run on either kernel
+    // nullptr restores the automatic choice, stores that already exist keep their kernel
+    static void SetIntersectSpheresOverride(IntersectSpheresFunction intersect_spheres);
+
+    std::size_t MemoryUsedBytes() const;
+
+protected:
+    // Same arithmetic as Sphere::HitDeferred, written out on the stored components so misses need no calls
+    bool SphereHit(uint32_t index, const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+    {
+        RecordIntersectionTest();
+
+        const double oc_x = m_sphere_centre_x[index] - ray.m_origin.m_x;
+        const double oc_y = m_sphere_centre_y[index] - ray.m_origin.m_y;
+        const double oc_z = m_sphere_centre_z[index] - ray.m_origin.m_z;
+        const double radius = m_sphere_radii[index];
+        const double a = (ray.m_direction.m_x * ray.m_direction.m_x) + (ray.m_direction.m_y * ray.m_direction.m_y) + (ray.m_direction.m_z * ray.m_direction.m_z);
+        const double h = (ray.m_direction.m_x * oc_x) + (ray.m_direction.m_y * oc_y) + (ray.m_direction.m_z * oc_z);
+        const double c = ((oc_x * oc_x) + (oc_y * oc_y) + (oc_z * oc_z)) - (radius * radius);
+        const double discriminant = (h * h) - (a * c);
+
+        if (discriminant < 0)
+        {
+            return false;
+        }
+
+        const double square_root_of_discriminant = std::sqrt(discriminant);
+
+        double root = (h - square_root_of_discriminant) / a;
+        if (!(ray_t.m_min < root && root < ray_t.m_max))
+        {
+            root = (h + square_root_of_discriminant) / a;
+        }
+
+        if (!(ray_t.m_min < root && root < ray_t.m_max))
+        {
+            return false;
+        }
+
+        out_result.m_t = root;
+        out_result.m_hit_object = m_sphere_objects[index];
+        return true;
+    }
+
+    // Same arithmetic as AxisAlignedBox::HitDeferred, written out on the stored components so misses need no calls
+    bool BoxHit(uint32_t index, const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+    {
+        RecordIntersectionTest();
+
+        const double min[3] = { m_box_min_x[index], m_box_min_y[index], m_box_min_z[index] };
+        const double max[3] = { m_box_max_x[index], m_box_max_y[index], m_box_max_z[index] };
+        const double origin[3] = { ray.m_origin.m_x, ray.m_origin.m_y, ray.m_origin.m_z };
+        const double inverse_direction[3] = { ray.m_inverse_direction.m_x, ray.m_inverse_direction.m_y, ray.m_inverse_direction.m_z };
+
+        double t_min = ray_t.m_min;
+        double t_max = ray_t.m_max;
+
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            const bool ray_direction_is_negative = inverse_direction[axis] < 0;
+            const double t_near = ((ray_direction_is_negative ? max[axis] : min[axis]) - origin[axis]) * inverse_direction[axis];
+            const double t_far  = ((ray_direction_is_negative ? min[axis] : max[axis]) - origin[axis]) * inverse_direction[axis];
+
+            t_min = std::max(t_min, t_near);
+            t_max = std::min(t_max, t_far);
+
+            if (t_min > t_max)
+            {
+                return false;
+            }
+        }
+
+        if (!(ray_t.m_min < t_min && t_min < ray_t.m_max))
+        {
+            return false;
+        }
+
+        out_result.m_t = t_min;
+        out_result.m_hit_object = m_box_objects[index];
+        return true;
+    }
+
+    // Tests the spheres of sphere_indices together, narrowing ray_t to the nearest hit
+    bool HitSpheres(const uint32_t* sphere_indices, std::size_t num_spheres, const Ray& ray, Interval& ray_t, RayHitResult& out_result) const
+    {
+        tl_traversal_counters.intersection_tests += num_spheres;
+
+        double t = 0.0;
+        const int position = m_intersect_spheres(*this, sphere_indices, num_spheres, ray, ray_t.m_min, ray_t.m_max, t);
+        if (position < 0)
+        {
+            return false;
+        }
+
+        out_result.m_t = t;
+        out_result.m_hit_object = m_sphere_objects[sphere_indices[position]];
+        ray_t.m_max = t;
+        return true;
+    }
+
+    static IntersectSpheresFunction s_intersect_spheres_override;
+
+    IntersectSpheresFunction m_intersect_spheres = SelectIntersectSpheresFunction();
+
+    std::vector<double> m_sphere_centre_x;
+    std::vector<double> m_sphere_centre_y;
+    std::vector<double> m_sphere_centre_z;
+    std::vector<double> m_sphere_radii;
+    std::vector<const IRayHittable*> m_sphere_objects;
+
+    std::vector<double> m_box_min_x;
+    std::vector<double> m_box_min_y;
+    std::vector<double> m_box_min_z;
+    std::vector<double> m_box_max_x;
+    std::vector<double> m_box_max_y;
+    std::vector<double> m_box_max_z;
+    std::vector<const IRayHittable*> m_box_objects;
+
+    std::vector<IRayHittable*> m_hittables;
+
+    // Id of each of the constructor's objects, in order
+    std::vector<PrimitiveId> m_ids;
+};
+
+} // namespace ART
@@ -1,6 +1,7 @@
 // Copyright Mia Rolfe. All rights reserved.
 #include <Geometry/Sphere.h>
 
+#include <Core/Random.h>
 #include <Core/TraversalStats.h>
 #include <Geometry/AxisAlignedBoundingBox.h>
 #include <Materials/Material.h>
@@ -16,7 +17,7 @@ Sphere::Sphere(const Point3& centre, double radius, Material* material)
     m_bounding_box = AABB(m_centre - radius_vec, m_centre + radius_vec);
 }
 
-bool Sphere::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+bool Sphere::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
     RecordIntersectionTest();
 
@@ -45,15 +46,77 @@ bool Sphere::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
         return false;
     }
 
-    // Populate result
     out_result.m_t = root;
+    out_result.m_hit_object = this;
+    return true;
+}
+
+bool Sphere::HitAny(const Ray& ray, Interval ray_t) const
+{
+    RayHitResult result;
+    return HitDeferred(ray, ray_t, result);
+}
+
+void Sphere::SetHitAttributes(const Ray& ray, RayHitResult& out_result) const
+{
     out_result.m_point = ray.At(out_result.m_t);
     const Vec3 outward_facing_normal = (out_result.m_point - m_centre) / m_radius;
     out_result.SetFaceNormal(ray, outward_facing_normal);
     GetUVOnUnitSphere(outward_facing_normal, out_result.m_u, out_result.m_v);
     out_result.m_material = m_material;
+}
 
-    return true;
+double Sphere::DirectionPdf(const Point3& origin, const Vec3& direction) const
+{
+    const Vec3 to_centre = m_centre - origin;
+    const double distance_squared = to_centre.LengthSquared();
+    const double radius_squared = m_radius * m_radius;
+
+    if (distance_squared <= radius_squared)
+    {
+        return 1.0 / (4.0 * pi);
+    }
+
+    // 1 - cos(theta_max) as sin^2 / (1 + cos), which keeps its precision for small, distant spheres
+    const double sin_theta_max_squared = radius_squared / distance_squared;
+    const double cos_theta_max = std::sqrt(std::max(0.0, 1.0 - sin_theta_max_squared));
+    const double cos_theta = Dot(Normalised(direction), to_centre) / std::sqrt(distance_squared);
+    if (cos_theta < cos_theta_max)
+    {
+        return 0.0;
+    }
+
+    const double one_minus_cos_theta_max = sin_theta_max_squared / (1.0 + cos_theta_max);
+    return 1.0 / (2.0 * pi * one_minus_cos_theta_max);
+}
+
+Vec3 Sphere::SampleDirection(const Point3& origin) const
+{
+    const Vec3 to_centre = m_centre - origin;
+    const double distance_squared = to_centre.LengthSquared();
+    const double radius_squared = m_radius * m_radius;
+
+    if (distance_squared <= radius_squared)
+    {
+        return RandomNormalised();
+    }
+
+    const double sin_theta_max_squared = radius_squared / distance_squared;
+    const double cos_theta_max = std::sqrt(std::max(0.0, 1.0 - sin_theta_max_squared));
+    const double one_minus_cos_theta_max = sin_theta_max_squared / (1.0 + cos_theta_max);
+
+    // Uniform in solid angle within the cone, cos(theta) is uniform in [cos(theta_max), 1]
+    const double cos_theta = 1.0 - (RandomCanonicalDouble() * one_minus_cos_theta_max);
+    const double sin_theta = std::sqrt(std::max(0.0, 1.0 - (cos_theta * cos_theta)));
+    const double phi = 2.0 * pi * RandomCanonicalDouble();
+
+    // Orthonormal basis with w towards the centre
+    const Vec3 w = to_centre / std::sqrt(distance_squared);
+    const Vec3 a = (std::fabs(w.m_x) > 0.9) ? Vec3(0.0, 1.0, 0.0) : Vec3(1.0, 0.0, 0.0);
+    const Vec3 v = Normalised(Cross(w, a));
+    const Vec3 u = Cross(w, v);
+
+    return (u * (std::cos(phi) * sin_theta)) + (v * (std::sin(phi) * sin_theta)) + (w * cos_theta);
 }
 
 AABB Sphere::BoundingBox() const
@@ -19,8 +19,20 @@ public:
     Sphere(const Point3& centre, double radius, Material* material);
 
     // Check if a ray intersects this sphere
-    // Returns the result details using out_result
-    bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+    // Returns the hit distance using out_result
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // A sphere reports a single hit, so any hit is its closest hit without the attributes
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
+
+    // Fills the point, normal, UV and material of a hit on this sphere
+    void SetHitAttributes(const Ray& ray, RayHitResult& out_result) const override;
+
+    // Directions are drawn uniformly within the cone the sphere subtends from origin, or over every direction
+    // from inside the sphere
+    double DirectionPdf(const Point3& origin, const Vec3& direction) const override;
+
+    Vec3 SampleDirection(const Point3& origin) const override;
 
     // Return the sphere's bounding box
     AABB BoundingBox() const override;
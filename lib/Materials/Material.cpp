@@ -19,6 +19,21 @@ bool Material::Scatter(const Ray& ray, const RayHitResult& result, Colour& out_a
     return false;
 }
 
+double Material::ScatteringPdf(const RayHitResult& result, const Vec3& direction) const
+{
+    return 0.0;
+}
+
+Colour Material::ScatteringValue(const RayHitResult& result, const Vec3& direction) const
+{
+    return Colour(0.0);
+}
+
+bool Material::IsEmissive() const
+{
+    return false;
+}
+
 LambertianMaterial::LambertianMaterial(Texture* texture)
 {
     m_texture = texture;
@@ -37,6 +52,17 @@ bool LambertianMaterial::Scatter(const Ray& ray, const RayHitResult& result, Col
     return true;
 }
 
+double LambertianMaterial::ScatteringPdf(const RayHitResult& result, const Vec3& direction) const
+{
+    return (Dot(direction, result.m_normal) > 0.0) ? 1.0 / (2.0 * pi) : 0.0;
+}
+
+Colour LambertianMaterial::ScatteringValue(const RayHitResult& result, const Vec3& direction) const
+{
+    // Scatter attenuates by the texture alone, whichever direction it draws
+    return m_texture->Value(result.m_u, result.m_v, result.m_point) * ScatteringPdf(result, direction);
+}
+
 MetalMaterial::MetalMaterial(const Colour& albedo, double fuzz)
 {
     m_albedo = albedo;
@@ -97,4 +123,9 @@ Colour DiffuseLightMaterial::Emitted(double u, double v, const Point3& point) co
     return m_texture->Value(u, v, point);
 }
 
+bool DiffuseLightMaterial::IsEmissive() const
+{
+    return true;
+}
+
 } // namespace ART
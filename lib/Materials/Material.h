@@ -17,6 +17,17 @@ public:
     virtual Colour Emitted(double u, double v, const Point3& point) const;
 
     virtual bool Scatter(const Ray& ray, const RayHitResult& result, Colour& out_attenuation, Ray& out_ray) const;
+
+    // Density over solid angle of Scatter drawing direction, 0 for materials whose scattered directions have no
+    // density to compare against (mirror-like reflection and refraction), which are never lit by sampling a light
+    virtual double ScatteringPdf(const RayHitResult& result, const Vec3& direction) const;
+
+    // Attenuation Scatter would give direction, times ScatteringPdf of direction, so a direction drawn some other way
+    // (towards a light) can be weighted the same way
+    virtual Colour ScatteringValue(const RayHitResult& result, const Vec3& direction) const;
+
+    // Whether Emitted can be non-zero, objects with an emissive material are gathered as lights
+    virtual bool IsEmissive() const;
 };
 
 class LambertianMaterial : public Material
@@ -26,6 +37,11 @@ public:
 
     bool Scatter(const Ray& ray, const RayHitResult& result, Colour& out_attenuation, Ray& out_ray) const override;
 
+    // Scatter draws directions uniformly over the hemisphere about the normal
+    double ScatteringPdf(const RayHitResult& result, const Vec3& direction) const override;
+
+    Colour ScatteringValue(const RayHitResult& result, const Vec3& direction) const override;
+
 protected:
     Texture* m_texture;
 };
@@ -65,6 +81,8 @@ public:
 
     Colour Emitted(double u, double v, const Point3& point) const override;
 
+    bool IsEmissive() const override;
+
 protected:
     Texture* m_texture;
 };
@@ -7,6 +7,7 @@
 #include <Core/Common.h>
 #include <Core/Logger.h>
 #include <Core/Random.h>
+#include <Core/Timer.h>
 #include <Core/TraversalStats.h>
 #include <Core/Utility.h>
 #include <Materials/Material.h>
@@ -14,6 +15,7 @@
 #include <Maths/Ray.h>
 #include <Maths/Vec3.h>
 #include <RayTracing/RayHitResult.h>
+#include <RayTracing/RayQueue.h>
 
 namespace ART
 {
@@ -35,7 +37,12 @@ const CameraRenderConfig default_render_config =
     600,
     600,
     50,
-    25
+    25,
+    0,
+    false,
+    0,
+    false,
+    false
 };
 
 Camera::Camera() : Camera(default_view_config, default_render_config) {}
@@ -53,6 +60,10 @@ Camera::Camera(const CameraViewConfig& view_config, const CameraRenderConfig& re
     m_image_height = render_config.image_height;
     m_samples_per_pixel = render_config.samples_per_pixel;
     m_max_ray_bounces = render_config.max_ray_bounces;
+    m_packet_tile_size = std::min(render_config.packet_tile_size, MAX_PACKET_TILE_SIZE);
+    m_wavefront = render_config.wavefront;
+    m_sort_rays_bounce_mask = render_config.sort_rays_bounce_mask;
+    m_next_event_estimation = render_config.next_event_estimation;
 
     DeriveDependentVariables();
     ResizeImageBuffer();
@@ -72,6 +83,10 @@ Camera::Camera(Camera&& other) noexcept
     , m_vertical_fov(other.m_vertical_fov)
     , m_samples_per_pixel(other.m_samples_per_pixel)
     , m_max_ray_bounces(other.m_max_ray_bounces)
+    , m_packet_tile_size(other.m_packet_tile_size)
+    , m_wavefront(other.m_wavefront)
+    , m_sort_rays_bounce_mask(other.m_sort_rays_bounce_mask)
+    , m_next_event_estimation(other.m_next_event_estimation)
     , m_look_from(other.m_look_from)
     , m_look_at(other.m_look_at)
     , m_up(other.m_up)
@@ -107,6 +122,10 @@ Camera& Camera::operator=(Camera&& other) noexcept
         m_vertical_fov = other.m_vertical_fov;
         m_samples_per_pixel = other.m_samples_per_pixel;
         m_max_ray_bounces = other.m_max_ray_bounces;
+        m_packet_tile_size = other.m_packet_tile_size;
+        m_wavefront = other.m_wavefront;
+        m_sort_rays_bounce_mask = other.m_sort_rays_bounce_mask;
+        m_next_event_estimation = other.m_next_event_estimation;
         m_look_from = other.m_look_from;
         m_look_at = other.m_look_at;
         m_up = other.m_up;
@@ -157,8 +176,6 @@ bool Camera::RenderAsync
     assert(m_max_ray_bounces >= 1);
     assert(m_image_data != nullptr);
 
-    const Colour& background_colour = scene_config.background_colour;
-
     // Update progress every 16 rows
     constexpr std::size_t progress_update_interval = 16;
 
@@ -172,48 +189,46 @@ bool Camera::RenderAsync
         tl_traversal_counters.Reset();
     }
 
-    #pragma omp parallel for schedule(dynamic)
-    for (std::int64_t j = 0; j < static_cast<std::int64_t>(m_image_height); j++)
-    {
-        // Skip work in loop until return possible
-        if (should_cancel.load(std::memory_order_relaxed))
-        {
-            continue;
-        }
-
-        std::size_t output_buffer_index =
-            static_cast<std::size_t>(j) *
-            m_image_width *
-            num_image_components;
+    uint64_t num_rays_sorted = 0;
+    double ray_sort_time_ms = 0.0;
 
-        for (std::size_t i = 0; i < m_image_width; i++)
+    if (m_wavefront)
+    {
+        RenderWavefront(scene, scene_config, should_cancel, num_completed_rows, num_rays_sorted, ray_sort_time_ms);
+    }
+    else if (m_packet_tile_size > 0)
+    {
+        RenderPacketTiles(scene, scene_config, should_cancel, num_completed_rows);
+    }
+    else
+    {
+        #pragma omp parallel for schedule(dynamic)
+        for (std::int64_t j = 0; j < static_cast<std::int64_t>(m_image_height); j++)
         {
-            Colour pixel_colour(0.0);
-
-            for (std::size_t sample = 0; sample < m_samples_per_pixel; sample++)
+            // Skip work in loop until return possible
+            if (should_cancel.load(std::memory_order_relaxed))
             {
-                const Ray& ray = GetRay(i, j);
-                pixel_colour += RayColour(ray, m_max_ray_bounces, scene, background_colour);
+                continue;
             }
 
-            pixel_colour *= m_pixel_sample_scale;
+            for (std::size_t i = 0; i < m_image_width; i++)
+            {
+                Colour pixel_colour(0.0);
 
-            const double r_component = LinearToGamma(pixel_colour.m_x);
-            const double g_component = LinearToGamma(pixel_colour.m_y);
-            const double b_component = LinearToGamma(pixel_colour.m_z);
+                for (std::size_t sample = 0; sample < m_samples_per_pixel; sample++)
+                {
+                    const Ray& ray = GetRay(i, j);
+                    pixel_colour += RayColour(ray, m_max_ray_bounces, scene, scene_config, 0.0);
+                }
 
-            m_image_data[output_buffer_index++] =
-                static_cast<uint8_t>(256 * intensity.Clamp(r_component));
-            m_image_data[output_buffer_index++] =
-                static_cast<uint8_t>(256 * intensity.Clamp(g_component));
-            m_image_data[output_buffer_index++] =
-                static_cast<uint8_t>(256 * intensity.Clamp(b_component));
-        }
+                WritePixel(i, static_cast<std::size_t>(j), pixel_colour);
+            }
 
-        // Update rows completed every (progress_update_interval) rows
-        if (num_completed_rows && (static_cast<std::size_t>(j) % progress_update_interval == 0))
-        {
-            num_completed_rows->fetch_add(progress_update_interval, std::memory_order_relaxed);
+            // Update rows completed every (progress_update_interval) rows
+            if (num_completed_rows && (static_cast<std::size_t>(j) % progress_update_interval == 0))
+            {
+                num_completed_rows->fetch_add(progress_update_interval, std::memory_order_relaxed);
+            }
         }
     }
 
@@ -230,11 +245,23 @@ bool Camera::RenderAsync
         out_traversal_stats->total_nodes_traversed = 0;
         out_traversal_stats->total_intersection_tests = 0;
         out_traversal_stats->total_rays_cast = 0;
+        out_traversal_stats->total_packet_ray_slots = 0;
+        out_traversal_stats->total_packet_active_rays = 0;
+        out_traversal_stats->total_rays_sorted = num_rays_sorted;
+        out_traversal_stats->ray_sort_time_ms = ray_sort_time_ms;
+        out_traversal_stats->total_occlusion_rays_cast = 0;
+        out_traversal_stats->total_occlusion_nodes_traversed = 0;
+        out_traversal_stats->total_occlusion_intersection_tests = 0;
         for (int thread_id = 0; thread_id < max_threads; thread_id++)
         {
             out_traversal_stats->total_nodes_traversed += per_thread_counters[thread_id].nodes_traversed;
             out_traversal_stats->total_intersection_tests += per_thread_counters[thread_id].intersection_tests;
             out_traversal_stats->total_rays_cast += per_thread_counters[thread_id].rays_cast;
+            out_traversal_stats->total_packet_ray_slots += per_thread_counters[thread_id].packet_ray_slots;
+            out_traversal_stats->total_packet_active_rays += per_thread_counters[thread_id].packet_active_rays;
+            out_traversal_stats->total_occlusion_rays_cast += per_thread_counters[thread_id].occlusion_rays_cast;
+            out_traversal_stats->total_occlusion_nodes_traversed += per_thread_counters[thread_id].occlusion_nodes_traversed;
+            out_traversal_stats->total_occlusion_intersection_tests += per_thread_counters[thread_id].occlusion_intersection_tests;
         }
     }
 
@@ -306,7 +333,230 @@ void Camera::ResizeImageBuffer()
     m_image_data = new uint8_t[m_image_width * m_image_height * num_image_components]{};
 }
 
-Colour Camera::RayColour(const Ray& ray, std::size_t depth, const IRayHittable& scene, const Colour& background_colour)
+void Camera::RenderPacketTiles
+(
+    const IRayHittable& scene,
+    const SceneConfig& scene_config,
+    const std::atomic<bool>& should_cancel,
+    std::atomic<std::size_t>* num_completed_rows
+)
+{
+    // Camera ray hits go straight to ShadeHit, which RayColour only reaches with depth > 0
+    assert(m_max_ray_bounces >= 1);
+
+    const Colour& background_colour = scene_config.background_colour;
+    const std::size_t tile_size = m_packet_tile_size;
+    const std::size_t num_tile_rows = (m_image_height + tile_size - 1) / tile_size;
+    const double min_ray_t = 0.001;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (std::int64_t tile_row = 0; tile_row < static_cast<std::int64_t>(num_tile_rows); tile_row++)
+    {
+        // Skip work in loop until return possible
+        if (should_cancel.load(std::memory_order_relaxed))
+        {
+            continue;
+        }
+
+        const std::size_t j_begin = static_cast<std::size_t>(tile_row) * tile_size;
+        const std::size_t j_end = std::min(j_begin + tile_size, m_image_height);
+
+        RayPacket packet;
+        RayHitResult results[RayPacket::MAX_SIZE];
+        Colour pixel_colours[RayPacket::MAX_SIZE];
+
+        for (std::size_t i_begin = 0; i_begin < m_image_width; i_begin += tile_size)
+        {
+            const std::size_t i_end = std::min(i_begin + tile_size, m_image_width);
+
+            for (std::size_t pixel_index = 0; pixel_index < RayPacket::MAX_SIZE; pixel_index++)
+            {
+                pixel_colours[pixel_index] = Colour(0.0);
+            }
+
+            // One packet per sample, holding that sample's ray through every pixel of the tile
+            for (std::size_t sample = 0; sample < m_samples_per_pixel; sample++)
+            {
+                packet.Clear();
+                for (std::size_t j = j_begin; j < j_end; j++)
+                {
+                    for (std::size_t i = i_begin; i < i_end; i++)
+                    {
+                        packet.Add(GetRay(i, j));
+                    }
+                }
+
+                const RayMask hit_rays = scene.HitPacket(packet, Interval(min_ray_t, infinity), results);
+
+                for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
+                {
+                    RecordRayCast();
+                    pixel_colours[ray_index] += (hit_rays & (RayMask(1) << ray_index))
+                        ? ShadeHit(packet.m_rays[ray_index], results[ray_index], m_max_ray_bounces, scene, scene_config, 0.0)
+                        : background_colour;
+                }
+            }
+
+            std::size_t pixel_index = 0;
+            for (std::size_t j = j_begin; j < j_end; j++)
+            {
+                for (std::size_t i = i_begin; i < i_end; i++)
+                {
+                    WritePixel(i, j, pixel_colours[pixel_index++]);
+                }
+            }
+        }
+
+        if (num_completed_rows)
+        {
+            num_completed_rows->fetch_add(j_end - j_begin, std::memory_order_relaxed);
+        }
+    }
+}
+
+void Camera::RenderWavefront
+(
+    const IRayHittable& scene,
+    const SceneConfig& scene_config,
+    const std::atomic<bool>& should_cancel,
+    std::atomic<std::size_t>* num_completed_rows,
+    uint64_t& out_num_rays_sorted,
+    double& out_ray_sort_time_ms
+)
+{
+    const Colour& background_colour = scene_config.background_colour;
+    const LightList& lights = scene_config.lights;
+    const std::size_t rows_per_band = std::max<std::size_t>(1, MAX_WAVEFRONT_PATHS / m_image_width);
+    const double min_ray_t = 0.001;
+
+    RayQueue queue;
+    RayQueue next_queue;
+    std::vector<uint8_t> scattered;
+    std::vector<Colour> pixel_colours;
+    const AABB scene_bounding_box = scene.BoundingBox();
+
+    for (std::size_t j_begin = 0; j_begin < m_image_height; j_begin += rows_per_band)
+    {
+        const std::size_t j_end = std::min(j_begin + rows_per_band, m_image_height);
+        const std::size_t num_band_pixels = (j_end - j_begin) * m_image_width;
+
+        pixel_colours.assign(num_band_pixels, Colour(0.0));
+
+        // One path per pixel in flight at a time, so no two entries of a queue add to the same pixel
+        for (std::size_t sample = 0; sample < m_samples_per_pixel; sample++)
+        {
+            if (should_cancel.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+
+            queue.Resize(num_band_pixels);
+
+            #pragma omp parallel for schedule(static)
+            for (std::int64_t pixel_index = 0; pixel_index < static_cast<std::int64_t>(num_band_pixels); pixel_index++)
+            {
+                const std::size_t i = static_cast<std::size_t>(pixel_index) % m_image_width;
+                const std::size_t j = j_begin + (static_cast<std::size_t>(pixel_index) / m_image_width);
+                queue.SetRay(pixel_index, GetRay(i, j));
+                queue.m_throughputs[pixel_index] = Colour(1.0);
+                queue.m_scatter_pdfs[pixel_index] = 0.0;
+                queue.m_pixel_indices[pixel_index] = static_cast<uint32_t>(pixel_index);
+            }
+
+            // Same sum as RayColour: each bounce adds its emission, or the background on a miss, scaled by the
+            // attenuation of every bounce before it, and paths still going after m_max_ray_bounces add nothing
+            for (std::size_t bounce = 0; bounce < m_max_ray_bounces && queue.Size() > 0; bounce++)
+            {
+                queue.Trace(scene, Interval(min_ray_t, infinity));
+
+                scattered.assign(queue.Size(), 0);
+
+                #pragma omp parallel for schedule(dynamic, 256)
+                for (std::int64_t index = 0; index < static_cast<std::int64_t>(queue.Size()); index++)
+                {
+                    Colour& throughput = queue.m_throughputs[index];
+                    Colour& pixel_colour = pixel_colours[queue.m_pixel_indices[index]];
+
+                    if (queue.m_hit_objects[index] == nullptr)
+                    {
+                        pixel_colour += throughput * background_colour;
+                        continue;
+                    }
+
+                    const Ray ray = queue.GetRay(index);
+                    RayHitResult result;
+                    result.m_t = queue.m_hit_t[index];
+                    result.m_hit_object = queue.m_hit_objects[index];
+                    result.m_hit_object->SetHitAttributes(ray, result);
+
+                    const double emission_weight = EmissionWeight(ray, result, lights, queue.m_scatter_pdfs[index]);
+                    pixel_colour += emission_weight * throughput * result.m_material->Emitted(result.m_u, result.m_v, result.m_point);
+
+                    Ray scattered_ray;
+                    Colour attenuation;
+                    if (result.m_material->Scatter(ray, result, attenuation, scattered_ray))
+                    {
+                        // Shadow rays are traced here as they're made rather than queued, each being a single any-hit
+                        // query that ends the moment it's blocked
+                        pixel_colour += throughput * SampleLight(result, m_max_ray_bounces - bounce, scene, lights);
+
+                        throughput = throughput * attenuation;
+                        queue.m_scatter_pdfs[index] = m_next_event_estimation ? result.m_material->ScatteringPdf(result, scattered_ray.m_direction) : 0.0;
+                        queue.SetRay(index, scattered_ray);
+                        scattered[index] = 1;
+                    }
+                }
+
+                // Only scattered rays are sorted, camera rays are already coherent in pixel order
+                const std::size_t mask_bit = std::min<std::size_t>(bounce, 31);
+                if ((m_sort_rays_bounce_mask >> mask_bit) & 1)
+                {
+                    Timer timer;
+                    timer.Start();
+                    next_queue.AssignSorted(queue, scattered, scene_bounding_box);
+                    timer.Stop();
+                    out_ray_sort_time_ms += timer.ElapsedMilliseconds();
+                    out_num_rays_sorted += next_queue.Size();
+                }
+                else
+                {
+                    next_queue.AssignCompacted(queue, scattered);
+                }
+                std::swap(queue, next_queue);
+            }
+        }
+
+        for (std::size_t pixel_index = 0; pixel_index < num_band_pixels; pixel_index++)
+        {
+            WritePixel(pixel_index % m_image_width, j_begin + (pixel_index / m_image_width), pixel_colours[pixel_index]);
+        }
+
+        if (num_completed_rows)
+        {
+            num_completed_rows->fetch_add(j_end - j_begin, std::memory_order_relaxed);
+        }
+    }
+}
+
+void Camera::WritePixel(std::size_t i, std::size_t j, Colour pixel_colour)
+{
+    pixel_colour *= m_pixel_sample_scale;
+
+    const double r_component = LinearToGamma(pixel_colour.m_x);
+    const double g_component = LinearToGamma(pixel_colour.m_y);
+    const double b_component = LinearToGamma(pixel_colour.m_z);
+
+    std::size_t output_buffer_index = ((j * m_image_width) + i) * num_image_components;
+
+    m_image_data[output_buffer_index++] =
+        static_cast<uint8_t>(256 * intensity.Clamp(r_component));
+    m_image_data[output_buffer_index++] =
+        static_cast<uint8_t>(256 * intensity.Clamp(g_component));
+    m_image_data[output_buffer_index++] =
+        static_cast<uint8_t>(256 * intensity.Clamp(b_component));
+}
+
+Colour Camera::RayColour(const Ray& ray, std::size_t depth, const IRayHittable& scene, const SceneConfig& scene_config, double scatter_pdf)
 {
     if (depth <= 0)
     {
@@ -319,20 +569,94 @@ Colour Camera::RayColour(const Ray& ray, std::size_t depth, const IRayHittable&
     const double min_ray_t = 0.001;
     if (!scene.Hit(ray, Interval(min_ray_t, infinity), result))
     {
-        return background_colour;
+        return scene_config.background_colour;
     }
 
+    return ShadeHit(ray, result, depth, scene, scene_config, scatter_pdf);
+}
+
+Colour Camera::ShadeHit(const Ray& ray, const RayHitResult& result, std::size_t depth, const IRayHittable& scene, const SceneConfig& scene_config, double scatter_pdf)
+{
     Ray scattered;
     Colour attenuation;
-    const Colour colour_from_emission = result.m_material->Emitted(result.m_u, result.m_v, result.m_point);
+    const double emission_weight = EmissionWeight(ray, result, scene_config.lights, scatter_pdf);
+    const Colour colour_from_emission = emission_weight * result.m_material->Emitted(result.m_u, result.m_v, result.m_point);
     if (!result.m_material->Scatter(ray, result, attenuation, scattered))
     {
         return colour_from_emission;
     }
 
-    Colour colour_from_scatter = attenuation * RayColour(scattered, depth - 1, scene, background_colour);
+    const Colour colour_from_light = SampleLight(result, depth, scene, scene_config.lights);
+
+    const double next_scatter_pdf = m_next_event_estimation ? result.m_material->ScatteringPdf(result, scattered.m_direction) : 0.0;
+    Colour colour_from_scatter = attenuation * RayColour(scattered, depth - 1, scene, scene_config, next_scatter_pdf);
+
+    return colour_from_emission + colour_from_light + colour_from_scatter;
+}
+
+Colour Camera::SampleLight(const RayHitResult& result, std::size_t depth, const IRayHittable& scene, const LightList& lights) const
+{
+    // The scattered ray only reaches a light if depth leaves it a bounce, sampling lights past that would count paths
+    // the scattered ray never could
+    if (!m_next_event_estimation || lights.Empty() || depth <= 1)
+    {
+        return Colour(0.0);
+    }
+
+    double light_probability = 0.0;
+    const IRayHittable* light = lights.Sample(result.m_point, light_probability);
+    if (light == nullptr)
+    {
+        return Colour(0.0);
+    }
+
+    const Vec3 direction = Normalised(light->SampleDirection(result.m_point));
+
+    const double scatter_pdf = result.m_material->ScatteringPdf(result, direction);
+    if (scatter_pdf <= 0.0)
+    {
+        return Colour(0.0);
+    }
+
+    const double light_pdf = light_probability * light->DirectionPdf(result.m_point, direction);
+    if (light_pdf <= 0.0)
+    {
+        return Colour(0.0);
+    }
+
+    const double min_ray_t = 0.001;
+    const Ray shadow_ray(result.m_point, direction);
+    RayHitResult light_result;
+    if (!light->Hit(shadow_ray, Interval(min_ray_t, infinity), light_result))
+    {
+        return Colour(0.0);
+    }
+
+    if (scene.Occluded(shadow_ray, Interval(min_ray_t, light_result.m_t - min_ray_t)))
+    {
+        return Colour(0.0);
+    }
+
+    const Colour emitted = light_result.m_material->Emitted(light_result.m_u, light_result.m_v, light_result.m_point);
+    const double weight = PowerHeuristic(light_pdf, scatter_pdf) / light_pdf;
+    return weight * result.m_material->ScatteringValue(result, direction) * emitted;
+}
 
-    return colour_from_emission + colour_from_scatter;
+double Camera::EmissionWeight(const Ray& ray, const RayHitResult& result, const LightList& lights, double scatter_pdf)
+{
+    if (scatter_pdf <= 0.0 || !result.m_material->IsEmissive())
+    {
+        return 1.0;
+    }
+
+    const double light_pdf = lights.Probability(ray.m_origin, result.m_hit_object) * result.m_hit_object->DirectionPdf(ray.m_origin, ray.m_direction);
+    return PowerHeuristic(scatter_pdf, light_pdf);
+}
+
+double Camera::PowerHeuristic(double pdf, double other_pdf)
+{
+    const double pdf_squared = pdf * pdf;
+    return pdf_squared / (pdf_squared + (other_pdf * other_pdf));
 }
 
 Ray Camera::GetRay(std::size_t i, std::size_t j)
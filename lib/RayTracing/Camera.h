@@ -7,6 +7,7 @@
 #include <Core/TraversalStats.h>
 #include <Maths/Colour.h>
 #include <RayTracing/IRayHittable.h>
+#include <RayTracing/LightList.h>
 
 namespace ART
 {
@@ -29,12 +30,29 @@ public:
     std::size_t image_height;
     std::size_t samples_per_pixel;
     std::size_t max_ray_bounces;
+    // Side in pixels of the square tiles whose camera rays are traced together as a RayPacket, 0 traces single rays
+    std::size_t packet_tile_size;
+    // Trace whole bounces of many paths at once, shading in a separate pass, instead of following one path at a time
+    // Takes precedence over packet_tile_size
+    bool wavefront;
+    // Bounces whose secondary rays a wavefront render sorts by direction and origin before tracing them
+    // Bit n covers the rays scattered at bounce n, bounce 0 being the camera rays' hits
+    // Bounces past 31 follow bit 31, 0 disables sorting
+    uint32_t sort_rays_bounce_mask;
+    // At each bounce, also sample a point on one of the scene's lights through a shadow ray, combining it with the
+    // scattered ray by multiple importance sampling
+    bool next_event_estimation;
+    // Pick the light each next-event estimate samples through a light BVH, in proportion to its estimated
+    // contribution, rather than uniformly. Read when the scene is set up
+    bool light_bvh;
 };
 
 struct SceneConfig
 {
 public:
     Colour background_colour;
+    // Emissive primitives sampled by next-event estimation
+    LightList lights;
 };
 
 class Camera
@@ -79,13 +97,61 @@ public:
 
     std::size_t GetImageHeight() const { return m_image_height; }
 
+    // Largest packet tile whose rays fit in one RayPacket
+    static constexpr std::size_t MAX_PACKET_TILE_SIZE = 8;
+
+    // sort_rays_bounce_mask that sorts the secondary rays of every bounce
+    static constexpr uint32_t SORT_RAYS_ALL_BOUNCES = 0xFFFFFFFF;
+
+    // Most paths a wavefront render keeps in flight, the image is rendered in bands of rows holding at most this many
+    // pixels
+    static constexpr std::size_t MAX_WAVEFRONT_PATHS = std::size_t(1) << 18;
 
 protected:
     void DeriveDependentVariables();
 
     void ResizeImageBuffer();
 
-    Colour RayColour(const Ray& ray, std::size_t depth, const IRayHittable& scene, const Colour& background_colour);
+    // Traces packet tiles of primary rays, then follows each bounce one ray at a time
+    void RenderPacketTiles
+    (
+        const IRayHittable& scene,
+        const SceneConfig& scene_config,
+        const std::atomic<bool>& should_cancel,
+        std::atomic<std::size_t>* num_completed_rows
+    );
+
+    // Renders bands of rows a bounce at a time: each bounce traces every live path of the band, then shades the hits
+    // and compacts the paths that scattered into the next bounce's queue
+    void RenderWavefront
+    (
+        const IRayHittable& scene,
+        const SceneConfig& scene_config,
+        const std::atomic<bool>& should_cancel,
+        std::atomic<std::size_t>* num_completed_rows,
+        uint64_t& out_num_rays_sorted,
+        double& out_ray_sort_time_ms
+    );
+
+    void WritePixel(std::size_t i, std::size_t j, Colour pixel_colour);
+
+    // scatter_pdf is the density with which the surface ray left drew its direction, 0 for camera rays and for rays
+    // whose emission isn't shared with next-event estimation
+    Colour RayColour(const Ray& ray, std::size_t depth, const IRayHittable& scene, const SceneConfig& scene_config, double scatter_pdf);
+
+    // Colour along ray given its closest hit in the scene, depth counting the bounce that found the hit
+    Colour ShadeHit(const Ray& ray, const RayHitResult& result, std::size_t depth, const IRayHittable& scene, const SceneConfig& scene_config, double scatter_pdf);
+
+    // Light reaching the hit of result directly from one sampled light, weighted against the chance of the scattered
+    // ray finding the same light. Nothing unless next-event estimation is on and depth leaves a bounce to the light
+    Colour SampleLight(const RayHitResult& result, std::size_t depth, const IRayHittable& scene, const LightList& lights) const;
+
+    // Weight of the emission found by ray at its hit, result, against the chance of next-event estimation from
+    // ray's origin sampling the same light
+    static double EmissionWeight(const Ray& ray, const RayHitResult& result, const LightList& lights, double scatter_pdf);
+
+    // Multiple importance sampling weight of a sample drawn with density pdf, another strategy having density other_pdf
+    static double PowerHeuristic(double pdf, double other_pdf);
 
     Ray GetRay(std::size_t i, std::size_t j);
 
@@ -112,6 +178,18 @@ protected:
     // Max number of recursions for each ray bouncing
     std::size_t m_max_ray_bounces;
 
+    // Side in pixels of the tiles traced as packets, 0 to trace single rays
+    std::size_t m_packet_tile_size;
+
+    // Render a bounce at a time rather than a path at a time
+    bool m_wavefront;
+
+    // Wavefront bounces whose secondary rays are reordered for coherence before being traced
+    uint32_t m_sort_rays_bounce_mask;
+
+    // Sample lights directly at each bounce
+    bool m_next_event_estimation;
+
     // The point where the camera is looking from, i.e. its position
     Point3 m_look_from;
 
@@ -1,10 +1,12 @@
 // Copyright Mia Rolfe. All rights reserved.
 #pragma once
 
+#include <Core/TraversalStats.h>
 #include <Geometry/AxisAlignedBoundingBox.h>
 #include <Maths/Interval.h>
 #include <Maths/Ray.h>
 #include <RayTracing/RayHitResult.h>
+#include <RayTracing/RayPacket.h>
 
 namespace ART
 {
@@ -14,7 +16,100 @@ struct IRayHittable
 {
 public:
     virtual ~IRayHittable() = default;
-    virtual bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const = 0;
+
+    // Closest hit within ray_t, with every attribute of out_result filled
+    bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+    {
+        if (!HitDeferred(ray, ray_t, out_result))
+        {
+            return false;
+        }
+
+        out_result.m_hit_object->SetHitAttributes(ray, out_result);
+        return true;
+    }
+
+    // Closest hit within ray_t, filling only out_result.m_t and out_result.m_hit_object
+    // Traversal is built on this, so the surface attributes are computed once for the closest hit rather than for
+    // every hit found before it. out_result is only written when there is a hit, and only with a closer one than
+    // ray_t.m_max, so callers can narrow ray_t and pass the same result along
+    virtual bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const = 0;
+
+    // True if anything is hit within ray_t, e.g. whether a shadow ray is blocked before reaching its light
+    // Counted as an occlusion ray, the nodes and intersection tests it takes go to the occlusion counters
+    bool Occluded(const Ray& ray, Interval ray_t) const
+    {
+        const uint64_t nodes_traversed_before = tl_traversal_counters.nodes_traversed;
+        const uint64_t intersection_tests_before = tl_traversal_counters.intersection_tests;
+
+        const bool occluded = HitAny(ray, ray_t);
+
+        tl_traversal_counters.occlusion_rays_cast++;
+        tl_traversal_counters.occlusion_nodes_traversed += tl_traversal_counters.nodes_traversed - nodes_traversed_before;
+        tl_traversal_counters.occlusion_intersection_tests += tl_traversal_counters.intersection_tests - intersection_tests_before;
+        tl_traversal_counters.nodes_traversed = nodes_traversed_before;
+        tl_traversal_counters.intersection_tests = intersection_tests_before;
+        return occluded;
+    }
+
+    // Whether any hit lies within ray_t. Returns on the first hit found, in whatever order traversal finds it, and
+    // writes no hit attributes. The default searches for the closest hit, structures override it to stop early
+    virtual bool HitAny(const Ray& ray, Interval ray_t) const
+    {
+        RayHitResult result;
+        return HitDeferred(ray, ray_t, result);
+    }
+
+    // Closest hit within ray_t of every ray of packet, with every attribute filled
+    // Returns the rays that hit, out_results[i] holding the hit of ray i
+    RayMask HitPacket(const RayPacket& packet, Interval ray_t, RayHitResult* out_results) const
+    {
+        double ray_t_max[RayPacket::MAX_SIZE];
+        for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
+        {
+            ray_t_max[ray_index] = ray_t.m_max;
+        }
+
+        const RayMask hit_rays = HitPacketDeferred(packet, packet.AllRays(), ray_t.m_min, ray_t_max, out_results);
+        for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
+        {
+            if (hit_rays & (RayMask(1) << ray_index))
+            {
+                out_results[ray_index].m_hit_object->SetHitAttributes(packet.m_rays[ray_index], out_results[ray_index]);
+            }
+        }
+        return hit_rays;
+    }
+
+    // HitDeferred for each ray i of active_rays within [ray_t_min, ray_t_max[i]], narrowing ray_t_max[i] to its hits
+    // Returns the rays that hit. Traces each ray on its own, structures that can share work across a packet override this
+    virtual RayMask HitPacketDeferred(const RayPacket& packet, RayMask active_rays, double ray_t_min, double* ray_t_max, RayHitResult* out_results) const
+    {
+        RayMask hit_rays = 0;
+        for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
+        {
+            const RayMask ray_bit = RayMask(1) << ray_index;
+            if ((active_rays & ray_bit) && HitDeferred(packet.m_rays[ray_index], Interval(ray_t_min, ray_t_max[ray_index]), out_results[ray_index]))
+            {
+                ray_t_max[ray_index] = out_results[ray_index].m_t;
+                hit_rays |= ray_bit;
+            }
+        }
+        return hit_rays;
+    }
+
+    // Fills the rest of out_result for a hit on this object found by HitDeferred
+    // Only primitives record themselves as the hit object, so objects that contain others needn't override this
+    virtual void SetHitAttributes(const Ray& /* ray */, RayHitResult& /* out_result */) const {}
+
+    // Density over solid angle, seen from origin, of SampleDirection drawing direction
+    // 0 for objects that can't be sampled as lights, or if direction from origin misses this object
+    virtual double DirectionPdf(const Point3& /* origin */, const Vec3& /* direction */) const { return 0.0; }
+
+    // Random direction from origin towards this object, for sampling it as a light
+    // Only meaningful for objects with a non-zero DirectionPdf
+    virtual Vec3 SampleDirection(const Point3& /* origin */) const { return Vec3(1.0, 0.0, 0.0); }
+
     virtual AABB BoundingBox() const = 0;
 };
 
@@ -0,0 +1,456 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <RayTracing/LightBVH.h>
+
+#include <Core/Random.h>
+#include <Geometry/AxisAlignedBox.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+
+namespace ART
+{
+
+static Point3 Centre(const AABB& bounding_box)
+{
+    return Point3
+    (
+        0.5 * (bounding_box.m_x.m_min + bounding_box.m_x.m_max),
+        0.5 * (bounding_box.m_y.m_min + bounding_box.m_y.m_max),
+        0.5 * (bounding_box.m_z.m_min + bounding_box.m_z.m_max)
+    );
+}
+
+static double SinFromCos(double cos_theta)
+{
+    return std::sqrt(std::max(0.0, 1.0 - (cos_theta * cos_theta)));
+}
+
+// cos(max(0, a - b)) and sin(max(0, a - b)) from the sines and cosines of a and b
+static double CosSubtractClamped(double sin_a, double cos_a, double sin_b, double cos_b)
+{
+    return (cos_a > cos_b) ? 1.0 : (cos_a * cos_b) + (sin_a * sin_b);
+}
+
+static double SinSubtractClamped(double sin_a, double cos_a, double sin_b, double cos_b)
+{
+    return (cos_a > cos_b) ? 0.0 : (sin_a * cos_b) - (cos_a * sin_b);
+}
+
+// Rotates vec by angle about unit axis
+static Vec3 Rotate(const Vec3& vec, const Vec3& axis, double angle)
+{
+    const double cos_angle = std::cos(angle);
+    const double sin_angle = std::sin(angle);
+    return (vec * cos_angle) + (Cross(axis, vec) * sin_angle) + (axis * (Dot(axis, vec) * (1.0 - cos_angle)));
+}
+
+LightBounds::LightBounds(const AABB& bounding_box, double power, const Vec3& direction, double cos_theta_normals, double cos_theta_emission)
+    : bounding_box(bounding_box), power(power), direction(direction), cos_theta_normals(cos_theta_normals), cos_theta_emission(cos_theta_emission) {}
+
+LightBounds::LightBounds(const LightBounds& bounds1, const LightBounds& bounds2)
+{
+    // Lights that emit nothing add nothing to the other's bounds
+    if (bounds1.power <= 0.0)
+    {
+        *this = bounds2;
+        return;
+    }
+    if (bounds2.power <= 0.0)
+    {
+        *this = bounds1;
+        return;
+    }
+
+    bounding_box = AABB(bounds1.bounding_box, bounds2.bounding_box);
+    power = bounds1.power + bounds2.power;
+    cos_theta_emission = std::min(bounds1.cos_theta_emission, bounds2.cos_theta_emission);
+
+    // Smallest cone about both normal cones
+    const double theta_1 = std::acos(std::clamp(bounds1.cos_theta_normals, -1.0, 1.0));
+    const double theta_2 = std::acos(std::clamp(bounds2.cos_theta_normals, -1.0, 1.0));
+    const double theta_between = std::acos(std::clamp(Dot(bounds1.direction, bounds2.direction), -1.0, 1.0));
+
+    if (std::min(theta_between + theta_2, pi) <= theta_1)
+    {
+        direction = bounds1.direction;
+        cos_theta_normals = bounds1.cos_theta_normals;
+        return;
+    }
+    if (std::min(theta_between + theta_1, pi) <= theta_2)
+    {
+        direction = bounds2.direction;
+        cos_theta_normals = bounds2.cos_theta_normals;
+        return;
+    }
+
+    const double theta = 0.5 * (theta_1 + theta_between + theta_2);
+    const Vec3 rotation_axis = Cross(bounds1.direction, bounds2.direction);
+    if (theta >= pi || rotation_axis.LengthSquared() == 0.0)
+    {
+        direction = bounds1.direction;
+        cos_theta_normals = -1.0;
+        return;
+    }
+
+    // Turn the first cone's axis towards the second's until the cone reaches both
+    direction = Rotate(bounds1.direction, Normalised(rotation_axis), theta - theta_1);
+    cos_theta_normals = std::cos(theta);
+}
+
+double LightBounds::Importance(const Point3& point) const
+{
+    if (power <= 0.0)
+    {
+        return 0.0;
+    }
+
+    const Point3 centre = Centre(bounding_box);
+    const Vec3 diagonal(bounding_box.m_x.Size(), bounding_box.m_y.Size(), bounding_box.m_z.Size());
+    const double radius_squared = 0.25 * diagonal.LengthSquared();
+
+    // Distance is clamped to a tenth of the half diagonal, so a point near the centre of large bounds can't give them
+    // unbounded importance. Clamping to the whole half diagonal would leave the upper levels picking by power alone
+    const Vec3 from_centre = point - centre;
+    const double distance_squared = std::max(from_centre.LengthSquared(), 0.01 * radius_squared);
+
+    // Normals in every direction reach point whatever its direction, the angles below would all come to 0
+    if (cos_theta_normals <= -1.0)
+    {
+        return power / distance_squared;
+    }
+
+    // Angle from the normal cone's axis to point, less the cone's own spread and the spread of the bounds as seen
+    // from point, gives the smallest angle any normal in the bounds can make with the direction to point
+    const double cos_theta_direction = (from_centre.LengthSquared() > 0.0) ? Dot(direction, Normalised(from_centre)) : 1.0;
+    const double sin_theta_direction = SinFromCos(cos_theta_direction);
+
+    const double cos_theta_bounds = (from_centre.LengthSquared() > radius_squared)
+        ? std::sqrt(std::max(0.0, 1.0 - (radius_squared / from_centre.LengthSquared())))
+        : -1.0;
+    const double sin_theta_bounds = SinFromCos(cos_theta_bounds);
+
+    const double sin_theta_normals = SinFromCos(cos_theta_normals);
+    const double cos_theta_outside_normals = CosSubtractClamped(sin_theta_direction, cos_theta_direction, sin_theta_normals, cos_theta_normals);
+    const double sin_theta_outside_normals = SinSubtractClamped(sin_theta_direction, cos_theta_direction, sin_theta_normals, cos_theta_normals);
+    const double cos_theta_nearest = CosSubtractClamped(sin_theta_outside_normals, cos_theta_outside_normals, sin_theta_bounds, cos_theta_bounds);
+
+    if (cos_theta_nearest <= cos_theta_emission)
+    {
+        return 0.0;
+    }
+
+    return power * cos_theta_nearest / distance_squared;
+}
+
+double LightBounds::OrientationMeasure() const
+{
+    const double theta_normals = std::acos(std::clamp(cos_theta_normals, -1.0, 1.0));
+    const double theta_emission = std::acos(std::clamp(cos_theta_emission, -1.0, 1.0));
+    const double theta_widest = std::min(theta_normals + theta_emission, pi);
+    const double sin_theta_normals = std::sin(theta_normals);
+
+    return (2.0 * pi * (1.0 - cos_theta_normals)) + ((pi / 2.0) *
+        ((2.0 * theta_widest * sin_theta_normals) - std::cos(theta_normals - (2.0 * theta_widest)) - (2.0 * theta_normals * sin_theta_normals) + cos_theta_normals));
+}
+
+bool LightBounds::FromLight(const IRayHittable* light, LightBounds& out_bounds)
+{
+    const Material* material = nullptr;
+    double surface_area = 0.0;
+    if (const Sphere* sphere = dynamic_cast<const Sphere*>(light))
+    {
+        material = sphere->m_material;
+        surface_area = 4.0 * pi * sphere->m_radius * sphere->m_radius;
+    }
+    else if (const AxisAlignedBox* box = dynamic_cast<const AxisAlignedBox*>(light))
+    {
+        material = box->m_material;
+        surface_area = box->m_bounding_box.SurfaceArea();
+    }
+
+    if (material == nullptr)
+    {
+        return false;
+    }
+
+    // Emitted radiance is taken at the centre, textured lights are only estimated
+    const AABB bounding_box = light->BoundingBox();
+    const Colour emitted = material->Emitted(0.5, 0.5, Centre(bounding_box));
+    const double average_radiance = (emitted.m_x + emitted.m_y + emitted.m_z) / 3.0;
+
+    out_bounds = LightBounds(bounding_box, pi * surface_area * std::max(0.0, average_radiance), Vec3(0.0, 0.0, 1.0), -1.0, 0.0);
+    return true;
+}
+
+void LightBVH::Clear()
+{
+    m_nodes.clear();
+    m_lights.clear();
+    m_leaf_indices.clear();
+}
+
+void LightBVH::Build(const std::vector<const IRayHittable*>& lights)
+{
+    Clear();
+
+    std::vector<LightRef> refs;
+    refs.reserve(lights.size());
+    for (const IRayHittable* light : lights)
+    {
+        LightRef ref;
+        if (LightBounds::FromLight(light, ref.bounds))
+        {
+            ref.centroid = Centre(ref.bounds.bounding_box);
+            ref.light = light;
+            refs.push_back(ref);
+        }
+    }
+
+    if (refs.empty())
+    {
+        return;
+    }
+
+    // Binary tree with one light per leaf has 2L-1 nodes
+    m_nodes.reserve((2 * refs.size()) - 1);
+    m_lights.reserve(refs.size());
+    Build(refs, 0, refs.size(), 0, 1);
+}
+
+uint32_t LightBVH::Build(std::vector<LightRef>& refs, std::size_t start, std::size_t count, uint32_t parent, std::size_t depth)
+{
+    const uint32_t node_index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+    m_nodes[node_index].parent = parent;
+
+    if (count == 1)
+    {
+        LightBVHNode& node = m_nodes[node_index];
+        node.bounds = refs[start].bounds;
+        node.offset = static_cast<uint32_t>(m_lights.size());
+        node.is_leaf = true;
+        m_leaf_indices[refs[start].light] = node_index;
+        m_lights.push_back(refs[start].light);
+        return node_index;
+    }
+
+    AABB centroid_bounds;
+    for (std::size_t ref_index = start; ref_index < start + count; ref_index++)
+    {
+        centroid_bounds = AABB(centroid_bounds, AABB(refs[ref_index].centroid, refs[ref_index].centroid));
+    }
+
+    std::size_t num_first = (depth <= MAX_SPLIT_DEPTH) ? SplitBuckets(refs, start, count, centroid_bounds) : 0;
+    if (num_first == 0 || num_first == count)
+    {
+        num_first = SplitMedian(refs, start, count, centroid_bounds);
+    }
+
+    const uint32_t first_child = Build(refs, start, num_first, node_index, depth + 1);
+    const uint32_t second_child = Build(refs, start + num_first, count - num_first, node_index, depth + 1);
+
+    LightBVHNode& node = m_nodes[node_index];
+    node.bounds = LightBounds(m_nodes[first_child].bounds, m_nodes[second_child].bounds);
+    node.offset = second_child;
+    return node_index;
+}
+
+std::size_t LightBVH::SplitBuckets(std::vector<LightRef>& refs, std::size_t start, std::size_t count, const AABB& centroid_bounds)
+{
+    double best_cost = infinity;
+    std::size_t best_axis = 0;
+    std::size_t best_split = 0;
+
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const Interval& extent = centroid_bounds[axis];
+        if (extent.Size() <= 0.0)
+        {
+            continue;
+        }
+
+        LightBounds bucket_bounds[NUM_SPLIT_BUCKETS];
+        std::size_t bucket_counts[NUM_SPLIT_BUCKETS] = {};
+        for (std::size_t ref_index = start; ref_index < start + count; ref_index++)
+        {
+            const double relative = (refs[ref_index].centroid[axis] - extent.m_min) / extent.Size();
+            const std::size_t bucket_index = std::min(static_cast<std::size_t>(relative * NUM_SPLIT_BUCKETS), NUM_SPLIT_BUCKETS - 1);
+            bucket_bounds[bucket_index] = (bucket_counts[bucket_index] == 0)
+                ? refs[ref_index].bounds
+                : LightBounds(bucket_bounds[bucket_index], refs[ref_index].bounds);
+            bucket_counts[bucket_index]++;
+        }
+
+        // Costs of every bucket boundary from sweeps of the buckets below it and above it
+        double below_costs[NUM_SPLIT_BUCKETS - 1];
+        LightBounds below_bounds;
+        std::size_t below_count = 0;
+        for (std::size_t split = 0; split < NUM_SPLIT_BUCKETS - 1; split++)
+        {
+            if (bucket_counts[split] > 0)
+            {
+                below_bounds = (below_count == 0) ? bucket_bounds[split] : LightBounds(below_bounds, bucket_bounds[split]);
+                below_count += bucket_counts[split];
+            }
+            below_costs[split] = (below_count > 0) ? SplitCost(below_bounds) : infinity;
+        }
+
+        LightBounds above_bounds;
+        std::size_t above_count = 0;
+        for (std::size_t split = NUM_SPLIT_BUCKETS - 1; split > 0; split--)
+        {
+            if (bucket_counts[split] > 0)
+            {
+                above_bounds = (above_count == 0) ? bucket_bounds[split] : LightBounds(above_bounds, bucket_bounds[split]);
+                above_count += bucket_counts[split];
+            }
+            if (above_count == 0 || above_count == count)
+            {
+                continue;
+            }
+
+            const double cost = below_costs[split - 1] + SplitCost(above_bounds);
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = split;
+            }
+        }
+    }
+
+    if (best_cost == infinity)
+    {
+        return 0;
+    }
+
+    const Interval& extent = centroid_bounds[best_axis];
+    const auto middle = std::partition
+    (
+        refs.begin() + start,
+        refs.begin() + start + count,
+        [&](const LightRef& ref)
+        {
+            const double relative = (ref.centroid[best_axis] - extent.m_min) / extent.Size();
+            return std::min(static_cast<std::size_t>(relative * NUM_SPLIT_BUCKETS), NUM_SPLIT_BUCKETS - 1) < best_split;
+        }
+    );
+    return static_cast<std::size_t>(middle - (refs.begin() + start));
+}
+
+std::size_t LightBVH::SplitMedian(std::vector<LightRef>& refs, std::size_t start, std::size_t count, const AABB& centroid_bounds)
+{
+    const std::size_t axis = centroid_bounds.LongestAxis();
+    const std::size_t num_first = count / 2;
+    std::nth_element
+    (
+        refs.begin() + start,
+        refs.begin() + start + num_first,
+        refs.begin() + start + count,
+        [axis](const LightRef& ref1, const LightRef& ref2) { return ref1.centroid[axis] < ref2.centroid[axis]; }
+    );
+    return num_first;
+}
+
+double LightBVH::SplitCost(const LightBounds& bounds)
+{
+    return bounds.power * bounds.OrientationMeasure() * bounds.bounding_box.SurfaceArea();
+}
+
+bool LightBVH::Empty() const
+{
+    return m_nodes.empty();
+}
+
+std::size_t LightBVH::NumNodes() const
+{
+    return m_nodes.size();
+}
+
+std::size_t LightBVH::NumLights() const
+{
+    return m_lights.size();
+}
+
+const std::vector<LightBVHNode>& LightBVH::GetNodes() const
+{
+    return m_nodes;
+}
+
+const IRayHittable* LightBVH::Sample(const Point3& point, double& out_probability) const
+{
+    out_probability = 0.0;
+    if (m_nodes.empty())
+    {
+        return nullptr;
+    }
+
+    double probability = 1.0;
+    uint32_t node_index = 0;
+    while (!m_nodes[node_index].is_leaf)
+    {
+        const uint32_t first_child = node_index + 1;
+        const uint32_t second_child = m_nodes[node_index].offset;
+        const double first_importance = m_nodes[first_child].bounds.Importance(point);
+        const double second_importance = m_nodes[second_child].bounds.Importance(point);
+        if (first_importance <= 0.0 && second_importance <= 0.0)
+        {
+            return nullptr;
+        }
+
+        // Same arithmetic as ChildProbability, so Probability gives the chance of this walk
+        const double total_importance = first_importance + second_importance;
+        if (RandomCanonicalDouble() * total_importance < first_importance)
+        {
+            node_index = first_child;
+            probability *= first_importance / total_importance;
+        }
+        else
+        {
+            node_index = second_child;
+            probability *= second_importance / total_importance;
+        }
+    }
+
+    out_probability = probability;
+    return m_lights[m_nodes[node_index].offset];
+}
+
+double LightBVH::Probability(const Point3& point, const IRayHittable* light) const
+{
+    const auto leaf = m_leaf_indices.find(light);
+    if (leaf == m_leaf_indices.end())
+    {
+        return 0.0;
+    }
+
+    double probability = 1.0;
+    for (uint32_t node_index = leaf->second; node_index != 0 && probability > 0.0; node_index = m_nodes[node_index].parent)
+    {
+        probability *= ChildProbability(point, node_index);
+    }
+    return probability;
+}
+
+double LightBVH::ChildProbability(const Point3& point, uint32_t node_index) const
+{
+    const uint32_t parent = m_nodes[node_index].parent;
+    const uint32_t first_child = parent + 1;
+    const uint32_t second_child = m_nodes[parent].offset;
+    const double first_importance = m_nodes[first_child].bounds.Importance(point);
+    const double second_importance = m_nodes[second_child].bounds.Importance(point);
+    if (first_importance <= 0.0 && second_importance <= 0.0)
+    {
+        return 0.0;
+    }
+
+    return ((node_index == first_child) ? first_importance : second_importance) / (first_importance + second_importance);
+}
+
+std::size_t LightBVH::MemoryUsedBytes() const
+{
+    return (m_nodes.size() * sizeof(LightBVHNode))
+        + (m_lights.size() * sizeof(const IRayHittable*))
+        + (m_leaf_indices.size() * (sizeof(const IRayHittable*) + sizeof(uint32_t)));
+}
+
+} // namespace ART
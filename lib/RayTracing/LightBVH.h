@@ -0,0 +1,119 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <Core/Common.h>
+#include <Geometry/AxisAlignedBoundingBox.h>
+#include <Maths/Vec3.h>
+#include <RayTracing/IRayHittable.h>
+
+namespace ART
+{
+
+// Where a group of lights is, how much power it emits and in which directions
+// Emission leaves within cos_theta_emission of a surface normal, every normal lying within cos_theta_normals of
+// direction
+struct LightBounds
+{
+public:
+    AABB bounding_box;
+    double power = 0.0;
+    Vec3 direction = Vec3(0.0, 0.0, 1.0);
+    double cos_theta_normals = 1.0;
+    double cos_theta_emission = 0.0;
+
+    LightBounds() = default;
+
+    LightBounds(const AABB& bounding_box, double power, const Vec3& direction, double cos_theta_normals, double cos_theta_emission);
+
+    // Union constructor
+    LightBounds(const LightBounds& bounds1, const LightBounds& bounds2);
+
+    // Estimate of the light these bounds can send to point: power over squared distance, cut to 0 if no emission
+    // direction can reach point. Only compared against other bounds' importance at the same point
+    double Importance(const Point3& point) const;
+
+    // Solid angle of emission directions, weighted by their cosine to the nearest normal
+    double OrientationMeasure() const;
+
+    // Bounds of a sphere or box with an emissive material, false for any other object
+    // Closed surfaces have normals in every direction, so emit in every direction
+    static bool FromLight(const IRayHittable* light, LightBounds& out_bounds);
+};
+
+// Node of a LightBVH, stored depth-first
+struct LightBVHNode
+{
+public:
+    LightBounds bounds;
+    // Interior: index of second child, first child is always the next node
+    // Leaf: index of its light
+    uint32_t offset = 0;
+    uint32_t parent = 0;
+    bool is_leaf = false;
+};
+
+// Binary tree of lights, one per leaf, picking a light for a point in O(log L) by descending into each child with
+// probability proportional to its importance at that point
+// Built top-down with binned splits minimising power times orientation measure times surface area of each child
+class LightBVH
+{
+public:
+    void Clear();
+
+    // Builds over lights, each a sphere or box with an emissive material
+    void Build(const std::vector<const IRayHittable*>& lights);
+
+    bool Empty() const;
+
+    std::size_t NumNodes() const;
+
+    std::size_t NumLights() const;
+
+    const std::vector<LightBVHNode>& GetNodes() const;
+
+    // Picks the light to sample from point, out_probability being the chance of picking it
+    // nullptr, with out_probability 0, if no light can reach point
+    const IRayHittable* Sample(const Point3& point, double& out_probability) const;
+
+    // Chance that Sample from point picks light, found by walking from its leaf up to the root
+    double Probability(const Point3& point, const IRayHittable* light) const;
+
+    std::size_t MemoryUsedBytes() const;
+
+    static constexpr std::size_t NUM_SPLIT_BUCKETS = 12;
+    // Past this depth splits fall back to median, which bounds the tree depth by MAX_SPLIT_DEPTH + log2(L)
+    static constexpr std::size_t MAX_SPLIT_DEPTH = 32;
+
+protected:
+    struct LightRef
+    {
+    public:
+        LightBounds bounds;
+        Point3 centroid;
+        const IRayHittable* light = nullptr;
+    };
+
+    // Builds the subtree for refs[start, start + count), returning the index of its root
+    uint32_t Build(std::vector<LightRef>& refs, std::size_t start, std::size_t count, uint32_t parent, std::size_t depth);
+
+    // Partitions refs[start, start + count) at the cheapest bucket boundary
+    // Returns number of refs in the first child, 0 if the centroids can't be told apart
+    std::size_t SplitBuckets(std::vector<LightRef>& refs, std::size_t start, std::size_t count, const AABB& centroid_bounds);
+
+    // Fallback if SplitBuckets couldn't split, halves the range along the longest centroid axis
+    std::size_t SplitMedian(std::vector<LightRef>& refs, std::size_t start, std::size_t count, const AABB& centroid_bounds);
+
+    // Chance of descending from node_index's parent into node_index
+    double ChildProbability(const Point3& point, uint32_t node_index) const;
+
+    static double SplitCost(const LightBounds& bounds);
+
+    std::vector<LightBVHNode> m_nodes;
+    std::vector<const IRayHittable*> m_lights;
+    std::unordered_map<const IRayHittable*, uint32_t> m_leaf_indices;
+};
+
+} // namespace ART
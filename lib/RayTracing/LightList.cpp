@@ -0,0 +1,102 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <RayTracing/LightList.h>
+
+#include <Core/Random.h>
+#include <Geometry/AxisAlignedBox.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+
+namespace ART
+{
+
+void LightList::Clear()
+{
+    m_lights.clear();
+    m_light_indices.clear();
+    m_light_bvh.Clear();
+}
+
+void LightList::Add(const IRayHittable* light)
+{
+    if (m_light_indices.count(light) > 0)
+    {
+        return;
+    }
+
+    m_light_indices[light] = m_lights.size();
+    m_lights.push_back(light);
+    m_light_bvh.Clear();
+}
+
+void LightList::Collect(const std::vector<IRayHittable*>& objects)
+{
+    for (const IRayHittable* object : objects)
+    {
+        // Only primitives that can sample directions towards themselves are usable as lights
+        const Material* material = nullptr;
+        if (const Sphere* sphere = dynamic_cast<const Sphere*>(object))
+        {
+            material = sphere->m_material;
+        }
+        else if (const AxisAlignedBox* box = dynamic_cast<const AxisAlignedBox*>(object))
+        {
+            material = box->m_material;
+        }
+
+        if (material != nullptr && material->IsEmissive())
+        {
+            Add(object);
+        }
+    }
+}
+
+std::size_t LightList::Size() const
+{
+    return m_lights.size();
+}
+
+bool LightList::Empty() const
+{
+    return m_lights.empty();
+}
+
+const std::vector<const IRayHittable*>& LightList::GetLights() const
+{
+    return m_lights;
+}
+
+void LightList::BuildLightBVH()
+{
+    m_light_bvh.Build(m_lights);
+}
+
+const LightBVH& LightList::GetLightBVH() const
+{
+    return m_light_bvh;
+}
+
+const IRayHittable* LightList::Sample(const Point3& point, double& out_probability) const
+{
+    assert(!m_lights.empty());
+
+    if (!m_light_bvh.Empty())
+    {
+        return m_light_bvh.Sample(point, out_probability);
+    }
+
+    const std::size_t index = std::min(static_cast<std::size_t>(RandomCanonicalDouble() * static_cast<double>(m_lights.size())), m_lights.size() - 1);
+    out_probability = 1.0 / static_cast<double>(m_lights.size());
+    return m_lights[index];
+}
+
+double LightList::Probability(const Point3& point, const IRayHittable* light) const
+{
+    if (!m_light_bvh.Empty())
+    {
+        return m_light_bvh.Probability(point, light);
+    }
+
+    return (m_light_indices.count(light) > 0) ? 1.0 / static_cast<double>(m_lights.size()) : 0.0;
+}
+
+} // namespace ART
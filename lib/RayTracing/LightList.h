@@ -0,0 +1,51 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <Maths/Vec3.h>
+#include <RayTracing/IRayHittable.h>
+#include <RayTracing/LightBVH.h>
+
+namespace ART
+{
+
+// The emissive primitives of a scene, sampled for next-event estimation
+// Lights are picked uniformly unless a light BVH has been built over them
+class LightList
+{
+public:
+    void Clear();
+
+    // Discards any light BVH, which no longer covers every light
+    void Add(const IRayHittable* light);
+
+    // Adds every sphere and box of objects whose material is emissive
+    void Collect(const std::vector<IRayHittable*>& objects);
+
+    std::size_t Size() const;
+
+    bool Empty() const;
+
+    const std::vector<const IRayHittable*>& GetLights() const;
+
+    // From here on, lights are picked in proportion to their estimated contribution at the shading point
+    void BuildLightBVH();
+
+    const LightBVH& GetLightBVH() const;
+
+    // Picks the light to sample from point, out_probability being the chance of picking it
+    // nullptr if no light can reach point
+    const IRayHittable* Sample(const Point3& point, double& out_probability) const;
+
+    // Chance that Sample from point picks light, 0 if light isn't in this list
+    double Probability(const Point3& point, const IRayHittable* light) const;
+
+protected:
+    std::vector<const IRayHittable*> m_lights;
+    std::unordered_map<const IRayHittable*, std::size_t> m_light_indices;
+    LightBVH m_light_bvh;
+};
+
+} // namespace ART
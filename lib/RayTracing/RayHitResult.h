@@ -10,6 +10,7 @@ namespace ART
 
 // Fwd decl
 class Material;
+struct IRayHittable;
 
 // Results for a ray intersection test
 struct RayHitResult
@@ -23,6 +24,9 @@ public:
     Material* m_material;
     bool m_is_front_facing;
 
+    // Primitive that was hit, which fills in the attributes above from m_t when asked, see IRayHittable::HitDeferred
+    const IRayHittable* m_hit_object;
+
     // Determine the correct face normal
     void SetFaceNormal(const Ray& ray, const Vec3& outward_normal);
 };
@@ -22,25 +22,36 @@ void RayHittableList::Add(IRayHittable* hittable)
     m_bounding_box = AABB(m_bounding_box, hittable->BoundingBox());
 }
 
-bool RayHittableList::Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
+bool RayHittableList::HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const
 {
-    RayHitResult temp_result;
     bool has_ray_hit_any_object = false;
     double closest_distance = ray_t.m_max;
 
     for (IRayHittable* object : m_objects)
     {
-        if (object->Hit(ray, Interval(ray_t.m_min, closest_distance), temp_result))
+        if (object->HitDeferred(ray, Interval(ray_t.m_min, closest_distance), out_result))
         {
             has_ray_hit_any_object = true;
-            closest_distance = temp_result.m_t;
-            out_result = temp_result;
+            closest_distance = out_result.m_t;
         }
     }
 
     return has_ray_hit_any_object;
 }
 
+bool RayHittableList::HitAny(const Ray& ray, Interval ray_t) const
+{
+    for (IRayHittable* object : m_objects)
+    {
+        if (object->HitAny(ray, ray_t))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 std::vector<IRayHittable*>& RayHittableList::GetObjects()
 {
     return m_objects;
@@ -20,7 +20,10 @@ public:
 
     void Add(IRayHittable* hittable);
 
-    bool Hit(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+    bool HitDeferred(const Ray& ray, Interval ray_t, RayHitResult& out_result) const override;
+
+    // Stops at the first object hit
+    bool HitAny(const Ray& ray, Interval ray_t) const override;
 
     std::vector<IRayHittable*>& GetObjects();
 
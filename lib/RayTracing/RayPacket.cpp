@@ -0,0 +1,68 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <RayTracing/RayPacket.h>
+
+namespace ART
+{
+
+void RayPacket::Clear()
+{
+    m_size = 0;
+    m_is_coherent = true;
+}
+
+void RayPacket::Add(const Ray& ray)
+{
+    assert(m_size < MAX_SIZE);
+
+    const double origin[3] = { ray.m_origin.m_x, ray.m_origin.m_y, ray.m_origin.m_z };
+    const double direction[3] = { ray.m_direction.m_x, ray.m_direction.m_y, ray.m_direction.m_z };
+    const double inverse_direction[3] = { ray.m_inverse_direction.m_x, ray.m_inverse_direction.m_y, ray.m_inverse_direction.m_z };
+
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const bool direction_is_negative = direction[axis] < 0.0;
+
+        if (m_size == 0)
+        {
+            m_origin_min[axis] = origin[axis];
+            m_origin_max[axis] = origin[axis];
+            m_inverse_direction_min[axis] = inverse_direction[axis];
+            m_inverse_direction_max[axis] = inverse_direction[axis];
+            m_direction_is_negative[axis] = direction_is_negative;
+        }
+        else
+        {
+            m_origin_min[axis] = std::min(m_origin_min[axis], origin[axis]);
+            m_origin_max[axis] = std::max(m_origin_max[axis], origin[axis]);
+            m_inverse_direction_min[axis] = std::min(m_inverse_direction_min[axis], inverse_direction[axis]);
+            m_inverse_direction_max[axis] = std::max(m_inverse_direction_max[axis], inverse_direction[axis]);
+        }
+
+        if (direction[axis] == 0.0 || direction_is_negative != m_direction_is_negative[axis])
+        {
+            m_is_coherent = false;
+        }
+    }
+
+    m_rays[m_size++] = ray;
+}
+
+RayMask RayPacket::AllRays() const
+{
+    return (m_size == MAX_SIZE) ? ~RayMask(0) : ((RayMask(1) << m_size) - 1);
+}
+
+double RayPacket::MaxRayT(RayMask ray_mask, const double* ray_t_max) const
+{
+    double max_ray_t = -infinity;
+    for (std::size_t ray_index = 0; ray_index < m_size; ray_index++)
+    {
+        if ((ray_mask & (RayMask(1) << ray_index)) && ray_t_max[ray_index] > max_ray_t)
+        {
+            max_ray_t = ray_t_max[ray_index];
+        }
+    }
+    return max_ray_t;
+}
+
+} // namespace ART
@@ -0,0 +1,84 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Core/Common.h>
+#include <Maths/Ray.h>
+
+namespace ART
+{
+
+// Set of rays of a RayPacket, bit i standing for the packet's ray i
+using RayMask = uint64_t;
+
+// Coherent rays traced together, e.g. the camera rays through a tile of pixels
+// Bounds on the rays' origins and inverse directions let interval arithmetic cull a box for every ray with one test
+struct RayPacket
+{
+public:
+    static constexpr std::size_t MAX_SIZE = 64;
+
+    // Once fewer rays than this are inside a node, traversal carries on below it one ray at a time
+    static constexpr std::size_t MIN_ACTIVE_RAYS = 4;
+
+    Ray m_rays[MAX_SIZE];
+    std::size_t m_size = 0;
+
+    // Per-axis bounds over every ray of the packet
+    double m_origin_min[3];
+    double m_origin_max[3];
+    double m_inverse_direction_min[3];
+    double m_inverse_direction_max[3];
+
+    // Shared direction sign of the rays on each axis, only meaningful while m_is_coherent
+    bool m_direction_is_negative[3];
+
+    // False once two rays' directions differ in sign on an axis or a direction has a zero component, interval
+    // arithmetic can't bound such a packet and it is traced as single rays instead
+    bool m_is_coherent = true;
+
+    void Clear();
+
+    void Add(const Ray& ray);
+
+    // Mask with every ray of the packet set
+    RayMask AllRays() const;
+
+    // Largest of ray_t_max over the rays of ray_mask
+    double MaxRayT(RayMask ray_mask, const double* ray_t_max) const;
+
+    // Conservative slab test of every ray at once, false only if no ray can hit the box within [ray_t_min, ray_t_max]
+    // Only valid while m_is_coherent
+    bool MayHitBox(const double box_min[3], const double box_max[3], double ray_t_min, double ray_t_max) const
+    {
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            const double inverse_min = m_inverse_direction_min[axis];
+            const double inverse_max = m_inverse_direction_max[axis];
+            double t_near_lower_bound;
+            double t_far_upper_bound;
+
+            if (m_direction_is_negative[axis])
+            {
+                // Rays enter through the max plane and leave through the min plane, all inverse directions negative
+                const double near_offset = box_max[axis] - m_origin_min[axis];
+                const double far_offset = box_min[axis] - m_origin_max[axis];
+                t_near_lower_bound = near_offset * ((near_offset >= 0.0) ? inverse_min : inverse_max);
+                t_far_upper_bound = far_offset * ((far_offset <= 0.0) ? inverse_min : inverse_max);
+            }
+            else
+            {
+                const double near_offset = box_min[axis] - m_origin_max[axis];
+                const double far_offset = box_max[axis] - m_origin_min[axis];
+                t_near_lower_bound = near_offset * ((near_offset >= 0.0) ? inverse_min : inverse_max);
+                t_far_upper_bound = far_offset * ((far_offset >= 0.0) ? inverse_max : inverse_min);
+            }
+
+            ray_t_min = (t_near_lower_bound > ray_t_min) ? t_near_lower_bound : ray_t_min;
+            ray_t_max = (t_far_upper_bound < ray_t_max) ? t_far_upper_bound : ray_t_max;
+        }
+
+        return ray_t_min <= ray_t_max;
+    }
+};
+
+} // namespace ART
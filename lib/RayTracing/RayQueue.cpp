@@ -0,0 +1,185 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <RayTracing/RayQueue.h>
+
+#include <Acceleration/LBVHBuilder.h>
+#include <Core/TraversalStats.h>
+
+namespace ART
+{
+
+std::size_t RayQueue::Size() const
+{
+    return m_pixel_indices.size();
+}
+
+void RayQueue::Resize(std::size_t size)
+{
+    m_origin_x.resize(size);
+    m_origin_y.resize(size);
+    m_origin_z.resize(size);
+    m_direction_x.resize(size);
+    m_direction_y.resize(size);
+    m_direction_z.resize(size);
+    m_throughputs.resize(size);
+    m_scatter_pdfs.resize(size);
+    m_pixel_indices.resize(size);
+    m_hit_t.resize(size);
+    m_hit_objects.resize(size);
+}
+
+Ray RayQueue::GetRay(std::size_t index) const
+{
+    return Ray
+    (
+        Point3(m_origin_x[index], m_origin_y[index], m_origin_z[index]),
+        Vec3(m_direction_x[index], m_direction_y[index], m_direction_z[index])
+    );
+}
+
+void RayQueue::SetRay(std::size_t index, const Ray& ray)
+{
+    m_origin_x[index] = ray.m_origin.m_x;
+    m_origin_y[index] = ray.m_origin.m_y;
+    m_origin_z[index] = ray.m_origin.m_z;
+    m_direction_x[index] = ray.m_direction.m_x;
+    m_direction_y[index] = ray.m_direction.m_y;
+    m_direction_z[index] = ray.m_direction.m_z;
+}
+
+void RayQueue::Trace(const IRayHittable& scene, Interval ray_t)
+{
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (std::int64_t index = 0; index < static_cast<std::int64_t>(Size()); index++)
+    {
+        RecordRayCast();
+
+        RayHitResult result;
+        if (scene.HitDeferred(GetRay(index), ray_t, result))
+        {
+            m_hit_t[index] = result.m_t;
+            m_hit_objects[index] = result.m_hit_object;
+        }
+        else
+        {
+            m_hit_objects[index] = nullptr;
+        }
+    }
+}
+
+void RayQueue::AssignCompacted(const RayQueue& source, const std::vector<uint8_t>& keep)
+{
+    assert(keep.size() == source.Size());
+
+    // Each thread counts the kept rays of its own contiguous range, an exclusive scan of the counts then gives each
+    // thread where its range starts in the compacted queue
+    const int max_threads = omp_get_max_threads();
+    std::vector<std::size_t> thread_offsets(static_cast<std::size_t>(max_threads) + 1, 0);
+    const std::size_t source_size = source.Size();
+
+    #pragma omp parallel
+    {
+        const std::size_t num_threads = static_cast<std::size_t>(omp_get_num_threads());
+        const std::size_t thread_id = static_cast<std::size_t>(omp_get_thread_num());
+        const std::size_t begin = (source_size * thread_id) / num_threads;
+        const std::size_t end = (source_size * (thread_id + 1)) / num_threads;
+
+        std::size_t num_kept = 0;
+        for (std::size_t index = begin; index < end; index++)
+        {
+            num_kept += keep[index];
+        }
+        thread_offsets[thread_id + 1] = num_kept;
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for (std::size_t thread = 1; thread <= num_threads; thread++)
+            {
+                thread_offsets[thread] += thread_offsets[thread - 1];
+            }
+            Resize(thread_offsets[num_threads]);
+        }
+
+        std::size_t destination = thread_offsets[thread_id];
+        for (std::size_t index = begin; index < end; index++)
+        {
+            if (!keep[index])
+            {
+                continue;
+            }
+
+            CopyRay(source, index, destination++);
+        }
+    }
+}
+
+void RayQueue::AssignSorted(const RayQueue& source, const std::vector<uint8_t>& keep, const AABB& bounds)
+{
+    assert(keep.size() == source.Size());
+
+    // Rays that aren't kept get the largest key, so they sort after every kept ray and are cut off below
+    const std::size_t source_size = source.Size();
+    std::vector<MortonPrimitive> keys(source_size);
+    std::size_t num_kept = 0;
+
+    #pragma omp parallel for schedule(static) reduction(+ : num_kept)
+    for (std::int64_t index = 0; index < static_cast<std::int64_t>(source_size); index++)
+    {
+        keys[index].object_index = static_cast<uint32_t>(index);
+        keys[index].morton_code = keep[index] ? source.SortKey(index, bounds) : std::numeric_limits<uint64_t>::max();
+        num_kept += keep[index];
+    }
+
+    LBVHBuilder::RadixSort(keys);
+
+    Resize(num_kept);
+
+    #pragma omp parallel for schedule(static)
+    for (std::int64_t destination = 0; destination < static_cast<std::int64_t>(num_kept); destination++)
+    {
+        CopyRay(source, keys[destination].object_index, destination);
+    }
+}
+
+uint64_t RayQueue::SortKey(std::size_t index, const AABB& bounds) const
+{
+    const uint64_t octant =
+        (m_direction_x[index] < 0.0 ? 4 : 0) |
+        (m_direction_y[index] < 0.0 ? 2 : 0) |
+        (m_direction_z[index] < 0.0 ? 1 : 0);
+
+    // 21 bits per axis, as LBVHBuilder quantises centroids
+    const double grid_size = static_cast<double>((1 << 21) - 1);
+    const double origin[3] = { m_origin_x[index], m_origin_y[index], m_origin_z[index] };
+    uint32_t grid[3];
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        const Interval& extent = bounds[axis];
+        const double size = extent.Size();
+        const double relative = (size > 0.0) ? (origin[axis] - extent.m_min) / size : 0.0;
+        grid[axis] = static_cast<uint32_t>(std::clamp(relative, 0.0, 1.0) * grid_size);
+    }
+
+    // The Morton code's 63 bits are cut to 60 to leave room for the octant
+    return (octant << 61) | (LBVHBuilder::MortonCode(grid[0], grid[1], grid[2]) >> 3);
+}
+
+void RayQueue::CopyRay(const RayQueue& source, std::size_t source_index, std::size_t destination_index)
+{
+    m_origin_x[destination_index] = source.m_origin_x[source_index];
+    m_origin_y[destination_index] = source.m_origin_y[source_index];
+    m_origin_z[destination_index] = source.m_origin_z[source_index];
+    m_direction_x[destination_index] = source.m_direction_x[source_index];
+    m_direction_y[destination_index] = source.m_direction_y[source_index];
+    m_direction_z[destination_index] = source.m_direction_z[source_index];
+    m_throughputs[destination_index] = source.m_throughputs[source_index];
+    m_scatter_pdfs[destination_index] = source.m_scatter_pdfs[source_index];
+    m_pixel_indices[destination_index] = source.m_pixel_indices[source_index];
+}
+
+std::size_t RayQueue::MemoryUsedBytes() const
+{
+    return Size() * ((8 * sizeof(double)) + sizeof(Colour) + sizeof(uint32_t) + sizeof(const IRayHittable*));
+}
+
+} // namespace ART
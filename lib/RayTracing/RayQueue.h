@@ -0,0 +1,61 @@
+// Copyright Mia Rolfe. All rights reserved.
+#pragma once
+
+#include <Core/Common.h>
+#include <Geometry/AxisAlignedBoundingBox.h>
+#include <Maths/Colour.h>
+#include <Maths/Ray.h>
+#include <RayTracing/IRayHittable.h>
+
+namespace ART
+{
+
+// Rays of the paths in flight in a wavefront render, in structure of arrays form
+// Entry i is the next ray of the path through pixel m_pixel_indices[i], m_throughputs[i] scaling whatever it finds
+struct RayQueue
+{
+public:
+    std::vector<double> m_origin_x;
+    std::vector<double> m_origin_y;
+    std::vector<double> m_origin_z;
+    std::vector<double> m_direction_x;
+    std::vector<double> m_direction_y;
+    std::vector<double> m_direction_z;
+    std::vector<Colour> m_throughputs;
+    // Density with which each ray's direction was scattered, as RayColour's scatter_pdf
+    std::vector<double> m_scatter_pdfs;
+    std::vector<uint32_t> m_pixel_indices;
+
+    // Closest hit of each ray from the last Trace, m_hit_objects[i] is nullptr if ray i missed
+    std::vector<double> m_hit_t;
+    std::vector<const IRayHittable*> m_hit_objects;
+
+    std::size_t Size() const;
+
+    void Resize(std::size_t size);
+
+    Ray GetRay(std::size_t index) const;
+
+    void SetRay(std::size_t index, const Ray& ray);
+
+    // Finds the closest hit of every ray within ray_t, in parallel, without evaluating any surface attributes
+    void Trace(const IRayHittable& scene, Interval ray_t);
+
+    // Copies the rays of source whose keep flag is set into this queue, preserving their order
+    void AssignCompacted(const RayQueue& source, const std::vector<uint8_t>& keep);
+
+    // As AssignCompacted, but ordering the kept rays by direction octant and then by the Morton code of their origin
+    // within bounds, so rays that are traced one after another tend to visit the same nodes
+    void AssignSorted(const RayQueue& source, const std::vector<uint8_t>& keep, const AABB& bounds);
+
+    // Direction octant in the top 3 bits, then the Morton code of the origin quantised within bounds
+    uint64_t SortKey(std::size_t index, const AABB& bounds) const;
+
+    std::size_t MemoryUsedBytes() const;
+
+protected:
+    // Copies ray source_index of source, without its hit, to entry destination_index
+    void CopyRay(const RayQueue& source, std::size_t source_index, std::size_t destination_index);
+};
+
+} // namespace ART
@@ -3,5 +3,9 @@
 
 #include <RayTracing/Camera.h>
 #include <RayTracing/IRayHittable.h>
+#include <RayTracing/LightBVH.h>
+#include <RayTracing/LightList.h>
 #include <RayTracing/RayHitResult.h>
 #include <RayTracing/RayHittableList.h>
+#include <RayTracing/RayPacket.h>
+#include <RayTracing/RayQueue.h>
@@ -13,6 +13,9 @@ RenderContext::RenderContext(RenderContext&& other) noexcept
     , scene_config(std::move(other.scene_config))
     , output_image_name(std::move(other.output_image_name))
     , acceleration_structure(other.acceleration_structure)
+    , grid_config(other.grid_config)
+    , octree_looseness(other.octree_looseness)
+    , bsp_candidate_budget(other.bsp_candidate_budget)
     , num_completed_rows(other.num_completed_rows.load())
     , total_rows(other.total_rows.load())
     , cancel_requested(other.cancel_requested.load())
@@ -44,6 +47,9 @@ RenderContext& RenderContext::operator=(RenderContext&& other) noexcept
         scene_config = std::move(other.scene_config);
         output_image_name = std::move(other.output_image_name);
         acceleration_structure = other.acceleration_structure;
+        grid_config = other.grid_config;
+        octree_looseness = other.octree_looseness;
+        bsp_candidate_budget = other.bsp_candidate_budget;
 
         num_completed_rows.store(other.num_completed_rows.load());
         total_rows.store(other.total_rows.load());
@@ -74,6 +80,29 @@ void LogRenderConfig(const CameraRenderConfig& render_config, int scene_number)
     std::ostringstream output_string_stream;
     output_string_stream << "Configuration: " << render_config.image_width << "x" << render_config.image_height
                          << ", " << render_config.samples_per_pixel << " samples per pixel";
+    if (render_config.wavefront)
+    {
+        if (render_config.sort_rays_bounce_mask == Camera::SORT_RAYS_ALL_BOUNCES)
+        {
+            output_string_stream << ", wavefront with sorted secondary rays";
+        }
+        else if (render_config.sort_rays_bounce_mask != 0)
+        {
+            output_string_stream << ", wavefront with secondary rays sorted at bounce mask 0x" << std::hex << render_config.sort_rays_bounce_mask << std::dec;
+        }
+        else
+        {
+            output_string_stream << ", wavefront";
+        }
+    }
+    else if (render_config.packet_tile_size > 0)
+    {
+        output_string_stream << ", " << render_config.packet_tile_size << "x" << render_config.packet_tile_size << " ray packets";
+    }
+    if (render_config.next_event_estimation)
+    {
+        output_string_stream << (render_config.light_bvh ? ", next-event estimation through a light BVH" : ", next-event estimation");
+    }
     Logger::Get().LogInfo(output_string_stream.str());
 }
 
@@ -92,9 +121,107 @@ void LogRenderStats(const RenderStats& stats)
         << ", Avg intersection tests/ray: " << stats.m_traversal_stats.AvgIntersectionTestsPerRay();
 
     Logger::Get().LogInfo(output_string_stream.str());
+
+    if (stats.m_traversal_stats.total_packet_ray_slots > 0)
+    {
+        LogPacketStats(stats.m_acceleration_structure, stats.m_traversal_stats);
+    }
+
+    if (stats.m_traversal_stats.total_rays_sorted > 0)
+    {
+        LogRaySortStats(stats.m_acceleration_structure, stats.m_traversal_stats);
+    }
+
+    if (stats.m_traversal_stats.total_occlusion_rays_cast > 0)
+    {
+        LogOcclusionStats(stats.m_acceleration_structure, stats.m_traversal_stats);
+    }
 }
 
-RenderStats RenderWithAccelerationStructure(Camera& camera, RayHittableList& scene, const SceneConfig& scene_config, AccelerationStructure acceleration_structure)
+void LogPacketStats(AccelerationStructure acceleration_structure, const TraversalStats& traversal_stats)
+{
+    std::ostringstream output_string_stream;
+    output_string_stream << std::fixed << std::setprecision(2);
+    output_string_stream << "[Ray packets: " << AccelerationStructureToString(acceleration_structure) << "] "
+        << "Packet utilisation: " << (traversal_stats.PacketUtilisation() * 100.0) << "%";
+
+    Logger::Get().LogInfo(output_string_stream.str());
+}
+
+void LogRaySortStats(AccelerationStructure acceleration_structure, const TraversalStats& traversal_stats)
+{
+    std::ostringstream output_string_stream;
+    output_string_stream << std::fixed << std::setprecision(2);
+    output_string_stream << "[Ray sorting: " << AccelerationStructureToString(acceleration_structure) << "] "
+        << "Rays sorted: " << traversal_stats.total_rays_sorted << ", "
+        << "Ray sort time: " << traversal_stats.ray_sort_time_ms << " ms";
+
+    Logger::Get().LogInfo(output_string_stream.str());
+}
+
+void LogOcclusionStats(AccelerationStructure acceleration_structure, const TraversalStats& traversal_stats)
+{
+    std::ostringstream output_string_stream;
+    output_string_stream << std::fixed << std::setprecision(2);
+    output_string_stream << "[Occlusion rays: " << AccelerationStructureToString(acceleration_structure) << "] "
+        << "Rays: " << traversal_stats.total_occlusion_rays_cast << ", "
+        << "Avg nodes/occlusion ray: " << traversal_stats.AvgNodesTraversedPerOcclusionRay() << ", "
+        << "Avg intersection tests/occlusion ray: " << traversal_stats.AvgIntersectionTestsPerOcclusionRay();
+
+    Logger::Get().LogInfo(output_string_stream.str());
+}
+
+void LogOctreeOverlapStats(AccelerationStructure acceleration_structure, const OctreeOverlapStats& overlap_stats)
+{
+    std::ostringstream output_string_stream;
+    output_string_stream << std::fixed << std::setprecision(4);
+    output_string_stream << "[Octree overlap: " << AccelerationStructureToString(acceleration_structure) << "] "
+        << "Nodes: " << overlap_stats.num_nodes << ", "
+        << "Max depth: " << overlap_stats.max_depth << ", "
+        << "Interior objects: " << overlap_stats.num_interior_objects << ", "
+        << "Overflow nodes: " << overlap_stats.num_overflow_nodes << ", "
+        << "Avg sibling overlap: " << overlap_stats.average_sibling_overlap;
+
+    Logger::Get().LogInfo(output_string_stream.str());
+}
+
+void LogUniformGridResolution(const UniformGrid& uniform_grid)
+{
+    const Vec3Int num_cells = uniform_grid.GetNumCells();
+
+    std::ostringstream output_string_stream;
+    output_string_stream << std::fixed << std::setprecision(4);
+    output_string_stream << "[Uniform grid resolution] "
+        << "Density: " << uniform_grid.GetDensity() << ", "
+        << "Cells: " << num_cells.m_x << " x " << num_cells.m_y << " x " << num_cells.m_z;
+
+    Logger::Get().LogInfo(output_string_stream.str());
+}
+
+void LogLooseOctreeLooseness(const LooseOctree& loose_octree)
+{
+    std::ostringstream output_string_stream;
+    output_string_stream << std::fixed << std::setprecision(4);
+    output_string_stream << "[Loose octree] "
+        << "Looseness: " << loose_octree.GetLooseness();
+
+    Logger::Get().LogInfo(output_string_stream.str());
+}
+
+void LogLightBVH(const LightBVH& light_bvh, double build_time_ms)
+{
+    std::ostringstream output_string_stream;
+    output_string_stream << std::fixed << std::setprecision(2);
+    output_string_stream << "[Light BVH] "
+        << "Lights: " << light_bvh.NumLights() << ", "
+        << "Nodes: " << light_bvh.NumNodes() << ", "
+        << "Build time: " << build_time_ms << " ms, "
+        << "Memory used: " << light_bvh.MemoryUsedBytes() << " B";
+
+    Logger::Get().LogInfo(output_string_stream.str());
+}
+
+RenderStats RenderWithAccelerationStructure(Camera& camera, RayHittableList& scene, const SceneConfig& scene_config, AccelerationStructure acceleration_structure, const UniformGridConfig& grid_config, double octree_looseness, std::size_t bsp_candidate_budget)
 {
     Timer timer;
     RenderStats stats;
@@ -116,10 +243,11 @@ RenderStats RenderWithAccelerationStructure(Camera& camera, RayHittableList& sce
         case AccelerationStructure::UNIFORM_GRID:
         {
             timer.Start();
-            UniformGrid uniform_grid(scene.GetObjects());
+            UniformGrid uniform_grid(scene.GetObjects(), grid_config);
             timer.Stop();
             stats.m_construction_time_ms = timer.ElapsedMilliseconds();
             stats.m_memory_used_bytes = uniform_grid.MemoryUsedBytes();
+            LogUniformGridResolution(uniform_grid);
 
             timer.Start();
             camera.Render(uniform_grid, scene_config, "render_uniform_grid.png", &stats.m_traversal_stats);
@@ -130,7 +258,7 @@ RenderStats RenderWithAccelerationStructure(Camera& camera, RayHittableList& sce
         case AccelerationStructure::HIERARCHICAL_UNIFORM_GRID:
         {
             timer.Start();
-            HierarchicalUniformGrid hierarchical_uniform_grid(scene.GetObjects());
+            HierarchicalUniformGrid hierarchical_uniform_grid(scene.GetObjects(), grid_config);
             timer.Stop();
             stats.m_construction_time_ms = timer.ElapsedMilliseconds();
             stats.m_memory_used_bytes = hierarchical_uniform_grid.MemoryUsedBytes();
@@ -141,6 +269,34 @@ RenderStats RenderWithAccelerationStructure(Camera& camera, RayHittableList& sce
             stats.m_render_time_ms = timer.ElapsedMilliseconds();
             break;
         }
+        case AccelerationStructure::HASHED_GRID:
+        {
+            timer.Start();
+            HashedGrid hashed_grid(scene.GetObjects());
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = hashed_grid.MemoryUsedBytes();
+
+            timer.Start();
+            camera.Render(hashed_grid, scene_config, "render_hashed_grid.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
+        case AccelerationStructure::TWO_LEVEL_GRID:
+        {
+            timer.Start();
+            TwoLevelGrid two_level_grid(scene.GetObjects());
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = two_level_grid.MemoryUsedBytes();
+
+            timer.Start();
+            camera.Render(two_level_grid, scene_config, "render_two_level_grid.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
         case AccelerationStructure::OCTREE:
         {
             timer.Start();
@@ -148,6 +304,7 @@ RenderStats RenderWithAccelerationStructure(Camera& camera, RayHittableList& sce
             timer.Stop();
             stats.m_construction_time_ms = timer.ElapsedMilliseconds();
             stats.m_memory_used_bytes = octree.MemoryUsedBytes();
+            LogOctreeOverlapStats(acceleration_structure, octree.ComputeOverlapStats());
 
             timer.Start();
             camera.Render(octree, scene_config, "render_octree.png", &stats.m_traversal_stats);
@@ -155,6 +312,51 @@ RenderStats RenderWithAccelerationStructure(Camera& camera, RayHittableList& sce
             stats.m_render_time_ms = timer.ElapsedMilliseconds();
             break;
         }
+        case AccelerationStructure::PARAMETRIC_OCTREE:
+        {
+            timer.Start();
+            ParametricOctree parametric_octree(scene.GetObjects());
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = parametric_octree.MemoryUsedBytes();
+
+            timer.Start();
+            camera.Render(parametric_octree, scene_config, "render_parametric_octree.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
+        case AccelerationStructure::LOOSE_OCTREE:
+        {
+            timer.Start();
+            LooseOctree loose_octree(scene.GetObjects(), octree_looseness);
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = loose_octree.MemoryUsedBytes();
+            LogLooseOctreeLooseness(loose_octree);
+            LogOctreeOverlapStats(acceleration_structure, loose_octree.ComputeOverlapStats());
+
+            timer.Start();
+            camera.Render(loose_octree, scene_config, "render_loose_octree.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
+        case AccelerationStructure::LINEAR_OCTREE:
+        {
+            timer.Start();
+            LinearOctree linear_octree(scene.GetObjects());
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = linear_octree.MemoryUsedBytes();
+            LogOctreeOverlapStats(acceleration_structure, linear_octree.ComputeOverlapStats());
+
+            timer.Start();
+            camera.Render(linear_octree, scene_config, "render_linear_octree.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
         case AccelerationStructure::BSP_TREE:
         {
             timer.Start();
@@ -169,6 +371,20 @@ RenderStats RenderWithAccelerationStructure(Camera& camera, RayHittableList& sce
             stats.m_render_time_ms = timer.ElapsedMilliseconds();
             break;
         }
+        case AccelerationStructure::ADAPTIVE_BSP_TREE:
+        {
+            timer.Start();
+            BSPTreeNode adaptive_bsp_tree(scene.GetObjects(), BSPBuildSettings{BSPSplitNormals::DATA_DRIVEN, bsp_candidate_budget});
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = adaptive_bsp_tree.MemoryUsedBytes();
+
+            timer.Start();
+            camera.Render(adaptive_bsp_tree, scene_config, "render_adaptive_bsp_tree.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
         case AccelerationStructure::K_D_TREE:
         {
             timer.Start();
@@ -183,6 +399,20 @@ RenderStats RenderWithAccelerationStructure(Camera& camera, RayHittableList& sce
             stats.m_render_time_ms = timer.ElapsedMilliseconds();
             break;
         }
+        case AccelerationStructure::ROPE_K_D_TREE:
+        {
+            timer.Start();
+            RopeKDTree rope_k_d_tree(scene.GetObjects());
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = rope_k_d_tree.MemoryUsedBytes();
+
+            timer.Start();
+            camera.Render(rope_k_d_tree, scene_config, "render_rope_k_d_tree.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
         case AccelerationStructure::BOUNDING_VOLUME_HIERARCHY:
         {
             timer.Start();
@@ -197,12 +427,127 @@ RenderStats RenderWithAccelerationStructure(Camera& camera, RayHittableList& sce
             stats.m_render_time_ms = timer.ElapsedMilliseconds();
             break;
         }
+        case AccelerationStructure::FLAT_BOUNDING_VOLUME_HIERARCHY:
+        {
+            timer.Start();
+            FlatBVH flat_bounding_volume_hierarchy(scene.GetObjects());
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = flat_bounding_volume_hierarchy.MemoryUsedBytes();
+
+            timer.Start();
+            camera.Render(flat_bounding_volume_hierarchy, scene_config, "render_flat_bounding_volume_hierarchy.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
+        case AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_4:
+        {
+            timer.Start();
+            BVH4 wide_bounding_volume_hierarchy_4(scene.GetObjects());
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = wide_bounding_volume_hierarchy_4.MemoryUsedBytes();
+
+            timer.Start();
+            camera.Render(wide_bounding_volume_hierarchy_4, scene_config, "render_wide_bounding_volume_hierarchy_4.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
+        case AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_8:
+        {
+            timer.Start();
+            BVH8 wide_bounding_volume_hierarchy_8(scene.GetObjects());
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = wide_bounding_volume_hierarchy_8.MemoryUsedBytes();
+
+            timer.Start();
+            camera.Render(wide_bounding_volume_hierarchy_8, scene_config, "render_wide_bounding_volume_hierarchy_8.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
+        case AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY:
+        {
+            timer.Start();
+            LinearBVH linear_bounding_volume_hierarchy(scene.GetObjects());
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = linear_bounding_volume_hierarchy.MemoryUsedBytes();
+
+            timer.Start();
+            camera.Render(linear_bounding_volume_hierarchy, scene_config, "render_linear_bounding_volume_hierarchy.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
+        case AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY_OPTIMISED:
+        {
+            timer.Start();
+            LinearBVH linear_bounding_volume_hierarchy_optimised(scene.GetObjects(), true);
+            timer.Stop();
+            stats.m_construction_time_ms = timer.ElapsedMilliseconds();
+            stats.m_memory_used_bytes = linear_bounding_volume_hierarchy_optimised.MemoryUsedBytes();
+
+            timer.Start();
+            camera.Render(linear_bounding_volume_hierarchy_optimised, scene_config, "render_linear_bounding_volume_hierarchy_optimised.png", &stats.m_traversal_stats);
+            timer.Stop();
+            stats.m_render_time_ms = timer.ElapsedMilliseconds();
+            break;
+        }
     }
 
     LogRenderStats(stats);
     return stats;
 }
 
+// Scene 2's view of its dense field, also used by scene 12
+static const CameraViewConfig DENSE_SPHERE_FIELD_VIEW_CONFIG
+{
+    Point3(-30.0, 50.0, -30.0),
+    Point3(20.0, 20.0, 20.0),
+    Vec3(0.0, 1.0, 0.0),
+    40.0, 0.0, 10.0
+};
+
+// Scene 2's field of 10,000 spheres filling the cube from (0, 0, 0) to (40, 40, 40), also used by scene 12
+static void AddDenseSphereField(RenderContext& render_context)
+{
+    // 21x21x21 = 9261 spheres on a regular grid with jitter
+    static constexpr int SPHERE_GRID_AXIS_LENGTH = 21;
+    static constexpr double SPHERE_JITTER = 0.3;
+    static constexpr double SPHERE_RADIUS = 0.4;
+    for (int i = 0; i < SPHERE_GRID_AXIS_LENGTH; i++)
+    {
+        for (int j = 0; j < SPHERE_GRID_AXIS_LENGTH; j++)
+        {
+            for (int k = 0; k < SPHERE_GRID_AXIS_LENGTH; k++)
+            {
+                const double jitter_x = RandomPositionDouble(-SPHERE_JITTER, SPHERE_JITTER);
+                const double jitter_y = RandomPositionDouble(-SPHERE_JITTER, SPHERE_JITTER);
+                const double jitter_z = RandomPositionDouble(-SPHERE_JITTER, SPHERE_JITTER);
+                const Point3 position(i * 2.0 + jitter_x, j * 2.0 + jitter_y, k * 2.0 + jitter_z);
+
+                Texture* texture = render_context.arena.Create<SolidColourTexture>(Colour(RandomColourDouble(), RandomColourDouble(), RandomColourDouble()));
+                Material* material = render_context.arena.Create<LambertianMaterial>(texture);
+                render_context.scene.Add(render_context.arena.Create<Sphere>(position, SPHERE_RADIUS, material));
+            }
+        }
+    }
+
+    // 739 additional to hit 10k spheres
+    static constexpr int NUM_RANDOMLY_DISTRIBUTED_SPHERES = 739;
+    for (int i = 0; i < NUM_RANDOMLY_DISTRIBUTED_SPHERES; i++)
+    {
+        const Point3 position(RandomPositionDouble(0.0, 40.0), RandomPositionDouble(0.0, 40.0), RandomPositionDouble(0.0, 40.0));
+        Texture* texture = render_context.arena.Create<SolidColourTexture>(Colour(RandomColourDouble(), RandomColourDouble(), RandomColourDouble()));
+        Material* material = render_context.arena.Create<LambertianMaterial>(texture);
+        render_context.scene.Add(render_context.arena.Create<Sphere>(position, SPHERE_RADIUS, material));
+    }
+}
+
 void SetupScene(RenderContext& render_context, const CameraRenderConfig& render_config, int scene_number, uint32_t colour_seed, uint32_t position_seed)
 {
     SeedColourRNG(colour_seed);
@@ -281,46 +626,9 @@ void SetupScene(RenderContext& render_context, const CameraRenderConfig& render_
         case 2:
         {
             // Uniform dense field: 10,000 objects mostly uniformly distributed
-            CameraViewConfig view_config
-            {
-                Point3(-30.0, 50.0, -30.0),
-                Point3(20.0, 20.0, 20.0),
-                Vec3(0.0, 1.0, 0.0),
-                40.0, 0.0, 10.0
-            };
-            render_context.camera = Camera(view_config, render_config);
-
-            // 21x21x21 = 9261 spheres on a regular grid with jitter
-            static constexpr int SPHERE_GRID_AXIS_LENGTH = 21;
-            static constexpr double SPHERE_JITTER = 0.3;
-            static constexpr double SPHERE_RADIUS = 0.4;
-            for (int i = 0; i < SPHERE_GRID_AXIS_LENGTH; i++)
-            {
-                for (int j = 0; j < SPHERE_GRID_AXIS_LENGTH; j++)
-                {
-                    for (int k = 0; k < SPHERE_GRID_AXIS_LENGTH; k++)
-                    {
-                        const double jitter_x = RandomPositionDouble(-SPHERE_JITTER, SPHERE_JITTER);
-                        const double jitter_y = RandomPositionDouble(-SPHERE_JITTER, SPHERE_JITTER);
-                        const double jitter_z = RandomPositionDouble(-SPHERE_JITTER, SPHERE_JITTER);
-                        const Point3 position(i * 2.0 + jitter_x, j * 2.0 + jitter_y, k * 2.0 + jitter_z);
+            render_context.camera = Camera(DENSE_SPHERE_FIELD_VIEW_CONFIG, render_config);
 
-                        Texture* texture = render_context.arena.Create<SolidColourTexture>(Colour(RandomColourDouble(), RandomColourDouble(), RandomColourDouble()));
-                        Material* material = render_context.arena.Create<LambertianMaterial>(texture);
-                        render_context.scene.Add(render_context.arena.Create<Sphere>(position, SPHERE_RADIUS, material));
-                    }
-                }
-            }
-
-            // 739 additional to hit 10k spheres
-            static constexpr int NUM_RANDOMLY_DISTRIBUTED_SPHERES = 739;
-            for (int i = 0; i < NUM_RANDOMLY_DISTRIBUTED_SPHERES; i++)
-            {
-                const Point3 position(RandomPositionDouble(0.0, 40.0), RandomPositionDouble(0.0, 40.0), RandomPositionDouble(0.0, 40.0));
-                Texture* texture = render_context.arena.Create<SolidColourTexture>(Colour(RandomColourDouble(), RandomColourDouble(), RandomColourDouble()));
-                Material* material = render_context.arena.Create<LambertianMaterial>(texture);
-                render_context.scene.Add(render_context.arena.Create<Sphere>(position, SPHERE_RADIUS, material));
-            }
+            AddDenseSphereField(render_context);
             break;
         }
         case 3:
@@ -676,6 +984,103 @@ void SetupScene(RenderContext& render_context, const CameraRenderConfig& render_
             }
             break;
         }
+        case 11:
+        {
+            // Small emitters: diffuse spheres and boxes lit only by a few small, bright spheres and one ceiling panel
+            render_context.scene_config.background_colour = Colour(0.0);
+
+            CameraViewConfig view_config
+            {
+                Point3(0.0, 9.0, 26.0),
+                Point3(0.0, 2.0, 0.0),
+                Vec3(0.0, 1.0, 0.0),
+                40.0, 0.0, 10.0
+            };
+            render_context.camera = Camera(view_config, render_config);
+
+            Texture* ground_texture = render_context.arena.Create<SolidColourTexture>(Colour(0.5, 0.5, 0.5));
+            Material* ground_material = render_context.arena.Create<LambertianMaterial>(ground_texture);
+            render_context.scene.Add(render_context.arena.Create<AxisAlignedBox>(Point3(-20.0, -1.0, -20.0), Point3(20.0, 0.0, 20.0), ground_material));
+
+            static constexpr int NUM_SPHERES = 200;
+            for (int i = 0; i < NUM_SPHERES; i++)
+            {
+                const double radius = RandomPositionDouble(0.3, 1.2);
+                const Point3 position(RandomPositionDouble(-15.0, 15.0), radius, RandomPositionDouble(-15.0, 15.0));
+                Texture* texture = render_context.arena.Create<SolidColourTexture>(Colour(RandomColourDouble(), RandomColourDouble(), RandomColourDouble()));
+                Material* material = render_context.arena.Create<LambertianMaterial>(texture);
+                render_context.scene.Add(render_context.arena.Create<Sphere>(position, radius, material));
+            }
+
+            static constexpr int NUM_BOXES = 60;
+            for (int i = 0; i < NUM_BOXES; i++)
+            {
+                const double x = RandomPositionDouble(-15.0, 15.0);
+                const double z = RandomPositionDouble(-15.0, 15.0);
+                const double w = RandomPositionDouble(0.5, 2.0);
+                const double d = RandomPositionDouble(0.5, 2.0);
+                const double h = RandomPositionDouble(1.0, 5.0);
+                Texture* texture = render_context.arena.Create<SolidColourTexture>(Colour(RandomColourDouble(), RandomColourDouble(), RandomColourDouble()));
+                Material* material = render_context.arena.Create<LambertianMaterial>(texture);
+                render_context.scene.Add(render_context.arena.Create<AxisAlignedBox>(Point3(x, 0.0, z), Point3(x + w, h, z + d), material));
+            }
+
+            static constexpr int NUM_EMITTERS = 8;
+            for (int i = 0; i < NUM_EMITTERS; i++)
+            {
+                const Point3 position(RandomPositionDouble(-12.0, 12.0), RandomPositionDouble(3.0, 7.0), RandomPositionDouble(-12.0, 12.0));
+                Texture* texture = render_context.arena.Create<SolidColourTexture>(40.0 * Colour(RandomColourDouble(), RandomColourDouble(), RandomColourDouble()));
+                Material* material = render_context.arena.Create<DiffuseLightMaterial>(texture);
+                render_context.scene.Add(render_context.arena.Create<Sphere>(position, 0.25, material));
+            }
+
+            Texture* panel_texture = render_context.arena.Create<SolidColourTexture>(Colour(15.0, 14.0, 12.0));
+            Material* panel_material = render_context.arena.Create<DiffuseLightMaterial>(panel_texture);
+            render_context.scene.Add(render_context.arena.Create<AxisAlignedBox>(Point3(-1.5, 12.0, -1.5), Point3(1.5, 12.2, 1.5), panel_material));
+            break;
+        }
+        case 12:
+        {
+            // Many lights: scene 2's dense field, lit only by 10,000 small emitters between its spheres
+            render_context.camera = Camera(DENSE_SPHERE_FIELD_VIEW_CONFIG, render_config);
+            render_context.scene_config.background_colour = Colour(0.0);
+
+            AddDenseSphereField(render_context);
+
+            // 20x20x20 = 8000 emitters on a regular grid with jitter, midway between the field's grid spheres
+            static constexpr int EMITTER_GRID_AXIS_LENGTH = 20;
+            static constexpr double EMITTER_JITTER = 0.2;
+            static constexpr double EMITTER_RADIUS = 0.1;
+            static constexpr double EMITTER_RADIANCE = 30.0;
+            for (int i = 0; i < EMITTER_GRID_AXIS_LENGTH; i++)
+            {
+                for (int j = 0; j < EMITTER_GRID_AXIS_LENGTH; j++)
+                {
+                    for (int k = 0; k < EMITTER_GRID_AXIS_LENGTH; k++)
+                    {
+                        const double jitter_x = RandomPositionDouble(-EMITTER_JITTER, EMITTER_JITTER);
+                        const double jitter_y = RandomPositionDouble(-EMITTER_JITTER, EMITTER_JITTER);
+                        const double jitter_z = RandomPositionDouble(-EMITTER_JITTER, EMITTER_JITTER);
+                        const Point3 position(i * 2.0 + 1.0 + jitter_x, j * 2.0 + 1.0 + jitter_y, k * 2.0 + 1.0 + jitter_z);
+
+                        Texture* texture = render_context.arena.Create<SolidColourTexture>(EMITTER_RADIANCE * Colour(RandomColourDouble(), RandomColourDouble(), RandomColourDouble()));
+                        Material* material = render_context.arena.Create<DiffuseLightMaterial>(texture);
+                        render_context.scene.Add(render_context.arena.Create<Sphere>(position, EMITTER_RADIUS, material));
+                    }
+                }
+            }
+
+            // 2000 emitters placed at random through the field, for 10,000 in total
+            static constexpr int NUM_RANDOMLY_DISTRIBUTED_EMITTERS = 2000;
+            for (int i = 0; i < NUM_RANDOMLY_DISTRIBUTED_EMITTERS; i++)
+            {
+                const Point3 position(RandomPositionDouble(0.0, 40.0), RandomPositionDouble(0.0, 40.0), RandomPositionDouble(0.0, 40.0));
+                Texture* texture = render_context.arena.Create<SolidColourTexture>(EMITTER_RADIANCE * Colour(RandomColourDouble(), RandomColourDouble(), RandomColourDouble()));
+                Material* material = render_context.arena.Create<DiffuseLightMaterial>(texture);
+                render_context.scene.Add(render_context.arena.Create<Sphere>(position, EMITTER_RADIUS, material));
+            }
+            break;
+        }
         default:
         {
             // Default to scene 1
@@ -683,13 +1088,24 @@ void SetupScene(RenderContext& render_context, const CameraRenderConfig& render_
             return;
         }
     }
+
+    render_context.scene_config.lights.Collect(render_context.scene.GetObjects());
+
+    if (render_config.light_bvh && !render_context.scene_config.lights.Empty())
+    {
+        Timer timer;
+        timer.Start();
+        render_context.scene_config.lights.BuildLightBVH();
+        timer.Stop();
+        LogLightBVH(render_context.scene_config.lights.GetLightBVH(), timer.ElapsedMilliseconds());
+    }
 }
 
-void RenderScene(const CameraRenderConfig& render_config, int scene_number, AccelerationStructure acceleration_structure, uint32_t colour_seed, uint32_t position_seed)
+void RenderScene(const CameraRenderConfig& render_config, int scene_number, AccelerationStructure acceleration_structure, uint32_t colour_seed, uint32_t position_seed, const UniformGridConfig& grid_config, double octree_looseness, std::size_t bsp_candidate_budget)
 {
     RenderContext ctx;
     SetupScene(ctx, render_config, scene_number, colour_seed, position_seed);
-    RenderWithAccelerationStructure(ctx.camera, ctx.scene, ctx.scene_config, acceleration_structure);
+    RenderWithAccelerationStructure(ctx.camera, ctx.scene, ctx.scene_config, acceleration_structure, grid_config, octree_looseness, bsp_candidate_budget);
 }
 
 RenderContext CreateAsyncRenderContext(
@@ -697,10 +1113,16 @@ RenderContext CreateAsyncRenderContext(
     int scene_number,
     AccelerationStructure acceleration_structure,
     uint32_t colour_seed,
-    uint32_t position_seed)
+    uint32_t position_seed,
+    const UniformGridConfig& grid_config,
+    double octree_looseness,
+    std::size_t bsp_candidate_budget)
 {
     RenderContext ctx;
     SetupScene(ctx, render_config, scene_number, colour_seed, position_seed);
+    ctx.grid_config = grid_config;
+    ctx.octree_looseness = octree_looseness;
+    ctx.bsp_candidate_budget = bsp_candidate_budget;
 
     switch (acceleration_structure)
     {
@@ -713,18 +1135,54 @@ RenderContext CreateAsyncRenderContext(
     case AccelerationStructure::HIERARCHICAL_UNIFORM_GRID:
         ctx.output_image_name = "render_hierarchical_uniform_grid.png";
         break;
+    case AccelerationStructure::HASHED_GRID:
+        ctx.output_image_name = "render_hashed_grid.png";
+        break;
+    case AccelerationStructure::TWO_LEVEL_GRID:
+        ctx.output_image_name = "render_two_level_grid.png";
+        break;
     case AccelerationStructure::OCTREE:
         ctx.output_image_name = "render_octree.png";
         break;
+    case AccelerationStructure::PARAMETRIC_OCTREE:
+        ctx.output_image_name = "render_parametric_octree.png";
+        break;
+    case AccelerationStructure::LOOSE_OCTREE:
+        ctx.output_image_name = "render_loose_octree.png";
+        break;
+    case AccelerationStructure::LINEAR_OCTREE:
+        ctx.output_image_name = "render_linear_octree.png";
+        break;
     case AccelerationStructure::BSP_TREE:
         ctx.output_image_name = "render_bsp_tree.png";
         break;
+    case AccelerationStructure::ADAPTIVE_BSP_TREE:
+        ctx.output_image_name = "render_adaptive_bsp_tree.png";
+        break;
     case AccelerationStructure::K_D_TREE:
         ctx.output_image_name = "render_k_d_tree.png";
         break;
+    case AccelerationStructure::ROPE_K_D_TREE:
+        ctx.output_image_name = "render_rope_k_d_tree.png";
+        break;
     case AccelerationStructure::BOUNDING_VOLUME_HIERARCHY:
         ctx.output_image_name = "render_bounding_volume_hierarchy.png";
         break;
+    case AccelerationStructure::FLAT_BOUNDING_VOLUME_HIERARCHY:
+        ctx.output_image_name = "render_flat_bounding_volume_hierarchy.png";
+        break;
+    case AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_4:
+        ctx.output_image_name = "render_wide_bounding_volume_hierarchy_4.png";
+        break;
+    case AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_8:
+        ctx.output_image_name = "render_wide_bounding_volume_hierarchy_8.png";
+        break;
+    case AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY:
+        ctx.output_image_name = "render_linear_bounding_volume_hierarchy.png";
+        break;
+    case AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY_OPTIMISED:
+        ctx.output_image_name = "render_linear_bounding_volume_hierarchy_optimised.png";
+        break;
     }
     ctx.acceleration_structure = acceleration_structure;
     ctx.total_rows.store(render_config.image_height, std::memory_order_relaxed);
@@ -766,17 +1224,38 @@ bool ExecuteAsyncRender(RenderContext& context)
         case AccelerationStructure::UNIFORM_GRID:
         {
             timer.Start();
-            UniformGrid accel(context.scene.GetObjects());
+            UniformGrid accel(context.scene.GetObjects(), context.grid_config);
             timer.Stop();
             context.construction_time_ms = timer.ElapsedMilliseconds();
             context.memory_used_bytes = accel.MemoryUsedBytes();
+            LogUniformGridResolution(accel);
             completed = do_render(accel);
             break;
         }
         case AccelerationStructure::HIERARCHICAL_UNIFORM_GRID:
         {
             timer.Start();
-            HierarchicalUniformGrid accel(context.scene.GetObjects());
+            HierarchicalUniformGrid accel(context.scene.GetObjects(), context.grid_config);
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            completed = do_render(accel);
+            break;
+        }
+        case AccelerationStructure::HASHED_GRID:
+        {
+            timer.Start();
+            HashedGrid accel(context.scene.GetObjects());
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            completed = do_render(accel);
+            break;
+        }
+        case AccelerationStructure::TWO_LEVEL_GRID:
+        {
+            timer.Start();
+            TwoLevelGrid accel(context.scene.GetObjects());
             timer.Stop();
             context.construction_time_ms = timer.ElapsedMilliseconds();
             context.memory_used_bytes = accel.MemoryUsedBytes();
@@ -790,6 +1269,40 @@ bool ExecuteAsyncRender(RenderContext& context)
             timer.Stop();
             context.construction_time_ms = timer.ElapsedMilliseconds();
             context.memory_used_bytes = accel.MemoryUsedBytes();
+            LogOctreeOverlapStats(context.acceleration_structure, accel.ComputeOverlapStats());
+            completed = do_render(accel);
+            break;
+        }
+        case AccelerationStructure::PARAMETRIC_OCTREE:
+        {
+            timer.Start();
+            ParametricOctree accel(context.scene.GetObjects());
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            completed = do_render(accel);
+            break;
+        }
+        case AccelerationStructure::LOOSE_OCTREE:
+        {
+            timer.Start();
+            LooseOctree accel(context.scene.GetObjects(), context.octree_looseness);
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            LogLooseOctreeLooseness(accel);
+            LogOctreeOverlapStats(context.acceleration_structure, accel.ComputeOverlapStats());
+            completed = do_render(accel);
+            break;
+        }
+        case AccelerationStructure::LINEAR_OCTREE:
+        {
+            timer.Start();
+            LinearOctree accel(context.scene.GetObjects());
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            LogOctreeOverlapStats(context.acceleration_structure, accel.ComputeOverlapStats());
             completed = do_render(accel);
             break;
         }
@@ -803,6 +1316,16 @@ bool ExecuteAsyncRender(RenderContext& context)
             completed = do_render(accel);
             break;
         }
+        case AccelerationStructure::ADAPTIVE_BSP_TREE:
+        {
+            timer.Start();
+            BSPTreeNode accel(context.scene.GetObjects(), BSPBuildSettings{BSPSplitNormals::DATA_DRIVEN, context.bsp_candidate_budget});
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            completed = do_render(accel);
+            break;
+        }
         case AccelerationStructure::K_D_TREE:
         {
             timer.Start();
@@ -813,6 +1336,16 @@ bool ExecuteAsyncRender(RenderContext& context)
             completed = do_render(accel);
             break;
         }
+        case AccelerationStructure::ROPE_K_D_TREE:
+        {
+            timer.Start();
+            RopeKDTree accel(context.scene.GetObjects());
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            completed = do_render(accel);
+            break;
+        }
         case AccelerationStructure::BOUNDING_VOLUME_HIERARCHY:
         {
             timer.Start();
@@ -823,6 +1356,56 @@ bool ExecuteAsyncRender(RenderContext& context)
             completed = do_render(accel);
             break;
         }
+        case AccelerationStructure::FLAT_BOUNDING_VOLUME_HIERARCHY:
+        {
+            timer.Start();
+            FlatBVH accel(context.scene.GetObjects());
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            completed = do_render(accel);
+            break;
+        }
+        case AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_4:
+        {
+            timer.Start();
+            BVH4 accel(context.scene.GetObjects());
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            completed = do_render(accel);
+            break;
+        }
+        case AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_8:
+        {
+            timer.Start();
+            BVH8 accel(context.scene.GetObjects());
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            completed = do_render(accel);
+            break;
+        }
+        case AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY:
+        {
+            timer.Start();
+            LinearBVH accel(context.scene.GetObjects());
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            completed = do_render(accel);
+            break;
+        }
+        case AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY_OPTIMISED:
+        {
+            timer.Start();
+            LinearBVH accel(context.scene.GetObjects(), true);
+            timer.Stop();
+            context.construction_time_ms = timer.ElapsedMilliseconds();
+            context.memory_used_bytes = accel.MemoryUsedBytes();
+            completed = do_render(accel);
+            break;
+        }
     }
 
     context.was_cancelled.store(!completed, std::memory_order_relaxed);
@@ -9,13 +9,23 @@
 
 #include <Acceleration/BoundingVolumeHierarchy.h>
 #include <Acceleration/BSPTree.h>
+#include <Acceleration/FlatBoundingVolumeHierarchy.h>
+#include <Acceleration/HashedGrid.h>
 #include <Acceleration/HierarchicalUniformGrid.h>
 #include <Acceleration/KDTree.h>
+#include <Acceleration/LinearBoundingVolumeHierarchy.h>
+#include <Acceleration/LinearOctree.h>
+#include <Acceleration/LooseOctree.h>
 #include <Acceleration/Octree.h>
+#include <Acceleration/ParametricOctree.h>
+#include <Acceleration/RopeKDTree.h>
+#include <Acceleration/TwoLevelGrid.h>
 #include <Acceleration/UniformGrid.h>
+#include <Acceleration/WideBoundingVolumeHierarchy.h>
 #include <Core/ArenaAllocator.h>
 #include <Core/Logger.h>
 #include <Core/Timer.h>
+#include <Core/TraversalStats.h>
 #include <Core/Utility.h>
 #include <Geometry/AxisAlignedBox.h>
 #include <Geometry/Sphere.h>
@@ -61,6 +71,9 @@ public:
     SceneConfig scene_config;
     std::string output_image_name;
     AccelerationStructure acceleration_structure = AccelerationStructure::NONE;
+    UniformGridConfig grid_config;
+    double octree_looseness = LooseOctree::DEFAULT_LOOSENESS;
+    std::size_t bsp_candidate_budget = BSPBuildSettings::DEFAULT_CANDIDATE_BUDGET;
 
     // Progress tracking (updated by render thread, read by UI thread)
     std::atomic<std::size_t> num_completed_rows{0};
@@ -88,12 +101,30 @@ void LogRenderConfig(const CameraRenderConfig& render_config, int scene_number);
 
 void LogRenderStats(const RenderStats& stats);
 
+// Logged separately from the render stats so benchmark parsing of those lines is unaffected
+void LogPacketStats(AccelerationStructure acceleration_structure, const TraversalStats& traversal_stats);
+
+void LogRaySortStats(AccelerationStructure acceleration_structure, const TraversalStats& traversal_stats);
+
+void LogOcclusionStats(AccelerationStructure acceleration_structure, const TraversalStats& traversal_stats);
+
+void LogOctreeOverlapStats(AccelerationStructure acceleration_structure, const OctreeOverlapStats& overlap_stats);
+
+void LogUniformGridResolution(const UniformGrid& uniform_grid);
+
+void LogLooseOctreeLooseness(const LooseOctree& loose_octree);
+
+void LogLightBVH(const LightBVH& light_bvh, double build_time_ms);
+
 RenderStats RenderWithAccelerationStructure
 (
     Camera& camera,
     RayHittableList& scene,
     const SceneConfig& scene_config,
-    AccelerationStructure acceleration_structure
+    AccelerationStructure acceleration_structure,
+    const UniformGridConfig& grid_config = UniformGridConfig(),
+    double octree_looseness = LooseOctree::DEFAULT_LOOSENESS,
+    std::size_t bsp_candidate_budget = BSPBuildSettings::DEFAULT_CANDIDATE_BUDGET
 );
 
 void SetupScene
@@ -111,7 +142,10 @@ void RenderScene
     int scene_number,
     AccelerationStructure acceleration_structure,
     uint32_t colour_seed = DEFAULT_COLOUR_SEED,
-    uint32_t position_seed = DEFAULT_POSITION_SEED
+    uint32_t position_seed = DEFAULT_POSITION_SEED,
+    const UniformGridConfig& grid_config = UniformGridConfig(),
+    double octree_looseness = LooseOctree::DEFAULT_LOOSENESS,
+    std::size_t bsp_candidate_budget = BSPBuildSettings::DEFAULT_CANDIDATE_BUDGET
 );
 
 // Set up a scene for async rendering
@@ -120,7 +154,10 @@ RenderContext CreateAsyncRenderContext(
     int scene_number,
     AccelerationStructure acceleration_structure,
     uint32_t colour_seed = DEFAULT_COLOUR_SEED,
-    uint32_t position_seed = DEFAULT_POSITION_SEED
+    uint32_t position_seed = DEFAULT_POSITION_SEED,
+    const UniformGridConfig& grid_config = UniformGridConfig(),
+    double octree_looseness = LooseOctree::DEFAULT_LOOSENESS,
+    std::size_t bsp_candidate_budget = BSPBuildSettings::DEFAULT_CANDIDATE_BUDGET
 );
 
 // Execute the render (call from background thread)
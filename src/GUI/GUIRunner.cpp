@@ -136,12 +136,27 @@ void GUIRunner::DrawSettingsUI()
             "Scene 7 (Flat plane distribution)",
             "Scene 8 (Diagonal wall)",
             "Scene 9 (High object count)",
-            "Scene 10 (Overlapping box city)"
+            "Scene 10 (Overlapping box city)",
+            "Scene 11 (Small emitters)",
+            "Scene 12 (Many lights)"
         };
-        ImGui::Combo("Scene", &m_scene_number, scenes, 10);
+        ImGui::Combo("Scene", &m_scene_number, scenes, 12);
         ImGui::InputInt("Width (px)", &m_render_width);
         ImGui::InputInt("Height (px)", &m_render_height);
         ImGui::InputInt("Samples per pixel", &m_samples_per_pixel);
+        ImGui::InputInt("Packet tile size (0 = single rays)", &m_packet_tile_size);
+        ImGui::Checkbox("Wavefront rendering", &m_wavefront);
+        ImGui::BeginDisabled(!m_wavefront);
+        ImGui::Checkbox("Sort secondary rays", &m_sort_rays);
+        ImGui::BeginDisabled(!m_sort_rays);
+        ImGui::InputInt("Sort from bounce", &m_first_sorted_bounce);
+        m_first_sorted_bounce = std::clamp(m_first_sorted_bounce, 0, 31);
+        ImGui::EndDisabled();
+        ImGui::EndDisabled();
+        ImGui::Checkbox("Next-event estimation", &m_next_event_estimation);
+        ImGui::BeginDisabled(!m_next_event_estimation);
+        ImGui::Checkbox("Light BVH", &m_light_bvh);
+        ImGui::EndDisabled();
         ImGui::InputInt("Colour seed (0 = random)", &m_colour_seed);
         ImGui::InputInt("Position seed (0 = random)", &m_position_seed);
 
@@ -151,6 +166,7 @@ void GUIRunner::DrawSettingsUI()
         m_render_height = (m_render_height > MAX_RENDER_HEIGHT) ? MAX_RENDER_HEIGHT : m_render_height;
         m_samples_per_pixel = (m_samples_per_pixel < MIN_SAMPLES_PER_PIXEL) ? MIN_SAMPLES_PER_PIXEL : m_samples_per_pixel;
         m_samples_per_pixel = (m_samples_per_pixel > MAX_SAMPLES_PER_PIXEL) ? MAX_SAMPLES_PER_PIXEL : m_samples_per_pixel;
+        m_packet_tile_size = std::clamp(m_packet_tile_size, 0, static_cast<int>(Camera::MAX_PACKET_TILE_SIZE));
         m_colour_seed = (m_colour_seed < 0) ? 0 : m_colour_seed;
         m_position_seed = (m_position_seed < 0) ? 0 : m_position_seed;
     }
@@ -160,10 +176,46 @@ void GUIRunner::DrawSettingsUI()
         ImGui::Checkbox("None (brute force)", &m_use_acceleration_structure_none);
         ImGui::Checkbox("Uniform grid", &m_use_acceleration_structure_uniform_grid);
         ImGui::Checkbox("Hierarchical uniform grid", &m_use_acceleration_structure_hierarchical_uniform_grid);
+        ImGui::Checkbox("Hashed grid", &m_use_acceleration_structure_hashed_grid);
+        ImGui::Checkbox("Two-level grid", &m_use_acceleration_structure_two_level_grid);
         ImGui::Checkbox("Octree", &m_use_acceleration_structure_octree);
+        ImGui::Checkbox("Parametric octree", &m_use_acceleration_structure_parametric_octree);
+        ImGui::Checkbox("Loose octree", &m_use_acceleration_structure_loose_octree);
+        ImGui::Checkbox("Linear octree", &m_use_acceleration_structure_linear_octree);
         ImGui::Checkbox("BSP tree", &m_use_acceleration_structure_bsp_tree);
+        ImGui::Checkbox("Adaptive BSP tree", &m_use_acceleration_structure_adaptive_bsp_tree);
         ImGui::Checkbox("k-d tree", &m_use_acceleration_structure_k_d_tree);
+        ImGui::Checkbox("Rope k-d tree", &m_use_acceleration_structure_rope_k_d_tree);
         ImGui::Checkbox("Bounding volume hierarchy", &m_use_acceleration_structure_bounding_volume_hierarchy);
+        ImGui::Checkbox("Flattened bounding volume hierarchy", &m_use_acceleration_structure_flat_bounding_volume_hierarchy);
+        ImGui::Checkbox("4-wide bounding volume hierarchy", &m_use_acceleration_structure_wide_bounding_volume_hierarchy_4);
+        ImGui::Checkbox("8-wide bounding volume hierarchy", &m_use_acceleration_structure_wide_bounding_volume_hierarchy_8);
+        ImGui::Checkbox("Linear bounding volume hierarchy", &m_use_acceleration_structure_linear_bounding_volume_hierarchy);
+        ImGui::Checkbox("Treelet optimised linear bounding volume hierarchy", &m_use_acceleration_structure_linear_bounding_volume_hierarchy_optimised);
+    }
+
+    if (ImGui::CollapsingHeader("Grid Settings"))
+    {
+        ImGui::Checkbox("Auto-tune density", &m_grid_config.auto_tune_density);
+        ImGui::BeginDisabled(m_grid_config.auto_tune_density);
+        ImGui::InputDouble("Cells per object", &m_grid_config.density, 0.25, 1.0, "%.3f");
+        ImGui::EndDisabled();
+
+        m_grid_config.density = std::clamp(m_grid_config.density, UniformGridConfig::MIN_DENSITY, UniformGridConfig::MAX_DENSITY);
+    }
+
+    if (ImGui::CollapsingHeader("Octree Settings"))
+    {
+        ImGui::InputDouble("Loose octree looseness", &m_octree_looseness, 0.25, 0.5, "%.3f");
+
+        m_octree_looseness = std::clamp(m_octree_looseness, LooseOctree::MIN_LOOSENESS, LooseOctree::MAX_LOOSENESS);
+    }
+
+    if (ImGui::CollapsingHeader("BSP Tree Settings"))
+    {
+        ImGui::InputInt("Adaptive BSP candidate normals", &m_bsp_candidate_budget);
+
+        m_bsp_candidate_budget = std::clamp(m_bsp_candidate_budget, static_cast<int>(BSPBuildSettings::MIN_CANDIDATE_BUDGET), static_cast<int>(BSPBuildSettings::MAX_CANDIDATE_BUDGET));
     }
 
     ImGui::Separator();
@@ -257,7 +309,7 @@ void GUIRunner::DrawResultsUI()
         return;
     }
 
-    if (ImGui::BeginTable("RenderResults", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    if (ImGui::BeginTable("RenderResults", 11, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
     {
         ImGui::TableSetupColumn("Structure");
         ImGui::TableSetupColumn("Construction (ms)");
@@ -266,6 +318,10 @@ void GUIRunner::DrawResultsUI()
         ImGui::TableSetupColumn("Memory used");
         ImGui::TableSetupColumn("Avg nodes/ray");
         ImGui::TableSetupColumn("Avg tests/ray");
+        ImGui::TableSetupColumn("Packet utilisation");
+        ImGui::TableSetupColumn("Ray sort (ms)");
+        ImGui::TableSetupColumn("Avg nodes/occlusion ray");
+        ImGui::TableSetupColumn("Avg tests/occlusion ray");
         ImGui::TableHeadersRow();
 
         for (const RenderStats& stats : m_completed_stats)
@@ -292,6 +348,18 @@ void GUIRunner::DrawResultsUI()
 
             ImGui::TableNextColumn();
             ImGui::Text("%.2f", stats.m_traversal_stats.AvgIntersectionTestsPerRay());
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f%%", stats.m_traversal_stats.PacketUtilisation() * 100.0);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", stats.m_traversal_stats.ray_sort_time_ms);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", stats.m_traversal_stats.AvgNodesTraversedPerOcclusionRay());
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", stats.m_traversal_stats.AvgIntersectionTestsPerOcclusionRay());
         }
 
         ImGui::EndTable();
@@ -301,8 +369,8 @@ void GUIRunner::DrawResultsUI()
     {
         std::ostringstream md;
         md << std::fixed << std::setprecision(2);
-        md << "| Structure | Construction (ms) | Render (ms) | Total (ms) | Memory used | Avg nodes/ray | Avg tests/ray |\n";
-        md << "| --- | --- | --- | --- | --- | --- | --- |\n";
+        md << "| Structure | Construction (ms) | Render (ms) | Total (ms) | Memory used | Avg nodes/ray | Avg tests/ray | Packet utilisation | Ray sort (ms) | Avg nodes/occlusion ray | Avg tests/occlusion ray |\n";
+        md << "| --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- |\n";
         for (const RenderStats& stats : m_completed_stats)
         {
             md << "| " << AccelerationStructureToString(stats.m_acceleration_structure)
@@ -312,6 +380,10 @@ void GUIRunner::DrawResultsUI()
                << " | " << FormatMemoryUsed(stats.m_memory_used_bytes)
                << " | " << stats.m_traversal_stats.AvgNodesTraversedPerRay()
                << " | " << stats.m_traversal_stats.AvgIntersectionTestsPerRay()
+               << " | " << (stats.m_traversal_stats.PacketUtilisation() * 100.0) << "%"
+               << " | " << stats.m_traversal_stats.ray_sort_time_ms
+               << " | " << stats.m_traversal_stats.AvgNodesTraversedPerOcclusionRay()
+               << " | " << stats.m_traversal_stats.AvgIntersectionTestsPerOcclusionRay()
                << " |\n";
         }
         SDL_SetClipboardText(md.str().c_str());
@@ -426,7 +498,12 @@ void GUIRunner::StartRenderQueue()
         static_cast<std::size_t>(m_render_width),
         static_cast<std::size_t>(m_render_height),
         static_cast<std::size_t>(m_samples_per_pixel),
-        25
+        25,
+        static_cast<std::size_t>(m_packet_tile_size),
+        m_wavefront,
+        (m_wavefront && m_sort_rays) ? (Camera::SORT_RAYS_ALL_BOUNCES << m_first_sorted_bounce) : 0u,
+        m_next_event_estimation,
+        m_next_event_estimation && m_light_bvh
     };
     int scene_number_one_indexed = m_scene_number + 1;
 
@@ -435,6 +512,7 @@ void GUIRunner::StartRenderQueue()
     // Cast from int (ImGui expects int for UI values)
     const uint32_t colour_seed = static_cast<uint32_t>(m_colour_seed);
     const uint32_t position_seed = static_cast<uint32_t>(m_position_seed);
+    const std::size_t bsp_candidate_budget = static_cast<std::size_t>(m_bsp_candidate_budget);
 
     m_render_queue.clear();
     m_completed_stats.clear();
@@ -443,43 +521,115 @@ void GUIRunner::StartRenderQueue()
     if (m_use_acceleration_structure_none)
     {
         RenderJob job;
-        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::NONE, colour_seed, position_seed);
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::NONE, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
         m_render_queue.push_back(std::move(job));
     }
     if (m_use_acceleration_structure_uniform_grid)
     {
         RenderJob job;
-        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::UNIFORM_GRID, colour_seed, position_seed);
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::UNIFORM_GRID, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
         m_render_queue.push_back(std::move(job));
     }
     if (m_use_acceleration_structure_hierarchical_uniform_grid)
     {
         RenderJob job;
-        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::HIERARCHICAL_UNIFORM_GRID, colour_seed, position_seed);
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::HIERARCHICAL_UNIFORM_GRID, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_hashed_grid)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::HASHED_GRID, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_two_level_grid)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::TWO_LEVEL_GRID, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
         m_render_queue.push_back(std::move(job));
     }
     if (m_use_acceleration_structure_octree)
     {
         RenderJob job;
-        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::OCTREE, colour_seed, position_seed);
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::OCTREE, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_parametric_octree)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::PARAMETRIC_OCTREE, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_loose_octree)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::LOOSE_OCTREE, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_linear_octree)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::LINEAR_OCTREE, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
         m_render_queue.push_back(std::move(job));
     }
     if (m_use_acceleration_structure_bsp_tree)
     {
         RenderJob job;
-        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::BSP_TREE, colour_seed, position_seed);
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::BSP_TREE, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_adaptive_bsp_tree)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::ADAPTIVE_BSP_TREE, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
         m_render_queue.push_back(std::move(job));
     }
     if (m_use_acceleration_structure_k_d_tree)
     {
         RenderJob job;
-        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::K_D_TREE, colour_seed, position_seed);
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::K_D_TREE, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_rope_k_d_tree)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::ROPE_K_D_TREE, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
         m_render_queue.push_back(std::move(job));
     }
     if (m_use_acceleration_structure_bounding_volume_hierarchy)
     {
         RenderJob job;
-        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::BOUNDING_VOLUME_HIERARCHY, colour_seed, position_seed);
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::BOUNDING_VOLUME_HIERARCHY, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_flat_bounding_volume_hierarchy)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::FLAT_BOUNDING_VOLUME_HIERARCHY, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_wide_bounding_volume_hierarchy_4)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_4, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_wide_bounding_volume_hierarchy_8)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_8, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_linear_bounding_volume_hierarchy)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
+        m_render_queue.push_back(std::move(job));
+    }
+    if (m_use_acceleration_structure_linear_bounding_volume_hierarchy_optimised)
+    {
+        RenderJob job;
+        job.context = CreateAsyncRenderContext(config, scene_number_one_indexed, AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY_OPTIMISED, colour_seed, position_seed, m_grid_config, m_octree_looseness, bsp_candidate_budget);
         m_render_queue.push_back(std::move(job));
     }
 
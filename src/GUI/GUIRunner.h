@@ -69,17 +69,39 @@ private:
     bool m_use_acceleration_structure_none = true;
     bool m_use_acceleration_structure_uniform_grid = true;
     bool m_use_acceleration_structure_hierarchical_uniform_grid = true;
+    bool m_use_acceleration_structure_hashed_grid = true;
+    bool m_use_acceleration_structure_two_level_grid = true;
     bool m_use_acceleration_structure_octree = true;
+    bool m_use_acceleration_structure_parametric_octree = true;
+    bool m_use_acceleration_structure_loose_octree = true;
+    bool m_use_acceleration_structure_linear_octree = true;
     bool m_use_acceleration_structure_bsp_tree = true;
+    bool m_use_acceleration_structure_adaptive_bsp_tree = true;
     bool m_use_acceleration_structure_k_d_tree = true;
+    bool m_use_acceleration_structure_rope_k_d_tree = true;
     bool m_use_acceleration_structure_bounding_volume_hierarchy = true;
+    bool m_use_acceleration_structure_flat_bounding_volume_hierarchy = true;
+    bool m_use_acceleration_structure_wide_bounding_volume_hierarchy_4 = true;
+    bool m_use_acceleration_structure_wide_bounding_volume_hierarchy_8 = true;
+    bool m_use_acceleration_structure_linear_bounding_volume_hierarchy = true;
+    bool m_use_acceleration_structure_linear_bounding_volume_hierarchy_optimised = true;
 
     int m_render_width = 1280;
     int m_render_height = 720;
     int m_samples_per_pixel = 100;
+    int m_packet_tile_size = 0;
+    bool m_wavefront = false;
+    bool m_sort_rays = false;
+    // Rays scattered at this bounce and every later one are sorted, bounce 0 being the camera rays' hits
+    int m_first_sorted_bounce = 0;
+    bool m_next_event_estimation = false;
+    bool m_light_bvh = false;
     int m_scene_number = 0; // 0-indexed
     int m_colour_seed = DEFAULT_COLOUR_SEED;
     int m_position_seed = DEFAULT_POSITION_SEED;
+    UniformGridConfig m_grid_config;
+    double m_octree_looseness = LooseOctree::DEFAULT_LOOSENESS;
+    int m_bsp_candidate_budget = static_cast<int>(BSPBuildSettings::DEFAULT_CANDIDATE_BUDGET);
 
     RenderState m_render_state = RenderState::IDLE;
     std::vector<RenderJob> m_render_queue;
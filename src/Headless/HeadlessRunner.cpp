@@ -22,6 +22,16 @@ void PrintHelpMsg(const char* program_name)
                 << "  --scene <scene_number> Scene to render (default: 1)\n"
                 << "  --colour-seed <seed>   Seed for object colour RNG (default: 22052003, 0 = random)\n"
                 << "  --position-seed <seed> Seed for object position RNG (default: 13012025, 0 = random)\n"
+                << "  --grid-density <cells> Uniform grid cells per object (default: 2.0)\n"
+                << "  --grid-auto-tune       Choose the uniform grid density by estimated cost\n"
+                << "  --octree-looseness <k> Loose octree cells hold objects up to k times their size (default: 2.0)\n"
+                << "  --bsp-candidates <n>   Split normals scored per adaptive BSP tree node (default: 8)\n"
+                << "  --packet-size <pixels> Trace camera rays in square packets of this side (default: 0 = single rays, max: 8)\n"
+                << "  --wavefront            Render a bounce at a time, tracing and shading in separate passes\n"
+                << "  --sort-rays            Sort wavefront secondary rays by direction and origin before each bounce\n"
+                << "  --sort-rays-mask <m>   Sort only the rays scattered at the bounces set in m, bit 0 being camera ray hits\n"
+                << "  --nee                  Sample emissive objects directly at each bounce (next-event estimation)\n"
+                << "  --light-bvh            Pick the light each next-event estimate samples through a light BVH\n"
                 << "  --help                 Show this help message\n";
 }
 
@@ -69,9 +79,9 @@ bool ParseCLIArgs(int argc, char* argv[], CLIParams& out_params)
                 return false;
             }
             out_params.scene = std::atoi(argv[++i]);
-            if (out_params.scene < 1 || out_params.scene > 10)
+            if (out_params.scene < 1 || out_params.scene > 12)
             {
-                std::cerr << "Error: --scene must be between 1 and 10\n";
+                std::cerr << "Error: --scene must be between 1 and 12\n";
                 return false;
             }
         }
@@ -93,6 +103,92 @@ bool ParseCLIArgs(int argc, char* argv[], CLIParams& out_params)
             }
             out_params.position_seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
         }
+        else if (std::strcmp(argv[i], "--grid-density") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Error: --grid-density requires a value\n";
+                return false;
+            }
+            out_params.grid_config.density = std::strtod(argv[++i], nullptr);
+            if (out_params.grid_config.density < UniformGridConfig::MIN_DENSITY || out_params.grid_config.density > UniformGridConfig::MAX_DENSITY)
+            {
+                std::cerr << "Error: --grid-density must be between " << UniformGridConfig::MIN_DENSITY << " and " << UniformGridConfig::MAX_DENSITY << "\n";
+                return false;
+            }
+        }
+        else if (std::strcmp(argv[i], "--octree-looseness") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Error: --octree-looseness requires a value\n";
+                return false;
+            }
+            out_params.octree_looseness = std::strtod(argv[++i], nullptr);
+            if (out_params.octree_looseness < LooseOctree::MIN_LOOSENESS || out_params.octree_looseness > LooseOctree::MAX_LOOSENESS)
+            {
+                std::cerr << "Error: --octree-looseness must be between " << LooseOctree::MIN_LOOSENESS << " and " << LooseOctree::MAX_LOOSENESS << "\n";
+                return false;
+            }
+        }
+        else if (std::strcmp(argv[i], "--bsp-candidates") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Error: --bsp-candidates requires a value\n";
+                return false;
+            }
+            const long bsp_candidate_budget = std::strtol(argv[++i], nullptr, 10);
+            if (bsp_candidate_budget < static_cast<long>(BSPBuildSettings::MIN_CANDIDATE_BUDGET) || bsp_candidate_budget > static_cast<long>(BSPBuildSettings::MAX_CANDIDATE_BUDGET))
+            {
+                std::cerr << "Error: --bsp-candidates must be between " << BSPBuildSettings::MIN_CANDIDATE_BUDGET << " and " << BSPBuildSettings::MAX_CANDIDATE_BUDGET << "\n";
+                return false;
+            }
+            out_params.bsp_candidate_budget = static_cast<std::size_t>(bsp_candidate_budget);
+        }
+        else if (std::strcmp(argv[i], "--packet-size") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Error: --packet-size requires a value\n";
+                return false;
+            }
+            out_params.packet_tile_size = static_cast<std::size_t>(std::atoi(argv[++i]));
+            if (out_params.packet_tile_size > Camera::MAX_PACKET_TILE_SIZE)
+            {
+                std::cerr << "Error: --packet-size must be between 0 and " << Camera::MAX_PACKET_TILE_SIZE << "\n";
+                return false;
+            }
+        }
+        else if (std::strcmp(argv[i], "--wavefront") == 0)
+        {
+            out_params.wavefront = true;
+        }
+        else if (std::strcmp(argv[i], "--sort-rays") == 0)
+        {
+            out_params.sort_rays_bounce_mask = Camera::SORT_RAYS_ALL_BOUNCES;
+        }
+        else if (std::strcmp(argv[i], "--sort-rays-mask") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Error: --sort-rays-mask requires a value\n";
+                return false;
+            }
+            out_params.sort_rays_bounce_mask = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if (std::strcmp(argv[i], "--nee") == 0)
+        {
+            out_params.next_event_estimation = true;
+        }
+        else if (std::strcmp(argv[i], "--light-bvh") == 0)
+        {
+            out_params.light_bvh = true;
+        }
+        else if (std::strcmp(argv[i], "--grid-auto-tune") == 0)
+        {
+            out_params.grid_config.auto_tune_density = true;
+        }
         else
         {
             std::cerr << "Error: Unknown option '" << argv[i] << "'\n";
@@ -101,6 +197,18 @@ bool ParseCLIArgs(int argc, char* argv[], CLIParams& out_params)
         }
     }
 
+    if (out_params.sort_rays_bounce_mask != 0 && !out_params.wavefront)
+    {
+        std::cerr << "Error: --sort-rays and --sort-rays-mask require --wavefront\n";
+        return false;
+    }
+
+    if (out_params.light_bvh && !out_params.next_event_estimation)
+    {
+        std::cerr << "Error: --light-bvh requires --nee\n";
+        return false;
+    }
+
     out_params.screen_width = (out_params.screen_width < MIN_RENDER_WIDTH) ? MIN_RENDER_WIDTH : out_params.screen_width;
     out_params.screen_width = (out_params.screen_width > MAX_RENDER_WIDTH) ? MAX_RENDER_WIDTH : out_params.screen_width;
     out_params.screen_height = (out_params.screen_height < MIN_RENDER_HEIGHT) ? MIN_RENDER_HEIGHT : out_params.screen_height;
@@ -118,7 +226,12 @@ CameraRenderConfig MakeCameraRenderConfig(const CLIParams& cli_params)
         cli_params.screen_width,
         cli_params.screen_height,
         cli_params.samples_per_pixel,
-        25
+        25,
+        cli_params.packet_tile_size,
+        cli_params.wavefront,
+        cli_params.sort_rays_bounce_mask,
+        cli_params.next_event_estimation,
+        cli_params.light_bvh
     };
 }
 
@@ -130,6 +243,9 @@ HeadlessRunner::HeadlessRunner(int argc, char* argv[])
     m_scene_number = cli_params.scene;
     m_colour_seed = cli_params.colour_seed;
     m_position_seed = cli_params.position_seed;
+    m_grid_config = cli_params.grid_config;
+    m_octree_looseness = cli_params.octree_looseness;
+    m_bsp_candidate_budget = cli_params.bsp_candidate_budget;
 }
 
 HeadlessRunner::~HeadlessRunner()
@@ -143,13 +259,25 @@ void HeadlessRunner::Init()
 
     LogRenderConfig(m_camera_render_config, m_scene_number);
 
-    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::NONE, m_colour_seed, m_position_seed);
-    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::UNIFORM_GRID, m_colour_seed, m_position_seed);
-    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::HIERARCHICAL_UNIFORM_GRID, m_colour_seed, m_position_seed);
-    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::OCTREE, m_colour_seed, m_position_seed);
-    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::BSP_TREE, m_colour_seed, m_position_seed);
-    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::K_D_TREE, m_colour_seed, m_position_seed);
-    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::BOUNDING_VOLUME_HIERARCHY, m_colour_seed, m_position_seed);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::NONE, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::UNIFORM_GRID, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::HIERARCHICAL_UNIFORM_GRID, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::HASHED_GRID, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::TWO_LEVEL_GRID, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::OCTREE, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::PARAMETRIC_OCTREE, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::LOOSE_OCTREE, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::LINEAR_OCTREE, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::BSP_TREE, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::ADAPTIVE_BSP_TREE, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::K_D_TREE, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::ROPE_K_D_TREE, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::BOUNDING_VOLUME_HIERARCHY, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::FLAT_BOUNDING_VOLUME_HIERARCHY, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_4, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_8, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
+    RenderScene(m_camera_render_config, m_scene_number, AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY_OPTIMISED, m_colour_seed, m_position_seed, m_grid_config, m_octree_looseness, m_bsp_candidate_budget);
 }
 
 void HeadlessRunner::Shutdown()
@@ -15,9 +15,17 @@ public:
     std::size_t screen_width = 1280;
     std::size_t screen_height = 720;
     std::size_t samples_per_pixel = 100;
+    std::size_t packet_tile_size = 0;
+    bool wavefront = false;
+    uint32_t sort_rays_bounce_mask = 0;
+    bool next_event_estimation = false;
+    bool light_bvh = false;
     int scene = 1;
     uint32_t colour_seed = DEFAULT_COLOUR_SEED;
     uint32_t position_seed = DEFAULT_POSITION_SEED;
+    UniformGridConfig grid_config;
+    double octree_looseness = LooseOctree::DEFAULT_LOOSENESS;
+    std::size_t bsp_candidate_budget = BSPBuildSettings::DEFAULT_CANDIDATE_BUDGET;
 };
 
 void PrintHelpMsg(const char* program_name);
@@ -42,6 +50,9 @@ protected:
     int m_scene_number = -1;
     uint32_t m_colour_seed = DEFAULT_COLOUR_SEED;
     uint32_t m_position_seed = DEFAULT_POSITION_SEED;
+    UniformGridConfig m_grid_config;
+    double m_octree_looseness = LooseOctree::DEFAULT_LOOSENESS;
+    std::size_t m_bsp_candidate_budget = BSPBuildSettings::DEFAULT_CANDIDATE_BUDGET;
 };
 
 } // namespace ART
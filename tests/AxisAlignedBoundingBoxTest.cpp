@@ -158,4 +158,31 @@ TEST_CASE("AABB LongestAxis returns correct axis index", "[AABB]")
     REQUIRE(aabb_z.LongestAxis() == 2);
 }
 
+TEST_CASE("AABB Volume and OverlapVolume", "[AABB]")
+{
+    const AABB aabb_a(
+        0.0, 2.0,
+        0.0, 3.0,
+        0.0, 4.0
+    );
+    REQUIRE(aabb_a.Volume() == Approx(24.0));
+
+    // Overlapping boxes share a 1x2x4 region
+    const AABB aabb_b(
+        1.0, 5.0,
+        -1.0, 2.0,
+        0.0, 4.0
+    );
+    REQUIRE(aabb_a.OverlapVolume(aabb_b) == Approx(8.0));
+    REQUIRE(aabb_b.OverlapVolume(aabb_a) == Approx(8.0));
+
+    // Boxes touching on a face share no volume
+    const AABB aabb_c(
+        2.0, 3.0,
+        0.0, 3.0,
+        0.0, 4.0
+    );
+    REQUIRE(aabb_a.OverlapVolume(aabb_c) == 0.0);
+}
+
 } // namespace ART
@@ -123,6 +123,40 @@ TEST_CASE("AxisAlignedBox Hit respects interval bounds", "[AxisAlignedBox]")
     REQUIRE(hit == false);
 }
 
+TEST_CASE("AxisAlignedBox HitDeferred defers the face to SetHitAttributes", "[AxisAlignedBox]")
+{
+    SolidColourTexture texture(Colour(0.5));
+    LambertianMaterial material(&texture);
+    const AxisAlignedBox box = MakeUnitBox(&material);
+
+    // One ray towards each face, from outside along its outward normal
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        for (double side : { -1.0, 1.0 })
+        {
+            Point3 origin(0.25);
+            origin[axis] = 5.0 * side;
+            Vec3 direction(0.0);
+            direction[axis] = -side;
+            const Ray ray(origin, direction);
+
+            RayHitResult result;
+            REQUIRE(box.HitDeferred(ray, Interval(0.001, infinity), result));
+            REQUIRE(result.m_t == Approx(4.0));
+            REQUIRE(result.m_hit_object == &box);
+
+            box.SetHitAttributes(ray, result);
+            Vec3 expected_normal(0.0);
+            expected_normal[axis] = side;
+            REQUIRE(result.m_normal.m_x == expected_normal.m_x);
+            REQUIRE(result.m_normal.m_y == expected_normal.m_y);
+            REQUIRE(result.m_normal.m_z == expected_normal.m_z);
+            REQUIRE(result.m_is_front_facing == true);
+            REQUIRE(result.m_material == &material);
+        }
+    }
+}
+
 TEST_CASE("AxisAlignedBox BoundingBox returns correct min and max (extents)", "[AxisAlignedBox]")
 {
     SolidColourTexture texture(Colour(0.5));
@@ -157,4 +191,44 @@ TEST_CASE("AxisAlignedBox BoundingBox constructor from AABB matches min/max cons
     REQUIRE(result_aabb.m_z.m_max == Approx(result_min_and_max_points.m_z.m_max));
 }
 
+TEST_CASE("AxisAlignedBox SampleDirection draws directions towards the box with their DirectionPdf", "[AxisAlignedBox]")
+{
+    SolidColourTexture texture(Colour(0.5));
+    LambertianMaterial material(&texture);
+    const AxisAlignedBox box(Point3(-1.0, -0.5, -2.0), Point3(1.0, 0.5, 1.0), &material);
+
+    // Sees three faces, or one when in line with the box on two axes
+    const Point3 origins[2] = { Point3(3.0, 2.0, 4.0), Point3(0.2, 0.1, 5.0) };
+    for (const Point3& origin : origins)
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            const Vec3 direction = box.SampleDirection(origin);
+            RayHitResult result;
+            REQUIRE(box.Hit(Ray(origin, direction), Interval(0.0, infinity), result));
+            REQUIRE(box.DirectionPdf(origin, direction) > 0.0);
+        }
+
+        // Midpoint rule over cells of equal solid angle, uniform in cos(theta) and phi
+        const int num_z_cells = 1000;
+        const int num_phi_cells = 2000;
+        const double cell_solid_angle = (4.0 * pi) / (num_z_cells * num_phi_cells);
+        double integral = 0.0;
+        for (int z_cell = 0; z_cell < num_z_cells; z_cell++)
+        {
+            const double z = -1.0 + ((z_cell + 0.5) * 2.0) / num_z_cells;
+            const double radius = std::sqrt(1.0 - (z * z));
+            for (int phi_cell = 0; phi_cell < num_phi_cells; phi_cell++)
+            {
+                const double phi = ((phi_cell + 0.5) * 2.0 * pi) / num_phi_cells;
+                integral += box.DirectionPdf(origin, Vec3(radius * std::cos(phi), radius * std::sin(phi), z)) * cell_solid_angle;
+            }
+        }
+        REQUIRE(integral == Approx(1.0).epsilon(0.01));
+    }
+
+    REQUIRE(box.DirectionPdf(Point3(3.0, 2.0, 4.0), Vec3(1.0, 0.0, 0.0)) == 0.0);
+    REQUIRE(box.DirectionPdf(Point3(0.0), Vec3(0.0, 0.0, 1.0)) == 0.0);
+}
+
 } // namespace ART
@@ -6,6 +6,7 @@
 #include <Core/Constants.h>
 #include <Geometry/Sphere.h>
 #include <Materials/Material.h>
+#include <RayTracing/RayHittableList.h>
 
 namespace ART
 {
@@ -181,6 +182,235 @@ TEST_CASE("BSPTreeNode Hit works when all objects are on the same side (index-sp
     }
 }
 
+TEST_CASE("BSPTreeNode Hit with split plane clipping matches brute force", "[BSPTreeNode]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Two diagonal walls of spheres, so oblique planes are chosen and many spheres span them
+    std::vector<IRayHittable*> objects;
+    RayHittableList brute_force;
+    for (int i = -15; i <= 15; i++)
+    {
+        for (int j = -3; j <= 3; j++)
+        {
+            const double radius = 0.3 + 0.1 * static_cast<double>((i + j + 20) % 4);
+            IRayHittable* wall_a = allocator.Create<Sphere>(Point3(i + j * 0.5, i - 4.0, -10.0 + j), radius, material);
+            IRayHittable* wall_b = allocator.Create<Sphere>(Point3(i, -i + 4.0, -14.0 + j * 0.7), radius, material);
+            objects.push_back(wall_a);
+            objects.push_back(wall_b);
+            brute_force.Add(wall_a);
+            brute_force.Add(wall_b);
+        }
+    }
+
+    BSPTreeNode bsp_tree(objects);
+
+    // Origins outside, between and behind the walls
+    const Point3 origins[4] = { Point3(0.0, 0.0, 5.0), Point3(0.0, 0.0, -12.0), Point3(-25.0, 3.0, -11.0), Point3(4.0, -20.0, -30.0) };
+    for (const Point3& origin : origins)
+    {
+        for (int ray_x = -15; ray_x <= 15; ray_x++)
+        {
+            for (int ray_y = -15; ray_y <= 15; ray_y++)
+            {
+                const Ray ray(origin, Point3(ray_x, ray_y, -12.0) - origin);
+
+                RayHitResult brute_force_result;
+                RayHitResult bsp_tree_result;
+                const bool brute_force_hit = brute_force.Hit(ray, Interval(0.001, infinity), brute_force_result);
+                const bool bsp_tree_hit = bsp_tree.Hit(ray, Interval(0.001, infinity), bsp_tree_result);
+
+                REQUIRE(bsp_tree_hit == brute_force_hit);
+                REQUIRE(bsp_tree.HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+                if (brute_force_hit)
+                {
+                    REQUIRE(bsp_tree_result.m_t == Approx(brute_force_result.m_t));
+                    REQUIRE_FALSE(bsp_tree.HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("BSPTreeNode Hit from a ray starting on the split plane", "[BSPTreeNode]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Mirror image halves put the root split on x = 0, through the ray origins below
+    std::vector<IRayHittable*> objects;
+    RayHittableList brute_force;
+    for (int x = 1; x <= 8; x++)
+    {
+        for (int y = -2; y <= 2; y++)
+        {
+            IRayHittable* right = allocator.Create<Sphere>(Point3(x, y, -5.0), 0.3, material);
+            IRayHittable* left = allocator.Create<Sphere>(Point3(-x, y, -5.0), 0.3, material);
+            objects.push_back(right);
+            objects.push_back(left);
+            brute_force.Add(right);
+            brute_force.Add(left);
+        }
+    }
+
+    BSPTreeNode bsp_tree(objects);
+
+    for (int ray_x = -8; ray_x <= 8; ray_x++)
+    {
+        for (int ray_y = -2; ray_y <= 2; ray_y++)
+        {
+            const Ray ray(Point3(0.0, 0.0, 5.0), Point3(ray_x, ray_y, -5.0) - Point3(0.0, 0.0, 5.0));
+
+            RayHitResult brute_force_result;
+            RayHitResult bsp_tree_result;
+            const bool brute_force_hit = brute_force.Hit(ray, Interval(0.001, infinity), brute_force_result);
+            const bool bsp_tree_hit = bsp_tree.Hit(ray, Interval(0.001, infinity), bsp_tree_result);
+
+            REQUIRE(bsp_tree_hit == brute_force_hit);
+            REQUIRE(bsp_tree.HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+            if (brute_force_hit)
+            {
+                REQUIRE(bsp_tree_result.m_t == Approx(brute_force_result.m_t));
+                REQUIRE_FALSE(bsp_tree.HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+            }
+        }
+    }
+}
+
+TEST_CASE("BSPTreeNode FindCandidateNormals derives normals from the objects", "[BSPTreeNode]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Flat wall of spheres facing (2, 0, -1), not one of the fixed diagonals
+    const Vec3 wall_normal = Normalised(Vec3(2.0, 0.0, -1.0));
+    std::vector<IRayHittable*> objects;
+    for (int along = 0; along < 20; along++)
+    {
+        for (int up = 0; up < 10; up++)
+        {
+            objects.push_back(allocator.Create<Sphere>(Point3(along * 1.0, up * 1.0, along * 2.0), 0.4, material));
+        }
+    }
+    std::vector<AABB> object_boxes;
+    std::vector<uint32_t> object_indices;
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    {
+        object_boxes.push_back(objects[object_index]->BoundingBox());
+        object_indices.push_back(static_cast<uint32_t>(object_index));
+    }
+
+    SECTION("Axes come first and the wall normal is found")
+    {
+        Vec3 normals[BSPTreeNode::MAX_CANDIDATE_NORMALS];
+        const std::size_t num_normals = BSPTreeNode::FindCandidateNormals(object_boxes.data(), object_indices.data(), object_indices.size(), 8, normals);
+
+        REQUIRE(num_normals > 3);
+        REQUIRE(normals[0].m_x == 1.0);
+        REQUIRE(normals[1].m_y == 1.0);
+        REQUIRE(normals[2].m_z == 1.0);
+
+        bool found_wall_normal = false;
+        for (std::size_t normal_index = 0; normal_index < num_normals; normal_index++)
+        {
+            REQUIRE(normals[normal_index].Length() == Approx(1.0));
+            found_wall_normal |= std::abs(Dot(normals[normal_index], wall_normal)) > 0.999;
+        }
+        REQUIRE(found_wall_normal);
+    }
+
+    SECTION("Candidate budget is respected")
+    {
+        Vec3 normals[BSPTreeNode::MAX_CANDIDATE_NORMALS];
+        REQUIRE(BSPTreeNode::FindCandidateNormals(object_boxes.data(), object_indices.data(), object_indices.size(), 4, normals) == 4);
+        REQUIRE(BSPTreeNode::FindCandidateNormals(object_boxes.data(), object_indices.data(), object_indices.size(), 0, normals) == 3);
+    }
+}
+
+TEST_CASE("BSPTreeNode::ClippedSurfaceArea", "[BSPTreeNode]")
+{
+    const AABB unit_cube(Point3(0.0, 0.0, 0.0), Point3(1.0, 1.0, 1.0));
+
+    SECTION("Plane missing the box")
+    {
+        const BSPSplitPlane plane(Vec3(1.0, 0.0, 0.0), 5.0);
+        REQUIRE(BSPTreeNode::ClippedSurfaceArea(unit_cube, plane, false) == Approx(6.0));
+        REQUIRE(BSPTreeNode::ClippedSurfaceArea(unit_cube, plane, true) == Approx(0.0));
+    }
+
+    SECTION("Axis aligned plane through the middle")
+    {
+        const BSPSplitPlane plane(Vec3(0.0, 1.0, 0.0), 0.5);
+        REQUIRE(BSPTreeNode::ClippedSurfaceArea(unit_cube, plane, true) == Approx(4.0));
+        REQUIRE(BSPTreeNode::ClippedSurfaceArea(unit_cube, plane, false) == Approx(4.0));
+    }
+
+    SECTION("Diagonal plane through the middle")
+    {
+        // Each half is a triangular prism, capped by a 1 x sqrt(2) rectangle
+        const BSPSplitPlane plane(Normalised(Vec3(1.0, -1.0, 0.0)), 0.0);
+        REQUIRE(BSPTreeNode::ClippedSurfaceArea(unit_cube, plane, true) == Approx(3.0 + std::sqrt(2.0)));
+        REQUIRE(BSPTreeNode::ClippedSurfaceArea(unit_cube, plane, false) == Approx(3.0 + std::sqrt(2.0)));
+    }
+}
+
+TEST_CASE("BSPTreeNode with data driven normals matches brute force", "[BSPTreeNode]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Two walls at angles the fixed normals don't cover, plus scattered spheres
+    std::vector<IRayHittable*> objects;
+    RayHittableList brute_force;
+    for (int along = -12; along <= 12; along++)
+    {
+        for (int up = -4; up <= 4; up++)
+        {
+            IRayHittable* wall_a = allocator.Create<Sphere>(Point3(along * 0.8, up, -15.0 + along * 0.3), 0.35, material);
+            IRayHittable* wall_b = allocator.Create<Sphere>(Point3(along * 0.3 + 4.0, up * 0.9, -20.0 - along * 0.9), 0.35, material);
+            objects.push_back(wall_a);
+            objects.push_back(wall_b);
+            brute_force.Add(wall_a);
+            brute_force.Add(wall_b);
+        }
+        IRayHittable* scattered = allocator.Create<Sphere>(Point3(along * 1.3, (along * 5) % 7, -8.0 - (along * 3) % 11), 0.5, material);
+        objects.push_back(scattered);
+        brute_force.Add(scattered);
+    }
+
+    BSPTreeNode bsp_tree(objects, BSPBuildSettings{BSPSplitNormals::DATA_DRIVEN, 6});
+
+    const Point3 origins[3] = { Point3(0.0, 0.0, 5.0), Point3(3.0, 1.0, -17.0), Point3(-25.0, 3.0, -11.0) };
+    for (const Point3& origin : origins)
+    {
+        for (int ray_x = -15; ray_x <= 15; ray_x++)
+        {
+            for (int ray_y = -10; ray_y <= 10; ray_y++)
+            {
+                const Ray ray(origin, Point3(ray_x, ray_y, -16.0) - origin);
+
+                RayHitResult brute_force_result;
+                RayHitResult bsp_tree_result;
+                const bool brute_force_hit = brute_force.Hit(ray, Interval(0.001, infinity), brute_force_result);
+                const bool bsp_tree_hit = bsp_tree.Hit(ray, Interval(0.001, infinity), bsp_tree_result);
+
+                REQUIRE(bsp_tree_hit == brute_force_hit);
+                REQUIRE(bsp_tree.HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+                if (brute_force_hit)
+                {
+                    REQUIRE(bsp_tree_result.m_t == Approx(brute_force_result.m_t));
+                    REQUIRE_FALSE(bsp_tree.HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+                }
+            }
+        }
+    }
+}
+
 TEST_CASE("BSPTreeNode BoundingBox encloses all objects", "[BSPTreeNode]")
 {
     ArenaAllocator allocator(ONE_MEGABYTE);
@@ -0,0 +1,144 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/BVHBuilder.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+
+namespace ART
+{
+
+static bool BoxContains(const AABB& outer, const AABB& inner)
+{
+    for (std::size_t axis = 0; axis < 3; axis++)
+    {
+        if (inner[axis].m_min < outer[axis].m_min || inner[axis].m_max > outer[axis].m_max)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Checks tree invariants and that every object is referenced by exactly one leaf
+static void RequireValidTree(const BVHBuilder& builder, const std::vector<IRayHittable*>& objects)
+{
+    const std::vector<BVHBuildNode>& nodes = builder.GetNodes();
+    const std::vector<IRayHittable*>& ordered_objects = builder.GetOrderedObjects();
+
+    REQUIRE(ordered_objects.size() == objects.size());
+    REQUIRE(nodes.size() <= (2 * objects.size()) - 1);
+
+    bool leaves_are_small = true;
+    bool children_are_valid = true;
+    bool boxes_are_nested = true;
+    std::vector<std::size_t> times_referenced(ordered_objects.size(), 0);
+    for (std::size_t node_index = 0; node_index < nodes.size(); node_index++)
+    {
+        const BVHBuildNode& node = nodes[node_index];
+        if (node.num_primitives > 0)
+        {
+            leaves_are_small = leaves_are_small && node.num_primitives <= BVHBuilder::MAX_PRIMITIVES_PER_LEAF;
+            for (std::size_t object_index = node.offset; object_index < node.offset + node.num_primitives; object_index++)
+            {
+                times_referenced[object_index]++;
+                boxes_are_nested = boxes_are_nested && BoxContains(node.bounding_box, ordered_objects[object_index]->BoundingBox());
+            }
+        }
+        else if (node.offset + 1 < nodes.size())
+        {
+            boxes_are_nested = boxes_are_nested && BoxContains(node.bounding_box, nodes[node.offset].bounding_box);
+            boxes_are_nested = boxes_are_nested && BoxContains(node.bounding_box, nodes[node.offset + 1].bounding_box);
+        }
+        else
+        {
+            children_are_valid = false;
+        }
+    }
+
+    REQUIRE(leaves_are_small);
+    REQUIRE(children_are_valid);
+    REQUIRE(boxes_are_nested);
+    REQUIRE(std::count(times_referenced.begin(), times_referenced.end(), 1) == static_cast<std::ptrdiff_t>(times_referenced.size()));
+
+    std::vector<IRayHittable*> sorted_objects = objects;
+    std::vector<IRayHittable*> sorted_ordered_objects = ordered_objects;
+    std::sort(sorted_objects.begin(), sorted_objects.end());
+    std::sort(sorted_ordered_objects.begin(), sorted_ordered_objects.end());
+    REQUIRE(sorted_objects == sorted_ordered_objects);
+}
+
+TEST_CASE("BVHBuilder builds valid trees", "[BVHBuilder]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE * 16);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SECTION("No objects")
+    {
+        std::vector<IRayHittable*> objects;
+        BVHBuilder builder(objects);
+
+        REQUIRE(builder.GetNodes().empty());
+        REQUIRE(builder.GetOrderedObjects().empty());
+    }
+
+    SECTION("Single object is a leaf root")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(1.0, 2.0, 3.0), 0.5, material));
+        BVHBuilder builder(objects);
+
+        REQUIRE(builder.GetNodes().size() == 1);
+        REQUIRE(builder.GetNodes()[0].num_primitives == 1);
+        REQUIRE(builder.GetNodes()[0].bounding_box.m_x.m_min == Approx(0.5));
+        REQUIRE(builder.GetNodes()[0].bounding_box.m_z.m_max == Approx(3.5));
+    }
+
+    SECTION("Objects sharing a centroid fall back to median splits")
+    {
+        std::vector<IRayHittable*> objects;
+        for (std::size_t object_index = 0; object_index < 100; object_index++)
+        {
+            objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+        }
+        BVHBuilder builder(objects);
+
+        RequireValidTree(builder, objects);
+    }
+
+    SECTION("Grid of objects")
+    {
+        std::vector<IRayHittable*> objects;
+        for (int x = 0; x < 20; x++)
+        {
+            for (int y = 0; y < 20; y++)
+            {
+                objects.push_back(allocator.Create<Sphere>(Point3(x, y, (x * y) % 7), 0.4, material));
+            }
+        }
+        BVHBuilder builder(objects);
+
+        RequireValidTree(builder, objects);
+    }
+
+    SECTION("Enough objects to bin and partition in parallel")
+    {
+        std::vector<IRayHittable*> objects;
+        for (std::size_t object_index = 0; object_index < 100000; object_index++)
+        {
+            // Deterministic scatter through a 100^3 volume
+            const double x = static_cast<double>((object_index * 7919) % 100);
+            const double y = static_cast<double>((object_index * 104729) % 100);
+            const double z = static_cast<double>((object_index * 1299709) % 100);
+            objects.push_back(allocator.Create<Sphere>(Point3(x, y, z), 0.25, material));
+        }
+        BVHBuilder builder(objects);
+
+        RequireValidTree(builder, objects);
+    }
+}
+
+} // namespace ART
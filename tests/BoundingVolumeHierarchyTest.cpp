@@ -4,6 +4,7 @@
 #include <Acceleration/BoundingVolumeHierarchy.h>
 #include <Core/ArenaAllocator.h>
 #include <Core/Constants.h>
+#include <Core/Random.h>
 #include <Geometry/Sphere.h>
 #include <Materials/Material.h>
 
@@ -95,6 +96,7 @@ TEST_CASE("BVHNode Hit detects intersections", "[BVHNode]")
         const bool hit = bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), result);
 
         REQUIRE(hit == false);
+        REQUIRE_FALSE(bounding_volume_hierarchy.HitAny(ray, Interval(0.001, infinity)));
     }
 
     SECTION("Ray hits closest object among multiple")
@@ -110,6 +112,8 @@ TEST_CASE("BVHNode Hit detects intersections", "[BVHNode]")
 
         REQUIRE(hit == true);
         REQUIRE(result.m_t == Approx(2.5));
+        REQUIRE(bounding_volume_hierarchy.HitAny(ray, Interval(0.001, infinity)));
+        REQUIRE_FALSE(bounding_volume_hierarchy.HitAny(ray, Interval(0.001, 2.0)));
     }
 
     SECTION("Ray respects interval bounds")
@@ -125,6 +129,35 @@ TEST_CASE("BVHNode Hit detects intersections", "[BVHNode]")
     }
 }
 
+TEST_CASE("BVHNode Occluded counts occlusion rays apart from closest hit rays", "[BVHNode]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    for (int i = 0; i < 8; i++)
+    {
+        objects.push_back(allocator.Create<Sphere>(Point3(static_cast<double>(i) * 3.0, 0.0, -5.0), 1.0, material));
+    }
+    BVHNode bounding_volume_hierarchy(objects);
+
+    tl_traversal_counters.Reset();
+
+    const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+    REQUIRE(bounding_volume_hierarchy.Occluded(ray, Interval(0.001, infinity)));
+    REQUIRE_FALSE(bounding_volume_hierarchy.Occluded(ray, Interval(0.001, 3.0)));
+
+    REQUIRE(tl_traversal_counters.occlusion_rays_cast == 2);
+    REQUIRE(tl_traversal_counters.occlusion_nodes_traversed > 0);
+    REQUIRE(tl_traversal_counters.occlusion_intersection_tests > 0);
+    REQUIRE(tl_traversal_counters.rays_cast == 0);
+    REQUIRE(tl_traversal_counters.nodes_traversed == 0);
+    REQUIRE(tl_traversal_counters.intersection_tests == 0);
+
+    tl_traversal_counters.Reset();
+}
+
 TEST_CASE("BVHNode constructs correct tree structure", "[BVHNode]")
 {
     ArenaAllocator allocator(ONE_MEGABYTE);
@@ -182,4 +215,62 @@ TEST_CASE("BVHNode BoundingBox encloses all objects", "[BVHNode]")
     }
 }
 
+TEST_CASE("BVHNode packet hits match single ray hits", "[BVHNode]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SeedPositionRNG(7);
+
+    std::vector<IRayHittable*> objects;
+    for (int i = 0; i < 200; i++)
+    {
+        const Point3 centre(RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-30.0, -10.0));
+        objects.push_back(allocator.Create<Sphere>(centre, RandomPositionDouble(0.2, 1.5), material));
+    }
+
+    BVHNode bounding_volume_hierarchy(objects);
+
+    // An 8x8 tile of rays through a plane in front of the origin, as the camera traces them, and a packet of
+    // scattered rays whose direction signs differ
+    for (bool is_coherent : { true, false })
+    {
+        for (int tile = 0; tile < 20; tile++)
+        {
+            RayPacket packet;
+            packet.Clear();
+            const double tile_x = ((tile & 1) ? -1.0 : 0.0) + RandomPositionDouble(0.01, 0.8);
+            const double tile_y = ((tile & 2) ? -1.0 : 0.0) + RandomPositionDouble(0.01, 0.8);
+            for (int j = 0; j < 8; j++)
+            {
+                for (int i = 0; i < 8; i++)
+                {
+                    const Vec3 direction = is_coherent
+                        ? Vec3(tile_x + (i * 0.02), tile_y + (j * 0.02), -1.0)
+                        : Vec3(RandomPositionDouble(-1.0, 1.0), RandomPositionDouble(-1.0, 1.0), RandomPositionDouble(-1.0, 1.0));
+                    packet.Add(Ray(Point3(0.0), direction));
+                }
+            }
+            REQUIRE(packet.m_is_coherent == is_coherent);
+
+            RayHitResult results[RayPacket::MAX_SIZE];
+            const RayMask hit_rays = bounding_volume_hierarchy.HitPacket(packet, Interval(0.001, infinity), results);
+
+            for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
+            {
+                RayHitResult expected;
+                const bool expected_hit = bounding_volume_hierarchy.Hit(packet.m_rays[ray_index], Interval(0.001, infinity), expected);
+                REQUIRE(((hit_rays >> ray_index) & 1) == (expected_hit ? 1u : 0u));
+                if (expected_hit)
+                {
+                    REQUIRE(results[ray_index].m_t == expected.m_t);
+                    REQUIRE(results[ray_index].m_hit_object == expected.m_hit_object);
+                    REQUIRE(results[ray_index].m_normal.m_z == expected.m_normal.m_z);
+                }
+            }
+        }
+    }
+}
+
 } // namespace ART
@@ -0,0 +1,277 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/BoundingVolumeHierarchy.h>
+#include <Acceleration/FlatBoundingVolumeHierarchy.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Core/Random.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+
+namespace ART
+{
+
+TEST_CASE("FlatBVH constructs from vector of objects", "[FlatBVH]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SECTION("Single object")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -1.0), 0.5, material));
+
+        FlatBVH flat_bounding_volume_hierarchy(objects);
+        const AABB box = flat_bounding_volume_hierarchy.BoundingBox();
+
+        REQUIRE(box.m_x.m_min == Approx(-0.5));
+        REQUIRE(box.m_x.m_max == Approx(0.5));
+        REQUIRE(box.m_y.m_min == Approx(-0.5));
+        REQUIRE(box.m_y.m_max == Approx(0.5));
+        REQUIRE(box.m_z.m_min == Approx(-1.5));
+        REQUIRE(box.m_z.m_max == Approx(-0.5));
+        REQUIRE(flat_bounding_volume_hierarchy.GetNodes().size() == 1);
+    }
+
+    SECTION("Multiple objects")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -1.0), 0.5, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(2.0, 0.0, -1.0), 0.5, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(1.0, 1.0, -1.0), 0.5, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(-1.0, -1.0, -1.0), 0.5, material));
+
+        FlatBVH flat_bounding_volume_hierarchy(objects);
+        const AABB box = flat_bounding_volume_hierarchy.BoundingBox();
+
+        REQUIRE(box.m_x.m_min == Approx(-1.5));
+        REQUIRE(box.m_x.m_max == Approx(2.5));
+        REQUIRE(box.m_y.m_min == Approx(-1.5));
+        REQUIRE(box.m_y.m_max == Approx(1.5));
+        REQUIRE(flat_bounding_volume_hierarchy.GetPrimitives().size() == 4);
+    }
+}
+
+TEST_CASE("FlatBVH Hit detects intersections", "[FlatBVH]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+
+    SECTION("Ray hits single object")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+
+        FlatBVH flat_bounding_volume_hierarchy(objects);
+        RayHitResult result;
+        const bool hit = flat_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), result);
+
+        REQUIRE(hit == true);
+        REQUIRE(result.m_t == Approx(4.0));
+    }
+
+    SECTION("Ray misses all objects")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(10.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(-10.0, 0.0, -5.0), 1.0, material));
+
+        FlatBVH flat_bounding_volume_hierarchy(objects);
+        RayHitResult result;
+        const bool hit = flat_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), result);
+
+        REQUIRE(hit == false);
+    }
+
+    SECTION("Ray hits closest object among multiple")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -10.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -3.0), 0.5, material));
+
+        FlatBVH flat_bounding_volume_hierarchy(objects);
+        RayHitResult result;
+        const bool hit = flat_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), result);
+
+        REQUIRE(hit == true);
+        REQUIRE(result.m_t == Approx(2.5));
+    }
+
+    SECTION("Ray respects interval bounds")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+
+        FlatBVH flat_bounding_volume_hierarchy(objects);
+        RayHitResult result;
+
+        const bool hit = flat_bounding_volume_hierarchy.Hit(ray, Interval(10.0, infinity), result);
+        REQUIRE(hit == false);
+    }
+}
+
+TEST_CASE("FlatBVH matches BVHNode results", "[FlatBVH]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int y = -5; y <= 5; y++)
+        {
+            const double z = -10.0 - static_cast<double>((x * 7 + y * 3) % 5);
+            const double radius = 0.3 + 0.02 * static_cast<double>((x + y + 10) % 7);
+            objects.push_back(allocator.Create<Sphere>(Point3(x, y, z), radius, material));
+        }
+    }
+
+    std::vector<IRayHittable*> objects_copy = objects;
+    BVHNode bounding_volume_hierarchy(objects_copy);
+    FlatBVH flat_bounding_volume_hierarchy(objects);
+
+    SECTION("Nodes are stored in depth-first order")
+    {
+        const std::vector<FlatBVHNode>& nodes = flat_bounding_volume_hierarchy.GetNodes();
+        for (std::size_t node_index = 0; node_index < nodes.size(); node_index++)
+        {
+            if (nodes[node_index].num_primitives == 0)
+            {
+                REQUIRE(nodes[node_index].offset > node_index + 1);
+                REQUIRE(nodes[node_index].offset < nodes.size());
+            }
+        }
+    }
+
+    SECTION("Closest hits agree for a fan of rays")
+    {
+        for (int ray_x = -30; ray_x <= 30; ray_x++)
+        {
+            for (int ray_y = -30; ray_y <= 30; ray_y++)
+            {
+                const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(ray_x * 0.02, ray_y * 0.02, -1.0));
+
+                RayHitResult bvh_result;
+                RayHitResult flat_bvh_result;
+                const bool bvh_hit = bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), bvh_result);
+                const bool flat_bvh_hit = flat_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), flat_bvh_result);
+
+                REQUIRE(bvh_hit == flat_bvh_hit);
+                REQUIRE(flat_bounding_volume_hierarchy.HitAny(ray, Interval(0.001, infinity)) == bvh_hit);
+                if (bvh_hit)
+                {
+                    REQUIRE(flat_bvh_result.m_t == Approx(bvh_result.m_t));
+                    REQUIRE_FALSE(flat_bounding_volume_hierarchy.HitAny(ray, Interval(0.001, 0.999 * bvh_result.m_t)));
+                }
+            }
+        }
+    }
+
+    SECTION("Memory usage is reported")
+    {
+        REQUIRE(flat_bounding_volume_hierarchy.MemoryUsedBytes() >= sizeof(FlatBVHNode) * flat_bounding_volume_hierarchy.GetNodes().size());
+    }
+}
+
+TEST_CASE("FlatBVH stores the child lower on the split axis first", "[FlatBVH]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SeedPositionRNG(7);
+
+    std::vector<IRayHittable*> objects;
+    for (int i = 0; i < 500; i++)
+    {
+        const Point3 centre(RandomPositionDouble(-20.0, 20.0), RandomPositionDouble(-20.0, 20.0), RandomPositionDouble(-20.0, 20.0));
+        objects.push_back(allocator.Create<Sphere>(centre, RandomPositionDouble(0.1, 1.0), material));
+    }
+
+    FlatBVH flat_bounding_volume_hierarchy(objects);
+
+    // Traversal visits the second child first exactly for rays heading down the split axis
+    const std::vector<FlatBVHNode>& nodes = flat_bounding_volume_hierarchy.GetNodes();
+    for (std::size_t node_index = 0; node_index < nodes.size(); node_index++)
+    {
+        const FlatBVHNode& node = nodes[node_index];
+        if (node.num_primitives > 0)
+        {
+            continue;
+        }
+
+        const std::size_t axis = node.split_axis;
+        const FlatBVHNode& first_child = nodes[node_index + 1];
+        const FlatBVHNode& second_child = nodes[node.offset];
+        const double first_centre = static_cast<double>(first_child.bounds_min[axis]) + static_cast<double>(first_child.bounds_max[axis]);
+        const double second_centre = static_cast<double>(second_child.bounds_min[axis]) + static_cast<double>(second_child.bounds_max[axis]);
+        REQUIRE(first_centre <= second_centre);
+    }
+}
+
+TEST_CASE("FlatBVH packet hits match single ray hits", "[FlatBVH]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SeedPositionRNG(7);
+
+    std::vector<IRayHittable*> objects;
+    for (int i = 0; i < 200; i++)
+    {
+        const Point3 centre(RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-30.0, -10.0));
+        objects.push_back(allocator.Create<Sphere>(centre, RandomPositionDouble(0.2, 1.5), material));
+    }
+
+    FlatBVH flat_bounding_volume_hierarchy(objects);
+
+    // An 8x8 tile of rays through a plane in front of the origin, as the camera traces them, and a packet of
+    // scattered rays whose direction signs differ
+    for (bool is_coherent : { true, false })
+    {
+        for (int tile = 0; tile < 20; tile++)
+        {
+            RayPacket packet;
+            packet.Clear();
+            const double tile_x = ((tile & 1) ? -1.0 : 0.0) + RandomPositionDouble(0.01, 0.8);
+            const double tile_y = ((tile & 2) ? -1.0 : 0.0) + RandomPositionDouble(0.01, 0.8);
+            for (int j = 0; j < 8; j++)
+            {
+                for (int i = 0; i < 8; i++)
+                {
+                    const Vec3 direction = is_coherent
+                        ? Vec3(tile_x + (i * 0.02), tile_y + (j * 0.02), -1.0)
+                        : Vec3(RandomPositionDouble(-1.0, 1.0), RandomPositionDouble(-1.0, 1.0), RandomPositionDouble(-1.0, 1.0));
+                    packet.Add(Ray(Point3(0.0), direction));
+                }
+            }
+            REQUIRE(packet.m_is_coherent == is_coherent);
+
+            RayHitResult results[RayPacket::MAX_SIZE];
+            const RayMask hit_rays = flat_bounding_volume_hierarchy.HitPacket(packet, Interval(0.001, infinity), results);
+
+            for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
+            {
+                RayHitResult expected;
+                const bool expected_hit = flat_bounding_volume_hierarchy.Hit(packet.m_rays[ray_index], Interval(0.001, infinity), expected);
+                REQUIRE(((hit_rays >> ray_index) & 1) == (expected_hit ? 1u : 0u));
+                if (expected_hit)
+                {
+                    REQUIRE(results[ray_index].m_t == expected.m_t);
+                    REQUIRE(results[ray_index].m_hit_object == expected.m_hit_object);
+                    REQUIRE(results[ray_index].m_normal.m_z == expected.m_normal.m_z);
+                }
+            }
+        }
+    }
+}
+
+} // namespace ART
@@ -0,0 +1,149 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/GridBuilder.h>
+#include <Core/ArenaAllocator.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+
+namespace ART
+{
+
+TEST_CASE("GridBuilder ExclusiveScan computes offsets", "[GridBuilder]")
+{
+    SECTION("Small input")
+    {
+        std::vector<std::size_t> values = { 3, 0, 2, 5, 1 };
+        const std::size_t total = GridBuilder::ExclusiveScan(values.data(), values.size());
+
+        REQUIRE(total == 11);
+        REQUIRE(values == std::vector<std::size_t>{ 0, 3, 3, 5, 10 });
+    }
+
+    SECTION("Empty input")
+    {
+        REQUIRE(GridBuilder::ExclusiveScan(nullptr, 0) == 0);
+    }
+
+    SECTION("Input spanning several chunks")
+    {
+        const std::size_t count = GridBuilder::MIN_CHUNK_SIZE * 5 + 17;
+        std::vector<std::size_t> values(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            values[i] = i % 7;
+        }
+
+        std::vector<std::size_t> expected(count);
+        std::size_t running_sum = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            expected[i] = running_sum;
+            running_sum += values[i];
+        }
+
+        REQUIRE(GridBuilder::ExclusiveScan(values.data(), count) == running_sum);
+        REQUIRE(values == expected);
+    }
+}
+
+TEST_CASE("GridBuilder CellRange clamps to the grid", "[GridBuilder]")
+{
+    const AABB grid_bounds(Point3(0.0, 0.0, 0.0), Point3(10.0, 10.0, 10.0));
+    const Vec3Int num_cells(10, 5, 2);
+    Vec3Int range_min;
+    Vec3Int range_max;
+
+    GridBuilder::CellRange(AABB(Point3(2.5, 2.5, 2.5), Point3(3.5, 6.5, 7.5)), grid_bounds, num_cells, range_min, range_max);
+    REQUIRE((range_min.m_x == 2 && range_min.m_y == 1 && range_min.m_z == 0));
+    REQUIRE((range_max.m_x == 3 && range_max.m_y == 3 && range_max.m_z == 1));
+
+    // Far outside the grid on both sides
+    GridBuilder::CellRange(AABB(Point3(-1.0e30, -5.0, 9.9), Point3(1.0e30, -1.0, 1.0e30)), grid_bounds, num_cells, range_min, range_max);
+    REQUIRE((range_min.m_x == 0 && range_min.m_y == 0 && range_min.m_z == 1));
+    REQUIRE((range_max.m_x == 9 && range_max.m_y == 0 && range_max.m_z == 1));
+}
+
+TEST_CASE("GridBuilder LimitReferences coarsens grids of overlapping objects", "[GridBuilder]")
+{
+    const AABB grid_bounds(Point3(0.0, 0.0, 0.0), Point3(16.0, 16.0, 16.0));
+
+    // Every object covers the whole grid
+    std::vector<AABB> large_bounding_boxes(10, grid_bounds);
+    REQUIRE(GridBuilder::CountReferences(large_bounding_boxes, grid_bounds, Vec3Int(4, 4, 4)) == 640);
+
+    const Vec3Int large_limited = GridBuilder::LimitReferences(large_bounding_boxes, grid_bounds, Vec3Int(8, 8, 4), 8.0);
+    REQUIRE((large_limited.m_x == 2 && large_limited.m_y == 2 && large_limited.m_z == 1));
+
+    // Small objects already within the limit keep their resolution
+    std::vector<AABB> small_bounding_boxes;
+    for (int i = 0; i < 16; i++)
+    {
+        small_bounding_boxes.push_back(AABB(Point3(i + 0.25, i + 0.25, i + 0.25), Point3(i + 0.75, i + 0.75, i + 0.75)));
+    }
+    const Vec3Int small_limited = GridBuilder::LimitReferences(small_bounding_boxes, grid_bounds, Vec3Int(16, 16, 16), 1.0);
+    REQUIRE((small_limited.m_x == 16 && small_limited.m_y == 16 && small_limited.m_z == 16));
+}
+
+TEST_CASE("GridBuilder BinObjects matches serial binning", "[GridBuilder]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    for (int i = 0; i < 5000; i++)
+    {
+        const double x = static_cast<double>((i * 37) % 101);
+        const double y = static_cast<double>((i * 53) % 89);
+        const double z = static_cast<double>((i * 71) % 97);
+        const double radius = 0.2 + static_cast<double>(i % 9);
+        objects.push_back(allocator.Create<Sphere>(Point3(x, y, z), radius, material));
+    }
+
+    std::vector<AABB> bounding_boxes;
+    const AABB grid_bounds = GridBuilder::ComputeBounds(objects, bounding_boxes);
+    REQUIRE(bounding_boxes.size() == objects.size());
+
+    AABB expected_bounds;
+    for (IRayHittable* object : objects)
+    {
+        expected_bounds = AABB(expected_bounds, object->BoundingBox());
+    }
+    REQUIRE(grid_bounds.m_x.m_min == expected_bounds.m_x.m_min);
+    REQUIRE(grid_bounds.m_y.m_max == expected_bounds.m_y.m_max);
+    REQUIRE(grid_bounds.m_z.m_max == expected_bounds.m_z.m_max);
+
+    const Vec3Int num_cells(13, 11, 7);
+    GridBins bins;
+    GridBuilder::BinObjects(bounding_boxes, grid_bounds, num_cells, bins);
+
+    const std::size_t num_grid_cells = static_cast<std::size_t>(num_cells.m_x * num_cells.m_y * num_cells.m_z);
+    std::vector<std::vector<uint32_t>> expected_cells(num_grid_cells);
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    {
+        Vec3Int range_min;
+        Vec3Int range_max;
+        GridBuilder::CellRange(bounding_boxes[object_index], grid_bounds, num_cells, range_min, range_max);
+        for (int x = range_min.m_x; x <= range_max.m_x; x++)
+        {
+            for (int y = range_min.m_y; y <= range_max.m_y; y++)
+            {
+                for (int z = range_min.m_z; z <= range_max.m_z; z++)
+                {
+                    expected_cells[(x * num_cells.m_y * num_cells.m_z) + (y * num_cells.m_z) + z].push_back(static_cast<uint32_t>(object_index));
+                }
+            }
+        }
+    }
+
+    REQUIRE(bins.cell_offsets.size() == num_grid_cells + 1);
+    REQUIRE(bins.cell_offsets[num_grid_cells] == bins.object_indices.size());
+    for (std::size_t cell_index = 0; cell_index < num_grid_cells; cell_index++)
+    {
+        const std::vector<uint32_t> cell_objects(bins.object_indices.begin() + bins.cell_offsets[cell_index], bins.object_indices.begin() + bins.cell_offsets[cell_index + 1]);
+        REQUIRE(cell_objects == expected_cells[cell_index]);
+    }
+}
+
+} // namespace ART
@@ -0,0 +1,247 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <algorithm>
+
+#include <Acceleration/HashedGrid.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Core/TraversalStats.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+#include <RayTracing/RayHittableList.h>
+
+namespace ART
+{
+
+TEST_CASE("HashedGrid Hit detects intersections", "[HashedGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SECTION("Empty grid never hits")
+    {
+        std::vector<IRayHittable*> objects;
+        HashedGrid hashed_grid(objects);
+
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+        REQUIRE(hashed_grid.Hit(ray, Interval(0.001, infinity), result) == false);
+        REQUIRE(hashed_grid.MemoryUsedBytes() == 0);
+    }
+
+    SECTION("Ray hits closest object among multiple")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -10.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0,  -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0,  -3.0), 0.5, material));
+
+        HashedGrid hashed_grid(objects);
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+
+        REQUIRE(hashed_grid.Hit(ray, Interval(0.001, infinity), result) == true);
+        REQUIRE(result.m_t == Approx(2.5));
+    }
+
+    SECTION("Ray respects interval bounds")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(3.0, 0.0, -5.0), 1.0, material));
+
+        HashedGrid hashed_grid(objects);
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+
+        REQUIRE(hashed_grid.Hit(ray, Interval(10.0, infinity), result) == false);
+        REQUIRE(hashed_grid.Hit(ray, Interval(0.001, 3.0), result) == false);
+    }
+}
+
+TEST_CASE("HashedGrid stores only occupied cells", "[HashedGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Two identical clusters, only their separation differs
+    auto create_clusters = [&](double separation)
+    {
+        std::vector<IRayHittable*> objects;
+        for (const double cluster_x : { 0.0, separation })
+        {
+            for (int x = 0; x < 5; x++)
+            {
+                for (int y = 0; y < 5; y++)
+                {
+                    for (int z = 0; z < 5; z++)
+                    {
+                        objects.push_back(allocator.Create<Sphere>(Point3(cluster_x + x * 3.0, y * 3.0, z * 3.0), 1.0, material));
+                    }
+                }
+            }
+        }
+        return objects;
+    };
+
+    std::vector<IRayHittable*> near_objects = create_clusters(100.0);
+    std::vector<IRayHittable*> far_objects = create_clusters(100000.0);
+    HashedGrid near_grid(near_objects);
+    HashedGrid far_grid(far_objects);
+
+    REQUIRE(near_grid.GetCellSize() == Approx(4.0));
+    REQUIRE(far_grid.GetCellSize() == Approx(4.0));
+    REQUIRE(near_grid.GetNumOccupiedCells() > 0);
+    REQUIRE(near_grid.GetNumOccupiedCells() == far_grid.GetNumOccupiedCells());
+    REQUIRE(near_grid.GetNumOccupiedBlocks() <= far_grid.GetNumOccupiedBlocks() + 2);
+    REQUIRE(near_grid.MemoryUsedBytes() == far_grid.MemoryUsedBytes());
+
+    SECTION("Empty space between clusters costs one step per block")
+    {
+        const Ray ray(Point3(-10.0, 6.0, 6.0), Vec3(1.0, 0.0, 0.0));
+        RayHitResult result;
+
+        tl_traversal_counters.Reset();
+        REQUIRE(far_grid.Hit(ray, Interval(0.001, infinity), result) == true);
+        REQUIRE(result.m_t == Approx(9.0));
+        // Far fewer steps than the 25000 cells between the clusters
+        REQUIRE(tl_traversal_counters.nodes_traversed < 50);
+
+        const Ray ray_between(Point3(-10.0, 7.5, 7.5), Vec3(1.0, 0.0, 0.0));
+        tl_traversal_counters.Reset();
+        REQUIRE(far_grid.Hit(ray_between, Interval(0.001, infinity), result) == false);
+        REQUIRE(tl_traversal_counters.nodes_traversed < 5000);
+        tl_traversal_counters.Reset();
+    }
+}
+
+TEST_CASE("HashedGrid moves large objects to coarser levels", "[HashedGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    IRayHittable* ground = allocator.Create<Sphere>(Point3(0.0, -1000.0, 0.0), 999.0, material);
+    objects.push_back(ground);
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int z = -5; z <= 5; z++)
+        {
+            objects.push_back(allocator.Create<Sphere>(Point3(x * 2.0, 0.5, z * 2.0), 0.4, material));
+        }
+    }
+
+    // Between the small spheres, down onto the ground
+    const Ray ray(Point3(1.0, 5.0, 1.0), Vec3(0.0, -1.0, 0.0));
+    const double ground_t = 5.0 + 1000.0 - std::sqrt((999.0 * 999.0) - 2.0);
+
+    SECTION("Ground is kept out of the finest level")
+    {
+        HashedGrid hashed_grid(objects);
+        REQUIRE(hashed_grid.GetLargeObjects().empty());
+
+        // ground is objects[0]
+        const std::vector<HashedGridLevel>& levels = hashed_grid.GetLevels();
+        const PrimitiveId ground_id = hashed_grid.GetPrimitiveStore().GetId(0);
+        REQUIRE(levels.size() == 2);
+        REQUIRE(levels[0].cell_size == hashed_grid.GetCellSize());
+        REQUIRE(std::find(levels[0].objects.begin(), levels[0].objects.end(), ground_id) == levels[0].objects.end());
+        REQUIRE(levels[1].cell_size > levels[0].cell_size);
+        REQUIRE(levels[1].objects.size() == levels[1].num_occupied_cells);
+        REQUIRE(std::count(levels[1].objects.begin(), levels[1].objects.end(), ground_id) == static_cast<std::ptrdiff_t>(levels[1].objects.size()));
+
+        RayHitResult result;
+        REQUIRE(hashed_grid.Hit(ray, Interval(0.001, infinity), result) == true);
+        REQUIRE(result.m_t == Approx(ground_t));
+        REQUIRE(hashed_grid.HitAny(ray, Interval(0.001, infinity)));
+    }
+
+    SECTION("Objects too large for the coarsest level are tested by every ray")
+    {
+        IRayHittable* planet = allocator.Create<Sphere>(Point3(0.0, -2000000.0, 0.0), 1000000.0, material);
+        objects.push_back(planet);
+
+        HashedGrid hashed_grid(objects);
+        REQUIRE(hashed_grid.GetLargeObjects().size() == 1);
+        REQUIRE(hashed_grid.GetLargeObjects()[0] == hashed_grid.GetPrimitiveStore().GetId(objects.size() - 1));
+
+        RayHitResult result;
+        REQUIRE(hashed_grid.Hit(ray, Interval(0.001, infinity), result) == true);
+        REQUIRE(result.m_t == Approx(ground_t));
+
+        // Clear of the ground, down onto the planet
+        const Ray planet_ray(Point3(5000.0, 0.0, 0.0), Vec3(0.0, -1.0, 0.0));
+        REQUIRE(hashed_grid.Hit(planet_ray, Interval(0.001, infinity), result) == true);
+        REQUIRE(result.m_t == Approx(2000000.0 - std::sqrt(1.0e12 - (5000.0 * 5000.0))));
+        REQUIRE(result.m_hit_object == planet);
+        REQUIRE(hashed_grid.HitAny(planet_ray, Interval(0.001, infinity)));
+    }
+}
+
+TEST_CASE("HashedGrid matches brute force results", "[HashedGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    RayHittableList brute_force;
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int y = -5; y <= 5; y++)
+        {
+            const double z = -10.0 - static_cast<double>((x * 7 + y * 3 + 50) % 5);
+            const double radius = 0.1 + 0.4 * static_cast<double>((x + y + 10) % 7);
+            IRayHittable* sphere = allocator.Create<Sphere>(Point3(x, y, z), radius, material);
+            objects.push_back(sphere);
+            brute_force.Add(sphere);
+        }
+    }
+
+    // A distant cluster leaves most of the grid empty
+    for (int x = 0; x < 4; x++)
+    {
+        IRayHittable* sphere = allocator.Create<Sphere>(Point3(200.0 + x, 50.0, -80.0), 0.5, material);
+        objects.push_back(sphere);
+        brute_force.Add(sphere);
+    }
+
+    HashedGrid hashed_grid(objects);
+
+    const Point3 origins[3] = { Point3(0.0, 0.0, 0.0), Point3(3.0, -2.0, -12.0), Point3(-20.0, 1.0, -11.0) };
+    for (const Point3& origin : origins)
+    {
+        for (int ray_x = -20; ray_x <= 20; ray_x++)
+        {
+            for (int ray_y = -20; ray_y <= 20; ray_y++)
+            {
+                const Ray ray(origin, Point3(ray_x * 0.3, ray_y * 0.3, -12.0) - origin);
+
+                RayHitResult brute_force_result;
+                RayHitResult hashed_grid_result;
+                const bool brute_force_hit = brute_force.Hit(ray, Interval(0.001, infinity), brute_force_result);
+                const bool hashed_grid_hit = hashed_grid.Hit(ray, Interval(0.001, infinity), hashed_grid_result);
+
+                REQUIRE(hashed_grid_hit == brute_force_hit);
+                REQUIRE(hashed_grid.HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+                if (brute_force_hit)
+                {
+                    REQUIRE(hashed_grid_result.m_t == Approx(brute_force_result.m_t));
+                    REQUIRE_FALSE(hashed_grid.HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+                }
+            }
+        }
+    }
+
+    // Axis-aligned rays towards the distant cluster
+    const Ray axis_ray(Point3(150.0, 50.0, -80.0), Vec3(1.0, 0.0, 0.0));
+    RayHitResult result;
+    REQUIRE(hashed_grid.Hit(axis_ray, Interval(0.001, infinity), result) == true);
+    REQUIRE(result.m_t == Approx(49.5));
+}
+
+} // namespace ART
@@ -5,6 +5,7 @@
 #include <Acceleration/UniformGrid.h>
 #include <Core/ArenaAllocator.h>
 #include <Core/Constants.h>
+#include <Core/TraversalStats.h>
 #include <Geometry/Sphere.h>
 #include <Materials/Material.h>
 
@@ -153,9 +154,11 @@ TEST_CASE("HierarchicalUniformGrid produces the same closest hit as UniformGrid"
         const bool did_ray_hit_hierarchical_uniform_grid = hierarchical_grid.Hit(ray, Interval(0.001, infinity), hierarchical_result);
 
         REQUIRE(did_ray_hit_uniform_grid == did_ray_hit_hierarchical_uniform_grid);
+        REQUIRE(hierarchical_grid.HitAny(ray, Interval(0.001, infinity)) == did_ray_hit_uniform_grid);
         if (did_ray_hit_uniform_grid)
         {
             REQUIRE(hierarchical_result.m_t == Approx(uniform_result.m_t));
+            REQUIRE_FALSE(hierarchical_grid.HitAny(ray, Interval(0.001, 0.999 * uniform_result.m_t)));
         }
     }
 }
@@ -239,4 +242,42 @@ TEST_CASE("HierarchicalUniformGrid BoundingBox encloses all objects", "[Hierarch
     REQUIRE(box.m_z.m_max >= 6.0);
 }
 
+TEST_CASE("HierarchicalUniformGrid tests each object at most once per ray", "[HierarchicalUniformGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Large overlapping spheres, each spans every cell of the grid
+    std::vector<IRayHittable*> objects;
+    for (int x = 0; x < 10; x++)
+    {
+        for (int y = 0; y < 10; y++)
+        {
+            for (int z = 0; z < 10; z++)
+            {
+                objects.push_back(allocator.Create<Sphere>(Point3(x * 0.2 - 1.0, y * 0.2 - 1.0, z * 0.2 - 1.0), 20.0, material));
+            }
+        }
+    }
+
+    HierarchicalUniformGrid grid(objects);
+
+    // Passes through a corner of the grid, crossing several cells without hitting any sphere
+    const Ray ray(Point3(19.0, 19.0, 30.0), Vec3(-0.02, -0.02, -1.0));
+    RayHitResult result;
+
+    tl_traversal_counters.Reset();
+    REQUIRE(grid.Hit(ray, Interval(0.001, infinity), result) == false);
+    REQUIRE(tl_traversal_counters.nodes_traversed > 1);
+    REQUIRE(tl_traversal_counters.intersection_tests == objects.size());
+
+    // A second ray gets a new mailbox query
+    tl_traversal_counters.Reset();
+    REQUIRE(grid.Hit(ray, Interval(0.001, infinity), result) == false);
+    REQUIRE(tl_traversal_counters.intersection_tests == objects.size());
+
+    tl_traversal_counters.Reset();
+}
+
 } // namespace ART
@@ -1,6 +1,8 @@
 // Copyright Mia Rolfe. All rights reserved.
 #include <Catch2/catch.hpp>
 
+#include <algorithm>
+
 #include <Acceleration/KDTree.h>
 #include <Core/ArenaAllocator.h>
 #include <Core/Constants.h>
@@ -114,10 +116,10 @@ TEST_CASE("KDTreeNode Hit detects intersections", "[KDTreeNode]")
     }
 }
 
-TEST_CASE("KDTreeNode Hit uses SplitLongestAxis fallback when all centroids are in the same plane", "[KDTreeNode]")
+TEST_CASE("KDTreeNode makes a single leaf when all centroids are coplanar", "[KDTreeNode]")
 {
-    // Place all sphere centroids at the same point on every axis (within fp_tolerance, 1e-10)
-    // SplitSAH will compute extent < 1e-10 for all 3 axes and skip them, falling back to SplitLongestAxis
+    // Place all sphere centroids at the same point on every axis (within 1e-12)
+    // No split plane separates them, so every candidate costs more than a leaf
     ArenaAllocator allocator(ONE_MEGABYTE);
     Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
     Material* material = allocator.Create<LambertianMaterial>(texture);
@@ -125,13 +127,17 @@ TEST_CASE("KDTreeNode Hit uses SplitLongestAxis fallback when all centroids are
     std::vector<IRayHittable*> objects;
     for (int i = 0; i < 10; i++)
     {
-        // All centroids within 1e-12 of (0, 0, -5) — well below the 1e-10 tolerance
+        // All centroids within 1e-12 of (0, 0, -5)
         const double sub_tolerance_offset = static_cast<double>(i) * 1e-12;
         objects.push_back(allocator.Create<Sphere>(Point3(sub_tolerance_offset, 0.0, -5.0), 0.5, material));
     }
 
     KDTreeNode kd_tree(objects);
 
+    REQUIRE(kd_tree.GetNodes().size() == 1);
+    REQUIRE(kd_tree.GetNodes()[0].IsLeaf());
+    REQUIRE(kd_tree.GetNodes()[0].NumPrimitives() == objects.size());
+
     // Ray aimed at the cluster must hit
     {
         const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
@@ -152,7 +158,7 @@ TEST_CASE("KDTreeNode Hit uses SplitLongestAxis fallback when all centroids are
 TEST_CASE("KDTreeNode Hit traverses in correct order for negative-direction ray (should_swap_child_order)", "[KDTreeNode]")
 {
     // After SAH splits along an axis (x in this case, objects are spread along x)
-    // ray going -x satisfies (ray_direction_along_axis < 0) so should_swap_order = true
+    // ray starting above every split plane and going -x visits the child above each plane first
     ArenaAllocator allocator(ONE_MEGABYTE);
     Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
     Material* material = allocator.Create<LambertianMaterial>(texture);
@@ -213,4 +219,142 @@ TEST_CASE("KDTreeNode BoundingBox encloses all objects", "[KDTreeNode]")
     REQUIRE(box.m_z.m_max >= 6.0);
 }
 
+TEST_CASE("KDTreeNode references straddling primitives from both sides of a split", "[KDTreeNode]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Row of small spheres along x, with one large sphere overlapping all of them
+    std::vector<IRayHittable*> objects;
+    for (int i = -10; i <= 10; i++)
+    {
+        objects.push_back(allocator.Create<Sphere>(Point3(static_cast<double>(i), 0.0, -5.0), 0.25, material));
+    }
+    objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 4.0, material));
+
+    KDTreeNode kd_tree(objects);
+
+    REQUIRE(kd_tree.GetNodes().size() > 1);
+    REQUIRE(kd_tree.GetPrimitives().size() > objects.size());
+
+    // Every object is referenced by at least one leaf
+    const std::vector<PrimitiveId>& primitives = kd_tree.GetPrimitives();
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    {
+        const PrimitiveId id = kd_tree.GetPrimitiveStore().GetId(object_index);
+        REQUIRE(std::find(primitives.begin(), primitives.end(), id) != primitives.end());
+    }
+}
+
+TEST_CASE("KDTreeNode cuts off empty space", "[KDTreeNode]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Two tight clusters far apart
+    std::vector<IRayHittable*> objects;
+    for (int i = 0; i < 8; i++)
+    {
+        const double offset = 0.1 * static_cast<double>(i);
+        objects.push_back(allocator.Create<Sphere>(Point3(-50.0 + offset, offset, -5.0), 0.5, material));
+        objects.push_back(allocator.Create<Sphere>(Point3( 50.0 - offset, offset, -5.0), 0.5, material));
+    }
+
+    KDTreeNode kd_tree(objects);
+
+    std::size_t num_empty_leaves = 0;
+    for (const FlatKDTreeNode& node : kd_tree.GetNodes())
+    {
+        if (node.IsLeaf() && node.NumPrimitives() == 0)
+        {
+            num_empty_leaves++;
+        }
+    }
+    REQUIRE(num_empty_leaves > 0);
+
+    // Ray through the gap between the clusters must miss
+    const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+    RayHitResult result;
+    REQUIRE(kd_tree.Hit(ray, Interval(0.001, infinity), result) == false);
+}
+
+TEST_CASE("KDTreeNode matches brute force closest hits", "[KDTreeNode]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Overlapping spheres of varying size, so many straddle split planes
+    std::vector<IRayHittable*> objects;
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int y = -5; y <= 5; y++)
+        {
+            const double z = -10.0 - static_cast<double>((x * 7 + y * 3 + 50) % 5);
+            const double radius = 0.3 + 0.15 * static_cast<double>((x + y + 10) % 7);
+            objects.push_back(allocator.Create<Sphere>(Point3(x, y, z), radius, material));
+        }
+    }
+
+    KDTreeNode kd_tree(objects);
+
+    SECTION("Nodes are stored in depth-first order")
+    {
+        const std::vector<FlatKDTreeNode>& nodes = kd_tree.GetNodes();
+        for (std::size_t node_index = 0; node_index < nodes.size(); node_index++)
+        {
+            if (!nodes[node_index].IsLeaf())
+            {
+                REQUIRE(nodes[node_index].SplitAxis() < 3);
+                REQUIRE(nodes[node_index].offset > node_index + 1);
+                REQUIRE(nodes[node_index].offset < nodes.size());
+            }
+            else
+            {
+                REQUIRE(nodes[node_index].offset + nodes[node_index].NumPrimitives() <= kd_tree.GetPrimitives().size());
+            }
+        }
+    }
+
+    SECTION("Closest hits agree for rays from several origins")
+    {
+        const Point3 origins[3] = { Point3(0.0, 0.0, 0.0), Point3(3.0, -2.0, -12.0), Point3(-20.0, 1.0, -11.0) };
+        for (const Point3& origin : origins)
+        {
+            for (int ray_x = -20; ray_x <= 20; ray_x++)
+            {
+                for (int ray_y = -20; ray_y <= 20; ray_y++)
+                {
+                    const Ray ray(origin, Point3(ray_x * 0.3, ray_y * 0.3, -12.0) - origin);
+
+                    RayHitResult brute_force_result;
+                    bool brute_force_hit = false;
+                    double closest_so_far = infinity;
+                    for (IRayHittable* object : objects)
+                    {
+                        if (object->Hit(ray, Interval(0.001, closest_so_far), brute_force_result))
+                        {
+                            brute_force_hit = true;
+                            closest_so_far = brute_force_result.m_t;
+                        }
+                    }
+
+                    RayHitResult kd_tree_result;
+                    const bool kd_tree_hit = kd_tree.Hit(ray, Interval(0.001, infinity), kd_tree_result);
+
+                    REQUIRE(kd_tree_hit == brute_force_hit);
+                    REQUIRE(kd_tree.HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+                    if (brute_force_hit)
+                    {
+                        REQUIRE(kd_tree_result.m_t == Approx(brute_force_result.m_t));
+                        REQUIRE_FALSE(kd_tree.HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+                    }
+                }
+            }
+        }
+    }
+}
+
 } // namespace ART
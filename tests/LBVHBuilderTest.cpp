@@ -0,0 +1,121 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/LBVHBuilder.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+
+namespace ART
+{
+
+TEST_CASE("LBVHBuilder MortonCode interleaves coordinate bits", "[LBVHBuilder]")
+{
+    REQUIRE(LBVHBuilder::MortonCode(0, 0, 0) == 0);
+    REQUIRE(LBVHBuilder::MortonCode(0, 0, 1) == 0b001);
+    REQUIRE(LBVHBuilder::MortonCode(0, 1, 0) == 0b010);
+    REQUIRE(LBVHBuilder::MortonCode(1, 0, 0) == 0b100);
+    REQUIRE(LBVHBuilder::MortonCode(3, 0, 0) == 0b100100);
+    REQUIRE(LBVHBuilder::MortonCode(0x1fffff, 0x1fffff, 0x1fffff) == 0x7fffffffffffffff);
+}
+
+TEST_CASE("LBVHBuilder RadixSort sorts stably by Morton code", "[LBVHBuilder]")
+{
+    std::vector<MortonPrimitive> primitives(50000);
+    for (std::size_t primitive_index = 0; primitive_index < primitives.size(); primitive_index++)
+    {
+        // Few distinct codes so stability is exercised, spread over high and low digits
+        const uint64_t code = (primitive_index * 2654435761u) % 97;
+        primitives[primitive_index].morton_code = (code << 40) | (code * 3);
+        primitives[primitive_index].object_index = static_cast<uint32_t>(primitive_index);
+    }
+
+    LBVHBuilder::RadixSort(primitives);
+
+    bool is_sorted = true;
+    for (std::size_t primitive_index = 1; primitive_index < primitives.size(); primitive_index++)
+    {
+        const MortonPrimitive& previous = primitives[primitive_index - 1];
+        const MortonPrimitive& current = primitives[primitive_index];
+        is_sorted = is_sorted && (previous.morton_code < current.morton_code || (previous.morton_code == current.morton_code && previous.object_index < current.object_index));
+    }
+    REQUIRE(is_sorted);
+}
+
+TEST_CASE("LBVHBuilder builds valid trees", "[LBVHBuilder]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+
+    SECTION("No objects")
+    {
+        LBVHBuilder builder(objects, false);
+        REQUIRE(builder.GetNodes().empty());
+    }
+
+    SECTION("Single object")
+    {
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -1.0), 0.5, material));
+        LBVHBuilder builder(objects, true);
+
+        REQUIRE(builder.GetNodes().size() == 1);
+        REQUIRE(builder.GetNodes()[0].num_primitives == 1);
+        REQUIRE(builder.GetOrderedObjects()[0] == objects[0]);
+    }
+
+    SECTION("Every object is in exactly one leaf")
+    {
+        for (int x = 0; x < 12; x++)
+        {
+            for (int y = 0; y < 12; y++)
+            {
+                // Duplicate positions give duplicate Morton codes
+                objects.push_back(allocator.Create<Sphere>(Point3(x, y, (x + y) % 3), 0.4, material));
+                objects.push_back(allocator.Create<Sphere>(Point3(x, y, (x + y) % 3), 0.2, material));
+            }
+        }
+
+        const bool optimise_treelets = GENERATE(false, true);
+        LBVHBuilder builder(objects, optimise_treelets);
+        const std::vector<BVHBuildNode>& nodes = builder.GetNodes();
+
+        std::size_t num_leaf_objects = 0;
+        bool leaves_are_small = true;
+        bool children_are_enclosed = true;
+        for (std::size_t node_index = 0; node_index < nodes.size(); node_index++)
+        {
+            const BVHBuildNode& node = nodes[node_index];
+            if (node.num_primitives > 0)
+            {
+                num_leaf_objects += node.num_primitives;
+                leaves_are_small = leaves_are_small && node.num_primitives <= BVHBuilder::MAX_PRIMITIVES_PER_LEAF;
+                continue;
+            }
+
+            for (std::size_t child_index = node.offset; child_index <= node.offset + 1; child_index++)
+            {
+                const AABB& child_box = nodes[child_index].bounding_box;
+                children_are_enclosed = children_are_enclosed
+                    && child_box.m_x.m_min >= node.bounding_box.m_x.m_min && child_box.m_x.m_max <= node.bounding_box.m_x.m_max
+                    && child_box.m_y.m_min >= node.bounding_box.m_y.m_min && child_box.m_y.m_max <= node.bounding_box.m_y.m_max
+                    && child_box.m_z.m_min >= node.bounding_box.m_z.m_min && child_box.m_z.m_max <= node.bounding_box.m_z.m_max;
+            }
+        }
+
+        REQUIRE(num_leaf_objects == objects.size());
+        REQUIRE(leaves_are_small);
+        REQUIRE(children_are_enclosed);
+
+        std::vector<IRayHittable*> sorted_objects = objects;
+        std::vector<IRayHittable*> sorted_ordered_objects = builder.GetOrderedObjects();
+        std::sort(sorted_objects.begin(), sorted_objects.end());
+        std::sort(sorted_ordered_objects.begin(), sorted_ordered_objects.end());
+        REQUIRE(sorted_objects == sorted_ordered_objects);
+    }
+}
+
+} // namespace ART
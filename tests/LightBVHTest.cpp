@@ -0,0 +1,194 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Core/Random.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+#include <Materials/Texture.h>
+#include <RayTracing/LightBVH.h>
+#include <RayTracing/LightList.h>
+
+namespace ART
+{
+
+// Utility helper for tests.
+// Emissive spheres of random position, size and brightness within [-extent, extent] on each axis
+static std::vector<const IRayHittable*> MakeRandomLights(ArenaAllocator& allocator, int num_lights, double extent)
+{
+    std::vector<const IRayHittable*> lights;
+    for (int i = 0; i < num_lights; i++)
+    {
+        Texture* texture = allocator.Create<SolidColourTexture>(Colour(RandomPositionDouble(0.5, 20.0)));
+        Material* material = allocator.Create<DiffuseLightMaterial>(texture);
+        const Point3 centre(RandomPositionDouble(-extent, extent), RandomPositionDouble(-extent, extent), RandomPositionDouble(-extent, extent));
+        lights.push_back(allocator.Create<Sphere>(centre, RandomPositionDouble(0.05, 0.5), material));
+    }
+    return lights;
+}
+
+TEST_CASE("LightBounds union covers both bounds", "[LightBVH]")
+{
+    const AABB box1(Point3(0.0), Point3(1.0));
+    const AABB box2(Point3(2.0), Point3(3.0));
+
+    SECTION("Power and boxes add up")
+    {
+        const LightBounds bounds(LightBounds(box1, 2.0, Vec3(0.0, 0.0, 1.0), -1.0, 0.0), LightBounds(box2, 3.0, Vec3(0.0, 0.0, 1.0), -1.0, 0.0));
+        REQUIRE(bounds.power == Approx(5.0));
+        REQUIRE(bounds.bounding_box.m_x.m_min == 0.0);
+        REQUIRE(bounds.bounding_box.m_z.m_max == 3.0);
+        REQUIRE(bounds.cos_theta_normals == -1.0);
+    }
+
+    SECTION("Normal cones merge into one holding both")
+    {
+        const double cos_30 = std::cos(pi / 6.0);
+        const LightBounds bounds(LightBounds(box1, 1.0, Vec3(0.0, 0.0, 1.0), cos_30, 0.0), LightBounds(box2, 1.0, Vec3(1.0, 0.0, 0.0), cos_30, 0.0));
+
+        // Both cones' axes and their outermost normals lie within the merged cone
+        const Vec3 outermost_normals[4] =
+        {
+            Vec3(0.0, 0.0, 1.0), Vec3(1.0, 0.0, 0.0),
+            Vec3(-std::sin(pi / 6.0), 0.0, cos_30), Vec3(cos_30, 0.0, -std::sin(pi / 6.0))
+        };
+        for (const Vec3& normal : outermost_normals)
+        {
+            REQUIRE(Dot(bounds.direction, normal) >= bounds.cos_theta_normals - 1e-9);
+        }
+        REQUIRE(bounds.cos_theta_normals == Approx(std::cos(pi / 12.0 * 5.0)));
+    }
+
+    SECTION("Opposite cones merge into every direction")
+    {
+        const LightBounds bounds(LightBounds(box1, 1.0, Vec3(0.0, 0.0, 1.0), 0.5, 0.0), LightBounds(box2, 1.0, Vec3(0.0, 0.0, -1.0), 0.5, 0.0));
+        REQUIRE(bounds.cos_theta_normals == -1.0);
+    }
+
+    SECTION("Bounds that emit nothing are ignored")
+    {
+        const LightBounds bounds(LightBounds(box1, 0.0, Vec3(1.0, 0.0, 0.0), 1.0, 0.0), LightBounds(box2, 3.0, Vec3(0.0, 0.0, 1.0), -1.0, 0.0));
+        REQUIRE(bounds.bounding_box.m_x.m_min == 2.0);
+        REQUIRE(bounds.power == 3.0);
+    }
+}
+
+TEST_CASE("LightBounds OrientationMeasure and Importance", "[LightBVH]")
+{
+    const AABB box(Point3(-0.5), Point3(0.5));
+
+    // Cosine weighted hemisphere, then every direction
+    REQUIRE(LightBounds(box, 1.0, Vec3(0.0, 0.0, 1.0), 1.0, 0.0).OrientationMeasure() == Approx(pi));
+    REQUIRE(LightBounds(box, 1.0, Vec3(0.0, 0.0, 1.0), -1.0, 0.0).OrientationMeasure() == Approx(4.0 * pi));
+
+    const LightBounds omnidirectional(box, 2.0, Vec3(0.0, 0.0, 1.0), -1.0, 0.0);
+    REQUIRE(omnidirectional.Importance(Point3(0.0, 0.0, 4.0)) == Approx(2.0 / 16.0));
+    REQUIRE(omnidirectional.Importance(Point3(0.0, 0.0, 4.0)) > omnidirectional.Importance(Point3(0.0, 8.0, 0.0)));
+
+    // A face emitting towards +z can't light points well below it
+    const LightBounds facing_up(box, 2.0, Vec3(0.0, 0.0, 1.0), 1.0, 0.0);
+    REQUIRE(facing_up.Importance(Point3(0.0, 0.0, 4.0)) > 0.0);
+    REQUIRE(facing_up.Importance(Point3(0.0, 0.0, -4.0)) == 0.0);
+}
+
+TEST_CASE("LightBVH Sample picks lights with the probability it reports", "[LightBVH]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    SeedPositionRNG(7);
+
+    const std::vector<const IRayHittable*> lights = MakeRandomLights(allocator, 500, 20.0);
+
+    LightBVH light_bvh;
+    light_bvh.Build(lights);
+
+    REQUIRE(light_bvh.NumLights() == lights.size());
+    REQUIRE(light_bvh.NumNodes() == (2 * lights.size()) - 1);
+    REQUIRE(light_bvh.MemoryUsedBytes() > 0);
+
+    for (int point_index = 0; point_index < 20; point_index++)
+    {
+        const Point3 point(RandomPositionDouble(-25.0, 25.0), RandomPositionDouble(-25.0, 25.0), RandomPositionDouble(-25.0, 25.0));
+
+        double total_probability = 0.0;
+        for (const IRayHittable* light : lights)
+        {
+            total_probability += light_bvh.Probability(point, light);
+        }
+        REQUIRE(total_probability == Approx(1.0));
+
+        for (int sample = 0; sample < 50; sample++)
+        {
+            double probability = 0.0;
+            const IRayHittable* light = light_bvh.Sample(point, probability);
+            REQUIRE(light != nullptr);
+            REQUIRE(probability > 0.0);
+            REQUIRE(probability == Approx(light_bvh.Probability(point, light)));
+        }
+    }
+
+    SECTION("Sample frequencies match the probabilities")
+    {
+        const std::vector<const IRayHittable*> few_lights(lights.begin(), lights.begin() + 8);
+        light_bvh.Build(few_lights);
+
+        const Point3 point(1.0, 2.0, 3.0);
+        const int num_samples = 100000;
+        std::vector<int> counts(few_lights.size(), 0);
+        for (int sample = 0; sample < num_samples; sample++)
+        {
+            double probability = 0.0;
+            const IRayHittable* light = light_bvh.Sample(point, probability);
+            counts[std::find(few_lights.begin(), few_lights.end(), light) - few_lights.begin()]++;
+        }
+
+        for (std::size_t index = 0; index < few_lights.size(); index++)
+        {
+            const double probability = light_bvh.Probability(point, few_lights[index]);
+            const double frequency = static_cast<double>(counts[index]) / num_samples;
+            REQUIRE(frequency == Approx(probability).margin(0.01));
+        }
+    }
+
+    SECTION("Nearby lights are favoured")
+    {
+        const Sphere* light = static_cast<const Sphere*>(lights[0]);
+        const Point3 near_point = light->m_centre + Vec3(0.0, light->m_radius + 0.01, 0.0);
+        const Point3 far_point = -light->m_centre * 2.0;
+        REQUIRE(light_bvh.Probability(near_point, light) > 2.0 / static_cast<double>(lights.size()));
+        REQUIRE(light_bvh.Probability(near_point, light) > 10.0 * light_bvh.Probability(far_point, light));
+    }
+}
+
+TEST_CASE("LightList picks lights through its light BVH once built", "[LightBVH]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    SeedPositionRNG(7);
+
+    LightList lights;
+    for (const IRayHittable* light : MakeRandomLights(allocator, 64, 10.0))
+    {
+        lights.Add(light);
+    }
+
+    const Point3 point(0.0, 0.0, 12.0);
+    const IRayHittable* first_light = lights.GetLights()[0];
+    REQUIRE(lights.Probability(point, first_light) == Approx(1.0 / 64.0));
+
+    lights.BuildLightBVH();
+    REQUIRE_FALSE(lights.GetLightBVH().Empty());
+    REQUIRE(lights.Probability(point, first_light) == lights.GetLightBVH().Probability(point, first_light));
+
+    double probability = 0.0;
+    const IRayHittable* light = lights.Sample(point, probability);
+    REQUIRE(probability == Approx(lights.GetLightBVH().Probability(point, light)));
+
+    SECTION("Adding a light discards the light BVH")
+    {
+        lights.Add(MakeRandomLights(allocator, 1, 10.0)[0]);
+        REQUIRE(lights.GetLightBVH().Empty());
+        REQUIRE(lights.Probability(point, first_light) == Approx(1.0 / 65.0));
+    }
+}
+
+} // namespace ART
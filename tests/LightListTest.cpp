@@ -0,0 +1,89 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Core/ArenaAllocator.h>
+#include <Geometry/AxisAlignedBox.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+#include <Materials/Texture.h>
+#include <RayTracing/LightList.h>
+
+namespace ART
+{
+
+TEST_CASE("LightList Collect keeps only emissive spheres and boxes", "[LightList]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Texture* light_texture = allocator.Create<SolidColourTexture>(Colour(4.0));
+    Material* lambertian_material = allocator.Create<LambertianMaterial>(texture);
+    Material* metal_material = allocator.Create<MetalMaterial>(Colour(0.7), 0.0);
+    Material* light_material = allocator.Create<DiffuseLightMaterial>(light_texture);
+
+    std::vector<IRayHittable*> objects;
+    objects.push_back(allocator.Create<Sphere>(Point3(0.0), 1.0, lambertian_material));
+    objects.push_back(allocator.Create<Sphere>(Point3(3.0), 0.5, light_material));
+    objects.push_back(allocator.Create<AxisAlignedBox>(Point3(-1.0), Point3(1.0), metal_material));
+    objects.push_back(allocator.Create<AxisAlignedBox>(Point3(5.0), Point3(6.0), light_material));
+
+    LightList lights;
+    lights.Collect(objects);
+
+    REQUIRE(lights.Size() == 2);
+    REQUIRE(lights.GetLights()[0] == objects[1]);
+    REQUIRE(lights.GetLights()[1] == objects[3]);
+
+    const Point3 point(0.0, 10.0, 0.0);
+    REQUIRE(lights.Probability(point, objects[1]) == Approx(0.5));
+    REQUIRE(lights.Probability(point, objects[0]) == 0.0);
+
+    SECTION("Adding a light twice keeps one entry")
+    {
+        lights.Add(objects[1]);
+        REQUIRE(lights.Size() == 2);
+    }
+
+    SECTION("Clear empties the list")
+    {
+        lights.Clear();
+        REQUIRE(lights.Empty());
+        REQUIRE(lights.Probability(point, objects[1]) == 0.0);
+    }
+}
+
+TEST_CASE("LightList Sample picks lights with the probability it reports", "[LightList]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* light_texture = allocator.Create<SolidColourTexture>(Colour(4.0));
+    Material* light_material = allocator.Create<DiffuseLightMaterial>(light_texture);
+
+    LightList lights;
+    std::vector<const IRayHittable*> spheres;
+    for (int i = 0; i < 4; i++)
+    {
+        spheres.push_back(allocator.Create<Sphere>(Point3(static_cast<double>(i) * 3.0, 0.0, 0.0), 1.0, light_material));
+        lights.Add(spheres.back());
+    }
+
+    const Point3 point(0.0, 10.0, 0.0);
+    const int num_samples = 40000;
+    std::vector<int> counts(spheres.size(), 0);
+    for (int i = 0; i < num_samples; i++)
+    {
+        double probability = 0.0;
+        const IRayHittable* light = lights.Sample(point, probability);
+        REQUIRE(probability == Approx(lights.Probability(point, light)));
+
+        const std::size_t index = static_cast<std::size_t>(std::find(spheres.begin(), spheres.end(), light) - spheres.begin());
+        REQUIRE(index < spheres.size());
+        counts[index]++;
+    }
+
+    for (std::size_t index = 0; index < spheres.size(); index++)
+    {
+        const double frequency = static_cast<double>(counts[index]) / num_samples;
+        REQUIRE(frequency == Approx(lights.Probability(point, spheres[index])).epsilon(0.05));
+    }
+}
+
+} // namespace ART
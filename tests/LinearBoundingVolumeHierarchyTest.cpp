@@ -0,0 +1,112 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/FlatBoundingVolumeHierarchy.h>
+#include <Acceleration/LinearBoundingVolumeHierarchy.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+
+namespace ART
+{
+
+TEST_CASE("LinearBVH Hit detects intersections", "[LinearBVH]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    const bool optimise_treelets = GENERATE(false, true);
+    Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+
+    SECTION("Ray hits closest object among multiple")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -10.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -3.0), 0.5, material));
+
+        LinearBVH linear_bounding_volume_hierarchy(objects, optimise_treelets);
+        RayHitResult result;
+        const bool hit = linear_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), result);
+
+        REQUIRE(hit == true);
+        REQUIRE(result.m_t == Approx(2.5));
+    }
+
+    SECTION("Ray misses all objects")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(10.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(-10.0, 0.0, -5.0), 1.0, material));
+
+        LinearBVH linear_bounding_volume_hierarchy(objects, optimise_treelets);
+        RayHitResult result;
+
+        REQUIRE(linear_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), result) == false);
+    }
+
+    SECTION("Bounding box encloses all objects")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(-5.0, -5.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(5.0, 5.0, 5.0), 1.0, material));
+
+        LinearBVH linear_bounding_volume_hierarchy(objects, optimise_treelets);
+        const AABB box = linear_bounding_volume_hierarchy.BoundingBox();
+
+        REQUIRE(box.m_x.m_min == Approx(-6.0));
+        REQUIRE(box.m_z.m_max == Approx(6.0));
+    }
+}
+
+TEST_CASE("LinearBVH matches FlatBVH results", "[LinearBVH]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int y = -5; y <= 5; y++)
+        {
+            const double z = -10.0 - static_cast<double>((x * 7 + y * 3) % 5);
+            const double radius = 0.3 + 0.02 * static_cast<double>((x + y + 10) % 7);
+            objects.push_back(allocator.Create<Sphere>(Point3(x, y, z), radius, material));
+        }
+    }
+
+    std::vector<IRayHittable*> objects_copy = objects;
+    FlatBVH flat_bounding_volume_hierarchy(objects_copy);
+    LinearBVH linear_bounding_volume_hierarchy(objects, false);
+    LinearBVH optimised_linear_bounding_volume_hierarchy(objects, true);
+
+    for (int ray_x = -30; ray_x <= 30; ray_x++)
+    {
+        for (int ray_y = -30; ray_y <= 30; ray_y++)
+        {
+            const Ray ray(Point3(0.5, -0.5, 2.0), Vec3(ray_x * 0.02, ray_y * 0.02, -1.0));
+
+            RayHitResult flat_bvh_result;
+            RayHitResult linear_bvh_result;
+            RayHitResult optimised_linear_bvh_result;
+            const bool flat_bvh_hit = flat_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), flat_bvh_result);
+            const bool linear_bvh_hit = linear_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), linear_bvh_result);
+            const bool optimised_linear_bvh_hit = optimised_linear_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), optimised_linear_bvh_result);
+
+            REQUIRE(flat_bvh_hit == linear_bvh_hit);
+            REQUIRE(flat_bvh_hit == optimised_linear_bvh_hit);
+            REQUIRE(linear_bounding_volume_hierarchy.HitAny(ray, Interval(0.001, infinity)) == flat_bvh_hit);
+            if (flat_bvh_hit)
+            {
+                REQUIRE(linear_bvh_result.m_t == Approx(flat_bvh_result.m_t));
+                REQUIRE_FALSE(linear_bounding_volume_hierarchy.HitAny(ray, Interval(0.001, 0.999 * flat_bvh_result.m_t)));
+                REQUIRE(optimised_linear_bvh_result.m_t == Approx(flat_bvh_result.m_t));
+            }
+        }
+    }
+}
+
+} // namespace ART
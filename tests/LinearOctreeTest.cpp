@@ -0,0 +1,196 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <algorithm>
+#include <bitset>
+
+#include <Acceleration/LinearOctree.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+#include <RayTracing/RayHittableList.h>
+
+namespace ART
+{
+
+TEST_CASE("LinearOctree Hit detects intersections", "[LinearOctree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SECTION("Empty tree never hits")
+    {
+        std::vector<IRayHittable*> objects;
+        LinearOctree linear_octree(objects);
+
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+        REQUIRE(linear_octree.Hit(ray, Interval(0.001, infinity), result) == false);
+        REQUIRE(linear_octree.MemoryUsedBytes() == 0);
+    }
+
+    SECTION("Ray hits closest object among multiple")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -10.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0,  -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0,  -3.0), 0.5, material));
+
+        LinearOctree linear_octree(objects);
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+
+        REQUIRE(linear_octree.Hit(ray, Interval(0.001, infinity), result) == true);
+        REQUIRE(result.m_t == Approx(2.5));
+    }
+
+    SECTION("Ray respects interval bounds")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(3.0, 0.0, -5.0), 1.0, material));
+
+        LinearOctree linear_octree(objects);
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+
+        REQUIRE(linear_octree.Hit(ray, Interval(10.0, infinity), result) == false);
+        REQUIRE(linear_octree.Hit(ray, Interval(0.001, 3.0), result) == false);
+    }
+}
+
+TEST_CASE("LinearOctree layout", "[LinearOctree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    for (int x = 0; x < 8; x++)
+    {
+        for (int y = 0; y < 8; y++)
+        {
+            for (int z = 0; z < 8; z++)
+            {
+                objects.push_back(allocator.Create<Sphere>(Point3(x, y, z), 0.25, material));
+            }
+        }
+    }
+
+    LinearOctree linear_octree(objects);
+    const std::vector<LinearOctreeNode>& nodes = linear_octree.GetNodes();
+
+    SECTION("Leaves cover every object exactly once")
+    {
+        std::vector<int> times_covered(objects.size(), 0);
+        for (const LinearOctreeNode& node : nodes)
+        {
+            if (node.child_mask == 0)
+            {
+                REQUIRE(node.num_primitives > 0);
+                REQUIRE(node.num_primitives <= LinearOctree::MAX_OBJECTS_PER_LEAF);
+                for (uint32_t primitive_index = node.offset; primitive_index < node.offset + node.num_primitives; primitive_index++)
+                {
+                    times_covered[primitive_index]++;
+                }
+            }
+        }
+        REQUIRE(std::count(times_covered.begin(), times_covered.end(), 1) == static_cast<std::ptrdiff_t>(objects.size()));
+        REQUIRE(linear_octree.GetPrimitives().size() == objects.size());
+    }
+
+    SECTION("Children follow their parent and nest inside its bounds")
+    {
+        for (std::size_t node_index = 0; node_index < nodes.size(); node_index++)
+        {
+            const LinearOctreeNode& node = nodes[node_index];
+            for (uint32_t child_index = 0; node.child_mask != 0 && child_index < 8; child_index++)
+            {
+                if (!(node.child_mask & (1 << child_index)))
+                {
+                    continue;
+                }
+                const uint32_t slot = static_cast<uint32_t>(std::bitset<8>(node.child_mask & ((1u << child_index) - 1)).count());
+                const LinearOctreeNode& child = nodes[node.offset + slot];
+                REQUIRE(node.offset > node_index);
+                REQUIRE(child.depth > node.depth);
+                for (std::size_t axis = 0; axis < 3; axis++)
+                {
+                    REQUIRE(child.bounds_min[axis] >= node.bounds_min[axis]);
+                    REQUIRE(child.bounds_max[axis] <= node.bounds_max[axis]);
+                }
+            }
+        }
+    }
+
+    SECTION("A regular lattice splits into all eight octants")
+    {
+        REQUIRE(nodes[0].child_mask == 0xFF);
+        REQUIRE(linear_octree.ComputeOverlapStats().num_overflow_nodes == 0);
+    }
+
+    SECTION("Nodes are smaller than pointer based octree nodes")
+    {
+        OctreeNode octree(objects);
+        REQUIRE(linear_octree.MemoryUsedBytes() < octree.MemoryUsedBytes());
+    }
+}
+
+TEST_CASE("LinearOctree matches brute force results", "[LinearOctree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    RayHittableList brute_force;
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int y = -5; y <= 5; y++)
+        {
+            const double z = -10.0 - static_cast<double>((x * 7 + y * 3 + 50) % 5);
+            const double radius = 0.1 + 0.4 * static_cast<double>((x + y + 10) % 7);
+            IRayHittable* sphere = allocator.Create<Sphere>(Point3(x, y, z), radius, material);
+            objects.push_back(sphere);
+            brute_force.Add(sphere);
+        }
+    }
+    // Coincident objects can only be told apart by their order
+    for (int i = 0; i < 10; i++)
+    {
+        IRayHittable* sphere = allocator.Create<Sphere>(Point3(0.0, 0.0, -20.0), 0.5 + 0.1 * i, material);
+        objects.push_back(sphere);
+        brute_force.Add(sphere);
+    }
+
+    LinearOctree linear_octree(objects);
+
+    const Point3 origins[3] = { Point3(0.0, 0.0, 0.0), Point3(3.0, -2.0, -12.0), Point3(-20.0, 1.0, -11.0) };
+    for (const Point3& origin : origins)
+    {
+        for (int ray_x = -20; ray_x <= 20; ray_x++)
+        {
+            for (int ray_y = -20; ray_y <= 20; ray_y++)
+            {
+                const Ray ray(origin, Point3(ray_x * 0.3, ray_y * 0.3, -12.0) - origin);
+
+                RayHitResult brute_force_result;
+                RayHitResult linear_octree_result;
+                const bool brute_force_hit = brute_force.Hit(ray, Interval(0.001, infinity), brute_force_result);
+                const bool linear_octree_hit = linear_octree.Hit(ray, Interval(0.001, infinity), linear_octree_result);
+
+                REQUIRE(linear_octree_hit == brute_force_hit);
+                REQUIRE(linear_octree.HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+                if (brute_force_hit)
+                {
+                    REQUIRE(linear_octree_result.m_t == Approx(brute_force_result.m_t));
+                    REQUIRE_FALSE(linear_octree.HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+                }
+            }
+        }
+    }
+}
+
+} // namespace ART
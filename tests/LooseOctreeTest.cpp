@@ -0,0 +1,180 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/LooseOctree.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+#include <RayTracing/RayHittableList.h>
+
+namespace ART
+{
+
+TEST_CASE("LooseOctree Hit detects intersections", "[LooseOctree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SECTION("Empty tree never hits")
+    {
+        std::vector<IRayHittable*> objects;
+        LooseOctree loose_octree(objects);
+
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+        REQUIRE(loose_octree.Hit(ray, Interval(0.001, infinity), result) == false);
+        REQUIRE(loose_octree.MemoryUsedBytes() == 0);
+    }
+
+    SECTION("Ray hits closest object among multiple")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -10.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0,  -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0,  -3.0), 0.5, material));
+
+        LooseOctree loose_octree(objects);
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+
+        REQUIRE(loose_octree.Hit(ray, Interval(0.001, infinity), result) == true);
+        REQUIRE(result.m_t == Approx(2.5));
+    }
+
+    SECTION("Ray respects interval bounds")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(3.0, 0.0, -5.0), 1.0, material));
+
+        LooseOctree loose_octree(objects);
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+
+        REQUIRE(loose_octree.Hit(ray, Interval(10.0, infinity), result) == false);
+        REQUIRE(loose_octree.Hit(ray, Interval(0.001, 3.0), result) == false);
+    }
+}
+
+TEST_CASE("LooseOctree places objects by size", "[LooseOctree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Small spheres spread over a large ground sphere that can't fit below the root
+    std::vector<IRayHittable*> objects;
+    IRayHittable* ground = allocator.Create<Sphere>(Point3(0.0, -1000.0, -10.0), 1000.0, material);
+    objects.push_back(ground);
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int z = -5; z <= 5; z++)
+        {
+            objects.push_back(allocator.Create<Sphere>(Point3(x * 2.0, 0.5, -10.0 + z * 2.0), 0.4, material));
+        }
+    }
+
+    SECTION("Every object is stored exactly once")
+    {
+        LooseOctree loose_octree(objects);
+        REQUIRE(loose_octree.GetObjects().size() == objects.size());
+    }
+
+    SECTION("Large objects stay at the root")
+    {
+        LooseOctree loose_octree(objects);
+        const LooseOctreeNode& root = loose_octree.GetNodes()[0];
+        REQUIRE(root.child_mask != 0);
+
+        // ground is objects[0]
+        const PrimitiveId ground_id = loose_octree.GetPrimitiveStore().GetId(0);
+        bool ground_at_root = false;
+        for (uint32_t object_index = 0; object_index < root.num_objects; object_index++)
+        {
+            ground_at_root |= loose_octree.GetObjects()[root.objects_offset + object_index] == ground_id;
+        }
+        REQUIRE(ground_at_root);
+
+        const OctreeOverlapStats overlap_stats = loose_octree.ComputeOverlapStats();
+        REQUIRE(overlap_stats.num_nodes == loose_octree.GetNodes().size());
+        REQUIRE(overlap_stats.num_interior_objects >= 1);
+        REQUIRE(overlap_stats.num_overflow_nodes == 0);
+    }
+
+    SECTION("Higher looseness pushes objects deeper")
+    {
+        LooseOctree tight_octree(objects, 1.0);
+        LooseOctree loose_octree(objects, 3.0);
+        REQUIRE(tight_octree.GetLooseness() == 1.0);
+        REQUIRE(loose_octree.GetLooseness() == 3.0);
+
+        // Only point-sized objects fit below the root of a tight octree
+        REQUIRE(tight_octree.GetNodes().size() == 1);
+        REQUIRE(loose_octree.GetNodes().size() > 1);
+        REQUIRE(loose_octree.ComputeOverlapStats().max_depth > 0);
+    }
+
+    SECTION("Looseness is clamped to the supported range")
+    {
+        LooseOctree too_tight_octree(objects, 0.5);
+        LooseOctree too_loose_octree(objects, 10.0);
+        REQUIRE(too_tight_octree.GetLooseness() == LooseOctree::MIN_LOOSENESS);
+        REQUIRE(too_loose_octree.GetLooseness() == LooseOctree::MAX_LOOSENESS);
+    }
+}
+
+TEST_CASE("LooseOctree matches brute force results", "[LooseOctree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    RayHittableList brute_force;
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int y = -5; y <= 5; y++)
+        {
+            const double z = -10.0 - static_cast<double>((x * 7 + y * 3 + 50) % 5);
+            const double radius = 0.1 + 0.4 * static_cast<double>((x + y + 10) % 7);
+            IRayHittable* sphere = allocator.Create<Sphere>(Point3(x, y, z), radius, material);
+            objects.push_back(sphere);
+            brute_force.Add(sphere);
+        }
+    }
+
+    const double looseness_values[3] = { 1.0, 1.5, LooseOctree::DEFAULT_LOOSENESS };
+    for (double looseness : looseness_values)
+    {
+        LooseOctree loose_octree(objects, looseness);
+
+        const Point3 origins[3] = { Point3(0.0, 0.0, 0.0), Point3(3.0, -2.0, -12.0), Point3(-20.0, 1.0, -11.0) };
+        for (const Point3& origin : origins)
+        {
+            for (int ray_x = -20; ray_x <= 20; ray_x++)
+            {
+                for (int ray_y = -20; ray_y <= 20; ray_y++)
+                {
+                    const Ray ray(origin, Point3(ray_x * 0.3, ray_y * 0.3, -12.0) - origin);
+
+                    RayHitResult brute_force_result;
+                    RayHitResult loose_octree_result;
+                    const bool brute_force_hit = brute_force.Hit(ray, Interval(0.001, infinity), brute_force_result);
+                    const bool loose_octree_hit = loose_octree.Hit(ray, Interval(0.001, infinity), loose_octree_result);
+
+                    REQUIRE(loose_octree_hit == brute_force_hit);
+                    REQUIRE(loose_octree.HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+                    if (brute_force_hit)
+                    {
+                        REQUIRE(loose_octree_result.m_t == Approx(brute_force_result.m_t));
+                        REQUIRE_FALSE(loose_octree.HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace ART
@@ -1,6 +1,7 @@
 // Copyright Mia Rolfe. All rights reserved.
 #include <Catch2/catch.hpp>
 
+#include <Core/Constants.h>
 #include <Materials/Material.h>
 #include <Materials/Texture.h>
 #include <Maths/Ray.h>
@@ -117,6 +118,39 @@ TEST_CASE("LambertianMaterial Scatter direction is on the correct hemisphere", "
     REQUIRE(scattered_direction_always_on_same_side_as_normal);
 }
 
+TEST_CASE("LambertianMaterial ScatteringPdf and ScatteringValue match its uniform hemisphere Scatter", "[Material]")
+{
+    SolidColourTexture texture(Colour(0.1, 0.2, 0.3));
+    const LambertianMaterial material(&texture);
+    const RayHitResult result = MakeFrontFacingResult(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, 1.0));
+
+    const Vec3 above = Normalised(Vec3(0.3, -0.2, 1.0));
+    const Vec3 below = Normalised(Vec3(0.3, -0.2, -1.0));
+
+    REQUIRE(material.ScatteringPdf(result, above) == Approx(1.0 / (2.0 * pi)));
+    REQUIRE(material.ScatteringPdf(result, below) == 0.0);
+
+    // Value over pdf is the attenuation Scatter gives
+    const Colour value = material.ScatteringValue(result, above);
+    REQUIRE(value.m_x / material.ScatteringPdf(result, above) == Approx(0.1));
+    REQUIRE(value.m_y / material.ScatteringPdf(result, above) == Approx(0.2));
+    REQUIRE(value.m_z / material.ScatteringPdf(result, above) == Approx(0.3));
+    REQUIRE(material.ScatteringValue(result, below).m_x == 0.0);
+    REQUIRE_FALSE(material.IsEmissive());
+}
+
+TEST_CASE("MetalMaterial and DielectricMaterial have no scattering density", "[Material]")
+{
+    const MetalMaterial metal(Colour(0.5), 0.1);
+    const DielectricMaterial dielectric(1.5);
+    const RayHitResult result = MakeFrontFacingResult(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, 1.0));
+
+    REQUIRE(metal.ScatteringPdf(result, Vec3(0.0, 0.0, 1.0)) == 0.0);
+    REQUIRE(dielectric.ScatteringPdf(result, Vec3(0.0, 0.0, 1.0)) == 0.0);
+    REQUIRE_FALSE(metal.IsEmissive());
+    REQUIRE_FALSE(dielectric.IsEmissive());
+}
+
 TEST_CASE("MetalMaterial Scatter reflects ray correctly when fuzz is zero", "[Material]")
 {
     const MetalMaterial material(Colour(0.9, 0.9, 0.9), 0.0);
@@ -237,4 +271,12 @@ TEST_CASE("DiffuseLightMaterial Scatter returns false", "[Material]")
     REQUIRE(material.Scatter(ray, result, attenuation, out_ray) == false);
 }
 
+TEST_CASE("DiffuseLightMaterial IsEmissive", "[Material]")
+{
+    SolidColourTexture texture(Colour(4.0));
+    const DiffuseLightMaterial material(&texture);
+
+    REQUIRE(material.IsEmissive());
+}
+
 } // namespace ART
@@ -156,6 +156,8 @@ TEST_CASE("OctreeNode Hit finds spheres in all 8 octants", "[OctreeNode]")
         RayHitResult result;
         const bool hit = octree.Hit(ray, Interval(0.001, infinity), result);
         REQUIRE(hit == true);
+        REQUIRE(octree.HitAny(ray, Interval(0.001, infinity)));
+        REQUIRE_FALSE(octree.HitAny(ray, Interval(0.001, 0.999 * result.m_t)));
     }
 }
 
@@ -197,4 +199,45 @@ TEST_CASE("OctreeNode BoundingBox encloses all objects", "[OctreeNode]")
     REQUIRE(box.m_z.m_max >= 6.0);
 }
 
+TEST_CASE("OctreeNode ComputeOverlapStats counts overflow nodes", "[OctreeNode]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SECTION("Coincident objects can't be split and overflow their leaf")
+    {
+        std::vector<IRayHittable*> objects;
+        for (int i = 0; i < 10; i++)
+        {
+            objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 0.5, material));
+        }
+
+        OctreeNode octree(objects);
+        const OctreeOverlapStats overlap_stats = octree.ComputeOverlapStats();
+
+        REQUIRE(overlap_stats.num_nodes == 1);
+        REQUIRE(overlap_stats.num_overflow_nodes == 1);
+        REQUIRE(overlap_stats.num_interior_objects == 0);
+        REQUIRE(overlap_stats.average_sibling_overlap == 0.0);
+    }
+
+    SECTION("Separated objects give disjoint siblings")
+    {
+        std::vector<IRayHittable*> objects;
+        for (int i = 0; i < 8; i++)
+        {
+            const Point3 centre((i & 1) ? 5.0 : -5.0, (i & 2) ? 5.0 : -5.0, (i & 4) ? 5.0 : -5.0);
+            objects.push_back(allocator.Create<Sphere>(centre, 1.0, material));
+        }
+
+        OctreeNode octree(objects);
+        const OctreeOverlapStats overlap_stats = octree.ComputeOverlapStats();
+
+        REQUIRE(overlap_stats.num_nodes == 9);
+        REQUIRE(overlap_stats.max_depth == 1);
+        REQUIRE(overlap_stats.average_sibling_overlap == 0.0);
+    }
+}
+
 } // namespace ART
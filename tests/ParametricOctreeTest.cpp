@@ -0,0 +1,175 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/ParametricOctree.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+
+namespace ART
+{
+
+TEST_CASE("ParametricOctree matches brute force closest hits", "[ParametricOctree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Overlapping spheres of varying size, so many straddle cell boundaries
+    std::vector<IRayHittable*> objects;
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int y = -5; y <= 5; y++)
+        {
+            const double z = -10.0 - static_cast<double>((x * 7 + y * 3 + 50) % 5);
+            const double radius = 0.3 + 0.15 * static_cast<double>((x + y + 10) % 7);
+            objects.push_back(allocator.Create<Sphere>(Point3(x, y, z), radius, material));
+        }
+    }
+
+    ParametricOctree octree(objects);
+
+    SECTION("Objects straddling cells are referenced more than once")
+    {
+        REQUIRE(octree.GetPrimitives().size() > objects.size());
+        REQUIRE(octree.MemoryUsedBytes() == octree.GetNodes().size() * sizeof(ParametricOctreeNode) + octree.GetPrimitives().size() * sizeof(PrimitiveId) + octree.GetPrimitiveStore().MemoryUsedBytes());
+    }
+
+    SECTION("Sibling nodes are stored contiguously")
+    {
+        const std::vector<ParametricOctreeNode>& nodes = octree.GetNodes();
+        for (std::size_t node_index = 0; node_index < nodes.size(); node_index++)
+        {
+            if (nodes[node_index].child_mask != 0)
+            {
+                std::size_t num_children = 0;
+                for (std::size_t octant = 0; octant < 8; octant++)
+                {
+                    num_children += (nodes[node_index].child_mask >> octant) & 1;
+                }
+                REQUIRE(nodes[node_index].offset > node_index);
+                REQUIRE(nodes[node_index].offset + num_children <= nodes.size());
+            }
+        }
+    }
+
+    SECTION("Closest hits agree for rays from several origins")
+    {
+        // Includes origins inside the octree and rays parallel to split planes
+        const Point3 origins[4] = { Point3(0.0, 0.0, 0.0), Point3(3.0, -2.0, -12.0), Point3(-20.0, 1.0, -11.0), Point3(0.5, 0.5, -12.0) };
+        for (const Point3& origin : origins)
+        {
+            for (int ray_x = -20; ray_x <= 20; ray_x++)
+            {
+                for (int ray_y = -20; ray_y <= 20; ray_y++)
+                {
+                    const Ray ray(origin, Point3(ray_x * 0.3, ray_y * 0.3, -12.0) - origin);
+
+                    RayHitResult brute_force_result;
+                    bool brute_force_hit = false;
+                    double closest_so_far = infinity;
+                    for (IRayHittable* object : objects)
+                    {
+                        if (object->Hit(ray, Interval(0.001, closest_so_far), brute_force_result))
+                        {
+                            brute_force_hit = true;
+                            closest_so_far = brute_force_result.m_t;
+                        }
+                    }
+
+                    RayHitResult octree_result;
+                    const bool octree_hit = octree.Hit(ray, Interval(0.001, infinity), octree_result);
+
+                    REQUIRE(octree_hit == brute_force_hit);
+                    REQUIRE(octree.HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+                    if (brute_force_hit)
+                    {
+                        REQUIRE(octree_result.m_t == Approx(brute_force_result.m_t));
+                        REQUIRE_FALSE(octree.HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Axis aligned rays in both directions")
+    {
+        for (int i = -5; i <= 5; i++)
+        {
+            const Ray rays[2] =
+            {
+                Ray(Point3(static_cast<double>(i), 0.0, 10.0), Vec3(0.0, 0.0, -1.0)),
+                Ray(Point3(20.0, static_cast<double>(i), -10.0), Vec3(-1.0, 0.0, 0.0))
+            };
+            for (const Ray& ray : rays)
+            {
+                RayHitResult brute_force_result;
+                bool brute_force_hit = false;
+                double closest_so_far = infinity;
+                for (IRayHittable* object : objects)
+                {
+                    if (object->Hit(ray, Interval(0.001, closest_so_far), brute_force_result))
+                    {
+                        brute_force_hit = true;
+                        closest_so_far = brute_force_result.m_t;
+                    }
+                }
+
+                RayHitResult octree_result;
+                const bool octree_hit = octree.Hit(ray, Interval(0.001, infinity), octree_result);
+
+                REQUIRE(octree_hit == brute_force_hit);
+                REQUIRE(octree.HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+                if (brute_force_hit)
+                {
+                    REQUIRE(octree_result.m_t == Approx(brute_force_result.m_t));
+                    REQUIRE_FALSE(octree.HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("ParametricOctree finds spheres in all 8 octants", "[ParametricOctree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    for (int octant = 0; octant < 8; octant++)
+    {
+        const double x = (octant & 1) ? 5.0 : -5.0;
+        const double y = (octant & 2) ? 5.0 : -5.0;
+        const double z = (octant & 4) ? 5.0 : -5.0;
+        objects.push_back(allocator.Create<Sphere>(Point3(x, y, z), 1.0, material));
+    }
+
+    ParametricOctree octree(objects);
+
+    for (int octant = 0; octant < 8; octant++)
+    {
+        const double x = (octant & 1) ? 5.0 : -5.0;
+        const double y = (octant & 2) ? 5.0 : -5.0;
+        const double z = (octant & 4) ? 5.0 : -5.0;
+
+        // Ray from origin straight at each sphere
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(x, y, z));
+        RayHitResult result;
+        REQUIRE(octree.Hit(ray, Interval(0.001, infinity), result) == true);
+        REQUIRE(result.m_t == Approx(1.0 - 1.0 / std::sqrt(75.0)));
+    }
+
+    SECTION("Empty octree never hits")
+    {
+        std::vector<IRayHittable*> no_objects;
+        ParametricOctree empty_octree(no_objects);
+
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+        REQUIRE(empty_octree.Hit(ray, Interval(0.001, infinity), result) == false);
+    }
+}
+
+} // namespace ART
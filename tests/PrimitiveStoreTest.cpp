@@ -0,0 +1,309 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/FlatBoundingVolumeHierarchy.h>
+#include <Acceleration/HashedGrid.h>
+#include <Acceleration/KDTree.h>
+#include <Acceleration/LinearOctree.h>
+#include <Acceleration/LooseOctree.h>
+#include <Acceleration/ParametricOctree.h>
+#include <Acceleration/RopeKDTree.h>
+#include <Acceleration/TwoLevelGrid.h>
+#include <Acceleration/UniformGrid.h>
+#include <Acceleration/WideBoundingVolumeHierarchy.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Core/Random.h>
+#include <Geometry/AxisAlignedBox.h>
+#include <Geometry/PrimitiveStore.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+#include <RayTracing/RayHittableList.h>
+
+namespace ART
+{
+
+TEST_CASE("PrimitiveStore ids", "[PrimitiveStore]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    RayHittableList list;
+    list.Add(allocator.Create<Sphere>(Point3(0.0, 0.0, -1.0), 0.5, material));
+
+    std::vector<IRayHittable*> objects =
+    {
+        allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material),
+        allocator.Create<AxisAlignedBox>(Point3(-1.0, -1.0, -10.0), Point3(1.0, 1.0, -9.0), material),
+        &list,
+        allocator.Create<Sphere>(Point3(3.0, 0.0, -5.0), 1.0, material)
+    };
+
+    const PrimitiveStore store(objects);
+
+    SECTION("Objects are stored by type, in order")
+    {
+        REQUIRE(store.Size() == 4);
+        REQUIRE(store.GetNumSpheres() == 2);
+        REQUIRE(store.GetNumBoxes() == 1);
+        REQUIRE(store.GetNumHittables() == 1);
+
+        REQUIRE(PrimitiveStore::GetType(store.GetId(0)) == PrimitiveType::SPHERE);
+        REQUIRE(PrimitiveStore::GetIndex(store.GetId(0)) == 0);
+        REQUIRE(PrimitiveStore::GetType(store.GetId(1)) == PrimitiveType::BOX);
+        REQUIRE(PrimitiveStore::GetIndex(store.GetId(1)) == 0);
+        REQUIRE(PrimitiveStore::GetType(store.GetId(2)) == PrimitiveType::HITTABLE);
+        REQUIRE(PrimitiveStore::GetIndex(store.GetId(2)) == 0);
+        REQUIRE(PrimitiveStore::GetType(store.GetId(3)) == PrimitiveType::SPHERE);
+        REQUIRE(PrimitiveStore::GetIndex(store.GetId(3)) == 1);
+
+        for (std::size_t object_index = 0; object_index < store.Size(); object_index++)
+        {
+            REQUIRE(store.GetIds()[object_index] == store.GetId(object_index));
+        }
+    }
+
+    SECTION("Ids round trip")
+    {
+        const PrimitiveId id = PrimitiveStore::MakeId(PrimitiveType::BOX, PrimitiveStore::INDEX_MASK);
+        REQUIRE(PrimitiveStore::GetType(id) == PrimitiveType::BOX);
+        REQUIRE(PrimitiveStore::GetIndex(id) == PrimitiveStore::INDEX_MASK);
+    }
+
+    SECTION("Bounding boxes match the objects")
+    {
+        for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+        {
+            const AABB expected = objects[object_index]->BoundingBox();
+            const AABB actual = store.BoundingBox(store.GetId(object_index));
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                REQUIRE(actual[axis].m_min == expected[axis].m_min);
+                REQUIRE(actual[axis].m_max == expected[axis].m_max);
+            }
+        }
+    }
+
+    SECTION("Memory grows with the number of primitives")
+    {
+        REQUIRE(store.MemoryUsedBytes() > 0);
+        REQUIRE(PrimitiveStore().MemoryUsedBytes() == 0);
+    }
+}
+
+TEST_CASE("PrimitiveStore hits match the objects' own hits", "[PrimitiveStore]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SeedPositionRNG(7);
+
+    std::vector<IRayHittable*> objects;
+    for (int i = 0; i < 32; i++)
+    {
+        const Point3 position(RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0));
+        if (i % 2 == 0)
+        {
+            objects.push_back(allocator.Create<Sphere>(position, RandomPositionDouble(0.1, 1.0), material));
+        }
+        else
+        {
+            objects.push_back(allocator.Create<AxisAlignedBox>(position, position + Vec3(RandomPositionDouble(0.1, 1.0)), material));
+        }
+    }
+
+    const PrimitiveStore store(objects);
+
+    std::vector<PrimitiveId> ids;
+    for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+    {
+        ids.push_back(store.GetId(object_index));
+    }
+
+    for (int ray_index = 0; ray_index < 500; ray_index++)
+    {
+        const Point3 origin(RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0));
+        const Point3 target(RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0));
+        const Ray ray(origin, target - origin);
+        const Interval ray_t(0.001, infinity);
+
+        for (std::size_t object_index = 0; object_index < objects.size(); object_index++)
+        {
+            RayHitResult expected;
+            RayHitResult actual;
+            const bool expected_hit = objects[object_index]->Hit(ray, ray_t, expected);
+            REQUIRE(store.Hit(ids[object_index], ray, ray_t, actual) == expected_hit);
+            if (expected_hit)
+            {
+                REQUIRE(actual.m_hit_object == objects[object_index]);
+                actual.m_hit_object->SetHitAttributes(ray, actual);
+                REQUIRE(actual.m_t == expected.m_t);
+                REQUIRE(actual.m_material == expected.m_material);
+                REQUIRE(actual.m_is_front_facing == expected.m_is_front_facing);
+            }
+        }
+
+        // A whole range returns the closest hit, like a linear scan
+        RayHitResult expected;
+        bool expected_hit = false;
+        double closest = ray_t.m_max;
+        for (IRayHittable* object : objects)
+        {
+            if (object->Hit(ray, Interval(ray_t.m_min, closest), expected))
+            {
+                expected_hit = true;
+                closest = expected.m_t;
+            }
+        }
+
+        RayHitResult actual;
+        REQUIRE(store.Hit(ids.data(), ids.size(), ray, ray_t, actual) == expected_hit);
+        if (expected_hit)
+        {
+            REQUIRE(actual.m_t == expected.m_t);
+        }
+    }
+}
+
+TEST_CASE("PrimitiveStore sphere kernels agree", "[PrimitiveStore]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SeedPositionRNG(7);
+
+    std::vector<IRayHittable*> objects;
+    for (int i = 0; i < 64; i++)
+    {
+        const Point3 centre(RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0));
+        objects.push_back(allocator.Create<Sphere>(centre, RandomPositionDouble(0.1, 2.0), material));
+    }
+
+    const PrimitiveStore store(objects);
+
+    std::vector<PrimitiveStore::IntersectSpheresFunction> kernels = { &PrimitiveStore::IntersectSpheresScalar };
+#if defined(ART_X86_64)
+    if (CPUSupportsAVX2())
+    {
+        kernels.push_back(&PrimitiveStore::IntersectSpheresAVX2);
+    }
+#endif
+
+    for (int ray_index = 0; ray_index < 500; ray_index++)
+    {
+        const Point3 origin(RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0));
+        const Point3 target(RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0));
+        const Ray ray(origin, target - origin);
+        const double ray_t_max = (ray_index % 4 == 0) ? RandomPositionDouble(1.0, 2.0) : infinity;
+
+        // Both contiguous and scattered blocks of every size
+        uint32_t sphere_indices[PrimitiveStore::SPHERE_BLOCK_WIDTH];
+        const std::size_t num_spheres = 1 + (ray_index % PrimitiveStore::SPHERE_BLOCK_WIDTH);
+        const uint32_t first = static_cast<uint32_t>(ray_index % 60);
+        for (std::size_t position = 0; position < num_spheres; position++)
+        {
+            sphere_indices[position] = (ray_index % 2 == 0) ? first + static_cast<uint32_t>(position) : static_cast<uint32_t>((first * 7 + position * 13) % 64);
+        }
+
+        // Expected result from a sequence of Sphere::Hit calls
+        int expected_position = -1;
+        double expected_t = ray_t_max;
+        for (std::size_t position = 0; position < num_spheres; position++)
+        {
+            RayHitResult result;
+            if (objects[sphere_indices[position]]->Hit(ray, Interval(0.001, expected_t), result))
+            {
+                expected_position = static_cast<int>(position);
+                expected_t = result.m_t;
+            }
+        }
+
+        for (PrimitiveStore::IntersectSpheresFunction kernel : kernels)
+        {
+            double t = 0.0;
+            REQUIRE(kernel(store, sphere_indices, num_spheres, ray, 0.001, ray_t_max, t) == expected_position);
+            if (expected_position >= 0)
+            {
+                REQUIRE(t == expected_t);
+            }
+        }
+    }
+}
+
+// Clears the sphere kernel override when a test ends, including by a failed REQUIRE
+struct ScopedIntersectSpheresOverride
+{
+public:
+    ScopedIntersectSpheresOverride(PrimitiveStore::IntersectSpheresFunction intersect_spheres)
+    {
+        PrimitiveStore::SetIntersectSpheresOverride(intersect_spheres);
+    }
+
+    ~ScopedIntersectSpheresOverride()
+    {
+        PrimitiveStore::SetIntersectSpheresOverride(nullptr);
+    }
+};
+
+TEMPLATE_TEST_CASE
+(
+    "Acceleration structures find the same closest hit with either sphere kernel",
+    "[PrimitiveStore]",
+    FlatBVH, BVH4, LinearOctree, UniformGrid, HashedGrid, TwoLevelGrid, KDTreeNode, RopeKDTree, LooseOctree, ParametricOctree
+)
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SeedPositionRNG(7);
+
+    // Mostly spheres so leaves fill whole SIMD blocks, with some boxes mixed in
+    std::vector<IRayHittable*> objects;
+    for (int i = 0; i < 256; i++)
+    {
+        const Point3 centre(RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0));
+        if (i % 8 == 0)
+        {
+            const Vec3 half_size(RandomPositionDouble(0.1, 1.0), RandomPositionDouble(0.1, 1.0), RandomPositionDouble(0.1, 1.0));
+            objects.push_back(allocator.Create<AxisAlignedBox>(centre - half_size, centre + half_size, material));
+        }
+        else
+        {
+            objects.push_back(allocator.Create<Sphere>(centre, RandomPositionDouble(0.1, 1.5), material));
+        }
+    }
+
+    std::vector<IRayHittable*> scalar_objects = objects;
+    std::vector<IRayHittable*> default_objects = objects;
+    ScopedIntersectSpheresOverride scalar_override(&PrimitiveStore::IntersectSpheresScalar);
+    const TestType scalar_structure(scalar_objects);
+    PrimitiveStore::SetIntersectSpheresOverride(nullptr);
+    const TestType default_structure(default_objects);
+
+    for (int ray_index = 0; ray_index < 2000; ray_index++)
+    {
+        const Point3 origin(RandomPositionDouble(-20.0, 20.0), RandomPositionDouble(-20.0, 20.0), RandomPositionDouble(-20.0, 20.0));
+        const Point3 target(RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0));
+        const Ray ray(origin, target - origin);
+        const Interval ray_t(0.001, (ray_index % 4 == 0) ? RandomPositionDouble(0.5, 1.5) : infinity);
+
+        RayHitResult scalar_result;
+        RayHitResult default_result;
+        const bool scalar_hit = scalar_structure.HitDeferred(ray, ray_t, scalar_result);
+        const bool default_hit = default_structure.HitDeferred(ray, ray_t, default_result);
+
+        REQUIRE(default_hit == scalar_hit);
+        REQUIRE(default_structure.HitAny(ray, ray_t) == scalar_hit);
+        if (scalar_hit)
+        {
+            REQUIRE(default_result.m_t == scalar_result.m_t);
+            REQUIRE(default_result.m_hit_object == scalar_result.m_hit_object);
+        }
+    }
+}
+
+} // namespace ART
@@ -0,0 +1,56 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/RayMailbox.h>
+
+namespace ART
+{
+
+TEST_CASE("RayMailbox CheckAndMark reports repeat objects within a query", "[RayMailbox]")
+{
+    SECTION("Objects are new the first time they are seen")
+    {
+        const RayMailboxQuery mailbox_query(4);
+        REQUIRE(tl_ray_mailbox.CheckAndMark(0) == false);
+        REQUIRE(tl_ray_mailbox.CheckAndMark(3) == false);
+        REQUIRE(tl_ray_mailbox.CheckAndMark(0) == true);
+        REQUIRE(tl_ray_mailbox.CheckAndMark(3) == true);
+        REQUIRE(tl_ray_mailbox.CheckAndMark(1) == false);
+    }
+
+    SECTION("A new query forgets earlier objects")
+    {
+        {
+            const RayMailboxQuery mailbox_query(4);
+            REQUIRE(tl_ray_mailbox.CheckAndMark(2) == false);
+        }
+        {
+            const RayMailboxQuery mailbox_query(4);
+            REQUIRE(tl_ray_mailbox.CheckAndMark(2) == false);
+        }
+    }
+
+    SECTION("Queries grow the mailbox to fit their ids")
+    {
+        const RayMailboxQuery mailbox_query(100000);
+        REQUIRE(tl_ray_mailbox.CheckAndMark(99999) == false);
+        REQUIRE(tl_ray_mailbox.CheckAndMark(99999) == true);
+    }
+
+    SECTION("Nested queries are independent and restore the outer query")
+    {
+        const RayMailboxQuery outer_query(4);
+        REQUIRE(tl_ray_mailbox.CheckAndMark(0) == false);
+        {
+            const RayMailboxQuery inner_query(4);
+            REQUIRE(tl_ray_mailbox.CheckAndMark(1) == false);
+            REQUIRE(tl_ray_mailbox.CheckAndMark(2) == false);
+        }
+        REQUIRE(tl_ray_mailbox.CheckAndMark(0) == true);
+        // Marks made by the inner query don't count for the outer one
+        REQUIRE(tl_ray_mailbox.CheckAndMark(1) == false);
+        REQUIRE(tl_ray_mailbox.CheckAndMark(1) == true);
+    }
+}
+
+} // namespace ART
@@ -0,0 +1,98 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Core/Random.h>
+#include <Geometry/AxisAlignedBoundingBox.h>
+#include <RayTracing/RayPacket.h>
+
+namespace ART
+{
+
+TEST_CASE("RayPacket tracks its rays", "[RayPacket]")
+{
+    RayPacket packet;
+    packet.Clear();
+
+    REQUIRE(packet.m_size == 0);
+    REQUIRE(packet.AllRays() == 0);
+
+    packet.Add(Ray(Point3(0.0), Vec3(1.0, 1.0, -1.0)));
+    packet.Add(Ray(Point3(1.0, 0.0, 0.0), Vec3(0.5, 2.0, -1.0)));
+
+    REQUIRE(packet.m_size == 2);
+    REQUIRE(packet.AllRays() == 0b11);
+    REQUIRE(packet.m_is_coherent);
+    REQUIRE(packet.m_origin_min[0] == 0.0);
+    REQUIRE(packet.m_origin_max[0] == 1.0);
+    REQUIRE(packet.m_direction_is_negative[2]);
+    REQUIRE_FALSE(packet.m_direction_is_negative[0]);
+
+    const double ray_t_max[2] = { 3.0, 5.0 };
+    REQUIRE(packet.MaxRayT(0b01, ray_t_max) == 3.0);
+    REQUIRE(packet.MaxRayT(0b11, ray_t_max) == 5.0);
+
+    SECTION("Rays of different direction signs make the packet incoherent")
+    {
+        packet.Add(Ray(Point3(0.0), Vec3(-1.0, 1.0, -1.0)));
+        REQUIRE_FALSE(packet.m_is_coherent);
+    }
+
+    SECTION("A zero direction component makes the packet incoherent")
+    {
+        packet.Add(Ray(Point3(0.0), Vec3(0.0, 1.0, -1.0)));
+        REQUIRE_FALSE(packet.m_is_coherent);
+    }
+
+    SECTION("A full packet masks every ray")
+    {
+        packet.Clear();
+        for (std::size_t ray_index = 0; ray_index < RayPacket::MAX_SIZE; ray_index++)
+        {
+            packet.Add(Ray(Point3(0.0), Vec3(1.0, 1.0, -1.0)));
+        }
+        REQUIRE(packet.AllRays() == ~RayMask(0));
+    }
+}
+
+TEST_CASE("RayPacket MayHitBox never culls a box one of its rays hits", "[RayPacket]")
+{
+    SeedPositionRNG(7);
+
+    for (int packet_index = 0; packet_index < 200; packet_index++)
+    {
+        // Rays from a small patch of origins, each direction component keeping one sign
+        const double signs[3] = { (packet_index & 1) ? -1.0 : 1.0, (packet_index & 2) ? -1.0 : 1.0, (packet_index & 4) ? -1.0 : 1.0 };
+        const Point3 origin_centre(RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0));
+
+        RayPacket packet;
+        packet.Clear();
+        for (int ray_index = 0; ray_index < 16; ray_index++)
+        {
+            const Point3 origin = origin_centre + Vec3(RandomPositionDouble(-0.5, 0.5), RandomPositionDouble(-0.5, 0.5), RandomPositionDouble(-0.5, 0.5));
+            const Vec3 direction(signs[0] * RandomPositionDouble(0.1, 1.0), signs[1] * RandomPositionDouble(0.1, 1.0), signs[2] * RandomPositionDouble(0.1, 1.0));
+            packet.Add(Ray(origin, direction));
+        }
+        REQUIRE(packet.m_is_coherent);
+
+        for (int box_index = 0; box_index < 20; box_index++)
+        {
+            const Point3 box_min(RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0));
+            const AABB box(box_min, box_min + Vec3(RandomPositionDouble(0.1, 3.0), RandomPositionDouble(0.1, 3.0), RandomPositionDouble(0.1, 3.0)));
+            const double box_min_bounds[3] = { box.m_x.m_min, box.m_y.m_min, box.m_z.m_min };
+            const double box_max_bounds[3] = { box.m_x.m_max, box.m_y.m_max, box.m_z.m_max };
+
+            bool any_ray_hits = false;
+            for (std::size_t ray_index = 0; ray_index < packet.m_size; ray_index++)
+            {
+                any_ray_hits |= box.Hit(packet.m_rays[ray_index], Interval(0.001, infinity));
+            }
+
+            if (any_ray_hits)
+            {
+                REQUIRE(packet.MayHitBox(box_min_bounds, box_max_bounds, 0.001, infinity));
+            }
+        }
+    }
+}
+
+} // namespace ART
@@ -0,0 +1,174 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/FlatBoundingVolumeHierarchy.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Core/Random.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+#include <RayTracing/RayQueue.h>
+
+namespace ART
+{
+
+TEST_CASE("RayQueue stores rays", "[RayQueue]")
+{
+    RayQueue queue;
+    queue.Resize(2);
+
+    REQUIRE(queue.Size() == 2);
+
+    queue.SetRay(1, Ray(Point3(1.0, 2.0, 3.0), Vec3(0.0, 0.0, -2.0)));
+    const Ray ray = queue.GetRay(1);
+
+    REQUIRE(ray.m_origin.m_y == 2.0);
+    REQUIRE(ray.m_direction.m_z == -2.0);
+    REQUIRE(ray.m_inverse_direction.m_z == Approx(-0.5));
+    REQUIRE(queue.MemoryUsedBytes() > 0);
+}
+
+TEST_CASE("RayQueue AssignCompacted keeps flagged rays in order", "[RayQueue]")
+{
+    const std::size_t num_rays = 10000;
+
+    RayQueue queue;
+    queue.Resize(num_rays);
+
+    std::vector<uint8_t> keep(num_rays);
+    std::vector<uint32_t> expected_pixel_indices;
+    for (std::size_t index = 0; index < num_rays; index++)
+    {
+        queue.SetRay(index, Ray(Point3(static_cast<double>(index)), Vec3(1.0, 0.0, 0.0)));
+        queue.m_throughputs[index] = Colour(static_cast<double>(index));
+        queue.m_scatter_pdfs[index] = static_cast<double>(index) * 0.5;
+        queue.m_pixel_indices[index] = static_cast<uint32_t>(index);
+
+        keep[index] = (index % 3 == 0 || index % 7 == 0) ? 1 : 0;
+        if (keep[index])
+        {
+            expected_pixel_indices.push_back(static_cast<uint32_t>(index));
+        }
+    }
+
+    RayQueue compacted;
+    compacted.AssignCompacted(queue, keep);
+
+    REQUIRE(compacted.Size() == expected_pixel_indices.size());
+    for (std::size_t index = 0; index < compacted.Size(); index++)
+    {
+        const double source_index = static_cast<double>(expected_pixel_indices[index]);
+        REQUIRE(compacted.m_pixel_indices[index] == expected_pixel_indices[index]);
+        REQUIRE(compacted.m_origin_x[index] == source_index);
+        REQUIRE(compacted.m_throughputs[index].m_y == source_index);
+        REQUIRE(compacted.m_scatter_pdfs[index] == source_index * 0.5);
+    }
+
+    SECTION("Nothing kept")
+    {
+        std::fill(keep.begin(), keep.end(), 0);
+        compacted.AssignCompacted(queue, keep);
+        REQUIRE(compacted.Size() == 0);
+    }
+}
+
+TEST_CASE("RayQueue AssignSorted orders kept rays by octant and origin", "[RayQueue]")
+{
+    SeedPositionRNG(7);
+
+    const std::size_t num_rays = 5000;
+    const AABB bounds(Point3(-10.0), Point3(10.0));
+
+    RayQueue queue;
+    queue.Resize(num_rays);
+
+    std::vector<uint8_t> keep(num_rays);
+    std::size_t num_kept = 0;
+    for (std::size_t index = 0; index < num_rays; index++)
+    {
+        const Point3 origin(RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0));
+        const Vec3 direction(RandomPositionDouble(-1.0, 1.0), RandomPositionDouble(-1.0, 1.0), RandomPositionDouble(-1.0, 1.0));
+        queue.SetRay(index, Ray(origin, direction));
+        queue.m_throughputs[index] = Colour(static_cast<double>(index));
+        queue.m_pixel_indices[index] = static_cast<uint32_t>(index);
+
+        keep[index] = (index % 4 != 0) ? 1 : 0;
+        num_kept += keep[index];
+    }
+
+    RayQueue sorted;
+    sorted.AssignSorted(queue, keep, bounds);
+
+    REQUIRE(sorted.Size() == num_kept);
+
+    std::vector<uint8_t> seen(num_rays, 0);
+    for (std::size_t index = 0; index < sorted.Size(); index++)
+    {
+        // Each kept ray appears once, carrying its own data
+        const uint32_t source_index = sorted.m_pixel_indices[index];
+        REQUIRE(keep[source_index] == 1);
+        REQUIRE(seen[source_index] == 0);
+        seen[source_index] = 1;
+        REQUIRE(sorted.m_origin_x[index] == queue.m_origin_x[source_index]);
+        REQUIRE(sorted.m_direction_z[index] == queue.m_direction_z[source_index]);
+        REQUIRE(sorted.m_throughputs[index].m_x == static_cast<double>(source_index));
+
+        if (index > 0)
+        {
+            REQUIRE(sorted.SortKey(index - 1, bounds) <= sorted.SortKey(index, bounds));
+        }
+    }
+
+    SECTION("Rays of one octant sort together")
+    {
+        const uint64_t first_octant = sorted.SortKey(0, bounds) >> 61;
+        const uint64_t last_octant = sorted.SortKey(sorted.Size() - 1, bounds) >> 61;
+        REQUIRE(first_octant == 0);
+        REQUIRE(last_octant == 7);
+        REQUIRE(sorted.m_direction_x[0] >= 0.0);
+        REQUIRE(sorted.m_direction_x[sorted.Size() - 1] < 0.0);
+    }
+}
+
+TEST_CASE("RayQueue Trace finds the same hits as single rays", "[RayQueue]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SeedPositionRNG(7);
+
+    std::vector<IRayHittable*> objects;
+    for (int i = 0; i < 100; i++)
+    {
+        const Point3 centre(RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0));
+        objects.push_back(allocator.Create<Sphere>(centre, RandomPositionDouble(0.1, 1.0), material));
+    }
+
+    FlatBVH flat_bounding_volume_hierarchy(objects);
+
+    RayQueue queue;
+    queue.Resize(1000);
+    for (std::size_t index = 0; index < queue.Size(); index++)
+    {
+        const Point3 origin(RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0), RandomPositionDouble(-10.0, 10.0));
+        const Point3 target(RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0), RandomPositionDouble(-5.0, 5.0));
+        queue.SetRay(index, Ray(origin, target - origin));
+    }
+
+    queue.Trace(flat_bounding_volume_hierarchy, Interval(0.001, infinity));
+
+    for (std::size_t index = 0; index < queue.Size(); index++)
+    {
+        RayHitResult expected;
+        const bool expected_hit = flat_bounding_volume_hierarchy.Hit(queue.GetRay(index), Interval(0.001, infinity), expected);
+        REQUIRE((queue.m_hit_objects[index] != nullptr) == expected_hit);
+        if (expected_hit)
+        {
+            REQUIRE(queue.m_hit_t[index] == expected.m_t);
+            REQUIRE(queue.m_hit_objects[index] == expected.m_hit_object);
+        }
+    }
+}
+
+} // namespace ART
@@ -0,0 +1,273 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/RopeKDTree.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+#include <RayTracing/RayHittableList.h>
+
+namespace ART
+{
+
+TEST_CASE("RopeKDTree Hit detects intersections", "[RopeKDTree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SECTION("Empty tree never hits")
+    {
+        std::vector<IRayHittable*> objects;
+        RopeKDTree rope_kd_tree(objects);
+
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+        REQUIRE(rope_kd_tree.Hit(ray, Interval(0.001, infinity), result) == false);
+        REQUIRE(rope_kd_tree.MemoryUsedBytes() == 0);
+    }
+
+    SECTION("Ray hits closest object among multiple")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -10.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0,  -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0,  -3.0), 0.5, material));
+
+        RopeKDTree rope_kd_tree(objects);
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+
+        REQUIRE(rope_kd_tree.Hit(ray, Interval(0.001, infinity), result) == true);
+        REQUIRE(result.m_t == Approx(2.5));
+    }
+
+    SECTION("Ray respects interval bounds")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(3.0, 0.0, -5.0), 1.0, material));
+
+        RopeKDTree rope_kd_tree(objects);
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+
+        REQUIRE(rope_kd_tree.Hit(ray, Interval(10.0, infinity), result) == false);
+        REQUIRE(rope_kd_tree.Hit(ray, Interval(0.001, 3.0), result) == false);
+    }
+}
+
+TEST_CASE("RopeKDTree matches KDTreeNode results", "[RopeKDTree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int y = -5; y <= 5; y++)
+        {
+            const double z = -10.0 - static_cast<double>((x * 7 + y * 3 + 50) % 5);
+            const double radius = 0.3 + 0.15 * static_cast<double>((x + y + 10) % 7);
+            objects.push_back(allocator.Create<Sphere>(Point3(x, y, z), radius, material));
+        }
+    }
+
+    KDTreeNode kd_tree(objects);
+    RopeKDTree rope_kd_tree(objects);
+
+    SECTION("Ropes on the tree boundary are empty, all others link to a node")
+    {
+        const AABB root_box = rope_kd_tree.BoundingBox();
+        const std::vector<RopeKDTreeLeaf>& leaves = rope_kd_tree.GetLeaves();
+        REQUIRE(leaves.size() > 1);
+
+        for (const RopeKDTreeLeaf& leaf : leaves)
+        {
+            for (std::size_t axis = 0; axis < 3; axis++)
+            {
+                const bool on_min_boundary = leaf.bounds_min[axis] == root_box[axis].m_min;
+                const bool on_max_boundary = leaf.bounds_max[axis] == root_box[axis].m_max;
+                REQUIRE((leaf.ropes[2 * axis] == RopeKDTreeLeaf::NO_ROPE) == on_min_boundary);
+                REQUIRE((leaf.ropes[2 * axis + 1] == RopeKDTreeLeaf::NO_ROPE) == on_max_boundary);
+            }
+        }
+    }
+
+    SECTION("Closest hits agree for rays from several origins")
+    {
+        const Point3 origins[3] = { Point3(0.0, 0.0, 0.0), Point3(3.0, -2.0, -12.0), Point3(-20.0, 1.0, -11.0) };
+        for (const Point3& origin : origins)
+        {
+            for (int ray_x = -20; ray_x <= 20; ray_x++)
+            {
+                for (int ray_y = -20; ray_y <= 20; ray_y++)
+                {
+                    const Ray ray(origin, Point3(ray_x * 0.3, ray_y * 0.3, -12.0) - origin);
+
+                    RayHitResult kd_tree_result;
+                    RayHitResult rope_kd_tree_result;
+                    const bool kd_tree_hit = kd_tree.Hit(ray, Interval(0.001, infinity), kd_tree_result);
+                    const bool rope_kd_tree_hit = rope_kd_tree.Hit(ray, Interval(0.001, infinity), rope_kd_tree_result);
+
+                    REQUIRE(rope_kd_tree_hit == kd_tree_hit);
+                    REQUIRE(rope_kd_tree.HitAny(ray, Interval(0.001, infinity)) == kd_tree_hit);
+                    if (kd_tree_hit)
+                    {
+                        REQUIRE(rope_kd_tree_result.m_t == Approx(kd_tree_result.m_t));
+                        REQUIRE_FALSE(rope_kd_tree.HitAny(ray, Interval(0.001, 0.999 * kd_tree_result.m_t)));
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Axis aligned rays walk through the tree")
+    {
+        for (int i = -5; i <= 5; i++)
+        {
+            const Ray ray(Point3(static_cast<double>(i), 0.0, 10.0), Vec3(0.0, 0.0, -1.0));
+
+            RayHitResult kd_tree_result;
+            RayHitResult rope_kd_tree_result;
+            const bool kd_tree_hit = kd_tree.Hit(ray, Interval(0.001, infinity), kd_tree_result);
+            const bool rope_kd_tree_hit = rope_kd_tree.Hit(ray, Interval(0.001, infinity), rope_kd_tree_result);
+
+            REQUIRE(rope_kd_tree_hit == kd_tree_hit);
+            REQUIRE(rope_kd_tree.HitAny(ray, Interval(0.001, infinity)) == kd_tree_hit);
+            if (kd_tree_hit)
+            {
+                REQUIRE(rope_kd_tree_result.m_t == Approx(kd_tree_result.m_t));
+                REQUIRE_FALSE(rope_kd_tree.HitAny(ray, Interval(0.001, 0.999 * kd_tree_result.m_t)));
+            }
+        }
+    }
+
+    SECTION("Ropes cost extra memory")
+    {
+        REQUIRE(rope_kd_tree.MemoryUsedBytes() == kd_tree.MemoryUsedBytes() + rope_kd_tree.GetLeaves().size() * sizeof(RopeKDTreeLeaf));
+    }
+}
+
+TEST_CASE("RopeKDTree matches brute force for rays along leaf faces and edges", "[RopeKDTree]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Small spheres in lattice cells put split planes on the lattice coordinates the rays below run along
+    // Spheres only touch their bounds at face centres, so rays along those planes have no tangent hits to disagree on
+    // Larger spheres around the lattice points straddle the planes, giving those rays something to hit
+    std::vector<IRayHittable*> objects;
+    RayHittableList brute_force;
+    for (int x = 0; x < 6; x++)
+    {
+        for (int y = 0; y < 6; y++)
+        {
+            for (int z = 0; z < 6; z++)
+            {
+                const int pattern = (x * 5 + y * 3 + z) % 7;
+                IRayHittable* sphere = nullptr;
+                if (pattern < 3)
+                {
+                    sphere = allocator.Create<Sphere>(Point3(x + 0.25, y + 0.25, z + 0.25), 0.25, material);
+                }
+                else if (pattern == 3)
+                {
+                    sphere = allocator.Create<Sphere>(Point3(x + 0.5, y + 0.5, z + 0.5), 0.6, material);
+                }
+                else
+                {
+                    continue;
+                }
+                objects.push_back(sphere);
+                brute_force.Add(sphere);
+            }
+        }
+    }
+
+    RopeKDTree rope_kd_tree(objects);
+    REQUIRE(rope_kd_tree.GetLeaves().size() > 1);
+
+    const auto require_brute_force_hit = [&](const Ray& ray)
+    {
+        RayHitResult expected;
+        RayHitResult result;
+        const bool expected_hit = brute_force.Hit(ray, Interval(0.001, infinity), expected);
+
+        REQUIRE(rope_kd_tree.Hit(ray, Interval(0.001, infinity), result) == expected_hit);
+        REQUIRE(rope_kd_tree.HitAny(ray, Interval(0.001, infinity)) == expected_hit);
+        if (expected_hit)
+        {
+            REQUIRE(result.m_t == Approx(expected.m_t));
+        }
+    };
+
+    const double lattice_coordinates[5] = { 0.0, 0.5, 1.0, 2.5, 3.0 };
+
+    SECTION("Axis aligned rays running along split planes and their edges")
+    {
+        for (std::size_t axis = 0; axis < 3; axis++)
+        {
+            for (const double u : lattice_coordinates)
+            {
+                for (const double v : lattice_coordinates)
+                {
+                    for (const double sign : { 1.0, -1.0 })
+                    {
+                        Vec3 origin;
+                        Vec3 direction(0.0);
+                        origin[axis] = (sign > 0.0) ? -1.0 : 7.0;
+                        origin[(axis + 1) % 3] = u;
+                        origin[(axis + 2) % 3] = v;
+                        direction[axis] = sign;
+                        require_brute_force_hit(Ray(origin, direction));
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Diagonal rays through lattice corners, crossing several planes at once")
+    {
+        const Vec3 directions[6] =
+        {
+            Vec3(1.0, 1.0, 1.0), Vec3(-1.0, -1.0, -1.0), Vec3(1.0, -1.0, 1.0),
+            Vec3(1.0, 1.0, 0.0), Vec3(0.0, -1.0, 1.0), Vec3(-1.0, 0.0, -1.0)
+        };
+        // Integer lattice points only, diagonals through half-integer points also pass through the small spheres'
+        // face centres, grazing them exactly where they touch a split plane
+        const double integer_coordinates[3] = { 0.0, 1.0, 3.0 };
+        for (const Vec3& direction : directions)
+        {
+            for (const double u : integer_coordinates)
+            {
+                for (const double v : integer_coordinates)
+                {
+                    // Start well outside the tree on a lattice point of the line through (u, v, 3)
+                    const Point3 through(u, v, 3.0);
+                    require_brute_force_hit(Ray(through - 8.0 * direction, direction));
+                }
+            }
+        }
+    }
+
+    SECTION("Grazing rays nearly parallel to split planes")
+    {
+        const double slopes[3] = { 1e-12, 1e-7, 1e-3 };
+        for (const double slope : slopes)
+        {
+            for (const double u : lattice_coordinates)
+            {
+                require_brute_force_hit(Ray(Point3(-1.0, u, 0.5), Vec3(1.0, slope, 0.0)));
+                require_brute_force_hit(Ray(Point3(7.0, u, 1.0), Vec3(-1.0, -slope, slope)));
+                require_brute_force_hit(Ray(Point3(u, -1.0, 3.0), Vec3(slope, 1.0, -slope)));
+                require_brute_force_hit(Ray(Point3(0.5, u, 7.0), Vec3(-slope, 0.0, -1.0)));
+            }
+        }
+    }
+}
+
+} // namespace ART
@@ -114,4 +114,49 @@ TEST_CASE("Sphere BoundingBox returns expected box", "[Sphere]")
     REQUIRE(aabb.m_z.m_max == Approx(1.0));
 }
 
+TEST_CASE("Sphere SampleDirection draws directions towards the sphere with their DirectionPdf", "[Sphere]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    const Sphere sphere(Point3(1.0, 2.0, -1.0), 1.0, material);
+    const Point3 origin(4.0, 2.0, -1.0);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        const Vec3 direction = sphere.SampleDirection(origin);
+        RayHitResult result;
+        REQUIRE(sphere.Hit(Ray(origin, direction), Interval(0.0, infinity), result));
+        REQUIRE(sphere.DirectionPdf(origin, direction) > 0.0);
+    }
+
+    REQUIRE(sphere.DirectionPdf(origin, Vec3(0.0, 0.0, 1.0)) == 0.0);
+
+    SECTION("DirectionPdf integrates to 1 over all directions")
+    {
+        // Midpoint rule over cells of equal solid angle, uniform in cos(theta) and phi
+        const int num_z_cells = 1000;
+        const int num_phi_cells = 2000;
+        const double cell_solid_angle = (4.0 * pi) / (num_z_cells * num_phi_cells);
+        double integral = 0.0;
+        for (int z_cell = 0; z_cell < num_z_cells; z_cell++)
+        {
+            const double z = -1.0 + ((z_cell + 0.5) * 2.0) / num_z_cells;
+            const double radius = std::sqrt(1.0 - (z * z));
+            for (int phi_cell = 0; phi_cell < num_phi_cells; phi_cell++)
+            {
+                const double phi = ((phi_cell + 0.5) * 2.0 * pi) / num_phi_cells;
+                integral += sphere.DirectionPdf(origin, Vec3(radius * std::cos(phi), radius * std::sin(phi), z)) * cell_solid_angle;
+            }
+        }
+        REQUIRE(integral == Approx(1.0).epsilon(0.01));
+    }
+
+    SECTION("Directions from inside the sphere are uniform over the sphere of directions")
+    {
+        REQUIRE(sphere.DirectionPdf(Point3(1.0, 2.0, -1.5), Vec3(0.0, 1.0, 0.0)) == Approx(1.0 / (4.0 * pi)));
+    }
+}
+
 } // namespace ART
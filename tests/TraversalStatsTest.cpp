@@ -61,6 +61,29 @@ TEST_CASE("TraversalStats averages return zero when no rays cast", "[TraversalSt
     REQUIRE(stats.AvgIntersectionTestsPerRay() == Approx(0.0));
 }
 
+TEST_CASE("TraversalStats occlusion averages", "[TraversalStats]")
+{
+    TraversalStats stats;
+    REQUIRE(stats.AvgNodesTraversedPerOcclusionRay() == Approx(0.0));
+    REQUIRE(stats.AvgIntersectionTestsPerOcclusionRay() == Approx(0.0));
+
+    stats.total_occlusion_rays_cast = 4;
+    stats.total_occlusion_nodes_traversed = 30;
+    stats.total_occlusion_intersection_tests = 6;
+    REQUIRE(stats.AvgNodesTraversedPerOcclusionRay() == Approx(7.5));
+    REQUIRE(stats.AvgIntersectionTestsPerOcclusionRay() == Approx(1.5));
+}
+
+TEST_CASE("TraversalStats packet utilisation", "[TraversalStats]")
+{
+    TraversalStats stats;
+    REQUIRE(stats.PacketUtilisation() == Approx(0.0));
+
+    stats.total_packet_ray_slots = 128;
+    stats.total_packet_active_rays = 96;
+    REQUIRE(stats.PacketUtilisation() == Approx(0.75));
+}
+
 TEST_CASE("Record helpers increment the thread-local traversal counters", "[TraversalStats]")
 {
     tl_traversal_counters.Reset();
@@ -74,6 +97,12 @@ TEST_CASE("Record helpers increment the thread-local traversal counters", "[Trav
     REQUIRE(tl_traversal_counters.intersection_tests == 1);
     REQUIRE(tl_traversal_counters.rays_cast == 1);
 
+    RecordPacketNodeTraversal(64, 10);
+
+    REQUIRE(tl_traversal_counters.nodes_traversed == 12);
+    REQUIRE(tl_traversal_counters.packet_ray_slots == 64);
+    REQUIRE(tl_traversal_counters.packet_active_rays == 10);
+
     // Reset for other tests, not constrained to this scope
     tl_traversal_counters.Reset();
 }
@@ -0,0 +1,169 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/TwoLevelGrid.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Core/TraversalStats.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+#include <RayTracing/RayHittableList.h>
+
+namespace ART
+{
+
+TEST_CASE("TwoLevelGrid Hit detects intersections", "[TwoLevelGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SECTION("Empty grid never hits")
+    {
+        std::vector<IRayHittable*> objects;
+        TwoLevelGrid two_level_grid(objects);
+
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+        REQUIRE(two_level_grid.Hit(ray, Interval(0.001, infinity), result) == false);
+        REQUIRE(two_level_grid.MemoryUsedBytes() == 0);
+    }
+
+    SECTION("Ray hits closest object among multiple")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -10.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0,  -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0,  -3.0), 0.5, material));
+
+        TwoLevelGrid two_level_grid(objects);
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+
+        REQUIRE(two_level_grid.Hit(ray, Interval(0.001, infinity), result) == true);
+        REQUIRE(result.m_t == Approx(2.5));
+    }
+
+    SECTION("Ray respects interval bounds")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(3.0, 0.0, -5.0), 1.0, material));
+
+        TwoLevelGrid two_level_grid(objects);
+        const Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+        RayHitResult result;
+
+        REQUIRE(two_level_grid.Hit(ray, Interval(10.0, infinity), result) == false);
+        REQUIRE(two_level_grid.Hit(ray, Interval(0.001, 3.0), result) == false);
+    }
+}
+
+TEST_CASE("TwoLevelGrid refines dense cells only", "[TwoLevelGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // A dense cluster in one corner and sparse objects spread over the rest of the scene
+    std::vector<IRayHittable*> objects;
+    for (int x = 0; x < 10; x++)
+    {
+        for (int y = 0; y < 10; y++)
+        {
+            for (int z = 0; z < 10; z++)
+            {
+                objects.push_back(allocator.Create<Sphere>(Point3(x * 0.3, y * 0.3, z * 0.3), 0.1, material));
+            }
+        }
+    }
+    for (int x = 0; x < 4; x++)
+    {
+        for (int z = 0; z < 4; z++)
+        {
+            objects.push_back(allocator.Create<Sphere>(Point3(20.0 + x * 25.0, 50.0, 20.0 + z * 25.0), 0.5, material));
+        }
+    }
+
+    TwoLevelGrid two_level_grid(objects);
+    const Vec3Int num_cells = two_level_grid.GetNumCells();
+    const std::size_t num_top_level_cells = static_cast<std::size_t>(num_cells.m_x) * num_cells.m_y * num_cells.m_z;
+
+    // Leaf cells follow the objects, not the volume of the scene
+    REQUIRE(two_level_grid.GetNumLeafCells() > num_top_level_cells);
+    REQUIRE(two_level_grid.GetNumLeafCells() < objects.size() * static_cast<std::size_t>(TwoLevelGrid::LEAF_DENSITY * 4.0));
+    REQUIRE(two_level_grid.GetNumObjectReferences() >= objects.size());
+
+    // Through the middle of the cluster, most of its 1000 spheres share a top level cell but are never tested
+    const Ray ray(Point3(1.35, 1.35, -5.0), Vec3(0.01, 0.01, 1.0));
+    RayHitResult result;
+
+    tl_traversal_counters.Reset();
+    REQUIRE(two_level_grid.Hit(ray, Interval(0.001, infinity), result) == false);
+    REQUIRE(tl_traversal_counters.intersection_tests < 400);
+    tl_traversal_counters.Reset();
+}
+
+TEST_CASE("TwoLevelGrid matches brute force results", "[TwoLevelGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    RayHittableList brute_force;
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int y = -5; y <= 5; y++)
+        {
+            const double z = -10.0 - static_cast<double>((x * 7 + y * 3 + 50) % 5);
+            const double radius = 0.1 + 0.4 * static_cast<double>((x + y + 10) % 7);
+            IRayHittable* sphere = allocator.Create<Sphere>(Point3(x, y, z), radius, material);
+            objects.push_back(sphere);
+            brute_force.Add(sphere);
+        }
+    }
+
+    // A distant cluster leaves most of the grid empty
+    for (int x = 0; x < 4; x++)
+    {
+        IRayHittable* sphere = allocator.Create<Sphere>(Point3(200.0 + x, 50.0, -80.0), 0.5, material);
+        objects.push_back(sphere);
+        brute_force.Add(sphere);
+    }
+
+    TwoLevelGrid two_level_grid(objects);
+
+    const Point3 origins[3] = { Point3(0.0, 0.0, 0.0), Point3(3.0, -2.0, -12.0), Point3(-20.0, 1.0, -11.0) };
+    for (const Point3& origin : origins)
+    {
+        for (int ray_x = -20; ray_x <= 20; ray_x++)
+        {
+            for (int ray_y = -20; ray_y <= 20; ray_y++)
+            {
+                const Ray ray(origin, Point3(ray_x * 0.3, ray_y * 0.3, -12.0) - origin);
+
+                RayHitResult brute_force_result;
+                RayHitResult two_level_grid_result;
+                const bool brute_force_hit = brute_force.Hit(ray, Interval(0.001, infinity), brute_force_result);
+                const bool two_level_grid_hit = two_level_grid.Hit(ray, Interval(0.001, infinity), two_level_grid_result);
+
+                REQUIRE(two_level_grid_hit == brute_force_hit);
+                REQUIRE(two_level_grid.HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+                if (brute_force_hit)
+                {
+                    REQUIRE(two_level_grid_result.m_t == Approx(brute_force_result.m_t));
+                    REQUIRE_FALSE(two_level_grid.HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+                }
+            }
+        }
+    }
+
+    // Axis-aligned rays towards the distant cluster
+    const Ray axis_ray(Point3(150.0, 50.0, -80.0), Vec3(1.0, 0.0, 0.0));
+    RayHitResult result;
+    REQUIRE(two_level_grid.Hit(axis_ray, Interval(0.001, infinity), result) == true);
+    REQUIRE(result.m_t == Approx(49.5));
+}
+
+} // namespace ART
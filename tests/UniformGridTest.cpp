@@ -4,8 +4,11 @@
 #include <Acceleration/UniformGrid.h>
 #include <Core/ArenaAllocator.h>
 #include <Core/Constants.h>
+#include <Core/TraversalStats.h>
+#include <Geometry/AxisAlignedBox.h>
 #include <Geometry/Sphere.h>
 #include <Materials/Material.h>
+#include <RayTracing/RayHittableList.h>
 
 namespace ART
 {
@@ -172,7 +175,7 @@ TEST_CASE("UniformGrid Hit detects large sphere spanning multiple cells", "[Unif
 
 TEST_CASE("UniformGrid Hit works with a single-object scene", "[UniformGrid]")
 {
-    // With only 1 object, DetermineCellSize produces a cell size of 3*max_extent,
+    // With only 1 object, DetermineResolution gives a single cell on every axis,
     // so the whole scene fits in single 1x1x1 grid (one cell).
     ArenaAllocator allocator(ONE_MEGABYTE);
     Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
@@ -203,6 +206,59 @@ TEST_CASE("UniformGrid Hit works with a single-object scene", "[UniformGrid]")
     }
 }
 
+TEST_CASE("UniformGrid Hit works with a planar scene", "[UniformGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Unpadded zero-thickness tiles in the plane z = -5, so the scene bounds have no extent along z
+    std::vector<IRayHittable*> objects;
+    for (int x = -4; x < 4; x++)
+    {
+        for (int y = -4; y < 4; y++)
+        {
+            const AABB tile(x + 0.1, x + 0.9, y + 0.1, y + 0.9, -5.0, -5.0);
+            objects.push_back(allocator.Create<AxisAlignedBox>(tile, material));
+        }
+    }
+
+    RayHittableList brute_force;
+    for (IRayHittable* object : objects)
+    {
+        brute_force.Add(object);
+    }
+    UniformGrid grid(objects);
+
+    // Cells along the flat axis must still have a size, Calculate3DIndex divides by it
+    REQUIRE(grid.GetNumCells().m_z == 1);
+    REQUIRE(grid.GetCellSize().m_z > 0.0);
+
+    for (int ray_x = -20; ray_x <= 20; ray_x++)
+    {
+        for (int ray_y = -20; ray_y <= 20; ray_y++)
+        {
+            // Rays straight down the flat axis, and slanted ones crossing cells as they cross the plane
+            const Vec3 directions[2] = { Vec3(0.0, 0.0, -1.0), Vec3(0.3, -0.2, -1.0) };
+            for (const Vec3& direction : directions)
+            {
+                const Ray ray(Point3(ray_x * 0.23, ray_y * 0.23, 0.0), direction);
+
+                RayHitResult expected;
+                RayHitResult result;
+                const bool expected_hit = brute_force.Hit(ray, Interval(0.001, infinity), expected);
+                const bool hit = grid.Hit(ray, Interval(0.001, infinity), result);
+
+                REQUIRE(hit == expected_hit);
+                if (expected_hit)
+                {
+                    REQUIRE(result.m_t == Approx(expected.m_t));
+                }
+            }
+        }
+    }
+}
+
 TEST_CASE("UniformGrid MemoryUsedBytes is non-zero for a non-trivial scene", "[UniformGrid]")
 {
     ArenaAllocator allocator(ONE_MEGABYTE);
@@ -241,4 +297,149 @@ TEST_CASE("UniformGrid BoundingBox encloses all objects in grid", "[UniformGrid]
     REQUIRE(box.m_z.m_max >= 6.0);
 }
 
+TEST_CASE("UniformGrid tests each object at most once per ray", "[UniformGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    // Large overlapping spheres, each spans every cell of the grid
+    std::vector<IRayHittable*> objects;
+    for (int x = 0; x < 10; x++)
+    {
+        for (int y = 0; y < 10; y++)
+        {
+            for (int z = 0; z < 10; z++)
+            {
+                objects.push_back(allocator.Create<Sphere>(Point3(x * 0.2 - 1.0, y * 0.2 - 1.0, z * 0.2 - 1.0), 20.0, material));
+            }
+        }
+    }
+
+    UniformGrid grid(objects);
+
+    // Passes through a corner of the grid, crossing several cells without hitting any sphere
+    const Ray ray(Point3(19.0, 19.0, 30.0), Vec3(-0.02, -0.02, -1.0));
+    RayHitResult result;
+
+    tl_traversal_counters.Reset();
+    REQUIRE(grid.Hit(ray, Interval(0.001, infinity), result) == false);
+    REQUIRE(tl_traversal_counters.nodes_traversed > 1);
+    REQUIRE(tl_traversal_counters.intersection_tests == objects.size());
+
+    // A second ray gets a new mailbox query
+    tl_traversal_counters.Reset();
+    REQUIRE(grid.Hit(ray, Interval(0.001, infinity), result) == false);
+    REQUIRE(tl_traversal_counters.intersection_tests == objects.size());
+
+    tl_traversal_counters.Reset();
+}
+
+TEST_CASE("UniformGrid resolution follows the shape of the bounds", "[UniformGrid]")
+{
+    SECTION("Cube")
+    {
+        const Vec3Int resolution = UniformGrid::DetermineResolution(AABB(Point3(0.0, 0.0, 0.0), Point3(10.0, 10.0, 10.0)), 1000, 8.0);
+        REQUIRE(resolution.m_x == 20);
+        REQUIRE(resolution.m_y == 20);
+        REQUIRE(resolution.m_z == 20);
+    }
+
+    SECTION("Long corridor")
+    {
+        const Vec3Int resolution = UniformGrid::DetermineResolution(AABB(Point3(0.0, 0.0, 0.0), Point3(2.0, 2.0, 100.0)), 50, 1.0);
+        REQUIRE(resolution.m_x == 1);
+        REQUIRE(resolution.m_y == 1);
+        REQUIRE(resolution.m_z == 50);
+    }
+
+    SECTION("Flat plane gets a 2D grid")
+    {
+        const Vec3Int resolution = UniformGrid::DetermineResolution(AABB(Point3(0.0, 0.0, 0.0), Point3(100.0, 0.0, 50.0)), 50, 1.0);
+        REQUIRE(resolution.m_x == 10);
+        REQUIRE(resolution.m_y == 1);
+        REQUIRE(resolution.m_z == 5);
+    }
+
+    SECTION("Empty")
+    {
+        const Vec3Int resolution = UniformGrid::DetermineResolution(AABB(), 0, 1.0);
+        REQUIRE(resolution.m_x == 1);
+        REQUIRE(resolution.m_y == 1);
+        REQUIRE(resolution.m_z == 1);
+    }
+}
+
+TEST_CASE("UniformGrid density settings", "[UniformGrid]")
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.5));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    RayHittableList brute_force;
+    for (int i = 0; i < 500; i++)
+    {
+        const double x = static_cast<double>((i * 37) % 101) * 0.5;
+        const double y = static_cast<double>((i * 53) % 11) * 0.5;
+        const double z = static_cast<double>((i * 71) % 97) * 0.5;
+        const double radius = 0.1 + 0.1 * static_cast<double>(i % 5);
+        IRayHittable* sphere = allocator.Create<Sphere>(Point3(x, y, z), radius, material);
+        objects.push_back(sphere);
+        brute_force.Add(sphere);
+    }
+
+    UniformGridConfig coarse_config;
+    coarse_config.density = 0.5;
+    UniformGridConfig fine_config;
+    fine_config.density = 8.0;
+    UniformGridConfig auto_tune_config;
+    auto_tune_config.auto_tune_density = true;
+
+    const UniformGrid coarse_grid(objects, coarse_config);
+    const UniformGrid fine_grid(objects, fine_config);
+    const UniformGrid auto_tuned_grid(objects, auto_tune_config);
+
+    REQUIRE(coarse_grid.GetDensity() == 0.5);
+    REQUIRE(fine_grid.GetDensity() == 8.0);
+    REQUIRE(auto_tuned_grid.GetDensity() >= UniformGrid::MIN_AUTO_TUNE_DENSITY);
+    REQUIRE(auto_tuned_grid.GetDensity() <= UniformGrid::MAX_AUTO_TUNE_DENSITY);
+
+    const Vec3Int coarse_cells = coarse_grid.GetNumCells();
+    const Vec3Int fine_cells = fine_grid.GetNumCells();
+    REQUIRE(coarse_cells.m_x * coarse_cells.m_y * coarse_cells.m_z < fine_cells.m_x * fine_cells.m_y * fine_cells.m_z);
+    // The scene is flattened along y, and cells stay roughly cubic
+    REQUIRE(fine_cells.m_y < fine_cells.m_x);
+    REQUIRE(fine_grid.GetCellSize().m_x == Approx(fine_grid.GetCellSize().m_y).epsilon(0.5));
+
+    // Rays from inside and outside the grid, including ones entering through its sides
+    const Point3 origins[3] = { Point3(25.0, 2.5, 24.0), Point3(-30.0, 10.0, 20.0), Point3(60.0, -5.0, 70.0) };
+    for (const UniformGrid* grid : { &coarse_grid, &fine_grid, &auto_tuned_grid })
+    {
+        for (const Point3& origin : origins)
+        {
+            for (int ray_x = -10; ray_x <= 10; ray_x++)
+            {
+                for (int ray_z = -10; ray_z <= 10; ray_z++)
+                {
+                    const Ray ray(origin, Point3(25.0 + ray_x * 2.7, 2.5, 24.0 + ray_z * 2.6) - origin);
+
+                    RayHitResult brute_force_result;
+                    RayHitResult grid_result;
+                    const bool brute_force_hit = brute_force.Hit(ray, Interval(0.001, infinity), brute_force_result);
+                    const bool grid_hit = grid->Hit(ray, Interval(0.001, infinity), grid_result);
+
+                    REQUIRE(grid_hit == brute_force_hit);
+                    REQUIRE(grid->HitAny(ray, Interval(0.001, infinity)) == brute_force_hit);
+                    if (brute_force_hit)
+                    {
+                        REQUIRE(grid_result.m_t == Approx(brute_force_result.m_t));
+                        REQUIRE_FALSE(grid->HitAny(ray, Interval(0.001, 0.999 * brute_force_result.m_t)));
+                    }
+                }
+            }
+        }
+    }
+}
+
 } // namespace ART
@@ -42,10 +42,22 @@ TEST_CASE("AccelerationStructureToString returns non-empty string for each value
     REQUIRE(AccelerationStructureToString(AccelerationStructure::NONE) != "");
     REQUIRE(AccelerationStructureToString(AccelerationStructure::UNIFORM_GRID) != "");
     REQUIRE(AccelerationStructureToString(AccelerationStructure::HIERARCHICAL_UNIFORM_GRID) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::HASHED_GRID) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::TWO_LEVEL_GRID) != "");
     REQUIRE(AccelerationStructureToString(AccelerationStructure::OCTREE) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::PARAMETRIC_OCTREE) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::LOOSE_OCTREE) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::LINEAR_OCTREE) != "");
     REQUIRE(AccelerationStructureToString(AccelerationStructure::BSP_TREE) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::ADAPTIVE_BSP_TREE) != "");
     REQUIRE(AccelerationStructureToString(AccelerationStructure::K_D_TREE) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::ROPE_K_D_TREE) != "");
     REQUIRE(AccelerationStructureToString(AccelerationStructure::BOUNDING_VOLUME_HIERARCHY) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::FLAT_BOUNDING_VOLUME_HIERARCHY) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_4) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_8) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY) != "");
+    REQUIRE(AccelerationStructureToString(AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY_OPTIMISED) != "");
 }
 
 TEST_CASE("AccelerationStructureToString returns distinct strings", "[Utility]")
@@ -53,10 +65,22 @@ TEST_CASE("AccelerationStructureToString returns distinct strings", "[Utility]")
     const std::string none_str  = AccelerationStructureToString(AccelerationStructure::NONE);
     const std::string uniform_grid_str  = AccelerationStructureToString(AccelerationStructure::UNIFORM_GRID);
     const std::string hierarchical_uniform_grid_str = AccelerationStructureToString(AccelerationStructure::HIERARCHICAL_UNIFORM_GRID);
+    const std::string hashed_grid_str = AccelerationStructureToString(AccelerationStructure::HASHED_GRID);
+    const std::string two_level_grid_str = AccelerationStructureToString(AccelerationStructure::TWO_LEVEL_GRID);
     const std::string octree_str   = AccelerationStructureToString(AccelerationStructure::OCTREE);
+    const std::string parametric_octree_str = AccelerationStructureToString(AccelerationStructure::PARAMETRIC_OCTREE);
+    const std::string loose_octree_str = AccelerationStructureToString(AccelerationStructure::LOOSE_OCTREE);
+    const std::string linear_octree_str = AccelerationStructureToString(AccelerationStructure::LINEAR_OCTREE);
     const std::string bsp_tree_str   = AccelerationStructureToString(AccelerationStructure::BSP_TREE);
+    const std::string adaptive_bsp_tree_str = AccelerationStructureToString(AccelerationStructure::ADAPTIVE_BSP_TREE);
     const std::string k_d_tree_str    = AccelerationStructureToString(AccelerationStructure::K_D_TREE);
+    const std::string rope_k_d_tree_str = AccelerationStructureToString(AccelerationStructure::ROPE_K_D_TREE);
     const std::string bounding_volume_hierarchy_str   = AccelerationStructureToString(AccelerationStructure::BOUNDING_VOLUME_HIERARCHY);
+    const std::string flat_bounding_volume_hierarchy_str = AccelerationStructureToString(AccelerationStructure::FLAT_BOUNDING_VOLUME_HIERARCHY);
+    const std::string wide_bounding_volume_hierarchy_4_str = AccelerationStructureToString(AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_4);
+    const std::string wide_bounding_volume_hierarchy_8_str = AccelerationStructureToString(AccelerationStructure::WIDE_BOUNDING_VOLUME_HIERARCHY_8);
+    const std::string linear_bounding_volume_hierarchy_str = AccelerationStructureToString(AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY);
+    const std::string linear_bounding_volume_hierarchy_optimised_str = AccelerationStructureToString(AccelerationStructure::LINEAR_BOUNDING_VOLUME_HIERARCHY_OPTIMISED);
 
     REQUIRE(none_str != uniform_grid_str);
     REQUIRE(none_str != hierarchical_uniform_grid_str);
@@ -67,6 +91,40 @@ TEST_CASE("AccelerationStructureToString returns distinct strings", "[Utility]")
     REQUIRE(uniform_grid_str != hierarchical_uniform_grid_str);
     REQUIRE(bsp_tree_str != k_d_tree_str);
     REQUIRE(k_d_tree_str != bounding_volume_hierarchy_str);
+    REQUIRE(bounding_volume_hierarchy_str != flat_bounding_volume_hierarchy_str);
+    REQUIRE(flat_bounding_volume_hierarchy_str != wide_bounding_volume_hierarchy_4_str);
+    REQUIRE(wide_bounding_volume_hierarchy_4_str != wide_bounding_volume_hierarchy_8_str);
+    REQUIRE(wide_bounding_volume_hierarchy_8_str != linear_bounding_volume_hierarchy_str);
+    REQUIRE(linear_bounding_volume_hierarchy_str != linear_bounding_volume_hierarchy_optimised_str);
+    REQUIRE(k_d_tree_str != rope_k_d_tree_str);
+    REQUIRE(octree_str != parametric_octree_str);
+    REQUIRE(parametric_octree_str != loose_octree_str);
+    REQUIRE(loose_octree_str != linear_octree_str);
+    REQUIRE(bsp_tree_str != adaptive_bsp_tree_str);
+    REQUIRE(hierarchical_uniform_grid_str != hashed_grid_str);
+    REQUIRE(hashed_grid_str != two_level_grid_str);
+}
+
+TEST_CASE("RoundDownToFloat and RoundUpToFloat bracket the double value", "[Utility]")
+{
+    SECTION("Exactly representable values are unchanged")
+    {
+        REQUIRE(RoundDownToFloat(0.5) == 0.5f);
+        REQUIRE(RoundUpToFloat(0.5) == 0.5f);
+        REQUIRE(RoundDownToFloat(-4.0) == -4.0f);
+        REQUIRE(RoundUpToFloat(-4.0) == -4.0f);
+    }
+
+    SECTION("Inexact values are rounded outwards")
+    {
+        const double values[] = {0.1, -0.1, 1000.0001, -123.456789, 1e-9};
+        for (const double value : values)
+        {
+            REQUIRE(static_cast<double>(RoundDownToFloat(value)) <= value);
+            REQUIRE(static_cast<double>(RoundUpToFloat(value)) >= value);
+            REQUIRE(RoundDownToFloat(value) < RoundUpToFloat(value));
+        }
+    }
 }
 
 TEST_CASE("RenderStats TotalTimeMilliseconds sums construction and render times", "[Utility]")
@@ -0,0 +1,178 @@
+// Copyright Mia Rolfe. All rights reserved.
+#include <Catch2/catch.hpp>
+
+#include <Acceleration/FlatBoundingVolumeHierarchy.h>
+#include <Acceleration/WideBoundingVolumeHierarchy.h>
+#include <Core/ArenaAllocator.h>
+#include <Core/Constants.h>
+#include <Geometry/Sphere.h>
+#include <Materials/Material.h>
+
+namespace ART
+{
+
+TEMPLATE_TEST_CASE("WideBVH constructs from vector of objects", "[WideBVH]", BVH4, BVH8)
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    SECTION("No objects")
+    {
+        std::vector<IRayHittable*> objects;
+
+        TestType wide_bounding_volume_hierarchy(objects);
+        RayHitResult result;
+
+        REQUIRE(wide_bounding_volume_hierarchy.GetNodes().empty());
+        REQUIRE(wide_bounding_volume_hierarchy.Hit(Ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0)), Interval(0.001, infinity), result) == false);
+    }
+
+    SECTION("Single object")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -1.0), 0.5, material));
+
+        TestType wide_bounding_volume_hierarchy(objects);
+        const AABB box = wide_bounding_volume_hierarchy.BoundingBox();
+
+        REQUIRE(box.m_x.m_min == Approx(-0.5));
+        REQUIRE(box.m_x.m_max == Approx(0.5));
+        REQUIRE(box.m_z.m_min == Approx(-1.5));
+        REQUIRE(box.m_z.m_max == Approx(-0.5));
+        REQUIRE(wide_bounding_volume_hierarchy.GetNodes().size() == 1);
+        REQUIRE(wide_bounding_volume_hierarchy.GetNodes()[0].num_children == 1);
+    }
+
+    SECTION("Nodes are filled up to their width")
+    {
+        std::vector<IRayHittable*> objects;
+        for (std::size_t object_index = 0; object_index < 64; object_index++)
+        {
+            objects.push_back(allocator.Create<Sphere>(Point3(static_cast<double>(object_index), 0.0, -5.0), 0.25, material));
+        }
+
+        TestType wide_bounding_volume_hierarchy(objects);
+        const auto& nodes = wide_bounding_volume_hierarchy.GetNodes();
+        const std::size_t width = sizeof(nodes[0].child_offset) / sizeof(uint32_t);
+
+        REQUIRE(nodes[0].num_children == width);
+        for (std::size_t node_index = 0; node_index < nodes.size(); node_index++)
+        {
+            REQUIRE(nodes[node_index].num_children >= 1);
+            REQUIRE(nodes[node_index].num_children <= width);
+        }
+    }
+}
+
+TEMPLATE_TEST_CASE("WideBVH Hit detects intersections", "[WideBVH]", BVH4, BVH8)
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    Ray ray(Point3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, -1.0));
+
+    SECTION("Ray hits single object")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+
+        TestType wide_bounding_volume_hierarchy(objects);
+        RayHitResult result;
+        const bool hit = wide_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), result);
+
+        REQUIRE(hit == true);
+        REQUIRE(result.m_t == Approx(4.0));
+    }
+
+    SECTION("Ray misses all objects")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(10.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(-10.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 10.0, -5.0), 1.0, material));
+
+        TestType wide_bounding_volume_hierarchy(objects);
+        RayHitResult result;
+        const bool hit = wide_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), result);
+
+        REQUIRE(hit == false);
+    }
+
+    SECTION("Ray hits closest object among multiple")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -10.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -3.0), 0.5, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(3.0, 0.0, -3.0), 0.5, material));
+        objects.push_back(allocator.Create<Sphere>(Point3(-3.0, 0.0, -3.0), 0.5, material));
+
+        TestType wide_bounding_volume_hierarchy(objects);
+        RayHitResult result;
+        const bool hit = wide_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), result);
+
+        REQUIRE(hit == true);
+        REQUIRE(result.m_t == Approx(2.5));
+    }
+
+    SECTION("Ray respects interval bounds")
+    {
+        std::vector<IRayHittable*> objects;
+        objects.push_back(allocator.Create<Sphere>(Point3(0.0, 0.0, -5.0), 1.0, material));
+
+        TestType wide_bounding_volume_hierarchy(objects);
+        RayHitResult result;
+
+        const bool hit = wide_bounding_volume_hierarchy.Hit(ray, Interval(10.0, infinity), result);
+        REQUIRE(hit == false);
+    }
+}
+
+TEMPLATE_TEST_CASE("WideBVH matches FlatBVH results", "[WideBVH]", BVH4, BVH8)
+{
+    ArenaAllocator allocator(ONE_MEGABYTE);
+    Texture* texture = allocator.Create<SolidColourTexture>(Colour(0.7));
+    Material* material = allocator.Create<LambertianMaterial>(texture);
+
+    std::vector<IRayHittable*> objects;
+    for (int x = -5; x <= 5; x++)
+    {
+        for (int y = -5; y <= 5; y++)
+        {
+            const double z = -10.0 - static_cast<double>((x * 7 + y * 3) % 5);
+            const double radius = 0.3 + 0.02 * static_cast<double>((x + y + 10) % 7);
+            objects.push_back(allocator.Create<Sphere>(Point3(x, y, z), radius, material));
+        }
+    }
+
+    std::vector<IRayHittable*> objects_copy = objects;
+    FlatBVH flat_bounding_volume_hierarchy(objects_copy);
+    TestType wide_bounding_volume_hierarchy(objects);
+
+    for (int ray_x = -30; ray_x <= 30; ray_x++)
+    {
+        for (int ray_y = -30; ray_y <= 30; ray_y++)
+        {
+            const Ray ray(Point3(0.5, -0.5, 2.0), Vec3(ray_x * 0.02, ray_y * 0.02, -1.0));
+
+            RayHitResult flat_bvh_result;
+            RayHitResult wide_bvh_result;
+            const bool flat_bvh_hit = flat_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), flat_bvh_result);
+            const bool wide_bvh_hit = wide_bounding_volume_hierarchy.Hit(ray, Interval(0.001, infinity), wide_bvh_result);
+
+            REQUIRE(flat_bvh_hit == wide_bvh_hit);
+            REQUIRE(wide_bounding_volume_hierarchy.HitAny(ray, Interval(0.001, infinity)) == flat_bvh_hit);
+            if (flat_bvh_hit)
+            {
+                REQUIRE(wide_bvh_result.m_t == Approx(flat_bvh_result.m_t));
+                REQUIRE_FALSE(wide_bounding_volume_hierarchy.HitAny(ray, Interval(0.001, 0.999 * flat_bvh_result.m_t)));
+            }
+        }
+    }
+
+    REQUIRE(wide_bounding_volume_hierarchy.GetNodes().size() < flat_bounding_volume_hierarchy.GetNodes().size());
+}
+
+} // namespace ART